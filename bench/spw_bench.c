@@ -0,0 +1,1264 @@
+/**
+ * @file spw_bench.c
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Benchmark suite running the output paths of the recorder on synthetic
+ *      traffic corpora. For every corpus and output path (packet indexing per
+ *      scan level, hexdump, event log, raw capture, hexdump through the file
+ *      writer, gzip compressed hexdump, archive serialization with a stub
+ *      transport, capture summary, error log, time-code analysis and
+ *      transaction latency pairing, byte pattern search and the hexdump
+ *      formatted and imported again) it measures events/s, packets/s, bytes/s
+ *      and the peak resident memory, and writes the results as JSON for
+ *      comparing runs. The verify mode checks that the accelerated paths
+ *      produce the same output as the reference, and that the reference
+ *      reproduces the checked-in golden files. Instead of the synthetic
+ *      corpora, a raw capture or hexdump can be run.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <argp.h>
+#include <zlib.h>
+#include <sys/resource.h>
+#include <spw_la_api.h>
+#include "arg_parser.h"
+#include "data_logger.h"
+#include "event_store.h"
+#include "event_scan.h"
+#include "packet_index.h"
+#include "capture_summary.h"
+#include "error_log.h"
+#include "timecode_analysis.h"
+#include "latency_pairing.h"
+#include "packet_search.h"
+#include "hexdump_import.h"
+#include "config_logger.h"
+#include "output_file.h"
+#include "packet_archiver.h"
+#include "file_writer.h"
+#include "raw_capture.h"
+#include "compressor.h"
+#include "synthetic_traffic.h"
+#include "run_stats.h"
+
+/* Version of the result format */
+#define BENCH_VERSION "v0.4.1"
+
+/* Default number of events in each corpus */
+#define BENCH_DEFAULT_EVENTS 1000000
+
+/* Default number of repetitions of each measurement */
+#define BENCH_DEFAULT_REPEATS 3
+
+/* Pre-trigger window in milliseconds covering the whole corpus */
+#define BENCH_PRE_TRIGGER 1000000
+
+/* Number of characters of a message UUID */
+#define DIGEST_UUID_LENGTH 36
+
+/* Default scratch file of the file writer path */
+#define BENCH_DEFAULT_SCRATCH "spw_bench.tmp"
+
+/* Size of the chunks read back from the scratch file */
+#define BENCH_READ_CHUNK (1024 * 1024)
+
+/* Parameters of the 64 bit FNV-1a hash */
+#define DIGEST_FNV_OFFSET 0xCBF29CE484222325ULL
+#define DIGEST_FNV_PRIME 0x100000001B3ULL
+
+/* Patterns of the search path, anchored and anywhere, with and without masks */
+#define BENCH_SEARCH_PATTERNS "0=fe;a5c3;1234/ff0f;10=00/80"
+
+/* Numbers of formatting threads checked in the verify mode */
+static const int verifyJobs[] = { 1, 2, 3, 8 };
+
+/* UUID replacing the random message UUIDs in the golden archive files */
+#define GOLDEN_UUID "00000000-0000-0000-0000-000000000000"
+
+/* Output paths to benchmark */
+enum benchPath {
+    BENCH_PATH_INDEX,
+    BENCH_PATH_HEXDUMP,
+    BENCH_PATH_EVENTLOG,
+    BENCH_PATH_RAW,
+    BENCH_PATH_FILE,
+    BENCH_PATH_GZIP,
+    BENCH_PATH_ARCHIVE,
+    BENCH_PATH_SUMMARY,
+    BENCH_PATH_ERRORS,
+    BENCH_PATH_TIMECODES,
+    BENCH_PATH_LATENCY,
+    BENCH_PATH_SEARCH,
+    BENCH_PATH_IMPORT,
+    BENCH_PATH_COUNT
+};
+
+/* Names of the output paths */
+static const char *const benchPathNames[] = { "index", "hexdump", "eventlog", "raw", "file", "gzip", "archive", "summary", "errors", "timecodes", "latency", "search", "import" };
+
+/* Output paths compared against golden files, named CORPUS.PATH in the golden directory */
+static const int goldenPaths[] = { BENCH_PATH_HEXDUMP, BENCH_PATH_EVENTLOG, BENCH_PATH_ARCHIVE };
+
+/* Corpora to benchmark, events and seed are set by the options */
+static const CorpusParams benchCorpora[] = {
+    /* name       events  util  distribution      mean  idle  errors  faults  seed */
+    { "idle",     0,      0.01, SIZE_UNIFORM,     64,   1.0,  0.0,    0.0,    0 },
+    { "light",    0,      0.1,  SIZE_UNIFORM,     64,   0.5,  0.0,    0.0,    0 },
+    { "heavy",    0,      0.9,  SIZE_UNIFORM,     64,   1.0,  0.0,    0.0,    0 },
+    { "small",    0,      0.5,  SIZE_FIXED,       12,   1.0,  0.0,    0.0,    0 },
+    { "large",    0,      0.5,  SIZE_EXPONENTIAL, 1024, 1.0,  0.0,    0.0,    0 },
+    { "bimodal",  0,      0.5,  SIZE_BIMODAL,     256,  1.0,  0.0,    0.0,    0 },
+    { "errors",   0,      0.5,  SIZE_UNIFORM,     64,   1.0,  0.001,  0.0,    0 },
+    { "faults",   0,      0.5,  SIZE_UNIFORM,     64,   1.0,  0.001,  0.02,   0 }
+};
+
+/* Options of the benchmark */
+struct benchOptions
+{
+    U32 events;             /* Number of events in each corpus */
+    int repeats;            /* Number of repetitions of each measurement */
+    unsigned int seed;      /* Seed of the corpora */
+    int jobs;               /* Number of threads formatting the hexdump */
+    char *output;           /* File to write the results to (NULL = stdout) */
+    char *corpus;           /* Name of the only corpus to run (NULL = all) */
+    char *path;             /* Name of the only output path to run (NULL = all) */
+    char *scratch;          /* Scratch file of the file writer path */
+    char *input;            /* Raw capture or hexdump to run instead of the synthetic corpora (NULL = synthetic) */
+    char *golden;           /* Directory of the golden files to compare the reference output against (NULL = none) */
+    char update;            /* Write the golden files from the reference output instead of comparing */
+    char verify;            /* Check the accelerated paths against the reference output instead of measuring */
+};
+
+/* Result of a single measurement */
+struct benchResult
+{
+    int path;                       /* Benchmarked output path (see enum benchPath) */
+    int scanLevel;                  /* Scan level in use (see enum scanLevel) */
+    unsigned long long events;      /* Events in the corpus */
+    unsigned long long packets;     /* Packets in the corpus */
+    unsigned long long bytes;       /* Packet bytes in the corpus */
+    unsigned long long outputBytes; /* Bytes written by the output path in a single run */
+    double minSeconds;              /* Fastest run */
+    double meanSeconds;             /* Average run */
+    long peakRss;                   /* Peak resident memory in KiB */
+};
+
+/* Output of a single run, counted and optionally hashed instead of written */
+struct outputDigest
+{
+    unsigned long long bytes;       /* Number of bytes written */
+    uint64_t hash;                  /* FNV-1a hash of the bytes written */
+    char hashed;                    /* Update the hash while counting */
+    FILE *copy;                     /* Stream to write a copy of the output to (NULL = none) */
+};
+
+static const char benchDoc[] = "Benchmark of the spw_data_rec output paths on synthetic traffic\v"
+                    "Generates reproducible synthetic traffic corpora varying the packet "
+                    "size distribution, link utilization, idle ratio, error and fault rate, runs "
+                    "the packet indexing for every scan level as well as the hexdump, event "
+                    "log, raw capture, hexdump written to the scratch file by the file writer, "
+                    "gzip compressed hexdump, archive serialization, capture summary, error log, time-code analysis, latency pairing, pattern search and hexdump import on them and writes the throughput and "
+                    "peak memory of every run as JSON. In the verify mode the outputs of all "
+                    "scan levels and thread counts are compared against the scalar single "
+                    "threaded reference instead, and the reference hexdump, event log and archive "
+                    "messages against the golden files given with -g. Corpora: idle, light, heavy, small, "
+                    "large, bimodal, errors, faults. Paths: index, hexdump, eventlog, raw, file, gzip, archive, summary, errors, timecodes, latency, search, import.";
+
+static struct argp_option benchOptionList[] = {
+    {"events",  'n', "EVENTS",  0, "Number of events in each corpus"},
+    {"repeats", 'r', "N",       0, "Number of repetitions of each measurement"},
+    {"seed",    's', "SEED",    0, "Seed of the synthetic corpora"},
+    {"jobs",    'j', "N",       0, "Number of threads formatting the hexdump or searching the packets"},
+    {"output",  'o', "FILE",    0, "Write the results to FILE instead of stdout"},
+    {"corpus",  'c', "NAME",    0, "Run only the corpus NAME"},
+    {"path",    'p', "NAME",    0, "Run only the output path NAME"},
+    {"scratch", 'w', "FILE",    0, "Scratch file written by the file path (default " BENCH_DEFAULT_SCRATCH ")"},
+    {"verify",  'V', 0,         0, "Check that every scan level and number of jobs produces the same"
+                                    " hexdump, event log and archive messages as the scalar single threaded"
+                                    " reference, instead of measuring"},
+    {"input",   'i', "FILE",    0, "Run the raw capture or hexdump FILE instead of the synthetic corpora"},
+    {"golden",  'g', "DIR",     0, "In the verify mode, compare the reference hexdump, event log and archive"
+                                    " messages against the golden files CORPUS.hexdump, CORPUS.eventlog and"
+                                    " CORPUS.archive in DIR"},
+    {"update",  'u', 0,         0, "Write the golden files from the reference output instead of comparing"},
+    { 0 }
+};
+
+static error_t parseBenchOpt(int key, char *arg, struct argp_state *state)
+{
+    /* Options to fill */
+    struct benchOptions *options = state->input;
+    /* Loop counter */
+    U32 i = 0;
+    /* The name passed to the option is known */
+    int known = 0;
+
+    switch (key)
+    {
+    case 'n':
+        options->events = (U32)strtoul(arg, NULL, 10);
+        if (0 == options->events)
+        {
+            argp_error(state, "Number of events must be at least 1");
+        }
+        break;
+    case 'r':
+        options->repeats = atoi(arg);
+        if (1 > options->repeats)
+        {
+            argp_error(state, "Number of repetitions must be at least 1");
+        }
+        break;
+    case 's':
+        options->seed = (unsigned int)strtoul(arg, NULL, 10);
+        break;
+    case 'j':
+        options->jobs = atoi(arg);
+        if (1 > options->jobs)
+        {
+            argp_error(state, "Number of jobs must be at least 1");
+        }
+        break;
+    case 'o':
+        options->output = arg;
+        break;
+    case 'c':
+        for (i = 0; i < sizeof(benchCorpora) / sizeof(benchCorpora[0]); i++)
+        {
+            known = known || (0 == strcmp(arg, benchCorpora[i].name));
+        }
+        if (!known)
+        {
+            argp_error(state, "Unknown corpus '%s'", arg);
+        }
+        options->corpus = arg;
+        break;
+    case 'V':
+        options->verify = 1;
+        break;
+    case 'w':
+        options->scratch = arg;
+        break;
+    case 'i':
+        options->input = arg;
+        break;
+    case 'g':
+        options->golden = arg;
+        break;
+    case 'u':
+        options->update = 1;
+        break;
+    case 'p':
+        for (i = 0; i < BENCH_PATH_COUNT; i++)
+        {
+            known = known || (0 == strcmp(arg, benchPathNames[i]));
+        }
+        if (!known)
+        {
+            argp_error(state, "Unknown output path '%s'", arg);
+        }
+        options->path = arg;
+        break;
+    default:
+        return ARGP_ERR_UNKNOWN;
+    }
+
+    return 0;
+}
+
+static struct argp benchArgp = { benchOptionList, parseBenchOpt, 0, benchDoc };
+
+static double secondsSince(const struct timespec *start)
+{
+    /* Current time */
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (double)(now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+static void resetPeakRss(void)
+{
+    /* Writing 5 resets the peak resident memory (VmHWM) of the process on Linux */
+    FILE *clearRefs = fopen("/proc/self/clear_refs", "w");
+
+    if (NULL != clearRefs)
+    {
+        fputs("5", clearRefs);
+        fclose(clearRefs);
+    }
+}
+
+static long getPeakRss(void)
+{
+    /* Peak resident memory in KiB */
+    long peakRss = 0;
+    /* Current line of the process status */
+    char line[128];
+    /* Process status */
+    FILE *status = fopen("/proc/self/status", "r");
+    /* Resource usage as fallback */
+    struct rusage usage;
+
+    while ((NULL != status) && (NULL != fgets(line, sizeof(line), status)))
+    {
+        if (0 == strncmp(line, "VmHWM:", 6))
+        {
+            peakRss = strtol(line + 6, NULL, 10);
+            break;
+        }
+    }
+    if (NULL != status)
+    {
+        fclose(status);
+    }
+    if ((0 == peakRss) && (0 == getrusage(RUSAGE_SELF, &usage)))
+    {
+        peakRss = usage.ru_maxrss;
+    }
+
+    return peakRss;
+}
+
+static void updateDigest(struct outputDigest *digest, const char *buffer, size_t size)
+{
+    /* Loop counter */
+    size_t i = 0;
+
+    digest->bytes += size;
+    for (i = 0; digest->hashed && (i < size); i++)
+    {
+        digest->hash = (digest->hash ^ (uint8_t)buffer[i]) * DIGEST_FNV_PRIME;
+    }
+}
+
+static ssize_t writeDigest(void *cookie, const char *buffer, size_t size)
+{
+    /* Digest of the output */
+    struct outputDigest *digest = cookie;
+
+    /* Discard the output, but count and hash its bytes */
+    updateDigest(digest, buffer, size);
+    if ((NULL != digest->copy) && (size != fwrite(buffer, 1, size, digest->copy)))
+    {
+        return -1;
+    }
+
+    return (ssize_t)size;
+}
+
+static FILE *openDigestStream(struct outputDigest *digest)
+{
+    /* Functions of the digest stream */
+    cookie_io_functions_t digestFunctions = { NULL, writeDigest, NULL, NULL };
+    /* Stream counting and hashing the formatted bytes */
+    FILE *stream = fopencookie(digest, "w", digestFunctions);
+
+    if (NULL == stream)
+    {
+        fputs("Unable to open counting stream\n", stderr);
+    }
+
+    return stream;
+}
+
+static int digestFile(const char *fileName, struct outputDigest *digest)
+{
+    /* The file to read back */
+    FILE *file = fopen(fileName, "rb");
+    /* Chunk of the file */
+    char *chunk = malloc(BENCH_READ_CHUNK);
+    /* Number of bytes read */
+    size_t length = 0;
+    /* Return value */
+    int success = (NULL != file) && (NULL != chunk);
+
+    while (success && (0 < (length = fread(chunk, 1, BENCH_READ_CHUNK, file))))
+    {
+        updateDigest(digest, chunk, length);
+    }
+    if (NULL == file)
+    {
+        fprintf(stderr, "Unable to read back %s\n", fileName);
+    }
+    else
+    {
+        success = success && !ferror(file);
+        fclose(file);
+    }
+    free(chunk);
+
+    return success;
+}
+
+static int digestCompressed(const unsigned char *data, size_t size, struct outputDigest *digest)
+{
+    /* Offset of the current gzip member */
+    size_t offset = 0;
+    /* Decompressing stream, gzip members are recognized by the 16 added to the window bits */
+    z_stream stream;
+    /* Chunk of decompressed data */
+    unsigned char *chunk = malloc(BENCH_READ_CHUNK);
+    /* Result of the last inflate call */
+    int result = Z_OK;
+    /* Return value */
+    int success = (NULL != chunk);
+
+    /* The member sizes in the headers have to lead from member to member up to the end */
+    while (success && (offset + COMPRESS_HEADER_SIZE <= size))
+    {
+        success = (0x1F == data[offset]) && (0x8B == data[offset + 1]) && ('S' == data[offset + 12]) && ('P' == data[offset + 13]);
+        offset += (size_t)data[offset + 16] | ((size_t)data[offset + 17] << 8) | ((size_t)data[offset + 18] << 16) | ((size_t)data[offset + 19] << 24);
+    }
+    success = success && (offset == size);
+    if (!success)
+    {
+        fputs("Gzip members cannot be skipped by their sizes\n", stderr);
+    }
+
+    memset(&stream, 0, sizeof(stream));
+    success = success && (Z_OK == inflateInit2(&stream, 16 + MAX_WBITS));
+    stream.next_in = (unsigned char *)data;
+    stream.avail_in = (uInt)size;
+    while (success && (0 < stream.avail_in))
+    {
+        stream.next_out = chunk;
+        stream.avail_out = BENCH_READ_CHUNK;
+        result = inflate(&stream, Z_NO_FLUSH);
+        updateDigest(digest, (const char *)chunk, BENCH_READ_CHUNK - stream.avail_out);
+        if (Z_STREAM_END == result)
+        {
+            /* Continue with the next member */
+            inflateReset(&stream);
+        }
+        success = (Z_OK == result) || (Z_STREAM_END == result);
+    }
+    inflateEnd(&stream);
+    free(chunk);
+
+    return success;
+}
+
+static void digestMessage(struct outputDigest *digest, const char *buffer, size_t length)
+{
+    /* Key of the random message UUID */
+    const char uuidKey[] = "\"uuid\": \"";
+    /* Position of the message UUID */
+    const char *uuid = memmem(buffer, length, uuidKey, sizeof(uuidKey) - 1);
+    /* Bytes up to the UUID value */
+    size_t prefix = (NULL != uuid) ? (size_t)(uuid - buffer) + sizeof(uuidKey) - 1 : length;
+
+    /* Skip the UUID, which differs between runs */
+    updateDigest(digest, buffer, prefix);
+    if ((NULL != uuid) && (prefix + DIGEST_UUID_LENGTH <= length))
+    {
+        updateDigest(digest, buffer + prefix + DIGEST_UUID_LENGTH, length - prefix - DIGEST_UUID_LENGTH);
+        digest->bytes += DIGEST_UUID_LENGTH;
+    }
+
+    /* The copy holds one message per line with the UUID replaced */
+    if ((NULL != digest->copy) && (NULL != uuid) && (prefix + DIGEST_UUID_LENGTH <= length))
+    {
+        fwrite(buffer, 1, prefix, digest->copy);
+        fputs(GOLDEN_UUID, digest->copy);
+        fwrite(buffer + prefix + DIGEST_UUID_LENGTH, 1, length - prefix - DIGEST_UUID_LENGTH, digest->copy);
+        fputc('\n', digest->copy);
+    }
+    else if (NULL != digest->copy)
+    {
+        fwrite(buffer, 1, length, digest->copy);
+        fputc('\n', digest->copy);
+    }
+
+    return;
+}
+
+static int32_t sendStubMessage(void *context, const char *topic, uint8_t *buffer, size_t length, void *opaque)
+{
+    /* Digest the delivered message */
+    digestMessage(context, (const char *)buffer, length);
+
+    return 1;
+}
+
+static int compareEntries(const void *first, const void *second)
+{
+    /* The compared entries */
+    const PacketEntry *a = first;
+    const PacketEntry *b = second;
+
+    if (a->receiver != b->receiver)
+    {
+        return (a->receiver < b->receiver) ? -1 : 1;
+    }
+    if (a->startTime != b->startTime)
+    {
+        return (a->startTime < b->startTime) ? -1 : 1;
+    }
+
+    return (a->startEvent < b->startEvent) ? -1 : (a->startEvent > b->startEvent);
+}
+
+static int compareImport(const EventStore *store, const PacketIndex *index, const EventStore *imported, unsigned long long guessed)
+{
+    /* Packets of the imported events */
+    PacketIndex importedIndex = { 0 };
+    /* Source entries ordered like the imported ones */
+    PacketEntry *sourceEntries = NULL;
+    /* Loop counter */
+    U32 i = 0;
+    /* Source and imported entry */
+    const PacketEntry *source = NULL;
+    const PacketEntry *entry = NULL;
+    /* Termination the hexdump can carry for the source entry */
+    U8 termination = 0;
+    /* Number of source bytes in the hexdump */
+    U32 length = 0;
+    /* Bytes of the source and imported packet */
+    U8 *sourceBytes = NULL;
+    U8 *importedBytes = NULL;
+    /* Return value */
+    int success = 0;
+
+    if (!LA_MK3_buildPacketIndex(&importedIndex, imported, BENCH_PRE_TRIGGER, NULL))
+    {
+        return 0;
+    }
+    sourceEntries = malloc(index->count * sizeof(PacketEntry) + 1);
+    sourceBytes = malloc(index->maxLength + 1);
+    importedBytes = malloc(importedIndex.maxLength + 1);
+    success = (NULL != sourceEntries) && (NULL != sourceBytes) && (NULL != importedBytes);
+    if (!success)
+    {
+        fputs("Unable to allocate the packet buffers\n", stderr);
+    }
+    else if (importedIndex.count != index->count)
+    {
+        fprintf(stderr, "Imported hexdump holds %u packets and time-codes instead of %u\n", importedIndex.count, index->count);
+        success = 0;
+    }
+    if (success)
+    {
+        /* Both indexes are in order of completion, which the import does not preserve for interleaved receivers */
+        memcpy(sourceEntries, index->entries, index->count * sizeof(PacketEntry));
+        qsort(sourceEntries, index->count, sizeof(PacketEntry), compareEntries);
+        qsort(importedIndex.entries, importedIndex.count, sizeof(PacketEntry), compareEntries);
+    }
+    for (i = 0; success && (i < index->count); i++)
+    {
+        source = &sourceEntries[i];
+        entry = &importedIndex.entries[i];
+        /* The hexdump marks neither EEPs nor errors, the packet is imported with an EOP */
+        termination = (PACKET_TERM_EEP == source->termination) ? PACKET_TERM_EOP : source->termination;
+        /* Single byte records reported as guessed may have been taken for the wrong kind */
+        if ((1 == source->length) && (0 < guessed) && (entry->termination != termination) &&
+            ((PACKET_TERM_TIMECODE == entry->termination) || (PACKET_TERM_TIMECODE == termination)))
+        {
+            termination = entry->termination;
+            guessed--;
+        }
+        /* The hexdump leaves out headers within a packet */
+        length = LA_MK3_getHexdumpBytes(source, store, sourceBytes);
+        success = (entry->receiver == source->receiver) && (entry->termination == termination) &&
+                  (entry->length == length) && (entry->startTime == source->startTime) &&
+                  (LA_MK3_getPacketBytes(entry, imported, importedBytes) == length) &&
+                  (0 == memcmp(sourceBytes, importedBytes, length));
+        if (!success)
+        {
+            fprintf(stderr, "Imported entry %u differs from the source: receiver %c, %u bytes, termination %u, tick %lld "
+                    "instead of receiver %c, %u bytes, termination %u, tick %lld\n", i,
+                    'A' + entry->receiver, entry->length, entry->termination, entry->startTime,
+                    'A' + source->receiver, length, termination, source->startTime);
+        }
+    }
+    free(sourceEntries);
+    free(sourceBytes);
+    free(importedBytes);
+    freePacketIndex(&importedIndex);
+
+    return success;
+}
+
+static int runPath(int path, const EventStore *store, PacketIndex *index, Settings *settings, struct outputDigest *output)
+{
+    /* Stream counting the formatted bytes */
+    FILE *stream = NULL;
+    /* Output of the capture logs writing to that stream */
+    OutputFile sink;
+    /* Trigger time of the synthetic traffic */
+    struct timespec triggerTime = { 0, 0 };
+    /* Transport discarding the archive messages */
+    ArchiveTransport transport = { sendStubMessage, output, NULL };
+    /* Number of messages delivered */
+    uint32_t messageCounter = 0;
+    /* Statistics of the capture */
+    CaptureSummary summary;
+    /* Time-codes of the capture */
+    TimecodeAnalysis timecodes;
+    /* Latencies of the transactions and the rules pairing them */
+    LatencyPairing latency;
+    PairingRules *rules = NULL;
+    /* Packets containing the search patterns and the compiled patterns */
+    PacketSearch search;
+    SearchPatterns *patterns = NULL;
+    /* Compressed output held in memory */
+    FILE *memory = NULL;
+    char *compressed = NULL;
+    size_t compressedSize = 0;
+    /* Hexdump held in memory and the events imported from it */
+    char *text = NULL;
+    size_t textSize = 0;
+    char timestamp[30];
+    STAR_LA_MK3_Traffic *pTraffic = NULL;
+    U32 trafficCount = 0;
+    double clockPeriod = 0.0;
+    struct timespec importTime;
+    char headerOnly = 0;
+    EventStore imported;
+    /* Single byte records of the hexdump guessed to be time-codes or packets before the import */
+    unsigned long long guessed = 0;
+    /* Return value */
+    int success = 1;
+
+    output->bytes = 0;
+    output->hash = DIGEST_FNV_OFFSET;
+
+    switch (path)
+    {
+    case BENCH_PATH_INDEX:
+        freePacketIndex(index);
+        success = LA_MK3_buildPacketIndex(index, store, BENCH_PRE_TRIGGER, NULL);
+        output->bytes = (unsigned long long)index->count * sizeof(PacketEntry);
+        break;
+    case BENCH_PATH_HEXDUMP:
+    case BENCH_PATH_EVENTLOG:
+        stream = openDigestStream(output);
+        if (NULL == stream)
+        {
+            return 0;
+        }
+        outputAttach(&sink, stream);
+        if (BENCH_PATH_HEXDUMP == path)
+        {
+            LA_MK3_printHexdumpData(&sink, store, index, &triggerTime, 0, settings->jobs);
+        }
+        else
+        {
+            fputs(EVENT_LOG_TITLE, stream);
+            LA_MK3_printEventCaptureLog(&sink, store, BENCH_PRE_TRIGGER, NULL, 0);
+        }
+        outputClose(&sink);
+        fclose(stream);
+        break;
+    case BENCH_PATH_RAW:
+        stream = openDigestStream(output);
+        if (NULL == stream)
+        {
+            return 0;
+        }
+        LA_MK3_writeRawCapture(stream, store, &triggerTime, 0);
+        fclose(stream);
+        break;
+    case BENCH_PATH_FILE:
+        /* The hexdump through the file writer, read back only for hashing */
+        stream = writerOpen(settings->outputFile, 0, FSYNC_NONE);
+        if (NULL == stream)
+        {
+            return 0;
+        }
+        outputAttach(&sink, stream);
+        output->bytes = LA_MK3_printHexdumpData(&sink, store, index, &triggerTime, 0, settings->jobs);
+        outputClose(&sink);
+        success = (0 == fclose(stream));
+        if (success && output->hashed)
+        {
+            output->bytes = 0;
+            success = digestFile(settings->outputFile, output);
+        }
+        remove(settings->outputFile);
+        break;
+    case BENCH_PATH_GZIP:
+        /* The hexdump compressed into memory, decompressed again only for hashing */
+        memory = open_memstream(&compressed, &compressedSize);
+        stream = (NULL != memory) ? compressOpen(memory, COMPRESS_DEFAULT_LEVEL, 1) : NULL;
+        if (NULL == stream)
+        {
+            fputs("Unable to open compressing stream\n", stderr);
+            return 0;
+        }
+        outputAttach(&sink, stream);
+        LA_MK3_printHexdumpData(&sink, store, index, &triggerTime, 0, settings->jobs);
+        outputClose(&sink);
+        success = (0 == fclose(stream));
+        output->bytes = compressedSize;
+        if (success && output->hashed)
+        {
+            output->bytes = 0;
+            success = digestCompressed((unsigned char *)compressed, compressedSize, output);
+        }
+        free(compressed);
+        break;
+    case BENCH_PATH_ARCHIVE:
+        success = LA_MK3_serializeCapturedPackets(*settings, store, index, &triggerTime, &transport, &messageCounter);
+        break;
+    case BENCH_PATH_SUMMARY:
+        stream = openDigestStream(output);
+        if (NULL == stream)
+        {
+            return 0;
+        }
+        LA_MK3_summarizeCapture(&summary, store, index);
+        printSummaryTable(stream, &summary);
+        fclose(stream);
+        break;
+    case BENCH_PATH_ERRORS:
+        stream = openDigestStream(output);
+        if (NULL == stream)
+        {
+            return 0;
+        }
+        outputAttach(&sink, stream);
+        LA_MK3_printErrorLog(&sink, store, index, &triggerTime, ERROR_DEFAULT_CONTEXT, 0.0);
+        outputClose(&sink);
+        fclose(stream);
+        break;
+    case BENCH_PATH_TIMECODES:
+        stream = openDigestStream(output);
+        if (NULL == stream)
+        {
+            return 0;
+        }
+        LA_MK3_analyseTimecodes(&timecodes, store, index);
+        printTimecodeTable(stream, &timecodes);
+        fclose(stream);
+        break;
+    case BENCH_PATH_LATENCY:
+        rules = compilePairingRules(PAIR_DEFAULT_RULES);
+        if (NULL == rules)
+        {
+            return 0;
+        }
+        stream = openDigestStream(output);
+        if (NULL == stream)
+        {
+            freePairingRules(rules);
+            return 0;
+        }
+        success = LA_MK3_pairTransactions(&latency, store, index, rules, PAIR_DEFAULT_TIMEOUT);
+        if (success)
+        {
+            printLatencyTable(stream, &latency);
+        }
+        freePairingRules(rules);
+        fclose(stream);
+        break;
+    case BENCH_PATH_SEARCH:
+        patterns = compileSearchPatterns(BENCH_SEARCH_PATTERNS);
+        if (NULL == patterns)
+        {
+            return 0;
+        }
+        stream = openDigestStream(output);
+        if (NULL == stream)
+        {
+            freeSearchPatterns(patterns);
+            return 0;
+        }
+        success = LA_MK3_searchPackets(&search, store, index, patterns, settings->jobs);
+        if (success)
+        {
+            printSearchMatches(stream, &search, store, index, &triggerTime);
+            freePacketSearch(&search);
+        }
+        freeSearchPatterns(patterns);
+        fclose(stream);
+        break;
+    case BENCH_PATH_IMPORT:
+        /* The hexdump formatted into memory and imported again, hashing the imported events as a raw capture */
+        memory = open_memstream(&text, &textSize);
+        if (NULL == memory)
+        {
+            fputs("Unable to open memory stream\n", stderr);
+            return 0;
+        }
+        timeToStr(&triggerTime, timestamp);
+        fprintf(memory, "# Trigger timestamp:   %s\n", timestamp);
+        outputAttach(&sink, memory);
+        LA_MK3_printHexdumpData(&sink, store, index, &triggerTime, 0, settings->jobs);
+        outputClose(&sink);
+        guessed = statsGet(STATS_IMPORT_GUESSED);
+        success = (0 == fclose(memory)) &&
+                  LA_MK3_parseHexdump(text, textSize, "benchmark", &pTraffic, &trafficCount, &clockPeriod, &importTime, &headerOnly);
+        free(text);
+        if (success)
+        {
+            success = LA_MK3_convertTraffic(&imported, pTraffic, &trafficCount, &clockPeriod);
+            free(pTraffic);
+        }
+        /* When verifying, the imported packets have to match the source apart from what the hexdump cannot hold */
+        if (success && output->hashed && !compareImport(store, index, &imported, statsGet(STATS_IMPORT_GUESSED) - guessed))
+        {
+            freeEventStore(&imported);
+            success = 0;
+        }
+        if (success)
+        {
+            stream = openDigestStream(output);
+            if (NULL != stream)
+            {
+                LA_MK3_writeRawCapture(stream, &imported, &importTime, headerOnly);
+                fclose(stream);
+            }
+            success = (NULL != stream);
+            freeEventStore(&imported);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return success;
+}
+
+static int measurePath(struct benchResult *result, const struct benchOptions *options, const EventStore *store, PacketIndex *index, Settings *settings)
+{
+    /* Loop counter */
+    int r = 0;
+    /* Start of the measurement */
+    struct timespec start;
+    /* Runtime of the current run */
+    double seconds = 0;
+    /* Accumulated runtime of all runs */
+    double totalSeconds = 0;
+    /* Output of the current run */
+    struct outputDigest output = { 0, 0, 0, NULL };
+
+    result->minSeconds = 0;
+    resetPeakRss();
+    for (r = 0; r < options->repeats; r++)
+    {
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        if (!runPath(result->path, store, index, settings, &output))
+        {
+            return 0;
+        }
+        result->outputBytes = output.bytes;
+        seconds = secondsSince(&start);
+        totalSeconds += seconds;
+        result->minSeconds = ((0 == r) || (seconds < result->minSeconds)) ? seconds : result->minSeconds;
+    }
+    result->meanSeconds = totalSeconds / options->repeats;
+    result->peakRss = getPeakRss();
+
+    return 1;
+}
+
+static void printResult(FILE *out, const CorpusParams *corpus, const char *input, const struct benchResult *result, int first)
+{
+    if (NULL != input)
+    {
+        fprintf(out, "%s\n    {\"corpus\": \"%s\", \"input\": \"%s\", ", first ? "" : ",", corpus->name, input);
+    }
+    else
+    {
+        fprintf(out, "%s\n    {\"corpus\": \"%s\", \"size_distribution\": \"%s\", \"mean_packet_size\": %u, "
+                "\"utilization\": %g, \"idle_ratio\": %g, \"error_rate\": %g, \"fault_rate\": %g, ",
+                first ? "" : ",", corpus->name, sizeDistributionNames[corpus->sizeDistribution],
+                corpus->meanPacketSize, corpus->utilization, corpus->idleRatio, corpus->errorRate, corpus->faultRate);
+    }
+    fprintf(out, "\"path\": \"%s\", \"scan\": \"%s\", \"events\": %llu, \"packets\": %llu, \"bytes\": %llu, "
+            "\"output_bytes\": %llu, \"seconds_min\": %.6f, \"seconds_mean\": %.6f, ",
+            benchPathNames[result->path], scanLevelNames[result->scanLevel], result->events,
+            result->packets, result->bytes, result->outputBytes, result->minSeconds, result->meanSeconds);
+    fprintf(out, "\"events_per_s\": %.0f, \"packets_per_s\": %.0f, \"bytes_per_s\": %.0f, \"peak_rss_kb\": %ld}",
+            result->events / result->minSeconds, result->packets / result->minSeconds,
+            result->bytes / result->minSeconds, result->peakRss);
+}
+
+static int loadCorpus(const CorpusParams *corpus, const char *input, EventStore *store, PacketIndex *index)
+{
+    /* Number of generated or read events */
+    U32 trafficCount = corpus->events;
+    /* Clock period of the traffic */
+    double clockPeriod = SYNTHETIC_CLOCK_PERIOD;
+    /* Generated or read traffic */
+    STAR_LA_MK3_Traffic *pTraffic = NULL;
+    /* Trigger time and recording mode of a capture, the outputs are formatted relative to the epoch */
+    struct timespec triggerTime;
+    char headerOnly = 0;
+
+    if (NULL == input)
+    {
+        pTraffic = generateTraffic(corpus);
+        if (NULL == pTraffic)
+        {
+            fputs("Error while generating synthetic traffic\n", stderr);
+            return 0;
+        }
+    }
+    else if (!(isRawCapture(input) ? LA_MK3_readRawCapture(input, &pTraffic, &trafficCount, &clockPeriod, &triggerTime, &headerOnly) :
+                                     LA_MK3_importHexdump(input, &pTraffic, &trafficCount, &clockPeriod, &triggerTime, &headerOnly)))
+    {
+        return 0;
+    }
+    else if (headerOnly)
+    {
+        fprintf(stderr, "Capture %s holds only packet headers, which the output paths are not run on\n", input);
+        free(pTraffic);
+        return 0;
+    }
+    if (!LA_MK3_convertTraffic(store, pTraffic, &trafficCount, &clockPeriod))
+    {
+        free(pTraffic);
+        return 0;
+    }
+    free(pTraffic);
+    if (!LA_MK3_buildPacketIndex(index, store, BENCH_PRE_TRIGGER, NULL))
+    {
+        freePacketIndex(index);
+        freeEventStore(store);
+        return 0;
+    }
+
+    return 1;
+}
+
+static int benchCorpus(FILE *out, const CorpusParams *corpus, const struct benchOptions *options, Settings *settings, int *first)
+{
+    /* Loop counters */
+    U32 i = 0;
+    int path = 0, level = 0;
+    /* Best scan level supported by the CPU */
+    const int bestLevel = setScanLevel(SCAN_LEVEL_AVX2);
+    /* Event store of the generated traffic */
+    EventStore store;
+    /* Packet index of the generated traffic */
+    PacketIndex index;
+    /* Result of the current measurement */
+    struct benchResult result;
+
+    if (!loadCorpus(corpus, options->input, &store, &index))
+    {
+        return 0;
+    }
+
+    memset(&result, 0, sizeof(result));
+    result.events = store.count;
+    for (i = 0; i < index.count; i++)
+    {
+        if (PACKET_TERM_TIMECODE != index.entries[i].termination)
+        {
+            result.packets++;
+            result.bytes += index.entries[i].length;
+        }
+    }
+
+    for (path = 0; path < BENCH_PATH_COUNT; path++)
+    {
+        if ((NULL != options->path) && (0 != strcmp(options->path, benchPathNames[path])))
+        {
+            continue;
+        }
+        /* Indexing runs for every scan level, the other paths with the best one */
+        for (level = (BENCH_PATH_INDEX == path) ? SCAN_LEVEL_SCALAR : bestLevel; level <= bestLevel; level++)
+        {
+            result.path = path;
+            result.scanLevel = setScanLevel(level);
+            if (!measurePath(&result, options, &store, &index, settings))
+            {
+                freePacketIndex(&index);
+                freeEventStore(&store);
+                return 0;
+            }
+            printResult(out, corpus, options->input, &result, *first);
+            *first = 0;
+        }
+    }
+    setScanLevel(bestLevel);
+
+    freePacketIndex(&index);
+    freeEventStore(&store);
+
+    return 1;
+}
+
+static int digestGolden(const char *fileName, int path, struct outputDigest *digest)
+{
+    /* The golden file */
+    FILE *file = NULL;
+    /* Current line of a golden archive file */
+    char *line = NULL;
+    size_t size = 0;
+    ssize_t length = 0;
+
+    digest->bytes = 0;
+    digest->hash = DIGEST_FNV_OFFSET;
+    if (BENCH_PATH_ARCHIVE != path)
+    {
+        return digestFile(fileName, digest);
+    }
+
+    /* The archive holds a message per line, digested like a delivered message */
+    file = fopen(fileName, "r");
+    if (NULL == file)
+    {
+        fprintf(stderr, "Unable to read back %s\n", fileName);
+        return 0;
+    }
+    while (0 < (length = getline(&line, &size, file)))
+    {
+        digestMessage(digest, line, ('\n' == line[length - 1]) ? (size_t)length - 1 : (size_t)length);
+    }
+    free(line);
+    fclose(file);
+
+    return 1;
+}
+
+static int checkGolden(FILE *out, const CorpusParams *corpus, const struct benchOptions *options, const EventStore *store, PacketIndex *index,
+                       Settings *settings, const struct outputDigest *reference, int *first, int *mismatches)
+{
+    /* Loop counter */
+    U32 g = 0;
+    /* Checked output path */
+    int path = 0;
+    /* Name of the golden file */
+    char fileName[FILENAME_MAX];
+    /* Output read from or written to the golden file */
+    struct outputDigest golden = { 0, 0, 1, NULL };
+    /* The golden file matches the reference */
+    int match = 0;
+    /* Return value */
+    int success = 1;
+
+    for (g = 0; success && (g < sizeof(goldenPaths) / sizeof(goldenPaths[0])); g++)
+    {
+        path = goldenPaths[g];
+        snprintf(fileName, sizeof(fileName), "%s/%s.%s", options->golden, corpus->name, benchPathNames[path]);
+        if (options->update)
+        {
+            golden.copy = fopen(fileName, "w");
+            if (NULL == golden.copy)
+            {
+                fprintf(stderr, "Unable to write the golden file %s\n", fileName);
+                return 0;
+            }
+            success = runPath(path, store, index, settings, &golden);
+            success = (0 == fclose(golden.copy)) && success;
+            golden.copy = NULL;
+            fprintf(stderr, "Wrote the golden file %s\n", fileName);
+        }
+        else
+        {
+            success = digestGolden(fileName, path, &golden);
+        }
+        match = (golden.bytes == reference[path].bytes) && (golden.hash == reference[path].hash);
+        if (success && !match)
+        {
+            fprintf(stderr, "Output of %s differs from the golden file %s on corpus %s\n", benchPathNames[path], fileName, corpus->name);
+            (*mismatches)++;
+        }
+        if (success)
+        {
+            fprintf(out, "%s\n    {\"corpus\": \"%s\", \"path\": \"%s\", \"golden\": \"%s\", "
+                    "\"output_bytes\": %llu, \"digest\": \"%016llx\", \"reference_digest\": \"%016llx\", \"match\": %s}",
+                    *first ? "" : ",", corpus->name, benchPathNames[path], fileName, golden.bytes,
+                    (unsigned long long)golden.hash, (unsigned long long)reference[path].hash, match ? "true" : "false");
+            *first = 0;
+        }
+    }
+
+    return success;
+}
+
+static int verifyCorpus(FILE *out, const CorpusParams *corpus, const struct benchOptions *options, Settings *settings, int *first, int *mismatches)
+{
+    /* Loop counters */
+    U32 j = 0;
+    int path = 0, level = 0;
+    /* Best scan level supported by the CPU */
+    const int bestLevel = setScanLevel(SCAN_LEVEL_AVX2);
+    /* Number of formatting threads requested by the options */
+    const int jobs = settings->jobs;
+    /* Event store of the generated traffic */
+    EventStore store;
+    /* Packet index of the generated traffic */
+    PacketIndex index;
+    /* Output of the scalar single threaded reference for every path */
+    struct outputDigest reference[BENCH_PATH_COUNT];
+    /* Output of the checked path */
+    struct outputDigest output = { 0, 0, 1, NULL };
+    /* Return value */
+    int success = 1;
+
+    /* Create the reference output with the scalar kernels and a single thread */
+    setScanLevel(SCAN_LEVEL_SCALAR);
+    if (!loadCorpus(corpus, options->input, &store, &index))
+    {
+        setScanLevel(bestLevel);
+        return 0;
+    }
+    settings->jobs = 1;
+    for (path = BENCH_PATH_HEXDUMP; success && (path < BENCH_PATH_COUNT); path++)
+    {
+        reference[path].hashed = 1;
+        reference[path].copy = NULL;
+        /* The file writer and the compressor have to reproduce exactly the hexdump */
+        success = runPath(((BENCH_PATH_FILE == path) || (BENCH_PATH_GZIP == path)) ? BENCH_PATH_HEXDUMP : path, &store, &index, settings, &reference[path]);
+    }
+
+    /* The reference has to reproduce the golden files */
+    if (success && (NULL != options->golden))
+    {
+        success = checkGolden(out, corpus, options, &store, &index, settings, reference, first, mismatches);
+    }
+
+    /* Every scan level has to produce the reference output with any number of threads */
+    for (level = SCAN_LEVEL_SCALAR; success && (level <= bestLevel); level++)
+    {
+        setScanLevel(level);
+        freePacketIndex(&index);
+        success = LA_MK3_buildPacketIndex(&index, &store, BENCH_PRE_TRIGGER, NULL);
+        for (path = BENCH_PATH_HEXDUMP; success && (path < BENCH_PATH_COUNT); path++)
+        {
+            if ((NULL != options->path) && (0 != strcmp(options->path, benchPathNames[path])))
+            {
+                continue;
+            }
+            /* Only the hexdump, the search and the import of the hexdump are run by multiple threads */
+            for (j = 0; success && (j < (((BENCH_PATH_HEXDUMP == path) || (BENCH_PATH_FILE == path) || (BENCH_PATH_GZIP == path) ||
+                                          (BENCH_PATH_SEARCH == path) || (BENCH_PATH_IMPORT == path)) ? sizeof(verifyJobs) / sizeof(verifyJobs[0]) : 1)); j++)
+            {
+                settings->jobs = verifyJobs[j];
+                success = runPath(path, &store, &index, settings, &output);
+                if (success && ((output.bytes != reference[path].bytes) || (output.hash != reference[path].hash)))
+                {
+                    fprintf(stderr, "Output of %s differs from the reference on corpus %s with %s scanning and %d job(s)\n",
+                            benchPathNames[path], corpus->name, scanLevelNames[level], settings->jobs);
+                    (*mismatches)++;
+                }
+                if (success)
+                {
+                    fprintf(out, "%s\n    {\"corpus\": \"%s\", \"path\": \"%s\", \"scan\": \"%s\", \"jobs\": %d, "
+                            "\"output_bytes\": %llu, \"digest\": \"%016llx\", \"reference_digest\": \"%016llx\", \"match\": %s}",
+                            *first ? "" : ",", corpus->name, benchPathNames[path], scanLevelNames[level], settings->jobs,
+                            output.bytes, (unsigned long long)output.hash, (unsigned long long)reference[path].hash,
+                            ((output.bytes == reference[path].bytes) && (output.hash == reference[path].hash)) ? "true" : "false");
+                    *first = 0;
+                }
+            }
+        }
+    }
+
+    settings->jobs = jobs;
+    setScanLevel(bestLevel);
+    freePacketIndex(&index);
+    freeEventStore(&store);
+
+    return success;
+}
+
+int main(int argc, char **argv)
+{
+    /* Loop counter */
+    U32 c = 0;
+    /* Options of the benchmark */
+    struct benchOptions options = { BENCH_DEFAULT_EVENTS, BENCH_DEFAULT_REPEATS, 1, 1, NULL, NULL, NULL, BENCH_DEFAULT_SCRATCH, NULL, NULL, 0, 0 };
+    /* Settings passed to the output paths */
+    Settings settings;
+    /* Corpus to generate */
+    CorpusParams corpus;
+    /* Name of the capture run instead, its file name without directory and extension */
+    char inputName[FILENAME_MAX];
+    char *extension = NULL;
+    /* Stream for the results */
+    FILE *out = stdout;
+    /* No result has been printed yet */
+    int first = 1;
+    /* Number of outputs differing from the reference */
+    int mismatches = 0;
+    /* Return value */
+    int success = 1;
+
+    argp_parse(&benchArgp, argc, argv, 0, 0, &options);
+    if (NULL != options.input)
+    {
+        snprintf(inputName, sizeof(inputName), "%s", (NULL != strrchr(options.input, '/')) ? strrchr(options.input, '/') + 1 : options.input);
+        extension = strrchr(inputName, '.');
+        if ((NULL != extension) && (extension != inputName))
+        {
+            *extension = '\0';
+        }
+    }
+
+    memset(&settings, 0, sizeof(settings));
+    settings.version = BENCH_VERSION;
+    settings.jobs = options.jobs;
+    settings.outputFile = options.scratch;
+    settings.kafka_topic = "bench";
+    settings.kafka_testId = "bench";
+    settings.kafka_testVersion = "1";
+    settings.kafka_interfaceIdIn = "IF_A";
+    settings.kafka_interfaceIdOut = "IF_B";
+    settings.kafka_dbVersion = "1";
+    settings.kafka_aswVersion = "1";
+
+    if (NULL != options.output)
+    {
+        out = fopen(options.output, "w");
+        if (NULL == out)
+        {
+            fprintf(stderr, "Unable to open %s\n", options.output);
+            return EXIT_FAILURE;
+        }
+    }
+
+    fprintf(out, "{\n  \"version\": \"%s\", \"mode\": \"%s\", \"events\": %u, \"repeats\": %d, \"seed\": %u, \"jobs\": %d,\n  \"results\": [",
+            BENCH_VERSION, options.verify ? "verify" : "bench", options.events, options.repeats, options.seed, options.jobs);
+    /* A capture is run as the only corpus */
+    for (c = 0; success && (c < ((NULL != options.input) ? 1 : sizeof(benchCorpora) / sizeof(benchCorpora[0]))); c++)
+    {
+        if ((NULL == options.input) && (NULL != options.corpus) && (0 != strcmp(options.corpus, benchCorpora[c].name)))
+        {
+            continue;
+        }
+        corpus = benchCorpora[c];
+        corpus.events = options.events;
+        corpus.seed = options.seed;
+        if (NULL != options.input)
+        {
+            corpus.name = inputName;
+        }
+        fprintf(stderr, "Running corpus %s...\n", corpus.name);
+        if (options.verify)
+        {
+            success = verifyCorpus(out, &corpus, &options, &settings, &first, &mismatches);
+        }
+        else
+        {
+            success = benchCorpus(out, &corpus, &options, &settings, &first);
+        }
+        fflush(out);
+    }
+    fputs("\n  ]\n}\n", out);
+
+    if (stdout != out)
+    {
+        fclose(out);
+    }
+
+    if (options.verify)
+    {
+        fprintf(stderr, "%d output(s) differ from the reference\n", mismatches);
+    }
+
+    return (success && (0 == mismatches)) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,161 @@
+#include <stdlib.h>
+#include <math.h>
+#include <spw_la_api.h>
+#include "synthetic_traffic.h"
+
+/* Generator state of a single receiver */
+struct receiverState
+{
+    U32 packetBytes;    /* Bytes left to send in the current packet (0 = idle) */
+    U32 idleEvents;     /* Idle events left before the next packet */
+    char failed;        /* The current packet was hit by an error and ends with an EEP */
+};
+
+static unsigned int nextRandom(unsigned int *state)
+{
+    /* xorshift32 */
+    *state ^= *state << 13;
+    *state ^= *state >> 17;
+    *state ^= *state << 5;
+
+    return *state;
+}
+
+static double nextUniform(unsigned int *state)
+{
+    /* Uniformly distributed in [0, 1) */
+    return (nextRandom(state) >> 8) * (1.0 / 16777216.0);
+}
+
+static U32 nextPacketSize(const CorpusParams *params, unsigned int *random)
+{
+    /* Length of short packets of the bimodal distribution */
+    U32 shortSize = (8 <= params->meanPacketSize) ? params->meanPacketSize / 8 : 1;
+    /* Drawn packet length */
+    U32 size = params->meanPacketSize;
+
+    switch (params->sizeDistribution)
+    {
+    case SIZE_UNIFORM:
+        size = 1 + nextRandom(random) % (2 * params->meanPacketSize - 1);
+        break;
+    case SIZE_EXPONENTIAL:
+        size = (U32)(-log(1.0 - nextUniform(random)) * params->meanPacketSize);
+        break;
+    case SIZE_BIMODAL:
+        /* Three in four packets are short, the long ones restore the mean */
+        size = (3 > nextRandom(random) % 4) ? shortSize : 4 * params->meanPacketSize - 3 * shortSize;
+        break;
+    default:
+        break;
+    }
+
+    return (0 < size) ? size : 1;
+}
+
+static STAR_LA_MK3_Event nextEvent(const CorpusParams *params, struct receiverState *receiver, unsigned int *random, U32 eventIndex)
+{
+    /* The generated event */
+    STAR_LA_MK3_Event event;
+    /* Mean number of idle events between two packets */
+    double meanGap = params->meanPacketSize * (1.0 - params->utilization) / params->utilization;
+
+    event.data = (U8)nextRandom(random);
+    event.errors = 0;
+
+    if ((0 == eventIndex % SYNTHETIC_TIMECODE_INTERVAL) && (0 == receiver->packetBytes))
+    {
+        event.type = STAR_LA_TRAFFIC_TYPE_TIMECODE;
+        event.data = (U8)((eventIndex / SYNTHETIC_TIMECODE_INTERVAL) & 0x3F);
+    }
+    else if (0 < receiver->idleEvents)
+    {
+        if (nextUniform(random) < params->idleRatio)
+        {
+            event.type = (0 == nextRandom(random) % 5) ? STAR_LA_TRAFFIC_TYPE_FCT : STAR_LA_TRAFFIC_TYPE_NULL;
+        }
+        else
+        {
+            event.type = STAR_LA_TRAFFIC_TYPE_NO_CHARACTER;
+        }
+        receiver->idleEvents--;
+    }
+    else if (0 == receiver->packetBytes)
+    {
+        /* Start new packet, the header counts as first byte */
+        event.type = STAR_LA_TRAFFIC_TYPE_HEADER;
+        receiver->packetBytes = nextPacketSize(params, random);
+    }
+    else if ((1 == receiver->packetBytes) || receiver->failed)
+    {
+        event.type = receiver->failed ? STAR_LA_TRAFFIC_TYPE_EEP : STAR_LA_TRAFFIC_TYPE_EOP;
+        receiver->packetBytes = 0;
+        receiver->failed = 0;
+        receiver->idleEvents = (U32)(2.0 * meanGap * nextUniform(random));
+    }
+    else if ((0 < params->faultRate) && (nextUniform(random) < params->faultRate))
+    {
+        switch (nextRandom(random) % 4)
+        {
+        case 0:
+            /* Time-code interrupting the packet */
+            event.type = STAR_LA_TRAFFIC_TYPE_TIMECODE;
+            event.data &= 0x3F;
+            break;
+        case 1:
+            /* Header character within the packet, which carries on */
+            event.type = STAR_LA_TRAFFIC_TYPE_HEADER;
+            break;
+        case 2:
+            /* Data character with error flags */
+            event.type = STAR_LA_TRAFFIC_TYPE_DATA;
+            event.errors = (U8)(1 + nextRandom(random) % 255);
+            receiver->packetBytes--;
+            break;
+        default:
+            /* The packet is truncated by an EEP */
+            event.type = STAR_LA_TRAFFIC_TYPE_EEP;
+            receiver->packetBytes = 0;
+            receiver->idleEvents = (U32)(2.0 * meanGap * nextUniform(random));
+            break;
+        }
+    }
+    else if ((0 < params->errorRate) && (nextUniform(random) < params->errorRate))
+    {
+        /* The packet is aborted after the erroneous character */
+        event.type = STAR_LA_TRAFFIC_TYPE_PARITY_ERROR;
+        receiver->failed = 1;
+    }
+    else
+    {
+        event.type = STAR_LA_TRAFFIC_TYPE_DATA;
+        receiver->packetBytes--;
+    }
+
+    return event;
+}
+
+STAR_LA_MK3_Traffic *generateTraffic(const CorpusParams *params)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* State of the pseudo random generator */
+    unsigned int random = params->seed ? params->seed : 1;
+    /* Generator state of receiver A and B */
+    struct receiverState receivers[2] = { { 0, 0, 0 }, { 0, 0, 0 } };
+    /* The generated traffic */
+    STAR_LA_MK3_Traffic *pTraffic = malloc((size_t)params->events * sizeof(STAR_LA_MK3_Traffic));
+
+    /* Start the second receiver out of phase */
+    receivers[1].idleEvents = params->meanPacketSize / 2;
+
+    for (i = 0; (NULL != pTraffic) && (i < params->events); i++)
+    {
+        /* Place the trigger in the middle of the recording */
+        pTraffic[i].time = ((long long)i - (long long)(params->events / 2)) * SYNTHETIC_TICKS_PER_EVENT;
+        pTraffic[i].linkAEvent = nextEvent(params, &receivers[0], &random, i);
+        pTraffic[i].linkBEvent = nextEvent(params, &receivers[1], &random, i);
+    }
+
+    return pTraffic;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file synthetic_traffic.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for generating reproducible synthetic traffic
+ *      in the format recorded by the Link Analyser, used for benchmarking.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+/* Capture clock period of the synthetic traffic in seconds */
+#define SYNTHETIC_CLOCK_PERIOD 1e-8
+
+/* Capture clock ticks between two synthetic events (one character at 100 Mbit/s) */
+#define SYNTHETIC_TICKS_PER_EVENT 10
+
+/* Number of events between two time-codes */
+#define SYNTHETIC_TIMECODE_INTERVAL 6400
+
+/* Distributions of the packet length */
+enum sizeDistribution {
+    SIZE_FIXED,             /* All packets have the mean length */
+    SIZE_UNIFORM,           /* Uniformly distributed between 1 and twice the mean length */
+    SIZE_EXPONENTIAL,       /* Exponentially distributed around the mean length */
+    SIZE_BIMODAL            /* Mostly short packets with a few long ones */
+};
+
+/* Names of the packet length distributions */
+static const char *const sizeDistributionNames[] = { "fixed", "uniform", "exponential", "bimodal" };
+
+/* Parameters of a synthetic traffic corpus */
+typedef struct corpusParams
+{
+    const char *name;       /* Name of the corpus */
+    U32 events;             /* Number of events to generate */
+    double utilization;     /* Share of events carrying packet characters on each receiver */
+    int sizeDistribution;   /* Distribution of the packet length (see enum sizeDistribution) */
+    U32 meanPacketSize;     /* Mean packet length in bytes including the header byte */
+    double idleRatio;       /* Share of the events between packets recorded as NULL/FCT instead of no character */
+    double errorRate;       /* Probability of a packet character being hit by a parity error */
+    double faultRate;       /* Probability of a packet character being replaced by a time-code, a header, an error flagged character or an EEP */
+    unsigned int seed;      /* Seed of the pseudo random generator */
+} CorpusParams;
+
+/**
+ * @brief Generates synthetic traffic. The same parameters always produce the same traffic.
+ *      A packet hit by a parity error is terminated with an EEP. A fault within a
+ *      packet is a time-code or header character interrupting it, a data character
+ *      carrying error flags, or an EEP truncating it before its announced length.
+ *
+ * @param params The parameters of the corpus.
+ * @return The generated traffic holding params->events structures, or NULL on failure.
+ */
+STAR_LA_MK3_Traffic *generateTraffic(const CorpusParams *params);
@@ -13,18 +13,133 @@
 
 #define KAFKA_ARGS 7
 
+typedef struct packetFilter PacketFilter;
+typedef struct pairingRules PairingRules;
+typedef struct searchPatterns SearchPatterns;
+
+/* Maximum number of stages in a trigger sequence */
+#define MAX_TRIGGER_STAGES 8
+
+/* Keys for options without a short form */
+enum longOptionKeys {
+    KEY_TRIG_DELAY = 256,
+    KEY_POST_TRIG,
+    KEY_STATS,
+    KEY_METRICS,
+    KEY_EVENT_LOG,
+    KEY_RAW,
+    KEY_FSYNC,
+    KEY_ROTATE_SIZE,
+    KEY_ROTATE_TIME,
+    KEY_FILTER,
+    KEY_EXCLUDE,
+    KEY_COLLAPSE,
+    KEY_SUMMARY,
+    KEY_ERRORS,
+    KEY_ERROR_CONTEXT,
+    KEY_TIMECODES,
+    KEY_LATENCY,
+    KEY_PAIR,
+    KEY_PAIR_TIMEOUT,
+    KEY_SEARCH,
+    KEY_DIFF,
+    KEY_DIFF_TOLERANCE,
+    KEY_COLUMNS,
+    KEY_PCAPNG,
+    KEY_DEDUP
+};
+
+/* Events a stage of the trigger sequence can fire on */
+enum triggerEvents {
+    TRIG_EVENT_HEADER,
+    TRIG_EVENT_DATA,
+    TRIG_EVENT_EOP,
+    TRIG_EVENT_EEP,
+    TRIG_EVENT_FCT,
+    TRIG_EVENT_TIMECODE,
+    TRIG_EVENT_NULL
+};
+
+/* Names of the trigger events as used in the trigger option */
+static const char *const triggerEventNames[] = {
+    "header", "data", "eop", "eep", "fct", "timecode", "null"
+};
+
+/* Event types the event log can leave out */
+enum logEventTypes {
+    LOG_EVENT_HEADER,
+    LOG_EVENT_DATA,
+    LOG_EVENT_EOP,
+    LOG_EVENT_EEP,
+    LOG_EVENT_FCT,
+    LOG_EVENT_TIMECODE,
+    LOG_EVENT_NULL,
+    LOG_EVENT_NCHAR,
+    LOG_EVENT_GOT_BIT
+};
+
+/* Names of the event types as used in the exclude option */
+static const char *const logEventNames[] = {
+    "header", "data", "eop", "eep", "fct", "timecode", "null", "nochar", "gotbit"
+};
+
+/* A single stage of the trigger sequence */
+typedef struct triggerStage {
+    char  recv;                 /* Receiver to fire on (A=0, B=1) */
+    char  event;                /* Event to fire on (see enum triggerEvents) */
+    unsigned char value;        /* Character value to match */
+    unsigned short repeat;      /* Number of matching events needed to complete the stage */
+} TriggerStage;
+
 /* Saves configuration according to input arguments */
 typedef struct settings {
     char *args[2];              /* Serial number & record duration */
+    char *inputFile;            /* Raw capture or hexdump to read instead of recording (NULL = record) */
     char *version;              /* Version of this software */
     char  enNull;               /* Enable recording NULLs */
     char  enFCT;                /* Enable recording FCTs */
     char  enTimecode;           /* Enable recording Timecodes */
     char  enNChar;              /* Enable recording NChars */
+    char  headerOnly;           /* Record only the packet headers */
     char  trigFCT;              /* Enable trigger on FCT */
     char  recv;                 /* Receiver to trigger on (A=0, B=1) */
     int   preTrigger;           /* Maximum displayed record duration in ms before the trigger */
+    char *trigSpec;             /* Trigger sequence as passed to the trigger option */
+    TriggerStage trigStages[MAX_TRIGGER_STAGES]; /* Stages of the trigger sequence */
+    int   trigStageCount;       /* Number of stages in the trigger sequence (0 = single stage from trigFCT/recv) */
+    unsigned int trigDelay;     /* Delay of the trigger after the sequence completed */
+    int   postTrigMemory;       /* Percentage of device memory used for events after the trigger */
     char  verbose;              /* Print readable event based capture logs */
+    char *logExcludeSpec;       /* Event log exclusions as passed to the exclude option */
+    unsigned int logExclude[2]; /* Event types left out of the event log per receiver (bit = enum logEventTypes) */
+    char  collapseIdle;         /* Collapse runs of identical idle rows of the event log */
+    int   jobs;                 /* Number of threads formatting the packets */
+    char *statsFile;            /* File to write the JSON report of timings and counters to */
+    char *summaryFile;          /* File to write the JSON summary of the capture to (NULL = no summary) */
+    char *timecodeFile;         /* File to write the JSON time-code analysis to (NULL = no analysis) */
+    char *latencyFile;          /* File to write the JSON transaction latencies to (NULL = no pairing) */
+    char *pairSpec;             /* Pairing rules as passed to the pair option */
+    PairingRules *pairRules;    /* Compiled pairing rules */
+    double pairTimeout;         /* Seconds after which a request is no longer answered */
+    char *searchSpec;           /* Search patterns as passed to the search option */
+    SearchPatterns *searchPatterns; /* Compiled search patterns (NULL = no search) */
+    char *diffFile;             /* Raw capture to compare the capture against (NULL = no diff) */
+    double diffTolerance;       /* Seconds a matching packet may be shifted without being reported */
+    char *metricsTarget;        /* Port or textfile to export live metrics to */
+    char *outputFile;           /* File to write the hexdump or event log to instead of stdout */
+    char *eventLogFile;         /* File to write the event log to */
+    char *rawFile;              /* File to write the binary capture to */
+    char *columnsDir;           /* Directory to export the event and packet columns to */
+    char *pcapngTarget;         /* Named pipe or file to stream the packets to in the PCAPNG format */
+    char *errorLogFile;         /* File to write the error events with their context to */
+    unsigned int errorContext;  /* Number of events printed before and after each error */
+    double errorContextTime;    /* Capture time in seconds printed before and after each error (0 = use errorContext) */
+    int   fsyncPolicy;          /* Points at which output files are synchronized (see enum fsyncPolicy) */
+    int   compressLevel;        /* Level of the gzip compression of the outputs (0 = uncompressed) */
+    unsigned long long rotateSize; /* Bytes of data after which output files are rotated (0 = unlimited) */
+    double rotateTime;          /* Seconds of capture time after which output files are rotated (0 = unlimited) */
+    char *filterSpec;           /* Packet filter expression as passed to the filter option */
+    PacketFilter *filter;       /* Compiled packet filter (NULL = all packets) */
     char *kafka_topic;          /* Kafka topic to archive data to */
 	char *kafka_testId;         /* String of the current test ID */
 	char *kafka_testVersion;    /* String of the current test version */
@@ -32,6 +147,7 @@ typedef struct settings {
     char *kafka_interfaceIdOut;  /* Name of the interface on receiver B */
 	char *kafka_dbVersion;      /* String of the current database version */
 	char *kafka_aswVersion;      /* String of the current database version */
+    double archiveDedup;        /* Seconds of capture time after which a repeated packet is archived in full again (0 = no deduplication) */
 } Settings;
 
 
@@ -47,17 +163,76 @@ static const char doc[] = "Software for recording SpaceWire traffic\v"
                     "of the Link Analyser.";
 
 /* A description of the arguments we accept */
-static const char args_doc[] = "SERIAL_NO SECONDS";
+static const char args_doc[] = "SERIAL_NO SECONDS\n-i FILE";
 
 /* Available options */
 static struct argp_option options[] = {
     {"chars",   'c', "EN_CHARS",    0,  "Which characters to record, given as 4-bit value (0-15)"},
     {"trigfct", 'f', 0, 0, "Trigger on FCT instead of Timecode" },
     {"receiver", 'r', "RECV", 0, "Which receiver to set the trigger for (A/B)"},
+    {"trigger", 't', "'STAGE[,STAGE...]'", 0, "Multi-stage trigger sequence, each stage given as"
+                                    " RECV:EVENT[=VALUE][*REPEAT] with EVENT being one of header, data,"
+                                    " eop, eep, fct, timecode or null (overrides -f and -r)"},
+    {"trigdelay", KEY_TRIG_DELAY, "DELAY", 0, "Delay of the trigger after the trigger sequence completed"},
+    {"posttrigmem", KEY_POST_TRIG, "PERCENT", 0, "Percentage of the device memory used for events recorded"
+                                    " AFTER the trigger (the remainder holds events before the trigger)"},
     {"pretrigger", 'p', "MILLIS", 0, "Maximum record duration in milliseconds to display"
                                     " BEFORE the device was triggered"},
     {"verbose", 'v', 0, 0, "Write readable event based capture logs instead of packet based hexdumps"},
+    {"output", 'o', "FILE", 0, "Write the hexdump (or the event log with -v) to FILE instead of stdout"},
+    {"eventlog", KEY_EVENT_LOG, "FILE", 0, "Additionally write the event based capture log to FILE"},
+    {"exclude", KEY_EXCLUDE, "SPEC", 0, "Leave events out of the event log, with SPEC given as comma separated"
+                                    " RECV:TYPE with RECV being a, b or * for both and TYPE being one of header,"
+                                    " data, eop, eep, fct, timecode, null, nochar or gotbit"},
+    {"collapse", KEY_COLLAPSE, 0, 0, "Collapse runs of identical idle rows (NULL, FCT, no character) of the"
+                                    " event log into a single row"},
+    {"errors", KEY_ERRORS, "FILE", 0, "Additionally write every error event with its context and the packets it hit to FILE"},
+    {"error-context", KEY_ERROR_CONTEXT, "N[us]", 0, "Number of events, or microseconds with the suffix us, printed"
+                                    " before and after each error (default 8 events)"},
+    {"raw", KEY_RAW, "FILE", 0, "Additionally write all recorded events in the binary capture format to FILE"},
+    {"columns", KEY_COLUMNS, "DIR", 0, "Additionally export the events and packets as little-endian arrays with a JSON"
+                                    " schema to the directory DIR for numeric analysis"},
+    {"pcapng", KEY_PCAPNG, "FIFO|FILE", 0, "Stream the packets in the PCAPNG format to the named pipe FIFO, e.g. read"
+                                    " live by Wireshark, or to FILE as soon as they are indexed"},
+    {"compress", 'z', "LEVEL", OPTION_ARG_OPTIONAL, "Compress the hexdump, event log and raw capture outputs"
+                                    " with gzip at LEVEL (1-9, default 3) on all processors"},
+    {"fsync", KEY_FSYNC, "POLICY", 0, "Synchronize output files to the disk never (none), when closing them"
+                                    " (close) or after each written buffer (buffer)"},
+    {"rotate-size", KEY_ROTATE_SIZE, "BYTES", 0, "Continue the hexdump and event log files in a new numbered"
+                                    " file after BYTES of data before compression, with an optional suffix K, M or G"},
+    {"rotate-time", KEY_ROTATE_TIME, "SECONDS", 0, "Continue the hexdump and event log files in a new numbered"
+                                    " file after SECONDS of capture time"},
+    {"filter", KEY_FILTER, "'EXPR'", 0, "Only index, print and archive the packets matching EXPR, combining"
+                                    " recv a|b, eop, eep, incomplete, timecode, error, len MIN[-MAX], addr VALUE,"
+                                    " proto VALUE, byte OFFSET=VALUE[/MASK] and at OFFSET=HEX with and, or, not"
+                                    " and parentheses"},
+    {"input", 'i', "FILE", 0, "Read a raw capture or import a hexdump from FILE instead of recording, only the"
+                                    " analyses, the search, the diff, the raw capture and the archive are run on it"},
+    {"search", KEY_SEARCH, "PATTERNS", 0, "Print the packets containing any of the byte patterns instead of the"
+                                    " capture log on stdout, with PATTERNS given as semicolon separated"
+                                    " [OFFSET=]HEX[/MASK] (anywhere without OFFSET)"},
+    {"diff", KEY_DIFF, "FILE", 0, "Print the packets removed, inserted, modified or shifted compared to the raw capture or hexdump FILE"
+                                    " instead of the capture log on stdout"},
+    {"diff-tolerance", KEY_DIFF_TOLERANCE, "SECONDS", 0, "Time a matching packet may be shifted relative to the trigger"
+                                    " without being reported by the diff (default 0.001)"},
+    {"jobs", 'j', "N", 0, "Number of threads formatting the packets of the hexdump or searching and hashing them"},
+    {"headeronly", 'H', 0, 0, "Record only the packet headers to extend the possible capture duration"},
+    {"stats", KEY_STATS, "FILE", 0, "Write the duration of each phase and counters of the run as JSON report to FILE"},
+    {"summary", KEY_SUMMARY, "FILE", 0, "Write packet, length, gap, error, utilization and time-code statistics"
+                                    " as JSON to FILE and print them as a table instead of the capture log on stdout"},
+    {"timecodes", KEY_TIMECODES, "FILE", 0, "Write the period, jitter, missing and out of sequence codes of the"
+                                    " time-codes and their delay between the receivers as JSON to FILE"},
+    {"latency", KEY_LATENCY, "FILE", 0, "Pair requests with their responses on the other receiver and write"
+                                    " the latency histogram and unmatched transactions as JSON to FILE"},
+    {"pair", KEY_PAIR, "'RULE[;RULE...]'", 0, "Pairing rules given as RECV:FIELD[,FIELD...]>RECV:FIELD[,FIELD...]"
+                                    " with FIELD being OFFSET[+LENGTH][/MASK] (default RMAP transaction IDs"
+                                    " in both directions)"},
+    {"pair-timeout", KEY_PAIR_TIMEOUT, "SECONDS", 0, "Time after which a request is no longer answered (default 1)"},
+    {"metrics", KEY_METRICS, "PORT|FILE", 0, "Export live metrics in the OpenMetrics text format on 127.0.0.1:PORT"
+                                    " or by replacing FILE every second"},
     {"archive", 'a', "'TOPIC TEST_ID TEST_VERS IF_ID_IN IF_ID_OUT DB_VERS ASW_VERS'", 0, "Archive the captured data to a Kafka TOPIC"},
+    {"dedup", KEY_DEDUP, "SECONDS", 0, "Archive packets repeating an earlier packet of the same interface as references"
+                                    " to its message, archiving them in full again after SECONDS of capture time"},
     { 0 }
 };
 
@@ -0,0 +1,119 @@
+/**
+ * @file capture_diff.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for comparing two captures at packet level, e.g.
+ *      the traffic of a test procedure before and after a software change.
+ *      The packets of both captures are hashed in parallel (64 bit FNV-1a over
+ *      their bytes, termination and error flags) and the sequences
+ *      of each receiver aligned with the linear space diff algorithm of Myers,
+ *      which finds the shortest edit script in O((N+M)D) time for D changes.
+ *      Removed and inserted packets next to each other count as modified, and
+ *      matching packets moved by more than a tolerance relative to the trigger
+ *      as shifted. Time-codes are not compared.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+
+typedef struct eventStore EventStore;
+typedef struct packetIndex PacketIndex;
+
+/* Default tolerance of the timing shift in seconds */
+#define DIFF_DEFAULT_TOLERANCE 0.001
+
+/* Number of diff steps after which the alignment of a section settles for a good, not necessarily shortest, edit script */
+#define DIFF_MAX_COST 256
+
+/* Initial number of changes allocated per receiver */
+#define DIFF_INITIAL_CHANGES 256
+
+/* Index of a packet missing on one side of a change */
+#define DIFF_NO_ENTRY 0xFFFFFFFFu
+
+/* Kinds of changes between the captures */
+enum diffKind {
+    DIFF_REMOVED,               /* Packet only in the reference capture */
+    DIFF_INSERTED,              /* Packet only in the compared capture */
+    DIFF_MODIFIED,              /* Packet replaced by a different one */
+    DIFF_SHIFTED                /* Same packet at a time shifted by more than the tolerance */
+};
+
+/* A single change between the captures */
+typedef struct diffChange
+{
+    U32 oldEntry;               /* Index of the packet in the reference index (DIFF_NO_ENTRY = inserted) */
+    U32 newEntry;               /* Index of the packet in the compared index (DIFF_NO_ENTRY = removed) */
+    U8  kind;                   /* Kind of the change (see enum diffKind) */
+} DiffChange;
+
+/* Changes on a single receiver */
+typedef struct receiverDiff
+{
+    DiffChange *changes;        /* Changes in order of the packets */
+    U32 count;                  /* Number of changes */
+    U32 capacity;               /* Number of allocated changes */
+    U32 oldPackets;             /* Number of packets in the reference capture */
+    U32 newPackets;             /* Number of packets in the compared capture */
+    U32 equal;                  /* Number of matching packets, shifted ones included */
+    U32 kindCount[4];           /* Number of changes of each kind */
+    double maxShift;            /* Largest timing shift of a matching packet in seconds */
+    int failed;                 /* Memory for the alignment could not be allocated */
+} ReceiverDiff;
+
+/* The changes between two captures */
+typedef struct captureDiff
+{
+    ReceiverDiff receivers[2];  /* Changes on receiver A and B */
+    double tolerance;           /* Tolerance of the timing shift in seconds */
+} CaptureDiff;
+
+/**
+ * @brief Compares the packets of a capture with those of a reference capture.
+ *
+ * @param diff The comparison to fill.
+ * @param oldStore The recorded events of the reference capture.
+ * @param oldIndex The packet index of the reference capture.
+ * @param newStore The recorded events of the compared capture.
+ * @param newIndex The packet index of the compared capture.
+ * @param tolerance The tolerance of the timing shift in seconds.
+ * @param jobs The number of threads hashing the packets.
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_diffCaptures(CaptureDiff *diff, const EventStore *oldStore, const PacketIndex *oldIndex, const EventStore *newStore,
+                        const PacketIndex *newIndex, double tolerance, int jobs);
+
+/**
+ * @brief Prints the changes with the record numbers of both captures, the
+ *      direction, timestamp, length and termination of the packets and the
+ *      timing shift.
+ *
+ * @param stream The stream to print to.
+ * @param diff The comparison.
+ * @param oldStore The recorded events of the reference capture.
+ * @param oldIndex The packet index of the reference capture.
+ * @param oldTriggerTime The trigger timestamp of the reference capture.
+ * @param newStore The recorded events of the compared capture.
+ * @param newIndex The packet index of the compared capture.
+ * @param newTriggerTime The trigger timestamp of the compared capture.
+ * @return The number of characters printed.
+ */
+unsigned long long printCaptureDiff(FILE *stream, const CaptureDiff *diff, const EventStore *oldStore, const PacketIndex *oldIndex,
+                                    struct timespec *oldTriggerTime, const EventStore *newStore, const PacketIndex *newIndex,
+                                    struct timespec *newTriggerTime);
+
+/**
+ * @brief Prints the number of packets and changes per receiver as a table.
+ *
+ * @param stream The stream to print to.
+ * @param diff The comparison.
+ */
+void printDiffTable(FILE *stream, const CaptureDiff *diff);
+
+/**
+ * @brief Frees the memory held by a comparison.
+ *
+ * @param diff The comparison.
+ */
+void freeCaptureDiff(CaptureDiff *diff);
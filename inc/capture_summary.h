@@ -0,0 +1,114 @@
+/**
+ * @file capture_summary.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for summarizing a capture in a single pass over
+ *      the packet index: packets and bytes per receiver, packet length and
+ *      inter-packet gap histograms, error counts, link utilization over time
+ *      and the time-code cadence. All histograms have a fixed size, so nothing
+ *      is allocated per packet. The summary is written as JSON report and
+ *      printed as a readable table.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+
+typedef struct settings Settings;
+typedef struct eventStore EventStore;
+typedef struct packetIndex PacketIndex;
+
+/* Number of packet length buckets, bucket k holding 2^k to 2^(k+1)-1 bytes */
+#define SUMMARY_LENGTH_BUCKETS 33
+
+/* Number of inter-packet gap buckets, split by a 1-2-5 series from 10ns to 50s */
+#define SUMMARY_GAP_BUCKETS 31
+
+/* Number of equally long time bins the link utilization is measured in */
+#define SUMMARY_TIME_BINS 50
+
+/* Number of error flags of an indexed packet (see PACKET_ERROR_*) */
+#define SUMMARY_PACKET_ERRORS 6
+
+/* Names of the packet error flags as used in the report */
+static const char *const summaryPacketErrorNames[] = {
+    "parity", "rx_credit", "tx_credit", "sequence", "escape", "disconnect"
+};
+
+/* Range of a series of time differences in seconds */
+typedef struct summaryInterval
+{
+    unsigned long long count;   /* Number of differences */
+    double min;                 /* Shortest difference */
+    double max;                 /* Longest difference */
+    double sum;                 /* Sum of the differences */
+    double sumSquares;          /* Sum of the squared differences */
+} SummaryInterval;
+
+/* Statistics of the traffic on a single receiver */
+typedef struct receiverSummary
+{
+    unsigned long long packets;     /* Number of packets */
+    unsigned long long bytes;       /* Number of packet bytes */
+    unsigned long long eop;         /* Packets terminated by an EOP */
+    unsigned long long eep;         /* Packets terminated by an EEP */
+    unsigned long long incomplete;  /* Packets not terminated before the end of recording */
+    U32 minLength;                  /* Length of the shortest packet */
+    U32 maxLength;                  /* Length of the longest packet */
+    unsigned long long lengths[SUMMARY_LENGTH_BUCKETS]; /* Histogram of the packet lengths */
+    SummaryInterval gap;            /* Gaps between the end of a packet and the header of the next */
+    unsigned long long gaps[SUMMARY_GAP_BUCKETS]; /* Histogram of the gaps */
+    unsigned long long packetErrors[SUMMARY_PACKET_ERRORS]; /* Packets with each error flag */
+    unsigned long long parityErrors;    /* Events with a parity error */
+    unsigned long long rxCreditErrors;  /* Events with a receiver credit error */
+    unsigned long long txCreditErrors;  /* Events with a transmitter credit error */
+    unsigned long long timecodes;   /* Number of time-codes */
+    SummaryInterval timecodeInterval; /* Intervals between consecutive time-codes */
+    unsigned long long timecodeSkips; /* Time-codes not following on the value of the previous one */
+    unsigned long long binBytes[SUMMARY_TIME_BINS]; /* Packet bytes per time bin */
+    long long lastEnd;              /* Capture clock tick of the end of the previous packet */
+    long long lastTimecode;         /* Capture clock tick of the previous time-code */
+    U8  lastTimecodeValue;          /* Value of the previous time-code */
+    char hasPacket;                 /* A previous packet has been summarized */
+    char hasTimecode;               /* A previous time-code has been summarized */
+} ReceiverSummary;
+
+/* Statistics of a capture */
+typedef struct captureSummary
+{
+    double clockPeriod;             /* The character capture clock period */
+    long long startTime;            /* Capture clock tick of the first event within the pre trigger duration */
+    long long endTime;              /* Capture clock tick of the last event */
+    double binSeconds;              /* Duration of a time bin */
+    unsigned long long filtered;    /* Packets and time-codes rejected by the packet filter */
+    ReceiverSummary receivers[2];   /* Statistics of receiver A and B */
+} CaptureSummary;
+
+/**
+ * @brief Summarizes the indexed packets and the error flags of the events
+ *      within the pre trigger duration in a single pass.
+ *
+ * @param summary The summary to fill.
+ * @param store The recorded events.
+ * @param index The packet index.
+ */
+void LA_MK3_summarizeCapture(CaptureSummary *summary, const EventStore *store, const PacketIndex *index);
+
+/**
+ * @brief Writes the summary as JSON report.
+ *
+ * @param fileName The file to write the report to.
+ * @param summary The summary.
+ * @param settings The application settings as configured by the input arguments.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @return A non-zero integer on success.
+ */
+int writeSummaryReport(const char *fileName, const CaptureSummary *summary, Settings settings, struct timespec *triggerTime);
+
+/**
+ * @brief Prints the summary as a readable table.
+ *
+ * @param stream The stream to print to.
+ * @param summary The summary.
+ */
+void printSummaryTable(FILE *stream, const CaptureSummary *summary);
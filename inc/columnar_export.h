@@ -0,0 +1,46 @@
+/**
+ * @file columnar_export.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for exporting the recorded events and the packet
+ *      index as columns for numeric analysis. Every column is written to its
+ *      own file as a plain little-endian array without header, so it can be
+ *      memory-mapped directly (e.g. with numpy.memmap). A JSON schema lists the
+ *      columns with their element types and lengths, the clock period and
+ *      trigger time, and the codes of the event types, error flags,
+ *      terminations and RMAP flags. The schema is written last and marks a
+ *      complete export.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <time.h>
+
+typedef struct eventStore EventStore;
+typedef struct packetIndex PacketIndex;
+
+/* Version of the layout of the exported columns */
+#define COLUMNS_FORMAT_VERSION 1
+
+/* Number of rows encoded at once */
+#define COLUMNS_BLOCK_ROWS 65536
+
+/* Name of the schema file in the export directory */
+#define COLUMNS_SCHEMA_FILE "schema.json"
+
+/* Extension of the column files */
+#define COLUMNS_FILE_EXTENSION ".bin"
+
+/**
+ * @brief Exports the events within the pre trigger duration and the indexed
+ *      packets as columns to a directory, which is created if necessary.
+ *
+ * @param directory The directory to write the column files and the schema to.
+ * @param store The recorded events.
+ * @param index The packet index of the recorded events.
+ * @param settings The application settings as configured by the input arguments.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_exportColumns(const char *directory, const EventStore *store, const PacketIndex *index, Settings settings,
+                         struct timespec *triggerTime);
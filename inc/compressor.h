@@ -0,0 +1,53 @@
+/**
+ * @file compressor.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains a streaming gzip compressor for the output sinks. The data is
+ *      cut into frames, which a pool of worker threads compresses in parallel
+ *      into independent gzip members written in order. Any gzip tool reads the
+ *      concatenated members as a single stream. Each member carries its own size
+ *      in the extra field of its header (subfield 'S' 'P', like the BGZF blocks of
+ *      samtools), so a reader can hop from member to member to jump into the
+ *      middle of a capture without decompressing what lies before:
+ *
+ *      Member header (COMPRESS_HEADER_SIZE bytes):
+ *        0  1F 8B 08 04 (gzip, deflate, FEXTRA)   4  mtime, XFL and OS
+ *        10 XLEN = 12 (u16)                       12 'S' 'P' and LEN = 8 (u16)
+ *        16 size of the whole member (u32)        20 uncompressed size (u32)
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+
+/* Uncompressed size of a frame in bytes */
+#define COMPRESS_FRAME_SIZE (1024 * 1024)
+
+/* Maximum number of compressing worker threads */
+#define COMPRESS_MAX_WORKERS 8
+
+/* Number of frames per worker, so that workers stay busy while frames are written */
+#define COMPRESS_FRAMES_PER_WORKER 2
+
+/* Size of the gzip member header in bytes */
+#define COMPRESS_HEADER_SIZE 24
+
+/* Size of the gzip member trailer (CRC-32 and uncompressed size) in bytes */
+#define COMPRESS_TRAILER_SIZE 8
+
+/* Default compression level, which keeps up with formatting */
+#define COMPRESS_DEFAULT_LEVEL 3
+
+/* Expected compression ratio of the text outputs for preallocating files */
+#define COMPRESS_EXPECTED_RATIO 4
+
+/**
+ * @brief Opens a stream compressing its data into gzip members written to another stream.
+ *
+ * @param sink The stream to write the compressed data to.
+ * @param level The zlib compression level (1-9).
+ * @param closeSink Non-zero, if the sink is to be closed together with the stream.
+ * @return The compressing stream or NULL on failure. Closing the stream with
+ *      fclose() compresses and writes the remaining data and reports errors.
+ */
+FILE *compressOpen(FILE *sink, int level, int closeSink);
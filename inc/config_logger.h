@@ -2,60 +2,67 @@
  * @file config_logger.h
  * @author Jonas Gesch (jonas.gesch@dlr.de)
  * @brief Contains functions for writing the configuration of the software and
- *      additional info regarding the Link Analyser to stdout so that it can be
+ *      additional info regarding the Link Analyser to a stream so that it can be
  *      used as a hexdump header.
  * @version 0.4.0
  * @date 2022-03-23
  *
  */
+#include <stdio.h>
 #include <time.h>
 #include <spw_la_api.h>
 
 typedef struct settings Settings;
 
 /**
- * @brief Prints the settings as configured by the input arguments to stdout.
+ * @brief Prints the settings as configured by the input arguments.
  *
+ * @param stream The stream to print to.
  * @param settings The settings struct to be printed.
  */
-void printConfig(Settings settings);
+void printConfig(FILE *stream, Settings settings);
 
 /**
  * @brief Prints the build date of a Link Analyser device.
  *
+ * @param stream The stream to print to.
  * @param linkAnalyser The Link Analyser to print the build date for.
  * @return A non-zero integer on success.
  */
-int LA_printBuildDate(STAR_LA_LinkAnalyser linkAnalyser);
+int LA_printBuildDate(FILE *stream, STAR_LA_LinkAnalyser linkAnalyser);
 
 /**
  * @brief Prints all available information for a Link Analyzer device.
  *
+ * @param stream The stream to print to.
  * @param linkAnalyser The Link Analyser device to print the information for.
  * @return A non-zero integer on success.
  */
-int LA_printInfo(STAR_LA_LinkAnalyser linkAnalyser);
+int LA_printInfo(FILE *stream, STAR_LA_LinkAnalyser linkAnalyser);
 
 /**
  * @brief Prints the SpaceWire Link Analyser API version.
  *
+ * @param stream The stream to print to.
  */
-void LA_printApiVersion(void);
+void LA_printApiVersion(FILE *stream);
 
 /**
  * @brief Prints the version information for the specified Link Analyser device.
  *
+ * @param stream The stream to print to.
  * @param linkAnalyser The Link Analyser device to print the version information for.
  * @return A non-zero integer on success.
  */
-int LA_printDeviceVersion(STAR_LA_LinkAnalyser linkAnalyser);
+int LA_printDeviceVersion(FILE *stream, STAR_LA_LinkAnalyser linkAnalyser);
 
 /**
  * @brief Prints the name, version info and author of a module, if available.
  *
+ * @param stream The stream to print to.
  * @param firmwareVersion Struct which stores the module info.
  */
-void printFirmwareVersion(STAR_VERSION_INFO *firmwareVersion);
+void printFirmwareVersion(FILE *stream, STAR_VERSION_INFO *firmwareVersion);
 
 /**
  * @brief Creates a formatted string for a timestamp.
@@ -67,11 +74,12 @@ void printFirmwareVersion(STAR_VERSION_INFO *firmwareVersion);
 int timeToStr(struct timespec *timestamp, char *timeString);
 
 /**
- * @brief Prints meta data of the recording to stdout.
+ * @brief Prints meta data of the recording.
  *
+ * @param stream The stream to print to.
  * @param triggerTime The timestamp of when the trigger occurred.
  * @param settings The settings as configured by the input arguments.
  * @param linkAnalyser The Link Analyzer device used to record data.
  * @return A non-zero integer on success.
  */
-int printConfigHeader(struct timespec *triggerTime, Settings settings, STAR_LA_LinkAnalyser linkAnalyser);
+int printConfigHeader(FILE *stream, struct timespec *triggerTime, Settings settings, STAR_LA_LinkAnalyser linkAnalyser);
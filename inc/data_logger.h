@@ -14,14 +14,22 @@
 /* Amount of payload bytes to be displayed per line */
 #define BYTES_PER_LINE 8
 
-/* A single data packet for an individual receiver */
-struct dataPacket
-{
-    U32 bytesReceived;       /* The number of bytes currently received */
-    STAR_LA_MK3_Event event; /* The current type of event on the receiver */
-    FILE *packetStream;      /* The file to write the packet's data to */
-    char direction;          /* The direction of traffic (Recv A = 'I'; Recv B = 'O') */
-};
+/* Number of index entries formatted at once by each thread */
+#define FORMAT_BLOCK_ENTRIES 1024
+
+/* Estimates for preallocating output files: size of the config header,
+characters per packet besides its bytes and characters per event log line */
+#define OUTPUT_HEADER_SIZE 2048
+#define OUTPUT_PACKET_OVERHEAD 48
+#define OUTPUT_EVENT_LINE 112
+
+/* Column titles of the event log, repeated in every rotated file */
+#define EVENT_LOG_TITLE "Index   Time            Event A Type        Event A Data    Error        Event B Type        Event B Data    Error\n"
+
+typedef struct eventStore EventStore;
+typedef struct packetEntry PacketEntry;
+typedef struct packetIndex PacketIndex;
+typedef struct outputFile OutputFile;
 
 /**
  * @brief Returns the STAR_LA_MK3_Event type as a string
@@ -31,6 +39,25 @@ struct dataPacket
  */
 char *GetEventTypeString(U8 trafficType);
 
+/**
+ * @brief Returns the error flags of an event as a string
+ *
+ * @param errors The error flags of the event on a single receiver
+ * @return The most severe error flag as a string
+ */
+char *GetErrorString(U8 errors);
+
+/**
+ * @brief Prints a single event of both receivers as a row of the event log.
+ *
+ * @param stream The stream to print the row to.
+ * @param store The recorded events.
+ * @param event The index of the event.
+ * @param time The time of the event relative to the trigger in milliseconds.
+ * @return The number of characters printed.
+ */
+int LA_MK3_printEvent(FILE *stream, const EventStore *store, U32 event, double time);
+
 /**
  * @brief Gets the absolute timestamp of a packet as a formatted string.
  *
@@ -42,45 +69,66 @@ char *GetEventTypeString(U8 trafficType);
 int LA_MK3_getPacketTimestamp(const double *deltaToTrigger, struct timespec *triggerTime, char *timeString);
 
 /**
- * @brief Checks the event of a receiver and acts accordingly
+ * @brief Prints a single indexed packet or time-code in the hexdump format.
  *
- * @param packet The struct for the receiver.
- * @param deltaToTrigger The time difference between the trigger and the current packet in seconds.
- * @param triggerTime The timestamp at which the Link Analyser device was triggered.
- * @return The amount of bytes in the packet, if the packet was terminated. Otherwise zero.
+ * @param stream The stream to print the packet to.
+ * @param entry The indexed packet.
+ * @param store The recorded events.
+ * @param buffer A buffer holding at least entry->length bytes for gathering the packet data.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @param headerOnly Non-zero, if only the packet headers have been recorded.
+ * @return The number of characters printed.
  */
-unsigned int LA_MK3_printByte(struct dataPacket *packet, const double *deltaToTrigger, struct timespec *triggerTime);
+int LA_MK3_printPacket(FILE *stream, const PacketEntry *entry, const EventStore *store, U8 *buffer, struct timespec *triggerTime, const char headerOnly);
 
 /**
- * @brief Prints the captured data in a packet based hexdump format.
+ * @brief Prints the indexed packets in a packet based hexdump format.
+ *      The output may be rotated between any two packets.
  *
- * @param pTraffic The address where the recorded traffic is read from.
- * @param trafficCount The number of STAR_LA_Traffic structures.
- * @param charCaptureClockPeriod The character capture clock period.
+ * @param output The output to print the hexdump to.
+ * @param store The recorded events.
+ * @param index The packet index of the recorded events.
  * @param triggerTime The timestamp of when the trigger occurred.
- * @param preTrigger The maximum duration for which packets received BEFORE the trigger are displayed.
+ * @param headerOnly Non-zero, if only the packet headers have been recorded.
+ * @param jobs The number of threads formatting the packets.
+ * @return The number of characters printed.
  */
-void LA_MK3_printHexdumpData(STAR_LA_MK3_Traffic *pTraffic, const U32 *trafficCount, const double *charCaptureClockPeriod, struct timespec *triggerTime, const int preTrigger);
+unsigned long long LA_MK3_printHexdumpData(OutputFile *output, const EventStore *store, PacketIndex *index, struct timespec *triggerTime, const char headerOnly, const int jobs);
 
 /**
- * @brief Prints the configuration data and captured data as a hexdump.
+ * @brief Prints the configuration data and captured data as a hexdump or event log
+ *      to stdout or the output file and writes the event log and raw capture files.
  *
  * @param linkAnalyser The Link Analyser device used for capturing the data traffic.
- * @param pTraffic The address where the recorded traffic is read from.
+ * @param store The recorded events.
+ * @param index The packet index of the recorded events.
+ * @param settings The application settings as configured by the input arguments.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_printRecordedTraffic(STAR_LA_LinkAnalyser linkAnalyser, const EventStore *store, PacketIndex *index, Settings settings, struct timespec *triggerTime);
+
+/**
+ * @brief Writes all events in the binary capture format to the raw capture
+ *      file, which is never rotated.
+ *
+ * @param store The recorded events.
  * @param settings The application settings as configured by the input arguments.
- * @param trafficCount The number of STAR_LA_Traffic structures.
- * @param charCaptureClockPeriod The character capture clock period.
  * @param triggerTime The timestamp of when the trigger occurred.
  * @return A non-zero integer on success.
  */
-int LA_MK3_printRecordedTraffic(STAR_LA_LinkAnalyser linkAnalyser, STAR_LA_MK3_Traffic *pTraffic, Settings settings, const U32 *trafficCount, const double *charCaptureClockPeriod, struct timespec *triggerTime);
+int LA_MK3_saveRawCapture(const EventStore *store, Settings settings, struct timespec *triggerTime);
 
 /**
- * @brief Prints previously recorded event based traffic.
+ * @brief Prints previously recorded event based traffic. The column titles
+ *      (EVENT_LOG_TITLE) are part of the header of the output. The output may
+ *      be rotated at events outside the packets of both receivers.
  *
- * @param pTraffic The address where the recorded traffic is read from.
- * @param trafficCount The number of STAR_LA_Traffic structures.
- * @param charCaptureClockPeriod The character capture clock period.
+ * @param output The output to print the capture log to.
+ * @param store The recorded events.
  * @param preTrigger The maximum duration for which packets received BEFORE the trigger are displayed.
+ * @param exclude The event types left out on receiver A and B (bit = enum logEventTypes, NULL = none).
+ * @param collapse Non-zero, if runs of identical idle rows are collapsed into a single row.
+ * @return The number of characters printed.
  */
-void LA_MK3_printEventCaptureLog(STAR_LA_MK3_Traffic *pTraffic, const U32 *trafficCount, const double *charCaptureClockPeriod, const int preTrigger);
+unsigned long long LA_MK3_printEventCaptureLog(OutputFile *output, const EventStore *store, const int preTrigger, const unsigned int *exclude, const char collapse);
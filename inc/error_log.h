@@ -0,0 +1,40 @@
+/**
+ * @file error_log.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for extracting the error events of a capture.
+ *      Events with parity or credit error flags and sequence, parity, escape
+ *      and disconnect error events on either receiver are found in a single
+ *      pass and printed with the surrounding events of both receivers in the
+ *      format of the event log. Each error references the packets it hit by
+ *      their record number in the hexdump, so link faults can be triaged
+ *      without reading the whole event log.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+typedef struct eventStore EventStore;
+typedef struct packetIndex PacketIndex;
+typedef struct outputFile OutputFile;
+
+/* Default number of events printed before and after each error */
+#define ERROR_DEFAULT_CONTEXT 8
+
+/* Column titles of the error log */
+#define ERROR_LOG_TITLE "  Index   Time            Event A Type        Event A Data    Error        Event B Type        Event B Data    Error\n"
+
+/**
+ * @brief Prints every error event within the pre trigger duration together with
+ *      its context. Errors whose context overlaps are printed in a single block,
+ *      in which every error event is marked with '>' and followed by the packets it hit.
+ *
+ * @param output The output to print the error log to.
+ * @param store The recorded events.
+ * @param index The packet index of the recorded events.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @param contextEvents The number of events printed before and after each error (ignored if contextTime is set).
+ * @param contextTime The capture time in seconds printed before and after each error (0 = use contextEvents).
+ * @return The number of characters printed.
+ */
+unsigned long long LA_MK3_printErrorLog(OutputFile *output, const EventStore *store, const PacketIndex *index, struct timespec *triggerTime,
+                                        unsigned int contextEvents, double contextTime);
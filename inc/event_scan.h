@@ -0,0 +1,111 @@
+/**
+ * @file event_scan.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains vectorized kernels (SSE2/AVX2 with a scalar fallback) for
+ *      scanning the event type columns of the event store, skipping idle
+ *      events and locating packet boundaries, for searching packet bytes and
+ *      for decoding the bytes of hexdumps.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+/* Instruction sets the scan kernels can use */
+enum scanLevel {
+    SCAN_LEVEL_SCALAR,
+    SCAN_LEVEL_SSE2,
+    SCAN_LEVEL_AVX2
+};
+
+/* Names of the scan levels */
+static const char *const scanLevelNames[] = { "scalar", "sse2", "avx2" };
+
+/**
+ * @brief Selects the instruction set used by the scan kernels. By default the
+ *      best level supported by the CPU is used.
+ *
+ * @param level The requested level (see enum scanLevel).
+ * @return The level in use, which is lower than requested if the CPU lacks support.
+ */
+int setScanLevel(int level);
+
+/**
+ * @brief Gets the instruction set used by the scan kernels.
+ *
+ * @return The level in use (see enum scanLevel).
+ */
+int getScanLevel(void);
+
+/**
+ * @brief Finds the next event that can start a record on a receiver outside of
+ *      a packet, which is a header or a time-code. All other events are skipped.
+ *
+ * @param types The event types of the receiver.
+ * @param start The index of the first event to check.
+ * @param end The index following the last event to check.
+ * @return The index of the found event or end, if there is none.
+ */
+U32 scanPacketStart(const U8 *types, U32 start, U32 end);
+
+/**
+ * @brief Skips the data and idle (NULL, FCT, no character) events within a
+ *      packet, counting the data bytes on the way.
+ *
+ * @param types The event types of the receiver.
+ * @param start The index of the first event to check.
+ * @param end The index following the last event to check.
+ * @param bytes Incremented by the number of skipped data events.
+ * @return The index of the first other event (e.g. EOP, EEP, header, time-code or error) or end, if there is none.
+ */
+U32 scanPacketData(const U8 *types, U32 start, U32 end, U32 *bytes);
+
+/**
+ * @brief Finds the next event with an error type (sequence, parity, escape or
+ *      disconnect error) on a receiver. The error flags of the events are not checked.
+ *
+ * @param types The event types of the receiver.
+ * @param start The index of the first event to check.
+ * @param end The index following the last event to check.
+ * @return The index of the found event or end, if there is none.
+ */
+U32 scanErrorEvent(const U8 *types, U32 start, U32 end);
+
+/**
+ * @brief Finds the next position in a block of bytes holding a byte value with a
+ *      second value at a fixed distance, locating candidates for a longer pattern.
+ *
+ * @param bytes The bytes, readable up to end - 1 + distance.
+ * @param start The first position to check.
+ * @param end The position following the last position to check.
+ * @param first The value at the position.
+ * @param last The value distance bytes behind the position.
+ * @param distance The distance of the second value.
+ * @return The found position or end, if there is none.
+ */
+U32 scanBytePair(const U8 *bytes, U32 start, U32 end, U8 first, U8 last, U32 distance);
+
+/**
+ * @brief Gathers the header and data bytes of a range of events into a contiguous buffer.
+ *
+ * @param types The event types of the receiver.
+ * @param data The event data of the receiver.
+ * @param start The index of the first event to gather.
+ * @param end The index following the last event to gather.
+ * @param buffer The buffer to write the bytes to.
+ * @param maxLength The maximum number of bytes to write.
+ * @return The number of bytes written to the buffer.
+ */
+U32 gatherPacketData(const U8 *types, const U8 *data, U32 start, U32 end, U8 *buffer, U32 maxLength);
+
+/**
+ * @brief Decodes a run of bytes written as a space followed by two hex digits
+ *      each, as in the data lines of the hexdump. Decoding stops at the first
+ *      character not belonging to such a group, e.g. the end of the line.
+ *
+ * @param text The text starting with the first group.
+ * @param length The number of readable characters, which may extend beyond the groups.
+ * @param bytes The buffer to write the decoded bytes to.
+ * @param maxBytes The maximum number of bytes to decode.
+ * @return The number of decoded bytes.
+ */
+U32 decodeHexBytes(const char *text, size_t length, U8 *bytes, U32 maxBytes);
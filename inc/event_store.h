@@ -0,0 +1,120 @@
+/**
+ * @file event_store.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for converting the recorded traffic into a compact
+ *      columnar event store, so that the traffic buffer of the STAR-API can be
+ *      freed right after the download.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+/* Number of events between two absolute time checkpoints */
+#define STORE_CHECKPOINT_INTERVAL 4096
+
+/* Time delta marking an event whose time is kept in the overflow list */
+#define STORE_DELTA_OVERFLOW 0xFFFFFFFFu
+
+/* Number of events converted before the pages of the traffic holding them are released */
+#define STORE_RELEASE_INTERVAL 65536
+
+/* Receiver indices of the event columns */
+#define RECV_A 0
+#define RECV_B 1
+
+/* Error flags of an event on both receivers */
+typedef struct eventErrors
+{
+    U32 event;      /* Index of the event */
+    U8  errors[2];  /* Error flags of the event on receiver A and B */
+} EventErrors;
+
+/* Absolute time of an event whose delta did not fit into 32 bits */
+typedef struct timeOverflow
+{
+    U32 event;          /* Index of the event */
+    long long time;     /* Capture clock tick of the event */
+} TimeOverflow;
+
+/* The recorded traffic as structure of arrays */
+typedef struct eventStore
+{
+    U32 count;                  /* Number of events */
+    double clockPeriod;         /* The character capture clock period */
+    long long *checkpoints;     /* Capture clock tick of every STORE_CHECKPOINT_INTERVAL-th event */
+    U32 *timeDeltas;            /* Ticks since the previous event */
+    TimeOverflow *overflows;    /* Times of events with a delta of STORE_DELTA_OVERFLOW */
+    U32 overflowCount;          /* Number of overflowing time deltas */
+    U8  *types[2];              /* Event types on receiver A and B */
+    U8  *data[2];               /* Event data on receiver A and B */
+    unsigned long long *errorBitmap; /* One bit per event with error flags on any receiver */
+    EventErrors *errors;        /* Error flags of the events marked in the bitmap */
+    U32 errorCount;             /* Number of events with error flags */
+} EventStore;
+
+/**
+ * @brief Converts the recorded traffic into the columnar event store. The pages of
+ *      the traffic are returned to the system while it is converted, so the
+ *      traffic can only be freed afterwards.
+ *
+ * @param store The event store to fill.
+ * @param pTraffic The address where the recorded traffic is read from.
+ * @param trafficCount The number of STAR_LA_Traffic structures.
+ * @param charCaptureClockPeriod The character capture clock period.
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_convertTraffic(EventStore *store, STAR_LA_MK3_Traffic *pTraffic, const U32 *trafficCount, const double *charCaptureClockPeriod);
+
+/**
+ * @brief Gets the capture clock tick of any event.
+ *
+ * @param store The event store.
+ * @param event The index of the event.
+ * @return The capture clock tick of the event.
+ */
+long long getEventTime(const EventStore *store, U32 event);
+
+/**
+ * @brief Gets the capture clock tick of a later event, starting from an event with known time.
+ *
+ * @param store The event store.
+ * @param fromEvent The index of the event with known time.
+ * @param fromTime The capture clock tick of that event.
+ * @param toEvent The index of the later event.
+ * @return The capture clock tick of the later event.
+ */
+long long advanceEventTime(const EventStore *store, U32 fromEvent, long long fromTime, U32 toEvent);
+
+/**
+ * @brief Gets the error flags of an event on a single receiver.
+ *
+ * @param store The event store.
+ * @param event The index of the event.
+ * @param receiver The receiver (RECV_A or RECV_B).
+ * @return The error flags of the event.
+ */
+U8 getEventErrors(const EventStore *store, U32 event, int receiver);
+
+/**
+ * @brief Frees the memory held by an event store.
+ *
+ * @param store The event store to free.
+ */
+void freeEventStore(EventStore *store);
+
+/**
+ * @brief Gets the capture clock tick of an event while iterating the events in order.
+ *
+ * @param store The event store.
+ * @param event The index of the event.
+ * @param previousTime The capture clock tick of the preceding event (ignored for the first event).
+ * @return The capture clock tick of the event.
+ */
+static inline long long getNextEventTime(const EventStore *store, U32 event, long long previousTime)
+{
+    if ((0 == event % STORE_CHECKPOINT_INTERVAL) || (STORE_DELTA_OVERFLOW == store->timeDeltas[event]))
+    {
+        return getEventTime(store, event);
+    }
+    return previousTime + store->timeDeltas[event];
+}
@@ -0,0 +1,48 @@
+/**
+ * @file file_writer.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains an asynchronous file writer for the output sinks. The data is
+ *      collected in large page-aligned buffers, which a writer thread gathers
+ *      into positional writes, so that formatting never waits on the disk as
+ *      long as a free buffer is left. The writer is used through a stdio stream.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+
+/* Size of each buffer handed to the writer thread in bytes */
+#define WRITER_BUFFER_SIZE (4 * 1024 * 1024)
+
+/* Number of buffers cycling between the formatting and the writer thread */
+#define WRITER_BUFFER_COUNT 4
+
+/* Alignment of the buffers, file offsets and direct write sizes in bytes */
+#define WRITER_ALIGNMENT 4096
+
+/* Size of the stdio buffer in front of the writer in bytes */
+#define WRITER_STREAM_BUFFER (64 * 1024)
+
+/* Points at which the written data is synchronized to the disk */
+enum fsyncPolicy {
+    FSYNC_NONE,     /* Leave writing back to the kernel */
+    FSYNC_CLOSE,    /* Synchronize once when closing the file */
+    FSYNC_BUFFER    /* Synchronize after each buffer written */
+};
+
+/* Names of the fsync policies as accepted by the fsync option */
+static const char *const fsyncPolicyNames[] = { "none", "close", "buffer" };
+
+/**
+ * @brief Opens an output file written asynchronously by a writer thread.
+ *      The file is written with direct I/O where the file system supports it.
+ *
+ * @param fileName The file to create or truncate.
+ * @param expectedSize The expected size of the file in bytes, preallocated on
+ *      the disk (0 = no preallocation). The file is truncated to the data written.
+ * @param fsyncPolicy The points at which the data is synchronized to the disk (see enum fsyncPolicy).
+ * @return A stream writing to the file or NULL on failure. Closing the stream with
+ *      fclose() waits for all data to be written and reports write errors.
+ */
+FILE *writerOpen(const char *fileName, unsigned long long expectedSize, int fsyncPolicy);
@@ -0,0 +1,73 @@
+/**
+ * @file hexdump_import.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for importing hexdumps written by this tool, so
+ *      older recordings can be indexed, filtered, analysed, archived and
+ *      converted to the binary capture format like a raw capture. The file is
+ *      memory-mapped (or inflated, if compressed) and parsed in a single
+ *      pass, decoding the data lines with the vectorized hex decoder. The events
+ *      of each packet are rebuilt one capture clock tick apart from the
+ *      timestamp of its header, so the packets keep their start times. Idle
+ *      events, error flags and the terminator (EOP or EEP) of complete packets
+ *      are not part of the hexdump: the packets are imported with an EOP, apart
+ *      from header only packets, which are marked with their terminator and
+ *      duration. Records of a single byte are written like packets of one
+ *      byte: they are imported as time-codes if they continue the time-code
+ *      sequence of their receiver, the others are guessed and counted.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stddef.h>
+#include <time.h>
+
+/* Capture clock period of the Link Analyser Mk3 the hexdumps were recorded with in seconds */
+#define HEXDUMP_CLOCK_PERIOD 10e-9
+
+/* Initial number of records allocated for the import */
+#define HEXDUMP_INITIAL_RECORDS 4096
+
+/* Maximum length of a header or marker line that is evaluated */
+#define HEXDUMP_MAX_LINE 128
+
+/* Counter bits of a time-code, the remaining bits are the control flags */
+#define HEXDUMP_TIMECODE_COUNTER 0x3F
+
+/* A time-code may deviate from the time expected from the time-code period by a fraction of 1/N of the period */
+#define HEXDUMP_TIMECODE_TOLERANCE 16
+
+/* Number of following single byte records searched for the continuation of a time-code sequence */
+#define HEXDUMP_TIMECODE_LOOKAHEAD 4
+
+/**
+ * @brief Parses a hexdump held in memory into the traffic structures of the
+ *      STAR-API, as if it had just been recorded.
+ *
+ * @param text The hexdump.
+ * @param size The size of the hexdump in bytes.
+ * @param name The name of the hexdump used in messages.
+ * @param ppTraffic Set to the imported traffic, which must be freed with free().
+ * @param trafficCount Set to the number of STAR_LA_Traffic structures.
+ * @param charCaptureClockPeriod Set to the character capture clock period.
+ * @param triggerTime Set to the timestamp of when the trigger occurred.
+ * @param headerOnly Set to non-zero, if only the packet headers have been recorded.
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_parseHexdump(const char *text, size_t size, const char *name, STAR_LA_MK3_Traffic **ppTraffic, U32 *trafficCount,
+                        double *charCaptureClockPeriod, struct timespec *triggerTime, char *headerOnly);
+
+/**
+ * @brief Imports a hexdump file, which may be gzip compressed, into the traffic
+ *      structures of the STAR-API, as if it had just been recorded.
+ *
+ * @param fileName The hexdump to import.
+ * @param ppTraffic Set to the imported traffic, which must be freed with free().
+ * @param trafficCount Set to the number of STAR_LA_Traffic structures.
+ * @param charCaptureClockPeriod Set to the character capture clock period.
+ * @param triggerTime Set to the timestamp of when the trigger occurred.
+ * @param headerOnly Set to non-zero, if only the packet headers have been recorded.
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_importHexdump(const char *fileName, STAR_LA_MK3_Traffic **ppTraffic, U32 *trafficCount,
+                         double *charCaptureClockPeriod, struct timespec *triggerTime, char *headerOnly);
@@ -0,0 +1,185 @@
+/**
+ * @file latency_pairing.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for pairing requests on one receiver with their
+ *      responses on the other and measuring the latency in between. Pairing
+ *      rules are compiled once from a specification of the form
+ *
+ *        RECV:FIELD[,FIELD...]>RECV:FIELD[,FIELD...][;RULE...]
+ *
+ *      where the left side selects the receiver and key fields of the requests
+ *      and the right side those of the responses. Each FIELD is given as
+ *      OFFSET[+LENGTH][/MASK], the bytes of all fields forming a key of up to
+ *      8 bytes. E.g. 'a:5+2>b:5+2' pairs RMAP commands on receiver A with the
+ *      replies on receiver B by their transaction ID. Pending requests are held
+ *      in a hash table of fixed size and expire after a timeout, so the memory
+ *      needed does not depend on the length of the capture.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+
+typedef struct settings Settings;
+typedef struct eventStore EventStore;
+typedef struct packetIndex PacketIndex;
+
+/* Maximum number of pairing rules */
+#define PAIR_MAX_RULES 4
+
+/* Maximum number of key fields of a request or response */
+#define PAIR_MAX_FIELDS 4
+
+/* Maximum number of bytes forming a key */
+#define PAIR_MAX_KEY_BYTES 8
+
+/* Maximum number of leading packet bytes the key fields can cover */
+#define PAIR_MAX_BYTES 64
+
+/* Number of slots of the hash table holding the pending requests (power of two) */
+#define PAIR_TABLE_SIZE 4096
+
+/* Maximum number of pending requests, expired requests are removed once it is reached */
+#define PAIR_MAX_PENDING (PAIR_TABLE_SIZE / 4 * 3)
+
+/* Number of latency buckets, bucket k holding 2^k to 2^(k+1)-1 nanoseconds */
+#define PAIR_LATENCY_BUCKETS 40
+
+/* Maximum number of unmatched transactions listed per rule */
+#define PAIR_MAX_LISTED 64
+
+/* Rules used if none are given: RMAP transaction IDs in both directions */
+#define PAIR_DEFAULT_RULES "a:5+2>b:5+2;b:5+2>a:5+2"
+
+/* Default time in seconds after which a request is no longer answered */
+#define PAIR_DEFAULT_TIMEOUT 1.0
+
+/* Reasons for a transaction being unmatched */
+enum unmatchedReason {
+    UNMATCHED_UNANSWERED,       /* Request still pending at the end of the capture */
+    UNMATCHED_TIMEOUT,          /* Request not answered within the timeout */
+    UNMATCHED_SUPERSEDED,       /* Request replaced by a later one with the same key */
+    UNMATCHED_DROPPED,          /* Request not held, because the table was full */
+    UNMATCHED_RESPONSE,         /* Response without a pending request */
+    UNMATCHED_REASONS
+};
+
+/* Names of the reasons as used in the report */
+static const char *const unmatchedReasonNames[] = { "unanswered", "timeout", "superseded", "dropped", "response" };
+
+/* A key field of a request or response */
+typedef struct pairField
+{
+    U8  offset;                 /* Offset of the first byte in the packet */
+    U8  length;                 /* Number of bytes */
+    unsigned long long mask;    /* Mask applied to the bytes read as big-endian value */
+} PairField;
+
+/* The packets of one side of a pairing rule */
+typedef struct pairSide
+{
+    U8  receiver;               /* Receiver the packets are recorded on (A=0, B=1) */
+    U8  fieldCount;             /* Number of key fields */
+    PairField fields[PAIR_MAX_FIELDS]; /* The key fields */
+} PairSide;
+
+/* A rule pairing requests with responses */
+typedef struct pairRule
+{
+    PairSide request;           /* Requests of the rule */
+    PairSide response;          /* Responses of the rule */
+} PairRule;
+
+/* Compiled pairing rules */
+typedef struct pairingRules
+{
+    PairRule rules[PAIR_MAX_RULES]; /* The rules */
+    U8  count;                  /* Number of rules */
+    U32 byteCount;              /* Number of leading packet bytes the key fields cover */
+} PairingRules;
+
+/* A transaction left unmatched */
+typedef struct unmatchedTransaction
+{
+    U32 record;                 /* Record number of the packet in the hexdump */
+    long long time;             /* Capture clock tick of the header of the packet */
+    unsigned long long key;     /* Key of the packet */
+    U8  receiver;               /* Receiver of the packet */
+    U8  reason;                 /* Reason (see enum unmatchedReason) */
+} UnmatchedTransaction;
+
+/* Transactions of a single rule */
+typedef struct ruleLatency
+{
+    U8  requestReceiver;            /* Receiver of the requests */
+    U8  responseReceiver;           /* Receiver of the responses */
+    unsigned long long requests;    /* Number of requests */
+    unsigned long long matched;     /* Number of requests answered within the timeout */
+    unsigned long long unmatched[UNMATCHED_REASONS]; /* Unmatched transactions per reason */
+    double min;                     /* Shortest latency */
+    double max;                     /* Longest latency */
+    double sum;                     /* Sum of the latencies */
+    double sumSquares;              /* Sum of the squared latencies */
+    unsigned long long histogram[PAIR_LATENCY_BUCKETS]; /* Histogram of the latencies */
+    UnmatchedTransaction listed[PAIR_MAX_LISTED]; /* The first unmatched transactions */
+    U32 listedCount;                /* Number of listed unmatched transactions */
+} RuleLatency;
+
+/* Latencies of all rules of a capture */
+typedef struct latencyPairing
+{
+    double clockPeriod;             /* The character capture clock period */
+    double timeout;                 /* Time in seconds after which a request is no longer answered */
+    U8  ruleCount;                  /* Number of rules */
+    RuleLatency rules[PAIR_MAX_RULES]; /* Transactions of each rule */
+    U32 peakPending;                /* Largest number of requests pending at once */
+} LatencyPairing;
+
+/**
+ * @brief Compiles a pairing rule specification.
+ *
+ * @param spec The specification.
+ * @return The compiled rules or NULL, if the specification is invalid.
+ */
+PairingRules *compilePairingRules(const char *spec);
+
+/**
+ * @brief Frees compiled pairing rules.
+ *
+ * @param rules The compiled rules.
+ */
+void freePairingRules(PairingRules *rules);
+
+/**
+ * @brief Pairs the indexed requests and responses in a single pass. The latency
+ *      of a transaction is measured from the end of the request to the header
+ *      of the response. A packet answering a request is never taken as request itself.
+ *
+ * @param pairing The latencies to fill.
+ * @param store The recorded events.
+ * @param index The packet index.
+ * @param rules The compiled pairing rules.
+ * @param timeout Time in seconds after which a request is no longer answered.
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_pairTransactions(LatencyPairing *pairing, const EventStore *store, const PacketIndex *index, const PairingRules *rules, double timeout);
+
+/**
+ * @brief Writes the latencies as JSON report.
+ *
+ * @param fileName The file to write the report to.
+ * @param pairing The latencies.
+ * @param settings The application settings as configured by the input arguments.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @return A non-zero integer on success.
+ */
+int writeLatencyReport(const char *fileName, const LatencyPairing *pairing, Settings settings, struct timespec *triggerTime);
+
+/**
+ * @brief Prints the latencies as a readable table.
+ *
+ * @param stream The stream to print to.
+ * @param pairing The latencies.
+ */
+void printLatencyTable(FILE *stream, const LatencyPairing *pairing);
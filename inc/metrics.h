@@ -0,0 +1,61 @@
+/**
+ * @file metrics.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains a lock-free registry of live metrics and an exporter
+ *      publishing them together with the run statistics as OpenMetrics text,
+ *      either on a local HTTP port or in a regularly replaced textfile.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+
+/* Prefix of all exported metric names */
+#define METRICS_PREFIX "spw_data_rec_"
+
+/* Interval in milliseconds for replacing the metrics textfile */
+#define METRICS_FILE_INTERVAL_MS 1000
+
+/* Timeout in milliseconds for waiting on scrapes, after which the exporter checks for being stopped */
+#define METRICS_POLL_TIMEOUT_MS 250
+
+/* Gauges of the registry */
+enum metricGauge {
+    METRIC_GAUGE_PHASE,             /* Current phase of the run (see enum statsPhase) */
+    METRIC_GAUGE_TRIGGER_STATE,     /* Last trigger state read from the Link Analyser */
+    METRIC_GAUGE_DECODER_BACKLOG,   /* Indexed packets not yet written or archived */
+    METRIC_GAUGE_KAFKA_QUEUE,       /* Messages in the Kafka producer queue */
+    METRIC_GAUGE_STREAM_QUEUE,      /* Buffers queued for the PCAPNG stream */
+    METRIC_GAUGE_COUNT
+};
+
+/**
+ * @brief Sets a gauge of the registry. Safe to call from any thread.
+ *
+ * @param gauge The gauge to set (see enum metricGauge).
+ * @param value The new value.
+ */
+void metricsSetGauge(int gauge, long long value);
+
+/**
+ * @brief Writes all metrics in the OpenMetrics text format.
+ *
+ * @param stream The stream to write the metrics to.
+ * @return A non-zero integer on success.
+ */
+int metricsWrite(FILE *stream);
+
+/**
+ * @brief Starts a thread exporting the metrics until metricsStopExporter() is called.
+ *
+ * @param target A port number to serve the metrics on 127.0.0.1 via HTTP,
+ *      or the path of a textfile to replace periodically.
+ * @return A non-zero integer on success.
+ */
+int metricsStartExporter(const char *target);
+
+/**
+ * @brief Stops the exporter thread. A textfile is written a last time with the final values.
+ */
+void metricsStopExporter(void);
@@ -0,0 +1,123 @@
+/**
+ * @file output_file.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains the output sinks of the capture logs. An output writes to
+ *      stdout or a file and can be rotated into numbered files after a number
+ *      of bytes or a span of capture time. Rotation only happens at packet
+ *      boundaries, every file starts with the same header and files are written
+ *      as NAME.part, which a background thread closes and renames to NAME, so
+ *      formatting continues in the next file right away.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+#include <pthread.h>
+
+/* Number of rotated files waiting to be closed before formatting has to wait */
+#define OUTPUT_PENDING_CLOSES 4
+
+/* Suffix of rotated files while they are written */
+#define OUTPUT_PART_SUFFIX ".part"
+
+typedef struct settings Settings;
+
+/* A file waiting to be closed and renamed by the closer thread */
+struct pendingClose
+{
+    FILE *stream;                   /* Stream of the file */
+    char *partName;                 /* Name of the file while written */
+};
+
+/* An output sink of a capture log */
+typedef struct outputFile
+{
+    FILE *stream;                   /* Stream of the current file */
+    const char *fileName;           /* Name of the output file (NULL = stdout or the attached stream) */
+    int attached;                   /* The stream has been attached by the caller and stays open */
+    unsigned long long maxBytes;    /* Bytes of data after which the file is rotated (0 = unlimited) */
+    long long maxTicks;             /* Capture clock ticks after which the file is rotated (0 = unlimited) */
+    int compressLevel;              /* Level of the gzip compression (0 = uncompressed) */
+    int fsyncPolicy;                /* Points at which the files are synchronized (see enum fsyncPolicy) */
+    unsigned long long expectedSize;/* Expected size of each file for preallocation */
+    const char *header;             /* Header at the start of every file */
+    size_t headerLength;            /* Length of the header in bytes */
+    unsigned long long bytes;       /* Bytes of data written to the current file after the header */
+    long long firstTick;            /* Capture clock tick of the first packet in the current file */
+    int empty;                      /* No packet has been written to the current file yet */
+    unsigned int sequence;          /* Sequence number of the current rotated file */
+    char *partName;                 /* Name of the current rotated file while written */
+    int failed;                     /* Writing one of the files failed */
+    struct pendingClose pending[OUTPUT_PENDING_CLOSES]; /* Files waiting for the closer thread */
+    unsigned int nextPending;       /* First file waiting to be closed */
+    unsigned int pendingCount;      /* Number of files waiting to be closed */
+    int closing;                    /* No further files will be handed to the closer thread */
+    int closerRunning;              /* The closer thread has been started */
+    pthread_mutex_t lock;           /* Protects the pending files and the failed flag */
+    pthread_cond_t pendingCond;     /* Signals a pending file to the closer thread */
+    pthread_cond_t closedCond;      /* Signals a closed file to the formatting thread */
+    pthread_t closer;               /* Thread closing and renaming the rotated files */
+} OutputFile;
+
+/**
+ * @brief Opens an output for a capture log as configured by the settings.
+ *
+ * @param output The output to open.
+ * @param fileName The file to write to (NULL = stdout). If rotation is allowed, the
+ *      file is rotated once it reaches the size or capture time span set in the settings.
+ *      Rotated files are numbered by inserting a four digit sequence number before
+ *      the file extension.
+ * @param settings The application settings as configured by the input arguments.
+ * @param expectedSize The expected size of the whole output in bytes for preallocation.
+ * @param clockPeriod The period of the capture clock in seconds.
+ * @param rotate Non-zero, if the file may be rotated.
+ * @param header The header written at the start of every file.
+ * @param headerLength The length of the header in bytes.
+ * @return A non-zero integer on success.
+ */
+int outputOpen(OutputFile *output, const char *fileName, Settings settings, unsigned long long expectedSize,
+               double clockPeriod, const char rotate, const char *header, size_t headerLength);
+
+/**
+ * @brief Sets up an output writing to a stream of the caller without header and rotation.
+ *
+ * @param output The output to set up.
+ * @param stream The stream to write to, which is left open by outputClose().
+ */
+void outputAttach(OutputFile *output, FILE *stream);
+
+/**
+ * @brief Marks a packet boundary and rotates the file, if it reached its size or
+ *      capture time span. Errors opening the next file are reported and writing
+ *      continues in the current file.
+ *
+ * @param output The output.
+ * @param tick The capture clock tick of the packet following the boundary.
+ * @return The stream to write the next packet to.
+ */
+FILE *outputBoundary(OutputFile *output, long long tick);
+
+/**
+ * @brief Counts data written to the current file towards its size limit.
+ *
+ * @param output The output.
+ * @param bytes The number of bytes written.
+ */
+void outputWritten(OutputFile *output, unsigned long long bytes);
+
+/**
+ * @brief Checks whether the output is rotated.
+ *
+ * @param output The output.
+ * @return A non-zero integer, if the output is rotated at packet boundaries.
+ */
+int outputRotates(const OutputFile *output);
+
+/**
+ * @brief Closes the current file and waits for all rotated files to be closed and renamed.
+ *
+ * @param output The output to close.
+ * @return A non-zero integer, if all files have been written successfully.
+ */
+int outputClose(OutputFile *output);
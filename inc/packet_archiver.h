@@ -17,7 +17,29 @@
 consisting of the size ofJSON keys, uuid and timestamp */
 #define STATIC_MESSAGE_LENGTH 207
 
+/* Maximum size of the additional JSON keys and values
+for packets of which only the header has been recorded */
+#define HEADER_ONLY_MESSAGE_LENGTH 64
+
+/* Maximum size of the additional JSON keys and values
+for the decoded header of RMAP packets */
+#define RMAP_MESSAGE_LENGTH 384
+
+/* Number of attempts to produce a message while the producer queue is full */
+#define KAFKA_PRODUCE_ATTEMPTS 3
+
+/* Number of slots of the cache of archived packets for the deduplication (power of two),
+a packet replaces the one cached in its slot */
+#define DEDUP_CACHE_SLOTS 4096
+
+/* Longest packet kept in the cache for the deduplication in bytes, longer packets are always archived in full */
+#define DEDUP_MAX_LENGTH 4096
+
 typedef struct settings Settings;
+typedef struct eventStore EventStore;
+typedef struct packetIndex PacketIndex;
+typedef struct rmapHeader RmapHeader;
+typedef struct dedupSlot DedupSlot;
 
 typedef struct packetInfo
 {
@@ -25,17 +47,67 @@ typedef struct packetInfo
 	char 	*interfaceId;	/* Receiver on which the packet was received */
 	char 	*rawData;    		/* String of raw packet data */
 	size_t 	rawDataLength;		/* Size of raw data string */
+	double	duration;		/* Time between the packet header and the end of packet in seconds */
+	const RmapHeader *rmap;	/* Decoded RMAP header (NULL = no RMAP packet) */
 } PacketInfo;
 
+/**
+ * @brief Delivers a single serialized capture message.
+ *
+ * @param context The context of the transport.
+ * @param topic The topic to deliver the message to.
+ * @param buffer The serialized message.
+ * @param length The length of the message in bytes.
+ * @param opaque Passed to LA_MK3_reportDelivery() once the delivery of the message is known
+ *      (NULL = no report needed).
+ * @return A non-zero value on success.
+ */
+typedef int32_t (*ArchiveSend)(void *context, const char *topic, uint8_t *buffer, size_t length, void *opaque);
+
+/* Transport delivering the serialized capture messages */
+typedef struct archiveTransport
+{
+	ArchiveSend send;	/* Function delivering a single message */
+	void 	*context;	/* Context passed to the send function */
+	DedupSlot *cache;	/* Cache of the deduplication awaiting delivery reports, managed by the serialization (NULL = none) */
+} ArchiveTransport;
+
+/**
+ * @brief Reports whether a message sent with a non-NULL opaque value has been delivered.
+ *      A repeated packet only refers to a message once its delivery has been reported,
+ *      a failed message is removed from the cache of the deduplication. Reports arriving
+ *      after the serialization has finished are ignored.
+ *
+ * @param transport The transport the message has been sent with.
+ * @param opaque The opaque value passed to the send function.
+ * @param delivered Non-zero, if the message has been delivered.
+ */
+void LA_MK3_reportDelivery(ArchiveTransport *transport, void *opaque, int delivered);
+
+/**
+ * @brief This function serializes the terminated packets of the index into capture messages
+ *      and hands them to a transport. With deduplication enabled in the settings, a packet
+ *      repeating a cached packet of the same interface is serialized as a reference to the
+ *      message of that packet, holding only its UUID and the new capture time. The cached
+ *      bytes are compared in full, and only messages reported as delivered are referred to.
+ *
+ * @param settings The settings of this application containing static information to be sent along.
+ * @param store The recorded events.
+ * @param index The packet index of the recorded events.
+ * @param triggerTime The timestamp at which the Link Analyser was triggered.
+ * @param transport The transport delivering the messages.
+ * @param messageCounter Incremented for every message delivered successfully.
+ * @return A non-zero value on success.
+ */
+int32_t LA_MK3_serializeCapturedPackets(Settings settings, const EventStore *store, PacketIndex *index, struct timespec *triggerTime, ArchiveTransport *transport, uint32_t *messageCounter);
+
 /**
  * @brief This function creates data packets from recorded events and archives them in the database as individual kafka messages.
  *
  * @param settings The settings of this application containing static information to be sent via kafka.
- * @param pTraffic The recorded events.
- * @param trafficCount The amount of recorded events.
- * @param charCaptureClockPeriod The character capture clock period.
+ * @param store The recorded events.
+ * @param index The packet index of the recorded events.
  * @param triggerTime The timestamp at which the Link Analyser was triggered.
- * @param preTrigger The maximum duration for which packets received BEFORE the trigger are archived.
  * @return A non-zero value on success.
  */
-int32_t LA_MK3_archiveCapturedPackets(Settings settings, STAR_LA_MK3_Traffic *pTraffic, const U32 *trafficCount, const double *charCaptureClockPeriod, struct timespec *triggerTime, const int preTrigger);
\ No newline at end of file
+int32_t LA_MK3_archiveCapturedPackets(Settings settings, const EventStore *store, PacketIndex *index, struct timespec *triggerTime);
\ No newline at end of file
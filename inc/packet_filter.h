@@ -0,0 +1,97 @@
+/**
+ * @file packet_filter.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains a packet filter, which is compiled once from an expression
+ *      into a small postfix program and evaluated while the packet index is
+ *      built, so that filtered out packets never reach the outputs. Expressions
+ *      combine the following terms with and (&&), or (||), not (!) and parentheses:
+ *
+ *        recv a|b              Packets recorded on receiver A or B
+ *        eop, eep, incomplete  Packets terminated by an EOP, an EEP or not at all
+ *        timecode              Time-codes
+ *        error                 Packets with any error flag
+ *        len MIN[-MAX]         Packets of MIN to MAX bytes (MIN- or -MAX leave a side open)
+ *        addr VALUE            Packets starting with the logical address VALUE
+ *        proto VALUE           Packets with the protocol ID VALUE (second byte)
+ *        byte OFFSET=VALUE[/MASK]  Packets with the masked byte at OFFSET equal to VALUE
+ *        at OFFSET=HEX         Packets containing the bytes HEX (e.g. fe01a2) at OFFSET
+ *        rmap, command, reply  RMAP packets, commands or replies with a complete header
+ *        crcerror              RMAP packets with a header or data CRC mismatch
+ *        tid VALUE             RMAP packets with the transaction ID VALUE
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+typedef struct eventStore EventStore;
+typedef struct packetEntry PacketEntry;
+
+/* Maximum number of instructions of a compiled filter */
+#define FILTER_MAX_INSTRUCTIONS 64
+
+/* Maximum depth of the evaluation stack of a compiled filter */
+#define FILTER_MAX_DEPTH 16
+
+/* Maximum number of packet bytes a filter can inspect */
+#define FILTER_MAX_BYTES 256
+
+/* Operations of the filter program */
+enum filterOp {
+    FILTER_OP_RECV,             /* Push whether the receiver equals value */
+    FILTER_OP_TERM,             /* Push whether the termination is set in the mask of value */
+    FILTER_OP_ERROR,            /* Push whether the packet has any error flag */
+    FILTER_OP_LENGTH,           /* Push whether the length lies between min and max */
+    FILTER_OP_BYTE,             /* Push whether the byte at offset masked with mask equals value */
+    FILTER_OP_PATTERN,          /* Push whether the max pattern bytes starting at min match at offset */
+    FILTER_OP_RMAP,             /* Push whether the RMAP flags masked with mask equal value */
+    FILTER_OP_TID,              /* Push whether the packet is RMAP with the transaction ID min */
+    FILTER_OP_NOT,              /* Negate the top of the stack */
+    FILTER_OP_AND,              /* Replace the two top values by their conjunction */
+    FILTER_OP_OR                /* Replace the two top values by their disjunction */
+};
+
+/* A single instruction of the filter program */
+struct filterInstruction
+{
+    U8  op;                     /* Operation (see enum filterOp) */
+    U8  value;                  /* Value to compare against */
+    U8  mask;                   /* Mask applied before comparing a byte */
+    U16 offset;                 /* Offset of the inspected bytes in the packet */
+    U32 min;                    /* Minimum length or start of the pattern */
+    U32 max;                    /* Maximum length or length of the pattern */
+};
+
+/* A compiled packet filter */
+typedef struct packetFilter
+{
+    struct filterInstruction program[FILTER_MAX_INSTRUCTIONS]; /* The postfix program */
+    U32 length;                 /* Number of instructions */
+    U32 byteCount;              /* Number of leading packet bytes the program inspects */
+    U8  patterns[FILTER_MAX_BYTES]; /* Bytes of the patterns */
+    U32 patternLength;          /* Number of pattern bytes in use */
+} PacketFilter;
+
+/**
+ * @brief Compiles a filter expression.
+ *
+ * @param expression The filter expression.
+ * @return The compiled filter or NULL, if the expression is invalid.
+ */
+PacketFilter *compilePacketFilter(const char *expression);
+
+/**
+ * @brief Evaluates a compiled filter on an indexed packet or time-code.
+ *
+ * @param filter The compiled filter.
+ * @param entry The packet or time-code.
+ * @param store The recorded events.
+ * @return A non-zero integer, if the packet passes the filter.
+ */
+int matchPacketFilter(const PacketFilter *filter, const PacketEntry *entry, const EventStore *store);
+
+/**
+ * @brief Frees a compiled filter.
+ *
+ * @param filter The compiled filter.
+ */
+void freePacketFilter(PacketFilter *filter);
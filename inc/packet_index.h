@@ -0,0 +1,103 @@
+/**
+ * @file packet_index.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for indexing the packets of the recorded traffic
+ *      in a single pass, so that all consumers can share the packet boundaries.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+typedef struct eventStore EventStore;
+typedef struct packetFilter PacketFilter;
+
+/* Initial number of entries allocated for the packet index */
+#define INDEX_INITIAL_ENTRIES 4096
+
+/* Error flags of an indexed packet */
+#define PACKET_ERROR_PARITY     0x01    /* Parity error on one of the events */
+#define PACKET_ERROR_RX_CREDIT  0x02    /* Receiver credit error on one of the events */
+#define PACKET_ERROR_TX_CREDIT  0x04    /* Transmitter credit error on one of the events */
+#define PACKET_ERROR_SEQUENCE   0x08    /* Sequence error event within the packet */
+#define PACKET_ERROR_ESCAPE     0x10    /* Escape error event within the packet */
+#define PACKET_ERROR_DISCONNECT 0x20    /* Disconnect error event within the packet */
+#define PACKET_ERROR_HEADER     0x40    /* Header character within the packet, the terminator before it is missing */
+
+/* How an indexed record has been terminated */
+enum packetTermination {
+    PACKET_TERM_EOP,            /* Packet terminated by an EOP */
+    PACKET_TERM_EEP,            /* Packet terminated by an EEP */
+    PACKET_TERM_INCOMPLETE,     /* Packet still open at the end of the recording */
+    PACKET_TERM_TIMECODE        /* Time-code, which is not part of a packet */
+};
+
+/* A single packet or time-code in the packet index */
+typedef struct packetEntry
+{
+    long long startTime;    /* Capture clock tick of the header event */
+    U32 startEvent;         /* Index of the header event in the recorded traffic */
+    U32 endEvent;           /* Index of the terminating (or last recorded) event */
+    U32 length;             /* Number of bytes in the packet */
+    U8  receiver;           /* Receiver the packet was recorded on (A=0, B=1) */
+    U8  termination;        /* Termination of the packet (see enum packetTermination) */
+    U8  errors;             /* Error flags of the packet (see PACKET_ERROR_*) */
+    U8  rmap;               /* RMAP flags of the packet (see RMAP_FLAG_*, 0 = no RMAP packet) */
+} PacketEntry;
+
+/* The packets of a recording in order of their completion */
+typedef struct packetIndex
+{
+    PacketEntry *entries;   /* The indexed packets and time-codes */
+    U32 count;              /* Number of entries */
+    U32 capacity;           /* Number of allocated entries */
+    U32 firstEvent;         /* Index of the first event within the pre trigger duration */
+    U32 maxLength;          /* Length of the longest packet in bytes */
+    U32 packetCount[2];     /* Number of packets per receiver */
+    U32 timecodeCount[2];   /* Number of time-codes per receiver */
+    unsigned long long byteCount[2]; /* Number of packet bytes per receiver */
+    U32 filteredCount;      /* Number of packets and time-codes rejected by the packet filter */
+    U32 rmapCommandCount;   /* Number of RMAP commands */
+    U32 rmapReplyCount;     /* Number of RMAP replies */
+    U32 rmapCrcErrorCount;  /* Number of RMAP packets with a header or data CRC mismatch */
+} PacketIndex;
+
+/**
+ * @brief Builds the packet index in a single pass over the recorded traffic.
+ *      The headers of RMAP packets are decoded and their CRCs validated on the
+ *      way. Packets rejected by the filter are not indexed and only counted.
+ *
+ * @param index The packet index to build.
+ * @param store The recorded events.
+ * @param preTrigger The maximum duration for which packets received BEFORE the trigger are indexed.
+ * @param filter The packet filter (NULL = index all packets).
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_buildPacketIndex(PacketIndex *index, const EventStore *store, const int preTrigger, const PacketFilter *filter);
+
+/**
+ * @brief Copies the bytes of an indexed packet into a contiguous buffer.
+ *
+ * @param entry The indexed packet.
+ * @param store The recorded events.
+ * @param buffer The buffer to write the bytes to, holding at least entry->length bytes.
+ * @return The number of bytes written to the buffer.
+ */
+U32 LA_MK3_getPacketBytes(const PacketEntry *entry, const EventStore *store, U8 *buffer);
+
+/**
+ * @brief Copies the bytes of an indexed packet as printed in the hexdump, which
+ *      leaves out header characters received within the packet.
+ *
+ * @param entry The indexed packet.
+ * @param store The recorded events.
+ * @param buffer The buffer to write the bytes to, holding at least entry->length bytes.
+ * @return The number of bytes written to the buffer.
+ */
+U32 LA_MK3_getHexdumpBytes(const PacketEntry *entry, const EventStore *store, U8 *buffer);
+
+/**
+ * @brief Frees the memory held by a packet index.
+ *
+ * @param index The packet index to free.
+ */
+void freePacketIndex(PacketIndex *index);
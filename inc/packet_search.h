@@ -0,0 +1,119 @@
+/**
+ * @file packet_search.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for searching the indexed packets for byte
+ *      patterns. Patterns are compiled once from a specification of the form
+ *
+ *        [OFFSET=]HEX[/MASK][;PATTERN...]
+ *
+ *      where HEX gives the pattern bytes (e.g. fe01a2), MASK optionally the bits
+ *      compared of each byte (e.g. ff0fff) and OFFSET anchors the pattern at a
+ *      position in the packet. Patterns without an offset are searched anywhere
+ *      in the packet. The bytes of each packet are gathered into a contiguous
+ *      buffer and scanned for candidates with the vectorized byte pair kernel,
+ *      the packets being split between worker threads.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+
+typedef struct eventStore EventStore;
+typedef struct packetIndex PacketIndex;
+
+/* Maximum number of search patterns */
+#define SEARCH_MAX_PATTERNS 8
+
+/* Maximum number of bytes of a search pattern */
+#define SEARCH_MAX_BYTES 64
+
+/* Offset of patterns searched anywhere in the packet */
+#define SEARCH_ANYWHERE 0xFFFFFFFFu
+
+/* Initial number of matches allocated per worker thread */
+#define SEARCH_INITIAL_MATCHES 256
+
+/* A compiled search pattern */
+typedef struct searchPattern
+{
+    U8  bytes[SEARCH_MAX_BYTES];    /* Pattern bytes, already masked */
+    U8  mask[SEARCH_MAX_BYTES];     /* Bits compared of each byte */
+    U8  length;                     /* Number of pattern bytes */
+    U8  first;                      /* Position of the first fully compared byte, locating candidates */
+    U8  last;                       /* Position of the last fully compared byte */
+    char exact;                     /* The pattern has at least one fully compared byte */
+    U32 offset;                     /* Position in the packet (SEARCH_ANYWHERE = anywhere) */
+} SearchPattern;
+
+/* Compiled search patterns */
+typedef struct searchPatterns
+{
+    SearchPattern patterns[SEARCH_MAX_PATTERNS]; /* The patterns */
+    U8  count;                      /* Number of patterns */
+} SearchPatterns;
+
+/* A pattern found in a packet */
+typedef struct searchMatch
+{
+    U32 entry;                      /* Index of the packet in the packet index */
+    U32 offset;                     /* Position of the first occurrence of the pattern in the packet */
+    U8  pattern;                    /* Number of the pattern */
+} SearchMatch;
+
+/* The matches of all patterns in a capture */
+typedef struct packetSearch
+{
+    SearchMatch *matches;           /* Matches in order of the packet index, then of the patterns */
+    U32 count;                      /* Number of matches */
+    U32 packets;                    /* Number of packets containing at least one pattern */
+    unsigned long long searched;    /* Number of packet bytes searched */
+} PacketSearch;
+
+/**
+ * @brief Compiles a search pattern specification.
+ *
+ * @param spec The specification.
+ * @return The compiled patterns or NULL, if the specification is invalid.
+ */
+SearchPatterns *compileSearchPatterns(const char *spec);
+
+/**
+ * @brief Frees compiled search patterns.
+ *
+ * @param patterns The compiled patterns.
+ */
+void freeSearchPatterns(SearchPatterns *patterns);
+
+/**
+ * @brief Searches all indexed packets for the patterns. Time-codes are not searched.
+ *
+ * @param search The search result to fill.
+ * @param store The recorded events.
+ * @param index The packet index.
+ * @param patterns The compiled patterns.
+ * @param jobs The number of threads searching the packets.
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_searchPackets(PacketSearch *search, const EventStore *store, const PacketIndex *index, const SearchPatterns *patterns, int jobs);
+
+/**
+ * @brief Prints the packets containing a pattern with their record number,
+ *      direction, timestamp and the positions of the patterns.
+ *
+ * @param stream The stream to print to.
+ * @param search The search result.
+ * @param store The recorded events.
+ * @param index The packet index.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @return The number of characters printed.
+ */
+unsigned long long printSearchMatches(FILE *stream, const PacketSearch *search, const EventStore *store, const PacketIndex *index,
+                                      struct timespec *triggerTime);
+
+/**
+ * @brief Frees the memory held by a search result.
+ *
+ * @param search The search result.
+ */
+void freePacketSearch(PacketSearch *search);
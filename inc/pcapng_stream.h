@@ -0,0 +1,91 @@
+/**
+ * @file pcapng_stream.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains a PCAPNG stream, which hands the packets to Wireshark as
+ *      soon as they are indexed, without formatting a hexdump and converting it
+ *      with text2pcap. The packets are framed with the same dummy Ethernet, IPv4
+ *      and TCP headers as with text2pcap, so the existing dissectors apply. The
+ *      blocks are queued in a bounded number of buffers for a writer thread. A
+ *      named pipe (FIFO) is read live by Wireshark: if the queue stays full for
+ *      the stall timeout, packets are dropped and counted instead of holding up
+ *      the recording tool, until Wireshark catches up again. A regular file is
+ *      written without drops.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <time.h>
+
+typedef struct eventStore EventStore;
+typedef struct packetIndex PacketIndex;
+
+/* Size of each buffer handed to the stream writer thread in bytes */
+#define PCAPNG_BUFFER_SIZE (1024 * 1024)
+
+/* Number of buffers queued for the stream writer thread at most */
+#define PCAPNG_BUFFER_COUNT 32
+
+/* Interval in milliseconds for checking whether a reader opened the named pipe */
+#define PCAPNG_POLL_INTERVAL_MS 100
+
+/* Time in milliseconds to wait for a free buffer before dropping packets for a named pipe */
+#define PCAPNG_STALL_TIMEOUT_MS 1000
+
+/* Time in milliseconds to wait for the reader to take the rest of a named pipe stream when stopping */
+#define PCAPNG_STOP_TIMEOUT_MS 5000
+
+/* Ports of the dummy TCP header, as given to text2pcap with -T for the dissectors */
+#define PCAPNG_SOURCE_PORT 0
+#define PCAPNG_DESTINATION_PORT 59274
+
+/* Size of the dummy Ethernet, IPv4 and TCP headers in front of each packet in bytes */
+#define PCAPNG_DUMMY_HEADERS (14 + 20 + 20)
+
+/* Longest packet fitting into the dummy IPv4 header in bytes, longer packets are truncated */
+#define PCAPNG_MAX_PAYLOAD (65535 - 20 - 20)
+
+/* Descriptions of the packet error flags in the packet comments (see PACKET_ERROR_*) */
+static const char *const pcapngErrorNames[] = {
+    "parity error", "receiver credit error", "transmitter credit error", "sequence error", "escape error", "disconnect",
+    "header within packet"
+};
+
+/* Descriptions of the RMAP error flags in the packet comments, starting with RMAP_FLAG_HEADER_CRC */
+static const char *const pcapngRmapErrorNames[] = {
+    "RMAP header CRC error", "RMAP data CRC error", "RMAP length error"
+};
+
+/**
+ * @brief Opens the PCAPNG stream and starts its writer thread. A named pipe is
+ *      opened by the writer thread as soon as Wireshark reads from it, a
+ *      regular file is created or truncated right away.
+ *
+ * @param target The named pipe or file to write the stream to.
+ * @param version The software version recorded in the section header.
+ * @return A non-zero integer on success.
+ */
+int pcapngStartStream(const char *target, const char *version);
+
+/**
+ * @brief Queues the indexed packets and time-codes in order of their completion.
+ *      For a named pipe, a full queue is waited on for up to the stall timeout,
+ *      after which packets are dropped without waiting until the reader catches up.
+ *
+ * @param store The recorded events.
+ * @param index The packet index of the recorded events.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @param headerOnly Non-zero, if only the packet headers have been recorded.
+ * @return The number of packets and time-codes queued.
+ */
+unsigned long long pcapngStreamPackets(const EventStore *store, const PacketIndex *index, struct timespec *triggerTime, const char headerOnly);
+
+/**
+ * @brief Writes the interface statistics with the number of dropped packets,
+ *      waits for the queue to be written and closes the stream. A named pipe
+ *      nobody has opened yet is given up, as is a reader not taking the rest
+ *      of the stream within the stop timeout.
+ *
+ * @return A non-zero integer, if all queued data has been written.
+ */
+int pcapngStopStream(void);
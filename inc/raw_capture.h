@@ -0,0 +1,80 @@
+/**
+ * @file raw_capture.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for writing the recorded events losslessly in a
+ *      binary capture format and reading them back. A capture consists of a header followed by one
+ *      fixed-size record per event, all values being little-endian:
+ *
+ *      Header (RAW_HEADER_SIZE bytes):
+ *        0  magic "SPWRAW01"        8  format version (u32)
+ *        12 header size (u32)       16 number of events (u64)
+ *        24 clock period in s (f64) 32 trigger time seconds (s64)
+ *        40 trigger time ns (s64)   48 flags (u32, RAW_FLAG_*)
+ *        52 record size (u32)       56 reserved
+ *
+ *      Record (RAW_RECORD_SIZE bytes):
+ *        0  capture clock tick relative to the trigger (s64)
+ *        8  type, data and error flags on receiver A (u8 each)
+ *        11 type, data and error flags on receiver B (u8 each)
+ *        14 reserved
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+/* Magic number at the start of a capture */
+#define RAW_MAGIC "SPWRAW01"
+
+/* Version of the capture format */
+#define RAW_FORMAT_VERSION 1
+
+/* Size of the capture header in bytes */
+#define RAW_HEADER_SIZE 64
+
+/* Size of an event record in bytes */
+#define RAW_RECORD_SIZE 16
+
+/* Number of event records encoded at once */
+#define RAW_BLOCK_EVENTS 4096
+
+/* Only the packet headers have been recorded */
+#define RAW_FLAG_HEADER_ONLY 0x1u
+
+typedef struct eventStore EventStore;
+
+/**
+ * @brief Writes all recorded events in the binary capture format.
+ *
+ * @param stream The stream to write the capture to.
+ * @param store The recorded events.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @param headerOnly Non-zero, if only the packet headers have been recorded.
+ * @return The number of bytes written.
+ */
+unsigned long long LA_MK3_writeRawCapture(FILE *stream, const EventStore *store, struct timespec *triggerTime, const char headerOnly);
+
+/**
+ * @brief Checks whether a file starts with the magic number of the binary capture format.
+ *
+ * @param fileName The file to check.
+ * @return A non-zero integer, if the file is a raw capture.
+ */
+int isRawCapture(const char *fileName);
+
+/**
+ * @brief Reads a capture written in the binary capture format into the traffic
+ *      structures of the STAR-API, as if it had just been recorded.
+ *
+ * @param fileName The file to read the capture from.
+ * @param ppTraffic Set to the read traffic, which must be freed with free().
+ * @param trafficCount Set to the number of STAR_LA_Traffic structures.
+ * @param charCaptureClockPeriod Set to the character capture clock period.
+ * @param triggerTime Set to the timestamp of when the trigger occurred.
+ * @param headerOnly Set to non-zero, if only the packet headers have been recorded.
+ * @return A non-zero integer on success.
+ */
+int LA_MK3_readRawCapture(const char *fileName, STAR_LA_MK3_Traffic **ppTraffic, U32 *trafficCount,
+                          double *charCaptureClockPeriod, struct timespec *triggerTime, char *headerOnly);
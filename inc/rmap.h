@@ -0,0 +1,81 @@
+/**
+ * @file rmap.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for decoding the headers of RMAP commands and
+ *      replies (ECSS-E-ST-50-52C) and validating their header and data CRCs
+ *      with a table-driven CRC-8. Packets are decoded while the packet index
+ *      is built, so the filter, statistics and archive share the result.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+typedef struct eventStore EventStore;
+typedef struct packetEntry PacketEntry;
+
+/* Protocol ID of RMAP packets */
+#define RMAP_PROTOCOL_ID 0x01
+
+/* Bits of the RMAP instruction field */
+#define RMAP_INSTRUCTION_COMMAND    0x40    /* Command (set) or reply (cleared) */
+#define RMAP_INSTRUCTION_WRITE      0x20    /* Write (set) or read (cleared) */
+#define RMAP_INSTRUCTION_VERIFY     0x10    /* Verify data before writing */
+#define RMAP_INSTRUCTION_REPLY      0x08    /* Reply requested */
+#define RMAP_INSTRUCTION_INCREMENT  0x04    /* Increment the address */
+#define RMAP_INSTRUCTION_ADDRESS    0x03    /* Length of the reply address in multiples of 4 bytes */
+
+/* Length of the longest RMAP header (command with 12 reply address bytes) */
+#define RMAP_MAX_HEADER 28
+
+/* RMAP flags of an indexed packet */
+#define RMAP_FLAG_PACKET     0x01   /* RMAP command or reply with a complete header */
+#define RMAP_FLAG_COMMAND    0x02   /* RMAP command (cleared for replies) */
+#define RMAP_FLAG_HEADER_CRC 0x04   /* Header CRC mismatch */
+#define RMAP_FLAG_DATA_CRC   0x08   /* Data CRC mismatch */
+#define RMAP_FLAG_LENGTH     0x10   /* Packet length differing from the data length in the header */
+
+/* A decoded RMAP header */
+typedef struct rmapHeader
+{
+    U8  flags;                  /* RMAP flags (see RMAP_FLAG_*) */
+    U8  instruction;            /* Instruction field */
+    U8  targetAddress;          /* Logical address of the target */
+    U8  initiatorAddress;       /* Logical address of the initiator */
+    U8  keyStatus;              /* Key of a command or status of a reply */
+    U16 transactionId;          /* Transaction identifier */
+    U8  extendedAddress;        /* Extended address of a command */
+    U32 address;                /* Memory address of a command */
+    U32 dataLength;             /* Number of data bytes following the header */
+    U8  headerLength;           /* Number of header bytes including the header CRC */
+    U8  hasData;                /* The header is followed by data and a data CRC */
+} RmapHeader;
+
+/**
+ * @brief Continues the RMAP CRC-8 over a block of bytes.
+ *
+ * @param crc The CRC of the preceding bytes (0 for the first block).
+ * @param bytes The bytes.
+ * @param length The number of bytes.
+ * @return The CRC including the bytes.
+ */
+U8 rmapCrc(U8 crc, const U8 *bytes, U32 length);
+
+/**
+ * @brief Decodes an RMAP header and validates its CRC.
+ *
+ * @param bytes The leading bytes of the packet.
+ * @param length The number of leading bytes, at least RMAP_MAX_HEADER unless the packet is shorter.
+ * @param header The header to fill.
+ * @return A non-zero integer, if the bytes start with a complete RMAP header.
+ */
+int decodeRmapHeader(const U8 *bytes, U32 length, RmapHeader *header);
+
+/**
+ * @brief Decodes the RMAP header of a packet and validates its header and data CRC.
+ *
+ * @param entry The packet.
+ * @param store The recorded events.
+ * @param header The header to fill.
+ * @return The RMAP flags of the packet (0 = no RMAP packet).
+ */
+U8 LA_MK3_decodeRmapPacket(const PacketEntry *entry, const EventStore *store, RmapHeader *header);
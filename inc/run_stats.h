@@ -0,0 +1,123 @@
+/**
+ * @file run_stats.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for timing the phases of a capture run and
+ *      counting its events, packets and messages. The statistics are always
+ *      collected and can be written as a JSON report at the end of the run.
+ *      The counters are lock-free atomics and may be updated from any thread.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+typedef struct settings Settings;
+
+/* Phases of a capture run */
+enum statsPhase {
+    STATS_PHASE_DETECT,         /* Detecting the Link Analyser */
+    STATS_PHASE_CONFIGURE,      /* Configuring the recording */
+    STATS_PHASE_TRIGGER_WAIT,   /* Waiting on the device triggering */
+    STATS_PHASE_CAPTURE,        /* Recording after the trigger */
+    STATS_PHASE_DOWNLOAD,       /* Downloading the recorded traffic */
+    STATS_PHASE_CONVERT,        /* Converting the traffic into the event store */
+    STATS_PHASE_INDEX,          /* Indexing the packets */
+    STATS_PHASE_PRINT,          /* Writing the hexdump or event log */
+    STATS_PHASE_ARCHIVE,        /* Serializing and producing the archive messages */
+    STATS_PHASE_FLUSH,          /* Flushing the remaining archive messages */
+    STATS_PHASE_TOTAL,          /* The whole run */
+    STATS_PHASE_COUNT
+};
+
+/* Names of the phases as used in the report */
+static const char *const statsPhaseNames[] = {
+    "detect", "configure", "trigger_wait", "capture", "download", "convert",
+    "index", "print", "archive", "flush", "total"
+};
+
+/* Counters of a capture run */
+enum statsCounter {
+    STATS_EVENTS,               /* Recorded events */
+    STATS_PACKETS_A,            /* Packets indexed on receiver A */
+    STATS_PACKETS_B,            /* Packets indexed on receiver B */
+    STATS_TIMECODES_A,          /* Time-codes indexed on receiver A */
+    STATS_TIMECODES_B,          /* Time-codes indexed on receiver B */
+    STATS_BYTES_A,              /* Packet bytes indexed on receiver A */
+    STATS_BYTES_B,              /* Packet bytes indexed on receiver B */
+    STATS_INCOMPLETE_PACKETS,   /* Packets not terminated before the end of recording */
+    STATS_PACKETS_FILTERED,     /* Packets and time-codes rejected by the packet filter */
+    STATS_RMAP_COMMANDS,        /* RMAP commands indexed */
+    STATS_RMAP_REPLIES,         /* RMAP replies indexed */
+    STATS_RMAP_CRC_ERRORS,      /* Indexed RMAP packets with a header or data CRC mismatch */
+    STATS_ERROR_EVENTS,         /* Error events found by the error log */
+    STATS_PACKETS_WRITTEN_A,    /* Packets of receiver A written to the hexdump */
+    STATS_PACKETS_WRITTEN_B,    /* Packets of receiver B written to the hexdump */
+    STATS_BYTES_WRITTEN,        /* Bytes written to the hexdump or event log */
+    STATS_DISK_BYTES,           /* Bytes written to output files by the file writers */
+    STATS_WRITER_BUSY_US,       /* Microseconds the file writers spent writing and synchronizing */
+    STATS_WRITER_STALLS,        /* Times formatting waited on a file writer for a free buffer */
+    STATS_COMPRESS_INPUT_BYTES, /* Bytes compressed into gzip members */
+    STATS_COMPRESS_OUTPUT_BYTES,/* Size of the written gzip members */
+    STATS_COMPRESS_BUSY_US,     /* Microseconds the compression workers spent compressing */
+    STATS_FILES_ROTATED,        /* Output files closed by rotation before the end of the log */
+    STATS_MESSAGES_PRODUCED,    /* Archive messages handed to the producer */
+    STATS_MESSAGES_RETRIED,     /* Attempts to produce repeated after a full queue */
+    STATS_MESSAGES_DROPPED,     /* Archive messages that could not be produced */
+    STATS_DELIVERY_FAILURES,    /* Archive messages reported as failed by the broker */
+    STATS_MESSAGES_UNDELIVERED, /* Archive messages left in the queue after flushing */
+    STATS_MESSAGES_REFERENCED,  /* Repeated packets archived as references to an earlier message */
+    STATS_PACKETS_STREAMED,     /* Packets written to the PCAPNG stream */
+    STATS_PACKETS_STREAM_DROPPED, /* Packets dropped from the PCAPNG stream on a full queue or a closed pipe */
+    STATS_IMPORT_GUESSED,       /* Single byte records of an imported hexdump guessed to be time-codes or packets */
+    STATS_COUNTER_COUNT
+};
+
+/* Names of the counters as used in the report */
+static const char *const statsCounterNames[] = {
+    "events", "packets_a", "packets_b", "timecodes_a", "timecodes_b", "bytes_a", "bytes_b",
+    "incomplete_packets", "packets_filtered", "rmap_commands", "rmap_replies", "rmap_crc_errors", "error_events", "packets_written_a", "packets_written_b", "bytes_written",
+    "disk_bytes", "writer_busy_us", "writer_stalls",
+    "compress_input_bytes", "compress_output_bytes", "compress_busy_us", "files_rotated", "messages_produced", "messages_retried", "messages_dropped",
+    "delivery_failures", "messages_undelivered", "messages_referenced", "packets_streamed", "packets_stream_dropped",
+    "import_guessed_records"
+};
+
+/**
+ * @brief Starts timing a phase using the monotonic clock. The phase is also
+ *      published as the current phase of the run.
+ *
+ * @param phase The phase to time (see enum statsPhase).
+ */
+void statsStartPhase(int phase);
+
+/**
+ * @brief Stops timing a phase and adds the elapsed time to its total.
+ *
+ * @param phase The phase to stop (see enum statsPhase).
+ */
+void statsStopPhase(int phase);
+
+/**
+ * @brief Adds a value to a counter.
+ *
+ * @param counter The counter to increase (see enum statsCounter).
+ * @param value The value to add.
+ */
+void statsAdd(int counter, unsigned long long value);
+
+/**
+ * @brief Gets the current value of a counter.
+ *
+ * @param counter The counter to read (see enum statsCounter).
+ * @return The value of the counter.
+ */
+unsigned long long statsGet(int counter);
+
+/**
+ * @brief Writes the phase timings and counters as a JSON report.
+ *
+ * @param fileName The file to write the report to.
+ * @param settings The application settings as configured by the input arguments.
+ * @param triggerTime The timestamp of when the trigger occurred, or NULL if the device did not trigger.
+ * @return A non-zero integer on success.
+ */
+int statsWriteReport(const char *fileName, Settings settings, struct timespec *triggerTime);
@@ -0,0 +1,99 @@
+/**
+ * @file timecode_analysis.h
+ * @author Jonas Gesch (jonas.gesch@dlr.de)
+ * @brief Contains functions for analysing the time-codes of a capture. The
+ *      time-codes of both receivers are read in a single pass over the event
+ *      store, including those rejected by the packet filter. For each receiver
+ *      the period and its jitter, missing, repeated and out of sequence codes
+ *      and changes of the control flags are tracked, and time-codes of the same
+ *      value on both receivers are paired to measure the propagation delay
+ *      between them. All statistics are updated as running values, so the
+ *      memory needed does not depend on the length of the capture.
+ * @version 0.4.1
+ * @date 2026-10-18
+ *
+ */
+
+#include <stdio.h>
+
+typedef struct settings Settings;
+typedef struct eventStore EventStore;
+typedef struct packetIndex PacketIndex;
+
+/* Number of time-code values, the counter wraps to 0 after 63 */
+#define TIMECODE_VALUES 64
+
+/* Largest step of the time-code value counted as missing codes, larger steps are out of sequence */
+#define TIMECODE_MAX_STEP (TIMECODE_VALUES / 2)
+
+/* Running statistics of a series of values in seconds */
+typedef struct timecodeStatistic
+{
+    unsigned long long count;   /* Number of values */
+    double mean;                /* Mean of the values */
+    double m2;                  /* Sum of the squared differences to the mean */
+    double min;                 /* Smallest value */
+    double max;                 /* Largest value */
+} TimecodeStatistic;
+
+/* Time-codes of a single receiver */
+typedef struct receiverTimecodes
+{
+    unsigned long long count;       /* Number of time-codes */
+    TimecodeStatistic period;       /* Intervals between time-codes following on each other */
+    unsigned long long missing;     /* Codes missing between time-codes */
+    unsigned long long gaps;        /* Time-codes following on missing codes */
+    unsigned long long repeated;    /* Time-codes with the value of the previous one */
+    unsigned long long outOfSequence; /* Time-codes stepping back or too far ahead */
+    unsigned long long flagChanges; /* Time-codes with other control flags than the previous one */
+    double position;                /* Number of periods since the first time-code */
+    double meanPosition;            /* Running mean of the positions */
+    double meanTime;                /* Running mean of the times since the first time-code */
+    double positionM2;              /* Running sum of the squared position differences */
+    double timeM2;                  /* Running sum of the squared time differences */
+    double comoment;                /* Running sum of the products of position and time differences */
+    long long firstTime;            /* Capture clock tick of the first time-code */
+    long long lastTime;             /* Capture clock tick of the previous time-code */
+    U8  lastValue;                  /* Value and control flags of the previous time-code */
+} ReceiverTimecodes;
+
+/* Time-code analysis of a capture */
+typedef struct timecodeAnalysis
+{
+    double clockPeriod;             /* The character capture clock period */
+    ReceiverTimecodes receivers[2]; /* Time-codes of receiver A and B */
+    TimecodeStatistic delay;        /* Delay of receiver B behind receiver A for time-codes of the same value */
+    unsigned long long unpaired[2]; /* Time-codes of receiver A and B without a partner on the other receiver */
+    long long pendingTime[2];       /* Capture clock tick of the time-code waiting for a partner */
+    U8  pendingValue[2];            /* Value of the time-code waiting for a partner */
+    char pending[2];                /* A time-code is waiting for a partner on receiver A and B */
+} TimecodeAnalysis;
+
+/**
+ * @brief Analyses the time-codes of both receivers within the pre trigger duration
+ *      in a single pass.
+ *
+ * @param analysis The analysis to fill.
+ * @param store The recorded events.
+ * @param index The packet index, giving the first event within the pre trigger duration.
+ */
+void LA_MK3_analyseTimecodes(TimecodeAnalysis *analysis, const EventStore *store, const PacketIndex *index);
+
+/**
+ * @brief Writes the time-code analysis as JSON report.
+ *
+ * @param fileName The file to write the report to.
+ * @param analysis The analysis.
+ * @param settings The application settings as configured by the input arguments.
+ * @param triggerTime The timestamp of when the trigger occurred.
+ * @return A non-zero integer on success.
+ */
+int writeTimecodeReport(const char *fileName, const TimecodeAnalysis *analysis, Settings settings, struct timespec *triggerTime);
+
+/**
+ * @brief Prints the time-code analysis as a readable table.
+ *
+ * @param stream The stream to print to.
+ * @param analysis The analysis.
+ */
+void printTimecodeTable(FILE *stream, const TimecodeAnalysis *analysis);
@@ -3,6 +3,8 @@
 #include <time.h>
 #include "arg_parser.h"
 #include "LA_interface.h"
+#include "run_stats.h"
+#include "metrics.h"
 
 int LA_MK3_detectDevice(STAR_LA_LinkAnalyser *linkAnalyser, const char *serialNumber)
 {
@@ -46,34 +48,40 @@ int LA_MK3_detectDevice(STAR_LA_LinkAnalyser *linkAnalyser, const char *serialNu
     return success;
 }
 
+/* STAR-API trigger events in the order of enum triggerEvents */
+static const STAR_LA_TRIGGER_EVENT trigEvents[] = {
+    STAR_LA_TRIGGER_EVENT_HEADER,
+    STAR_LA_TRIGGER_EVENT_DATA,
+    STAR_LA_TRIGGER_EVENT_EOP,
+    STAR_LA_TRIGGER_EVENT_EEP,
+    STAR_LA_TRIGGER_EVENT_FCT,
+    STAR_LA_TRIGGER_EVENT_TIMECODE,
+    STAR_LA_TRIGGER_EVENT_NULL
+};
+
 void LA_configRecording(STAR_LA_LinkAnalyser linkAnalyser, Settings config)
 {
-    /* Trigger event type */
-    STAR_LA_TRIGGER_EVENT trigEvent = 0;
-
-    /* Receiver to trigger on */
-    STAR_LA_TRIGGER_SEQ_SOURCE trigSource = 0;
-
-    if (config.trigFCT)
-    {
-        /* Trigger on FCT */
-        trigEvent = STAR_LA_TRIGGER_EVENT_FCT;
-    }
-    else
-    {
-        /* Trigger on Timecode */
-        trigEvent = STAR_LA_TRIGGER_EVENT_TIMECODE;
-    }
-
-    if (!config.recv)
-    {
-        /* Trigger on receiver A */
-        trigSource = STAR_LA_TRIGGER_SEQ_SOURCE_RECEIVER_A;
-    }
-    else
-    {
-        /* Trigger on Receiver B */
-        trigSource = STAR_LA_TRIGGER_SEQ_SOURCE_RECEIVER_B;
+    /* Stages of the trigger sequence */
+    TriggerStage *stages = config.trigStages;
+    /* Number of stages in the trigger sequence */
+    int stageCount = config.trigStageCount;
+    /* Single stage trigger, if no sequence was specified */
+    TriggerStage singleStage;
+    /* Loop counter */
+    int stage = 0;
+    /* Maximum number of events the device can record */
+    U32 maxEvents = 0;
+
+    if (0 == stageCount)
+    {
+        /* Trigger on FCT or Timecode */
+        singleStage.event = config.trigFCT ? TRIG_EVENT_FCT : TRIG_EVENT_TIMECODE;
+        /* Trigger on receiver A or B */
+        singleStage.recv = config.recv;
+        singleStage.value = 1;
+        singleStage.repeat = 1;
+        stages = &singleStage;
+        stageCount = 1;
     }
 
     /* Configure the device to record the specified characters */
@@ -83,34 +91,48 @@ void LA_configRecording(STAR_LA_LinkAnalyser linkAnalyser, Settings config)
         return;
     }
 
-    /* Disable recording just the packet header */
-    if (!STAR_LA_SetRecordOnlyPacketHeader(linkAnalyser, 0))
+    /* Enable or disable recording just the packet header */
+    if (!STAR_LA_SetRecordOnlyPacketHeader(linkAnalyser, config.headerOnly))
     {
-        fputs("Unable to disable recording only packet header\n", stderr);
+        fprintf(stderr, "Unable to %s recording only packet header\n", config.headerOnly ? "enable" : "disable");
         return;
     }
 
-    /* Set the first stage of the trigger sequence to fire on receipt of time-code or FCT event on receiver A */
-    if (!STAR_LA_SetTriggerSequence(linkAnalyser, 0, trigSource, trigEvent, 1, 1))
+    /* Set the stages of the trigger sequence to fire on receipt of the specified events */
+    for (stage = 0; stage < stageCount; stage++)
     {
-        /* Print error */
-        fputs("Failed to set first stage of trigger sequence\n", stderr);
+        if (!STAR_LA_SetTriggerSequence(linkAnalyser, (U8)stage,
+                                        stages[stage].recv ? STAR_LA_TRIGGER_SEQ_SOURCE_RECEIVER_B : STAR_LA_TRIGGER_SEQ_SOURCE_RECEIVER_A,
+                                        trigEvents[(int)stages[stage].event], stages[stage].value, stages[stage].repeat))
+        {
+            /* Print error */
+            fprintf(stderr, "Failed to set stage %d of trigger sequence\n", stage);
+            return;
+        }
     }
-    else
+    /* Disable the remaining stages, which keep their settings from an earlier longer sequence otherwise */
+    /* (a stage waiting for no events completes at once, so the sequence fires with its last set stage) */
+    for (stage = stageCount; stage < MAX_TRIGGER_STAGES; stage++)
     {
-        /* Print success */
-        fputs("First stage of trigger sequence has been set\n", stderr);
+        if (!STAR_LA_SetTriggerSequence(linkAnalyser, (U8)stage, STAR_LA_TRIGGER_SEQ_SOURCE_RECEIVER_A, STAR_LA_TRIGGER_EVENT_NULL, 0, 0))
+        {
+            fprintf(stderr, "Failed to disable stage %d of trigger sequence\n", stage);
+            return;
+        }
     }
+    /* Print success */
+    fprintf(stderr, "%d stage(s) of trigger sequence have been set\n", stageCount);
 
-    /* Set the trigger delay to 0 */
-    if (!STAR_LA_SetTriggerDelay(linkAnalyser, 0))
+    /* Set the trigger delay */
+    if (!STAR_LA_SetTriggerDelay(linkAnalyser, config.trigDelay))
     {
         fputs("Unable to set the trigger delay\n", stderr);
         return;
     }
 
-    /* Set the amount of events to be recorded after the trigger to maximum */
-    if (!STAR_LA_SetPostTriggerMemory(linkAnalyser, STAR_LA_GetMaximumRecordedEvents(linkAnalyser)))
+    /* Split the device memory between events before and after the trigger */
+    maxEvents = STAR_LA_GetMaximumRecordedEvents(linkAnalyser);
+    if (!STAR_LA_SetPostTriggerMemory(linkAnalyser, (U32)((unsigned long long)maxEvents * (unsigned int)config.postTrigMemory / 100)))
     {
         fputs("Unable to set the size of post trigger memory\n", stderr);
         return;
@@ -143,6 +165,7 @@ int LA_MK3_recordTraffic(STAR_LA_LinkAnalyser linkAnalyser, STAR_LA_MK3_Traffic
         return 0;
     }
     fputs("Recording, waiting on trigger...\n", stderr);
+    statsStartPhase(STATS_PHASE_TRIGGER_WAIT);
 
     /* Wait on the device triggering */
     do
@@ -152,7 +175,10 @@ int LA_MK3_recordTraffic(STAR_LA_LinkAnalyser linkAnalyser, STAR_LA_MK3_Traffic
             fputs("Unable to get trigger state\n", stderr);
             return 0;
         }
+        metricsSetGauge(METRIC_GAUGE_TRIGGER_STATE, triggerState);
     } while (STAR_LA_TRIGGERSTATE_TRIGGERED != triggerState);
+    statsStopPhase(STATS_PHASE_TRIGGER_WAIT);
+    statsStartPhase(STATS_PHASE_CAPTURE);
     /* Save timestamp */
     if (clock_gettime(CLOCK_REALTIME, triggerTime))
     {
@@ -161,6 +187,7 @@ int LA_MK3_recordTraffic(STAR_LA_LinkAnalyser linkAnalyser, STAR_LA_MK3_Traffic
     fprintf(stderr, "Triggered, continue recording for %.3f seconds\n", *captureDuration);
 
     /* Delay for specified capture duration */
+    /* (the device offers no traffic counts while recording, so only the phase and trigger state are live until the download) */
     if (0 < captureDurationS)
     {
         if (0 != sleep(captureDurationS))
@@ -189,9 +216,12 @@ int LA_MK3_recordTraffic(STAR_LA_LinkAnalyser linkAnalyser, STAR_LA_MK3_Traffic
         /* Print success */
         fputs("Recording completed\n", stderr);
     }
+    statsStopPhase(STATS_PHASE_CAPTURE);
 
     /* Get the recorded traffic */
+    statsStartPhase(STATS_PHASE_DOWNLOAD);
     *ppTraffic = STAR_LA_MK3_GetAllRecordedTraffic(linkAnalyser, trafficCount, charCaptureClockPeriod);
+    statsStopPhase(STATS_PHASE_DOWNLOAD);
 
     if (!*ppTraffic)
     {
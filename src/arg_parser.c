@@ -1,6 +1,13 @@
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
+#include <spw_la_api.h>
 #include "arg_parser.h"
+#include "file_writer.h"
+#include "compressor.h"
+#include "packet_filter.h"
+#include "latency_pairing.h"
+#include "packet_search.h"
 
 static int setArchiveSettings(char **str, char *delim, char **setting)
 {
@@ -54,6 +61,244 @@ static int parseArchiveOptions(char *arg, Settings *config)
     return counter;
 }
 
+static int parseTriggerStage(char *str, TriggerStage *stage)
+{
+    /* Loop counter */
+    int event = 0;
+    /* Index of the matching event name */
+    int found = -1;
+    /* Length of the event name */
+    size_t nameLength = 0;
+    /* Parsed numeric value */
+    unsigned long number = 0;
+    /* End of the parsed numeric value */
+    char *end = NULL;
+
+    /* Receiver followed by a colon */
+    if (('A' == str[0] || 'a' == str[0]) && ':' == str[1])
+    {
+        stage->recv = 0;
+    }
+    else if (('B' == str[0] || 'b' == str[0]) && ':' == str[1])
+    {
+        stage->recv = 1;
+    }
+    else
+    {
+        return 0;
+    }
+    str += 2;
+
+    /* Event name up to the optional value or repeat count */
+    nameLength = strcspn(str, "=*");
+    for (event = 0; event < (int)(sizeof(triggerEventNames) / sizeof(triggerEventNames[0])); event++)
+    {
+        if ((strlen(triggerEventNames[event]) == nameLength) && (0 == strncmp(str, triggerEventNames[event], nameLength)))
+        {
+            found = event;
+        }
+    }
+    /* Only assign a matched event, as char may be unsigned */
+    if (0 > found)
+    {
+        return 0;
+    }
+    stage->event = (char)found;
+    str += nameLength;
+
+    /* Defaults as used for the single stage trigger */
+    stage->value = 1;
+    stage->repeat = 1;
+
+    if ('=' == *str)
+    {
+        number = strtoul(str + 1, &end, 0);
+        if ((end == str + 1) || (0xFF < number))
+        {
+            return 0;
+        }
+        stage->value = (unsigned char)number;
+        str = end;
+    }
+    if ('*' == *str)
+    {
+        number = strtoul(str + 1, &end, 0);
+        if ((end == str + 1) || (0 == number) || (0xFFFF < number))
+        {
+            return 0;
+        }
+        stage->repeat = (unsigned short)number;
+        str = end;
+    }
+
+    return ('\0' == *str);
+}
+
+static int parseTriggerSequence(char *arg, Settings *config)
+{
+    /* Context for tokenizing the stages */
+    char *savePtr = NULL;
+    /* Current stage string */
+    char *stage = NULL;
+    /* Number of parsed stages */
+    int counter = 0;
+
+    /* Replace the sequence of a previous trigger option */
+    free(config->trigSpec);
+    config->trigStageCount = 0;
+
+    /* Keep the unmodified sequence for the capture log header */
+    config->trigSpec = strdup(arg);
+
+    for (stage = strtok_r(arg, ",", &savePtr); NULL != stage; stage = strtok_r(NULL, ",", &savePtr))
+    {
+        if ((MAX_TRIGGER_STAGES <= counter) || (0 == parseTriggerStage(stage, &config->trigStages[counter])))
+        {
+            fprintf(stderr, "\nInvalid trigger stage '%s'.\n", stage);
+            return 0;
+        }
+        counter++;
+    }
+    if (0 == counter)
+    {
+        fputs("\nEmpty trigger sequence.\n", stderr);
+    }
+    config->trigStageCount = counter;
+
+    return counter;
+}
+
+static int parseLogExclusions(char *arg, Settings *config)
+{
+    /* Context for tokenizing the exclusions */
+    char *savePtr = NULL;
+    /* Current exclusion string */
+    char *exclusion = NULL;
+    /* Loop counter */
+    int type = 0;
+    /* Event type of the current exclusion (-1 = unknown) */
+    int excluded = -1;
+
+    /* Replace the exclusions of a previous exclude option */
+    free(config->logExcludeSpec);
+    config->logExclude[0] = 0;
+    config->logExclude[1] = 0;
+
+    /* Keep the unmodified exclusions for the capture log header */
+    config->logExcludeSpec = strdup(arg);
+
+    for (exclusion = strtok_r(arg, ",", &savePtr); NULL != exclusion; exclusion = strtok_r(NULL, ",", &savePtr))
+    {
+        /* Receiver followed by a colon */
+        excluded = -1;
+        if (('\0' != exclusion[0]) && (NULL != strchr("aAbB*", exclusion[0])) && (':' == exclusion[1]))
+        {
+            for (type = LOG_EVENT_HEADER; type <= LOG_EVENT_GOT_BIT; type++)
+            {
+                if (0 == strcmp(exclusion + 2, logEventNames[type]))
+                {
+                    excluded = type;
+                }
+            }
+        }
+        if (0 > excluded)
+        {
+            fprintf(stderr, "\nInvalid event log exclusion '%s'.\n", exclusion);
+            return 0;
+        }
+        if ('b' != tolower((unsigned char)exclusion[0]))
+        {
+            config->logExclude[0] |= 1u << excluded;
+        }
+        if ('a' != tolower((unsigned char)exclusion[0]))
+        {
+            config->logExclude[1] |= 1u << excluded;
+        }
+    }
+
+    return 1;
+}
+
+static int parseFsyncPolicy(const char *arg)
+{
+    /* Loop counter */
+    int i = 0;
+    /* The parsed policy (-1 = unknown) */
+    int policy = -1;
+
+    for (i = FSYNC_NONE; i <= FSYNC_BUFFER; i++)
+    {
+        if (0 == strcmp(arg, fsyncPolicyNames[i]))
+        {
+            policy = i;
+        }
+    }
+
+    return policy;
+}
+
+static int parseSize(const char *arg, unsigned long long *size)
+{
+    /* Characters following the number */
+    char *unit = NULL;
+    /* The parsed number */
+    unsigned long long value = strtoull(arg, &unit, 10);
+    /* Multiplier of the unit */
+    unsigned long long multiplier = 0;
+
+    if (unit == arg)
+    {
+        multiplier = 0;
+    }
+    else if ('\0' == *unit)
+    {
+        multiplier = 1;
+    }
+    else if ((0 == strcmp(unit, "K")) || (0 == strcmp(unit, "k")))
+    {
+        multiplier = 1024ULL;
+    }
+    else if ((0 == strcmp(unit, "M")) || (0 == strcmp(unit, "m")))
+    {
+        multiplier = 1024ULL * 1024;
+    }
+    else if ((0 == strcmp(unit, "G")) || (0 == strcmp(unit, "g")))
+    {
+        multiplier = 1024ULL * 1024 * 1024;
+    }
+    *size = value * multiplier;
+
+    return (0 < multiplier);
+}
+
+static int parseErrorContext(const char *arg, Settings *config)
+{
+    /* Characters following the number */
+    char *unit = NULL;
+    /* The parsed number */
+    double value = strtod(arg, &unit);
+
+    if ((unit == arg) || (0.0 > value))
+    {
+        return 0;
+    }
+    if ((0 == strcmp(unit, "us")) && (0.0 < value))
+    {
+        /* Context given as capture time */
+        config->errorContextTime = value * 1e-6;
+        return 1;
+    }
+    if (('\0' == *unit) && (value == (double)(unsigned int)value))
+    {
+        /* Context given as number of events */
+        config->errorContext = (unsigned int)value;
+        config->errorContextTime = 0.0;
+        return 1;
+    }
+
+    return 0;
+}
+
 error_t parse_opt(int key, char *arg, struct argp_state *state)
 {
     /* Get the input argument from argp_parse, which we
@@ -88,6 +333,36 @@ error_t parse_opt(int key, char *arg, struct argp_state *state)
         config->trigFCT = 1;
         break;
 
+    case 'j':
+        /* Set number of formatting threads */
+        config->jobs = atoi(arg);
+        if (1 > config->jobs)
+        {
+            fputs("\nNumber of jobs has to be at least 1.\n", stderr);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case 'o':
+        /* Set output file */
+        config->outputFile = arg;
+        break;
+
+    case 'z':
+        /* Enable compression of the outputs */
+        config->compressLevel = (NULL != arg) ? atoi(arg) : COMPRESS_DEFAULT_LEVEL;
+        if ((1 > config->compressLevel) || (9 < config->compressLevel))
+        {
+            fputs("\nCompression level has to be between 1 and 9.\n", stderr);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case 'H':
+        /* Enable recording only the packet headers */
+        config->headerOnly = 1;
+        break;
+
     case 'r':
         /* Set receiver for trigger */
         if (!strcmp("A", arg) || !strcmp("a", arg))
@@ -104,6 +379,203 @@ error_t parse_opt(int key, char *arg, struct argp_state *state)
         }
         break;
 
+    case 't':
+        /* Read multi-stage trigger sequence */
+        if (0 == parseTriggerSequence(arg, config))
+        {
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_TRIG_DELAY:
+        /* Set delay of the trigger */
+        config->trigDelay = (unsigned int)strtoul(arg, NULL, 0);
+        break;
+
+    case KEY_POST_TRIG:
+        /* Set percentage of memory used after the trigger */
+        config->postTrigMemory = atoi(arg);
+        if ((0 > config->postTrigMemory) || (100 < config->postTrigMemory))
+        {
+            fputs("\nPost trigger memory has to be between 0 and 100 percent.\n", stderr);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_STATS:
+        /* Set file for the statistics report */
+        config->statsFile = arg;
+        break;
+
+    case KEY_SUMMARY:
+        /* Set file for the capture summary */
+        config->summaryFile = arg;
+        break;
+
+    case KEY_TIMECODES:
+        /* Set file for the time-code analysis */
+        config->timecodeFile = arg;
+        break;
+
+    case KEY_LATENCY:
+        /* Set file for the transaction latencies */
+        config->latencyFile = arg;
+        break;
+
+    case KEY_PAIR:
+        /* Compile the pairing rules once */
+        freePairingRules(config->pairRules);
+        config->pairSpec = arg;
+        config->pairRules = compilePairingRules(arg);
+        if (NULL == config->pairRules)
+        {
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_SEARCH:
+        /* Compile the search patterns once */
+        freeSearchPatterns(config->searchPatterns);
+        config->searchSpec = arg;
+        config->searchPatterns = compileSearchPatterns(arg);
+        if (NULL == config->searchPatterns)
+        {
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case 'i':
+        /* Set raw capture to read instead of recording */
+        config->inputFile = arg;
+        break;
+
+    case KEY_DIFF:
+        /* Set raw capture to compare against */
+        config->diffFile = arg;
+        break;
+
+    case KEY_DIFF_TOLERANCE:
+        /* Set time a matching packet may be shifted */
+        config->diffTolerance = atof(arg);
+        if (0.0 > config->diffTolerance)
+        {
+            fputs("\nDiff tolerance must not be negative.\n", stderr);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_DEDUP:
+        /* Set time after which a repeated packet is archived in full again */
+        config->archiveDedup = atof(arg);
+        if (0.0 >= config->archiveDedup)
+        {
+            fputs("\nDeduplication interval must be positive.\n", stderr);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_PAIR_TIMEOUT:
+        /* Set time after which a request is no longer answered */
+        config->pairTimeout = atof(arg);
+        if (0.0 >= config->pairTimeout)
+        {
+            fputs("\nPairing timeout has to be greater than 0 seconds.\n", stderr);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_METRICS:
+        /* Set port or file for exporting metrics */
+        config->metricsTarget = arg;
+        break;
+
+    case KEY_EVENT_LOG:
+        /* Set file for the event log */
+        config->eventLogFile = arg;
+        break;
+
+    case KEY_RAW:
+        /* Set file for the binary capture */
+        config->rawFile = arg;
+        break;
+
+    case KEY_COLUMNS:
+        /* Set directory for the column export */
+        config->columnsDir = arg;
+        break;
+
+    case KEY_PCAPNG:
+        /* Set named pipe or file for the PCAPNG stream */
+        config->pcapngTarget = arg;
+        break;
+
+    case KEY_ERRORS:
+        /* Set file for the error log */
+        config->errorLogFile = arg;
+        break;
+
+    case KEY_ERROR_CONTEXT:
+        /* Set context printed around each error */
+        if (0 == parseErrorContext(arg, config))
+        {
+            fprintf(stderr, "\nInvalid error context '%s'.\n", arg);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_FSYNC:
+        /* Set fsync policy of the output files */
+        config->fsyncPolicy = parseFsyncPolicy(arg);
+        if (0 > config->fsyncPolicy)
+        {
+            fprintf(stderr, "\nUnknown fsync policy '%s'.\n", arg);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_ROTATE_SIZE:
+        /* Set size limit of rotated output files */
+        if (!parseSize(arg, &config->rotateSize) || (0 == config->rotateSize))
+        {
+            fprintf(stderr, "\nInvalid rotation size '%s'.\n", arg);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_ROTATE_TIME:
+        /* Set capture time span of rotated output files */
+        config->rotateTime = atof(arg);
+        if (0.0 >= config->rotateTime)
+        {
+            fputs("\nRotation time has to be greater than 0 seconds.\n", stderr);
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_EXCLUDE:
+        /* Set event types left out of the event log */
+        if (0 == parseLogExclusions(arg, config))
+        {
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
+    case KEY_COLLAPSE:
+        /* Enable collapsing idle rows of the event log */
+        config->collapseIdle = 1;
+        break;
+
+    case KEY_FILTER:
+        /* Compile the packet filter once */
+        freePacketFilter(config->filter);
+        config->filterSpec = arg;
+        config->filter = compilePacketFilter(arg);
+        if (NULL == config->filter)
+        {
+            return ARGP_KEY_ERROR;
+        }
+        break;
+
     case 'p':
         /* Set pre trigger duration */
         config->preTrigger = atoi(arg);
@@ -122,9 +594,19 @@ error_t parse_opt(int key, char *arg, struct argp_state *state)
         break;
 
     case ARGP_KEY_END:
-        if (state->arg_num < 2)
+        if ((state->arg_num < 2) && (NULL == config->inputFile))
             /* Not enough arguments. */
             argp_usage(state);
+        /* Pair RMAP transactions, if no rules are given */
+        if ((NULL != config->latencyFile) && (NULL == config->pairRules))
+        {
+            config->pairSpec = PAIR_DEFAULT_RULES;
+            config->pairRules = compilePairingRules(config->pairSpec);
+            if (NULL == config->pairRules)
+            {
+                return ARGP_KEY_ERROR;
+            }
+        }
         break;
 
     default:
@@ -0,0 +1,719 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <spw_la_api.h>
+#include "arg_parser.h"
+#include "event_store.h"
+#include "packet_index.h"
+#include "data_logger.h"
+#include "capture_diff.h"
+
+/* Parameters of the 64 bit FNV-1a hash */
+#define HASH_FNV_OFFSET 0xCBF29CE484222325ULL
+#define HASH_FNV_PRIME 0x100000001B3ULL
+
+/* Names of the changes as printed */
+static const char *const kindNames[] = { "removed", "inserted", "modified", "shifted" };
+
+/* Names of the packet terminations as printed with the changes */
+static const char *const terminationNames[] = { "EOP", "EEP", "incomplete", "timecode" };
+
+/* Packets hashed by a single thread */
+struct hashJob
+{
+    const EventStore *store;        /* The recorded events */
+    const PacketIndex *index;       /* The packet index */
+    unsigned long long *hashes;     /* Hash of every indexed packet */
+    U32 first;                      /* Index of the first packet to hash */
+    U32 last;                       /* Index following the last packet to hash */
+    U8  *buffer;                    /* Buffer for gathering the bytes of a packet */
+};
+
+/* A section of both packet sequences still to be aligned */
+struct diffRange
+{
+    U32 xoff, xlim;                 /* Section of the reference sequence */
+    U32 yoff, ylim;                 /* Section of the compared sequence */
+};
+
+/* The packets of a receiver aligned by a single thread */
+struct alignJob
+{
+    const EventStore *oldStore;     /* The recorded events of the reference capture */
+    const PacketIndex *oldIndex;    /* The packet index of the reference capture */
+    const EventStore *newStore;     /* The recorded events of the compared capture */
+    const PacketIndex *newIndex;    /* The packet index of the compared capture */
+    const unsigned long long *a;    /* Hashes of the reference packets on the receiver */
+    const unsigned long long *b;    /* Hashes of the compared packets on the receiver */
+    const U32 *aEntries;            /* Index entries of the reference packets on the receiver */
+    const U32 *bEntries;            /* Index entries of the compared packets on the receiver */
+    U8  *removed;                   /* Reference packets not in the compared capture */
+    U8  *inserted;                  /* Compared packets not in the reference capture */
+    long long *fv;                  /* Furthest reaching forward paths per diagonal */
+    long long *bv;                  /* Furthest reaching backward paths per diagonal */
+    double tolerance;               /* Tolerance of the timing shift in seconds */
+    ReceiverDiff *result;           /* The changes on the receiver */
+};
+
+static void *hashPacketBlock(void *arg)
+{
+    /* The packets to hash */
+    struct hashJob *job = arg;
+    /* The current packet */
+    const PacketEntry *entry = NULL;
+    /* Loop counters */
+    U32 i = 0, j = 0;
+    /* Number of bytes of the current packet */
+    U32 length = 0;
+    /* Hash of the current packet */
+    unsigned long long hash = 0;
+
+    for (i = job->first; i < job->last; i++)
+    {
+        entry = &job->index->entries[i];
+        if (PACKET_TERM_TIMECODE == entry->termination)
+        {
+            continue;
+        }
+        length = LA_MK3_getPacketBytes(entry, job->store, job->buffer);
+        /* Packets only match with the same termination and error flags */
+        hash = (HASH_FNV_OFFSET ^ entry->termination) * HASH_FNV_PRIME;
+        hash = (hash ^ entry->errors) * HASH_FNV_PRIME;
+        for (j = 0; j < length; j++)
+        {
+            hash = (hash ^ job->buffer[j]) * HASH_FNV_PRIME;
+        }
+        job->hashes[i] = hash;
+    }
+
+    return NULL;
+}
+
+static int hashPackets(const EventStore *store, const PacketIndex *index, unsigned long long *hashes, int jobs)
+{
+    /* Loop counter */
+    int t = 0;
+    /* Number of threads hashing the packets */
+    int threadCount = (1 < jobs) ? jobs : 1;
+    /* Packets hashed by the individual threads */
+    struct hashJob *hashJobs = calloc((size_t)threadCount, sizeof(struct hashJob));
+    /* Threads hashing the packets */
+    pthread_t *threads = calloc((size_t)threadCount, sizeof(pthread_t));
+    /* Number of packets per thread */
+    U32 blockSize = index->count / (U32)threadCount + 1;
+    /* All memory needed for hashing has been allocated */
+    int allocated = (NULL != hashJobs) && (NULL != threads);
+
+    for (t = 0; allocated && (t < threadCount); t++)
+    {
+        hashJobs[t].store = store;
+        hashJobs[t].index = index;
+        hashJobs[t].hashes = hashes;
+        hashJobs[t].first = ((U32)t * blockSize < index->count) ? (U32)t * blockSize : index->count;
+        hashJobs[t].last = (hashJobs[t].first + blockSize < index->count) ? hashJobs[t].first + blockSize : index->count;
+        hashJobs[t].buffer = malloc(index->maxLength + 1);
+        allocated = (NULL != hashJobs[t].buffer);
+    }
+
+    if (allocated)
+    {
+        /* Hash consecutive blocks of packets in parallel */
+        for (t = 0; t < threadCount; t++)
+        {
+            if (0 != pthread_create(&threads[t], NULL, hashPacketBlock, &hashJobs[t]))
+            {
+                /* Hash block in this thread instead */
+                hashPacketBlock(&hashJobs[t]);
+                threads[t] = pthread_self();
+            }
+        }
+        for (t = 0; t < threadCount; t++)
+        {
+            if (!pthread_equal(threads[t], pthread_self()))
+            {
+                pthread_join(threads[t], NULL);
+            }
+        }
+    }
+
+    /* Free memory */
+    for (t = 0; (NULL != hashJobs) && (t < threadCount); t++)
+    {
+        free(hashJobs[t].buffer);
+    }
+    free(hashJobs);
+    free(threads);
+
+    return allocated;
+}
+
+/* Furthest reaching paths of a diagonal, relative to the center diagonal of the search */
+#define FV(d) job->fv[(d) - fmid + DIFF_MAX_COST + 2]
+#define BV(d) job->bv[(d) - bmid + DIFF_MAX_COST + 2]
+
+static void bisectRange(struct alignJob *job, const struct diffRange *range, U32 *xmid, U32 *ymid)
+{
+    /* Packet hashes of both sequences */
+    const unsigned long long *a = job->a;
+    const unsigned long long *b = job->b;
+    /* Bounds of the section */
+    const long long xoff = range->xoff, xlim = range->xlim, yoff = range->yoff, ylim = range->ylim;
+    /* Valid diagonals (x - y) of the section */
+    const long long dmin = xoff - ylim, dmax = xlim - yoff;
+    /* Center diagonals of the forward and backward search */
+    const long long fmid = xoff - yoff, bmid = xlim - ylim;
+    /* Diagonals reached by the forward and backward search */
+    long long fmin = fmid, fmax = fmid, bmin = bmid, bmax = bmid;
+    /* The searches meet on a forward step, if the center diagonals differ by an odd number */
+    const int odd = (int)((fmid - bmid) & 1);
+    /* Number of diff steps and current diagonal */
+    long long c = 0, d = 0;
+    /* Current position and best positions of the searches */
+    long long x = 0, y = 0, x0 = 0;
+    long long fxbest = xoff, fxybest = -1, bxbest = xlim, bxybest = 0;
+
+    FV(fmid) = xoff;
+    BV(bmid) = xlim;
+    for (c = 1;; c++)
+    {
+        /* Extend the forward search by a diff step on every diagonal */
+        if (fmin > dmin)
+        {
+            FV(--fmin - 1) = -1;
+        }
+        else
+        {
+            fmin++;
+        }
+        if (fmax < dmax)
+        {
+            FV(++fmax + 1) = -1;
+        }
+        else
+        {
+            fmax--;
+        }
+        for (d = fmax; d >= fmin; d -= 2)
+        {
+            x0 = (FV(d - 1) < FV(d + 1)) ? FV(d + 1) : FV(d - 1) + 1;
+            for (x = x0, y = x0 - d; (x < xlim) && (y < ylim) && (a[x] == b[y]); x++, y++)
+            {
+            }
+            FV(d) = x;
+            if (odd && (bmin <= d) && (d <= bmax) && (BV(d) <= x))
+            {
+                *xmid = (U32)x;
+                *ymid = (U32)y;
+                return;
+            }
+        }
+
+        /* Extend the backward search the same way */
+        if (bmin > dmin)
+        {
+            BV(--bmin - 1) = xlim + ylim + 1;
+        }
+        else
+        {
+            bmin++;
+        }
+        if (bmax < dmax)
+        {
+            BV(++bmax + 1) = xlim + ylim + 1;
+        }
+        else
+        {
+            bmax--;
+        }
+        for (d = bmax; d >= bmin; d -= 2)
+        {
+            x0 = (BV(d - 1) < BV(d + 1)) ? BV(d - 1) : BV(d + 1) - 1;
+            for (x = x0, y = x0 - d; (xoff < x) && (yoff < y) && (a[x - 1] == b[y - 1]); x--, y--)
+            {
+            }
+            BV(d) = x;
+            if (!odd && (fmin <= d) && (d <= fmax) && (x <= FV(d)))
+            {
+                *xmid = (U32)x;
+                *ymid = (U32)y;
+                return;
+            }
+        }
+
+        if (c >= DIFF_MAX_COST)
+        {
+            /* Too many changes for the shortest edit script, split at the furthest reaching path */
+            for (d = fmax; d >= fmin; d -= 2)
+            {
+                x = (FV(d) < xlim) ? FV(d) : xlim;
+                y = x - d;
+                if (ylim < y)
+                {
+                    x = ylim + d;
+                    y = ylim;
+                }
+                if (fxybest < x + y)
+                {
+                    fxybest = x + y;
+                    fxbest = x;
+                }
+            }
+            bxybest = xlim + ylim + 1;
+            for (d = bmax; d >= bmin; d -= 2)
+            {
+                x = (xoff < BV(d)) ? BV(d) : xoff;
+                y = x - d;
+                if (y < yoff)
+                {
+                    x = yoff + d;
+                    y = yoff;
+                }
+                if (x + y < bxybest)
+                {
+                    bxybest = x + y;
+                    bxbest = x;
+                }
+            }
+            if ((xlim + ylim) - bxybest < fxybest - (xoff + yoff))
+            {
+                *xmid = (U32)fxbest;
+                *ymid = (U32)(fxybest - fxbest);
+            }
+            else
+            {
+                *xmid = (U32)bxbest;
+                *ymid = (U32)(bxybest - bxbest);
+            }
+            return;
+        }
+    }
+}
+
+#undef FV
+#undef BV
+
+static int alignSequences(struct alignJob *job, U32 n, U32 m)
+{
+    /* Sections still to be aligned */
+    struct diffRange *stack = malloc(DIFF_INITIAL_CHANGES * sizeof(struct diffRange));
+    U32 depth = 0, capacity = DIFF_INITIAL_CHANGES;
+    /* Reallocated sections */
+    struct diffRange *grown = NULL;
+    /* The current section */
+    struct diffRange range = { 0, n, 0, m };
+    /* Position where the current section is split */
+    U32 xmid = 0, ymid = 0;
+
+    if (NULL == stack)
+    {
+        return 0;
+    }
+
+    /* The order of the sections does not matter, so they are kept on a stack instead of recursing */
+    stack[depth++] = range;
+    while (0 < depth)
+    {
+        range = stack[--depth];
+        /* Skip the packets the section starts and ends with in both captures */
+        while ((range.xoff < range.xlim) && (range.yoff < range.ylim) && (job->a[range.xoff] == job->b[range.yoff]))
+        {
+            range.xoff++;
+            range.yoff++;
+        }
+        while ((range.xoff < range.xlim) && (range.yoff < range.ylim) && (job->a[range.xlim - 1] == job->b[range.ylim - 1]))
+        {
+            range.xlim--;
+            range.ylim--;
+        }
+
+        if (range.xoff == range.xlim)
+        {
+            memset(&job->inserted[range.yoff], 1, range.ylim - range.yoff);
+        }
+        else if (range.yoff == range.ylim)
+        {
+            memset(&job->removed[range.xoff], 1, range.xlim - range.xoff);
+        }
+        else
+        {
+            bisectRange(job, &range, &xmid, &ymid);
+            if (depth + 2 > capacity)
+            {
+                grown = realloc(stack, 2 * (size_t)capacity * sizeof(struct diffRange));
+                if (NULL == grown)
+                {
+                    free(stack);
+                    return 0;
+                }
+                stack = grown;
+                capacity *= 2;
+            }
+            stack[depth].xoff = range.xoff;
+            stack[depth].xlim = xmid;
+            stack[depth].yoff = range.yoff;
+            stack[depth].ylim = ymid;
+            depth++;
+            stack[depth].xoff = xmid;
+            stack[depth].xlim = range.xlim;
+            stack[depth].yoff = ymid;
+            stack[depth].ylim = range.ylim;
+            depth++;
+        }
+    }
+
+    free(stack);
+
+    return 1;
+}
+
+static void appendChange(ReceiverDiff *result, U32 oldEntry, U32 newEntry, U8 kind)
+{
+    /* Reallocated changes */
+    DiffChange *changes = NULL;
+
+    if (result->count == result->capacity)
+    {
+        changes = realloc(result->changes, 2 * (size_t)result->capacity * sizeof(DiffChange));
+        if (NULL == changes)
+        {
+            result->failed = 1;
+            return;
+        }
+        result->changes = changes;
+        result->capacity *= 2;
+    }
+
+    result->changes[result->count].oldEntry = oldEntry;
+    result->changes[result->count].newEntry = newEntry;
+    result->changes[result->count].kind = kind;
+    result->count++;
+    result->kindCount[kind]++;
+
+    return;
+}
+
+static void collectChanges(struct alignJob *job, U32 n, U32 m)
+{
+    /* The changes on the receiver */
+    ReceiverDiff *result = job->result;
+    /* Positions in both sequences and start of the current change */
+    U32 i = 0, j = 0, iStart = 0, jStart = 0;
+    /* Loop counter */
+    U32 k = 0;
+    /* Timing shift of a matching packet in seconds */
+    double shift = 0.0;
+
+    while (((i < n) || (j < m)) && !result->failed)
+    {
+        if ((i < n) && (j < m) && !job->removed[i] && !job->inserted[j])
+        {
+            /* Matching packets, compared by their time relative to the trigger */
+            shift = job->newIndex->entries[job->bEntries[j]].startTime * job->newStore->clockPeriod -
+                    job->oldIndex->entries[job->aEntries[i]].startTime * job->oldStore->clockPeriod;
+            shift = (0.0 > shift) ? -shift : shift;
+            if (shift > result->maxShift)
+            {
+                result->maxShift = shift;
+            }
+            if (shift > job->tolerance)
+            {
+                appendChange(result, job->aEntries[i], job->bEntries[j], DIFF_SHIFTED);
+            }
+            result->equal++;
+            i++;
+            j++;
+            continue;
+        }
+
+        /* Removed and inserted packets of the same change are paired as modified */
+        for (iStart = i; (i < n) && job->removed[i]; i++)
+        {
+        }
+        for (jStart = j; (j < m) && job->inserted[j]; j++)
+        {
+        }
+        for (k = 0; (iStart + k < i) || (jStart + k < j); k++)
+        {
+            if ((iStart + k < i) && (jStart + k < j))
+            {
+                appendChange(result, job->aEntries[iStart + k], job->bEntries[jStart + k], DIFF_MODIFIED);
+            }
+            else if (iStart + k < i)
+            {
+                appendChange(result, job->aEntries[iStart + k], DIFF_NO_ENTRY, DIFF_REMOVED);
+            }
+            else
+            {
+                appendChange(result, DIFF_NO_ENTRY, job->bEntries[jStart + k], DIFF_INSERTED);
+            }
+        }
+    }
+
+    return;
+}
+
+static void *alignReceiver(void *arg)
+{
+    /* The packets of the receiver to align */
+    struct alignJob *job = arg;
+
+    if (!alignSequences(job, job->result->oldPackets, job->result->newPackets))
+    {
+        job->result->failed = 1;
+        return NULL;
+    }
+    collectChanges(job, job->result->oldPackets, job->result->newPackets);
+
+    return NULL;
+}
+
+static void splitReceivers(const PacketIndex *index, const unsigned long long *hashes, unsigned long long *sequence[2], U32 *entries[2], U32 count[2])
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* The current packet */
+    const PacketEntry *entry = NULL;
+
+    count[RECV_A] = count[RECV_B] = 0;
+    for (i = 0; i < index->count; i++)
+    {
+        entry = &index->entries[i];
+        if (PACKET_TERM_TIMECODE != entry->termination)
+        {
+            sequence[entry->receiver][count[entry->receiver]] = hashes[i];
+            entries[entry->receiver][count[entry->receiver]] = i;
+            count[entry->receiver]++;
+        }
+    }
+
+    return;
+}
+
+int LA_MK3_diffCaptures(CaptureDiff *diff, const EventStore *oldStore, const PacketIndex *oldIndex, const EventStore *newStore,
+                        const PacketIndex *newIndex, double tolerance, int jobs)
+{
+    /* Loop counter */
+    int r = 0;
+    /* Hashes of all indexed packets of both captures */
+    unsigned long long *oldHashes = malloc(((size_t)oldIndex->count + 1) * sizeof(unsigned long long));
+    unsigned long long *newHashes = malloc(((size_t)newIndex->count + 1) * sizeof(unsigned long long));
+    /* Hashes and index entries of the packets per receiver */
+    unsigned long long *oldSequence[2] = { NULL, NULL }, *newSequence[2] = { NULL, NULL };
+    U32 *oldEntries[2] = { NULL, NULL }, *newEntries[2] = { NULL, NULL };
+    U32 oldCount[2] = { 0, 0 }, newCount[2] = { 0, 0 };
+    /* Alignment of each receiver */
+    struct alignJob alignJobs[2];
+    /* Threads aligning the receivers */
+    pthread_t threads[2];
+    /* All memory needed for the comparison has been allocated */
+    int allocated = (NULL != oldHashes) && (NULL != newHashes);
+
+    memset(diff, 0, sizeof(CaptureDiff));
+    memset(alignJobs, 0, sizeof(alignJobs));
+    diff->tolerance = tolerance;
+
+    for (r = RECV_A; allocated && (r <= RECV_B); r++)
+    {
+        oldSequence[r] = malloc(((size_t)oldIndex->count + 1) * sizeof(unsigned long long));
+        newSequence[r] = malloc(((size_t)newIndex->count + 1) * sizeof(unsigned long long));
+        oldEntries[r] = malloc(((size_t)oldIndex->count + 1) * sizeof(U32));
+        newEntries[r] = malloc(((size_t)newIndex->count + 1) * sizeof(U32));
+        allocated = (NULL != oldSequence[r]) && (NULL != newSequence[r]) && (NULL != oldEntries[r]) && (NULL != newEntries[r]);
+    }
+
+    /* Hash the packets of both captures in parallel */
+    allocated = allocated && hashPackets(oldStore, oldIndex, oldHashes, jobs) && hashPackets(newStore, newIndex, newHashes, jobs);
+    if (allocated)
+    {
+        splitReceivers(oldIndex, oldHashes, oldSequence, oldEntries, oldCount);
+        splitReceivers(newIndex, newHashes, newSequence, newEntries, newCount);
+    }
+
+    for (r = RECV_A; allocated && (r <= RECV_B); r++)
+    {
+        diff->receivers[r].oldPackets = oldCount[r];
+        diff->receivers[r].newPackets = newCount[r];
+        diff->receivers[r].capacity = DIFF_INITIAL_CHANGES;
+        diff->receivers[r].changes = malloc(DIFF_INITIAL_CHANGES * sizeof(DiffChange));
+        alignJobs[r].oldStore = oldStore;
+        alignJobs[r].oldIndex = oldIndex;
+        alignJobs[r].newStore = newStore;
+        alignJobs[r].newIndex = newIndex;
+        alignJobs[r].a = oldSequence[r];
+        alignJobs[r].b = newSequence[r];
+        alignJobs[r].aEntries = oldEntries[r];
+        alignJobs[r].bEntries = newEntries[r];
+        alignJobs[r].removed = calloc((size_t)oldCount[r] + 1, sizeof(U8));
+        alignJobs[r].inserted = calloc((size_t)newCount[r] + 1, sizeof(U8));
+        alignJobs[r].fv = malloc((2 * DIFF_MAX_COST + 5) * sizeof(long long));
+        alignJobs[r].bv = malloc((2 * DIFF_MAX_COST + 5) * sizeof(long long));
+        alignJobs[r].tolerance = tolerance;
+        alignJobs[r].result = &diff->receivers[r];
+        allocated = (NULL != diff->receivers[r].changes) && (NULL != alignJobs[r].removed) && (NULL != alignJobs[r].inserted) &&
+                    (NULL != alignJobs[r].fv) && (NULL != alignJobs[r].bv);
+    }
+
+    if (allocated)
+    {
+        /* Align both receivers in parallel */
+        for (r = RECV_A; r <= RECV_B; r++)
+        {
+            if ((1 >= jobs) || (0 != pthread_create(&threads[r], NULL, alignReceiver, &alignJobs[r])))
+            {
+                /* Align receiver in this thread instead */
+                alignReceiver(&alignJobs[r]);
+                threads[r] = pthread_self();
+            }
+        }
+        for (r = RECV_A; r <= RECV_B; r++)
+        {
+            if (!pthread_equal(threads[r], pthread_self()))
+            {
+                pthread_join(threads[r], NULL);
+            }
+            allocated = allocated && !diff->receivers[r].failed;
+        }
+    }
+
+    if (!allocated)
+    {
+        fputs("Unable to allocate memory for comparing the captures\n", stderr);
+        freeCaptureDiff(diff);
+    }
+
+    /* Free memory */
+    for (r = RECV_A; r <= RECV_B; r++)
+    {
+        free(oldSequence[r]);
+        free(newSequence[r]);
+        free(oldEntries[r]);
+        free(newEntries[r]);
+        free(alignJobs[r].removed);
+        free(alignJobs[r].inserted);
+        free(alignJobs[r].fv);
+        free(alignJobs[r].bv);
+    }
+    free(oldHashes);
+    free(newHashes);
+
+    return allocated;
+}
+
+static double getChangeTime(const DiffChange *change, const EventStore *oldStore, const PacketIndex *oldIndex,
+                            const EventStore *newStore, const PacketIndex *newIndex)
+{
+    /* Removed packets only exist in the reference capture */
+    if (DIFF_NO_ENTRY == change->newEntry)
+    {
+        return oldIndex->entries[change->oldEntry].startTime * oldStore->clockPeriod;
+    }
+
+    return newIndex->entries[change->newEntry].startTime * newStore->clockPeriod;
+}
+
+unsigned long long printCaptureDiff(FILE *stream, const CaptureDiff *diff, const EventStore *oldStore, const PacketIndex *oldIndex,
+                                    struct timespec *oldTriggerTime, const EventStore *newStore, const PacketIndex *newIndex,
+                                    struct timespec *newTriggerTime)
+{
+    /* Position in the changes of receiver A and B */
+    U32 next[2] = { 0, 0 };
+    /* Receiver of the change printed next */
+    int r = 0;
+    /* The change printed next and the packets it refers to */
+    const DiffChange *change = NULL;
+    const PacketEntry *oldEntry = NULL, *newEntry = NULL, *entry = NULL;
+    /* Time difference of the packet to the trigger in seconds */
+    double deltaToTrigger = 0.0;
+    /* Timestamp of the packet */
+    char timestampStr[30];
+    /* Record numbers of the packet in both captures */
+    char oldRecord[12], newRecord[12];
+    /* Number of characters printed */
+    unsigned long long written = 0;
+
+    written += fprintf(stream, "# Dir Change     Old rec  New rec Timestamp                     Length Termination Detail\n");
+    while ((next[RECV_A] < diff->receivers[RECV_A].count) || (next[RECV_B] < diff->receivers[RECV_B].count))
+    {
+        /* Print the changes of both receivers in order of time */
+        r = (next[RECV_A] == diff->receivers[RECV_A].count) ? RECV_B : RECV_A;
+        if ((RECV_A == r) && (next[RECV_B] < diff->receivers[RECV_B].count) &&
+            (getChangeTime(&diff->receivers[RECV_B].changes[next[RECV_B]], oldStore, oldIndex, newStore, newIndex) <
+             getChangeTime(&diff->receivers[RECV_A].changes[next[RECV_A]], oldStore, oldIndex, newStore, newIndex)))
+        {
+            r = RECV_B;
+        }
+        change = &diff->receivers[r].changes[next[r]++];
+
+        oldEntry = (DIFF_NO_ENTRY != change->oldEntry) ? &oldIndex->entries[change->oldEntry] : NULL;
+        newEntry = (DIFF_NO_ENTRY != change->newEntry) ? &newIndex->entries[change->newEntry] : NULL;
+        entry = (NULL != newEntry) ? newEntry : oldEntry;
+        /* The record numbers count the records of the hexdump of each capture */
+        strcpy(oldRecord, "-");
+        strcpy(newRecord, "-");
+        if (NULL != oldEntry)
+        {
+            snprintf(oldRecord, sizeof(oldRecord), "%u", change->oldEntry + 1);
+        }
+        if (NULL != newEntry)
+        {
+            snprintf(newRecord, sizeof(newRecord), "%u", change->newEntry + 1);
+        }
+        deltaToTrigger = getChangeTime(change, oldStore, oldIndex, newStore, newIndex);
+        LA_MK3_getPacketTimestamp(&deltaToTrigger, (NULL != newEntry) ? newTriggerTime : oldTriggerTime, timestampStr);
+        written += fprintf(stream, "%c   %-9s %8s %8s %s %6u %s", r ? 'O' : 'I', kindNames[change->kind], oldRecord, newRecord,
+                           timestampStr, entry->length, terminationNames[entry->termination]);
+
+        /* Align the details of modified and shifted packets after the termination column */
+        if (DIFF_MODIFIED == change->kind)
+        {
+            written += fprintf(stream, "%*s was %u %s", (int)(11 - strlen(terminationNames[entry->termination])), "",
+                               oldEntry->length, terminationNames[oldEntry->termination]);
+        }
+        else if (DIFF_SHIFTED == change->kind)
+        {
+            written += fprintf(stream, "%*s shift %+.3fus", (int)(11 - strlen(terminationNames[entry->termination])), "",
+                               (newEntry->startTime * newStore->clockPeriod - oldEntry->startTime * oldStore->clockPeriod) * 1e6);
+        }
+        written += fprintf(stream, "\n");
+    }
+
+    return written;
+}
+
+void printDiffTable(FILE *stream, const CaptureDiff *diff)
+{
+    /* Changes on receiver A and B */
+    const ReceiverDiff *a = &diff->receivers[RECV_A];
+    const ReceiverDiff *b = &diff->receivers[RECV_B];
+
+    fprintf(stream, "Capture diff (shift tolerance %.3fus)\n\n", diff->tolerance * 1e6);
+    fprintf(stream, "%-26s  %16s  %16s\n", "", "Receiver A", "Receiver B");
+    fprintf(stream, "%-26s  %16u  %16u\n", "Reference packets", a->oldPackets, b->oldPackets);
+    fprintf(stream, "%-26s  %16u  %16u\n", "Compared packets", a->newPackets, b->newPackets);
+    fprintf(stream, "%-26s  %16u  %16u\n", "Matching", a->equal, b->equal);
+    fprintf(stream, "%-26s  %16u  %16u\n", "Removed", a->kindCount[DIFF_REMOVED], b->kindCount[DIFF_REMOVED]);
+    fprintf(stream, "%-26s  %16u  %16u\n", "Inserted", a->kindCount[DIFF_INSERTED], b->kindCount[DIFF_INSERTED]);
+    fprintf(stream, "%-26s  %16u  %16u\n", "Modified", a->kindCount[DIFF_MODIFIED], b->kindCount[DIFF_MODIFIED]);
+    fprintf(stream, "%-26s  %16u  %16u\n", "Shifted", a->kindCount[DIFF_SHIFTED], b->kindCount[DIFF_SHIFTED]);
+    fprintf(stream, "%-26s  %16.3f  %16.3f\n", "Max shift (us)", a->maxShift * 1e6, b->maxShift * 1e6);
+
+    return;
+}
+
+void freeCaptureDiff(CaptureDiff *diff)
+{
+    /* Loop counter */
+    int r = 0;
+
+    for (r = RECV_A; r <= RECV_B; r++)
+    {
+        free(diff->receivers[r].changes);
+        diff->receivers[r].changes = NULL;
+        diff->receivers[r].count = 0;
+        diff->receivers[r].capacity = 0;
+    }
+
+    return;
+}
@@ -0,0 +1,480 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <json-c/json.h>
+#include <spw_la_api.h>
+#include "arg_parser.h"
+#include "config_logger.h"
+#include "event_store.h"
+#include "packet_index.h"
+#include "capture_summary.h"
+
+/* Receiver names as used in the report */
+static const char *const receiverNames[] = { "a", "b" };
+
+/* Steps of the 1-2-5 series splitting the gap buckets */
+static const unsigned int gapSteps[] = { 1, 2, 5 };
+
+static unsigned long long getGapBound(int bucket)
+{
+    /* Upper bound in nanoseconds of the gap bucket */
+    unsigned long long bound = gapSteps[bucket % 3] * 10ull;
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; i < bucket / 3; i++)
+    {
+        bound *= 10;
+    }
+
+    return bound;
+}
+
+static int getGapBucket(double seconds)
+{
+    /* Bucket of the gap */
+    int bucket = 0;
+    /* Gap in whole nanoseconds, so that gaps on a bound are not split by rounding */
+    unsigned long long nanoseconds = (unsigned long long)(seconds * 1e9 + 0.5);
+
+    while ((bucket < SUMMARY_GAP_BUCKETS - 1) && (nanoseconds >= getGapBound(bucket)))
+    {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static int getLengthBucket(U32 length)
+{
+    /* Bucket of the length */
+    int bucket = 0;
+
+    while ((bucket < SUMMARY_LENGTH_BUCKETS - 1) && (length >> (bucket + 1)))
+    {
+        bucket++;
+    }
+
+    return bucket;
+}
+
+static void addInterval(SummaryInterval *interval, double seconds)
+{
+    if ((0 == interval->count) || (seconds < interval->min))
+    {
+        interval->min = seconds;
+    }
+    if ((0 == interval->count) || (seconds > interval->max))
+    {
+        interval->max = seconds;
+    }
+    interval->sum += seconds;
+    interval->sumSquares += seconds * seconds;
+    interval->count++;
+
+    return;
+}
+
+static double getIntervalDeviation(const SummaryInterval *interval)
+{
+    /* Mean of the differences */
+    double mean = (0 < interval->count) ? interval->sum / interval->count : 0.0;
+    /* Variance of the differences */
+    double variance = (0 < interval->count) ? interval->sumSquares / interval->count - mean * mean : 0.0;
+
+    return (0.0 < variance) ? sqrt(variance) : 0.0;
+}
+
+static void summarizeEntry(CaptureSummary *summary, const PacketEntry *entry, const EventStore *store, long long binTicks)
+{
+    /* Statistics of the receiver of the entry */
+    ReceiverSummary *receiver = &summary->receivers[entry->receiver];
+    /* Capture clock tick of the terminating event */
+    long long endTime = 0;
+    /* Time bin of the header */
+    long long bin = (entry->startTime - summary->startTime) / binTicks;
+    /* Time-code value */
+    U8 value = 0;
+    /* Loop counter */
+    int i = 0;
+
+    if (PACKET_TERM_TIMECODE == entry->termination)
+    {
+        value = store->data[entry->receiver][entry->startEvent] & 0x3F;
+        if (receiver->hasTimecode)
+        {
+            addInterval(&receiver->timecodeInterval, (entry->startTime - receiver->lastTimecode) * summary->clockPeriod);
+            if (value != ((receiver->lastTimecodeValue + 1) & 0x3F))
+            {
+                receiver->timecodeSkips++;
+            }
+        }
+        receiver->timecodes++;
+        receiver->lastTimecode = entry->startTime;
+        receiver->lastTimecodeValue = value;
+        receiver->hasTimecode = 1;
+        return;
+    }
+
+    receiver->packets++;
+    receiver->bytes += entry->length;
+    receiver->lengths[getLengthBucket(entry->length)]++;
+    if ((1 == receiver->packets) || (entry->length < receiver->minLength))
+    {
+        receiver->minLength = entry->length;
+    }
+    if (entry->length > receiver->maxLength)
+    {
+        receiver->maxLength = entry->length;
+    }
+    for (i = 0; i < SUMMARY_PACKET_ERRORS; i++)
+    {
+        if (entry->errors & (1u << i))
+        {
+            receiver->packetErrors[i]++;
+        }
+    }
+    receiver->binBytes[(bin < 0) ? 0 : ((bin >= SUMMARY_TIME_BINS) ? SUMMARY_TIME_BINS - 1 : bin)] += entry->length;
+
+    switch (entry->termination)
+    {
+    case PACKET_TERM_EOP:
+        receiver->eop++;
+        break;
+    case PACKET_TERM_EEP:
+        receiver->eep++;
+        break;
+    default:
+        /* Incomplete packets are indexed last and end no gap */
+        receiver->incomplete++;
+        return;
+    }
+
+    /* Packets on a receiver never overlap, so the gap to the previous one is never negative */
+    if (receiver->hasPacket)
+    {
+        addInterval(&receiver->gap, (entry->startTime - receiver->lastEnd) * summary->clockPeriod);
+        receiver->gaps[getGapBucket((entry->startTime - receiver->lastEnd) * summary->clockPeriod)]++;
+    }
+    endTime = advanceEventTime(store, entry->startEvent, entry->startTime, entry->endEvent);
+    receiver->lastEnd = endTime;
+    receiver->hasPacket = 1;
+
+    return;
+}
+
+void LA_MK3_summarizeCapture(CaptureSummary *summary, const EventStore *store, const PacketIndex *index)
+{
+    /* Capture clock ticks per time bin */
+    long long binTicks = 1;
+    /* Loop counter */
+    U32 i = 0;
+    /* Receiver counter */
+    int r = 0;
+    /* Error flags of an event */
+    U8 errors = 0;
+
+    memset(summary, 0, sizeof(CaptureSummary));
+    summary->clockPeriod = store->clockPeriod;
+    summary->filtered = index->filteredCount;
+    if (index->firstEvent < store->count)
+    {
+        summary->startTime = getEventTime(store, index->firstEvent);
+        summary->endTime = getEventTime(store, store->count - 1);
+    }
+    binTicks = (summary->endTime - summary->startTime) / SUMMARY_TIME_BINS + 1;
+    summary->binSeconds = binTicks * summary->clockPeriod;
+
+    for (i = 0; i < index->count; i++)
+    {
+        summarizeEntry(summary, &index->entries[i], store, binTicks);
+    }
+
+    /* Count the error flags of the events within the pre trigger duration */
+    for (i = 0; i < store->errorCount; i++)
+    {
+        if (store->errors[i].event < index->firstEvent)
+        {
+            continue;
+        }
+        for (r = RECV_A; r <= RECV_B; r++)
+        {
+            errors = store->errors[i].errors[r];
+            summary->receivers[r].parityErrors += (0 != STAR_LA_MK3_ParityError(errors));
+            summary->receivers[r].rxCreditErrors += (0 != STAR_LA_MK3_ReceiverCreditError(errors));
+            summary->receivers[r].txCreditErrors += (0 != STAR_LA_MK3_TransmitterCreditError(errors));
+        }
+    }
+
+    return;
+}
+
+static struct json_object *newIntervalObject(const SummaryInterval *interval)
+{
+    /* JSON object of the interval in microseconds */
+    struct json_object *object = json_object_new_object();
+
+    json_object_object_add(object, "count", json_object_new_int64((int64_t)interval->count));
+    if (0 < interval->count)
+    {
+        json_object_object_add(object, "min_us", json_object_new_double(interval->min * 1e6));
+        json_object_object_add(object, "mean_us", json_object_new_double(interval->sum / interval->count * 1e6));
+        json_object_object_add(object, "max_us", json_object_new_double(interval->max * 1e6));
+        json_object_object_add(object, "stddev_us", json_object_new_double(getIntervalDeviation(interval) * 1e6));
+    }
+
+    return object;
+}
+
+static struct json_object *newReceiverObject(const CaptureSummary *summary, const ReceiverSummary *receiver)
+{
+    /* JSON objects of the receiver */
+    struct json_object *object = json_object_new_object();
+    struct json_object *lengths = json_object_new_array();
+    struct json_object *gaps = json_object_new_array();
+    struct json_object *errors = json_object_new_object();
+    struct json_object *timecodes = json_object_new_object();
+    struct json_object *utilization = json_object_new_array();
+    struct json_object *bucket = NULL;
+    /* Loop counter */
+    int i = 0;
+
+    json_object_object_add(object, "packets", json_object_new_int64((int64_t)receiver->packets));
+    json_object_object_add(object, "bytes", json_object_new_int64((int64_t)receiver->bytes));
+    json_object_object_add(object, "eop", json_object_new_int64((int64_t)receiver->eop));
+    json_object_object_add(object, "eep", json_object_new_int64((int64_t)receiver->eep));
+    json_object_object_add(object, "incomplete", json_object_new_int64((int64_t)receiver->incomplete));
+    if (0 < receiver->packets)
+    {
+        json_object_object_add(object, "min_length", json_object_new_int64(receiver->minLength));
+        json_object_object_add(object, "mean_length", json_object_new_double((double)receiver->bytes / receiver->packets));
+        json_object_object_add(object, "max_length", json_object_new_int64(receiver->maxLength));
+    }
+
+    /* Only buckets holding packets are listed */
+    for (i = 0; i < SUMMARY_LENGTH_BUCKETS; i++)
+    {
+        if (0 < receiver->lengths[i])
+        {
+            bucket = json_object_new_object();
+            json_object_object_add(bucket, "min_bytes", json_object_new_int64(1ll << i));
+            json_object_object_add(bucket, "max_bytes", json_object_new_int64((2ll << i) - 1));
+            json_object_object_add(bucket, "packets", json_object_new_int64((int64_t)receiver->lengths[i]));
+            json_object_array_add(lengths, bucket);
+        }
+    }
+    json_object_object_add(object, "length_histogram", lengths);
+
+    json_object_object_add(object, "gap", newIntervalObject(&receiver->gap));
+    for (i = 0; i < SUMMARY_GAP_BUCKETS; i++)
+    {
+        if (0 < receiver->gaps[i])
+        {
+            bucket = json_object_new_object();
+            json_object_object_add(bucket, "min_us", json_object_new_double((0 < i) ? getGapBound(i - 1) * 1e-3 : 0.0));
+            if (SUMMARY_GAP_BUCKETS - 1 > i)
+            {
+                json_object_object_add(bucket, "max_us", json_object_new_double(getGapBound(i) * 1e-3));
+            }
+            json_object_object_add(bucket, "gaps", json_object_new_int64((int64_t)receiver->gaps[i]));
+            json_object_array_add(gaps, bucket);
+        }
+    }
+    json_object_object_add(object, "gap_histogram", gaps);
+
+    for (i = 0; i < SUMMARY_PACKET_ERRORS; i++)
+    {
+        json_object_object_add(errors, summaryPacketErrorNames[i], json_object_new_int64((int64_t)receiver->packetErrors[i]));
+    }
+    json_object_object_add(errors, "parity_events", json_object_new_int64((int64_t)receiver->parityErrors));
+    json_object_object_add(errors, "rx_credit_events", json_object_new_int64((int64_t)receiver->rxCreditErrors));
+    json_object_object_add(errors, "tx_credit_events", json_object_new_int64((int64_t)receiver->txCreditErrors));
+    json_object_object_add(object, "errors", errors);
+
+    for (i = 0; i < SUMMARY_TIME_BINS; i++)
+    {
+        json_object_array_add(utilization, json_object_new_double(receiver->binBytes[i] / summary->binSeconds));
+    }
+    json_object_object_add(object, "bytes_per_second", utilization);
+
+    json_object_object_add(timecodes, "count", json_object_new_int64((int64_t)receiver->timecodes));
+    json_object_object_add(timecodes, "interval", newIntervalObject(&receiver->timecodeInterval));
+    json_object_object_add(timecodes, "skips", json_object_new_int64((int64_t)receiver->timecodeSkips));
+    json_object_object_add(object, "timecodes", timecodes);
+
+    return object;
+}
+
+int writeSummaryReport(const char *fileName, const CaptureSummary *summary, Settings settings, struct timespec *triggerTime)
+{
+    /* Loop counter */
+    int r = 0;
+    /* Trigger time as string */
+    char triggerTimeStr[30] = "";
+    /* JSON objects of the report */
+    struct json_object *report = json_object_new_object();
+    struct json_object *receivers = json_object_new_object();
+    /* The report file */
+    FILE *file = NULL;
+    /* Return value */
+    int ret = 0;
+
+    json_object_object_add(report, "version", json_object_new_string(settings.version));
+    if (NULL != settings.inputFile)
+    {
+        json_object_object_add(report, "input", json_object_new_string(settings.inputFile));
+    }
+    else
+    {
+        json_object_object_add(report, "serial_number", json_object_new_string(settings.args[0]));
+    }
+    if ((NULL != triggerTime) && timeToStr(triggerTime, triggerTimeStr))
+    {
+        json_object_object_add(report, "trigger_time", json_object_new_string(triggerTimeStr));
+    }
+    if (NULL != settings.filterSpec)
+    {
+        json_object_object_add(report, "filter", json_object_new_string(settings.filterSpec));
+        json_object_object_add(report, "filtered", json_object_new_int64((int64_t)summary->filtered));
+    }
+    json_object_object_add(report, "start_ms", json_object_new_double(summary->startTime * summary->clockPeriod * 1000.0));
+    json_object_object_add(report, "end_ms", json_object_new_double(summary->endTime * summary->clockPeriod * 1000.0));
+    json_object_object_add(report, "bin_ms", json_object_new_double(summary->binSeconds * 1000.0));
+    for (r = RECV_A; r <= RECV_B; r++)
+    {
+        json_object_object_add(receivers, receiverNames[r], newReceiverObject(summary, &summary->receivers[r]));
+    }
+    json_object_object_add(report, "receivers", receivers);
+
+    file = fopen(fileName, "w");
+    if (NULL == file)
+    {
+        fprintf(stderr, "Unable to open summary report %s\n", fileName);
+    }
+    else
+    {
+        ret = (0 <= fprintf(file, "%s\n", json_object_to_json_string_ext(report, JSON_C_TO_STRING_PRETTY)));
+        ret = (0 == fclose(file)) && ret;
+        if (!ret)
+        {
+            fprintf(stderr, "Unable to write summary report %s\n", fileName);
+        }
+    }
+
+    json_object_put(report);
+
+    return ret;
+}
+
+static char *formatDuration(char *buffer, size_t size, double seconds)
+{
+    if (seconds >= 1.0)
+    {
+        snprintf(buffer, size, "%.3gs", seconds);
+    }
+    else if (seconds >= 1e-3)
+    {
+        snprintf(buffer, size, "%.3gms", seconds * 1e3);
+    }
+    else if (seconds >= 1e-6)
+    {
+        snprintf(buffer, size, "%.3gus", seconds * 1e6);
+    }
+    else
+    {
+        snprintf(buffer, size, "%.3gns", seconds * 1e9);
+    }
+
+    return buffer;
+}
+
+static void printIntervalRow(FILE *stream, const char *name, const CaptureSummary *summary, int interval)
+{
+    /* Loop counter */
+    int r = 0;
+    /* The interval of the receiver */
+    const SummaryInterval *range = NULL;
+    /* Formatted durations */
+    char min[16], mean[16], max[16];
+
+    fprintf(stream, "%-24s", name);
+    for (r = RECV_A; r <= RECV_B; r++)
+    {
+        range = interval ? &summary->receivers[r].timecodeInterval : &summary->receivers[r].gap;
+        if (0 < range->count)
+        {
+            fprintf(stream, "  %8s %8s %8s", formatDuration(min, sizeof(min), range->min),
+                    formatDuration(mean, sizeof(mean), range->sum / range->count), formatDuration(max, sizeof(max), range->max));
+        }
+        else
+        {
+            fprintf(stream, "  %26s", "-");
+        }
+    }
+    fputs("\n", stream);
+
+    return;
+}
+
+void printSummaryTable(FILE *stream, const CaptureSummary *summary)
+{
+    /* Statistics of receiver A and B */
+    const ReceiverSummary *a = &summary->receivers[RECV_A];
+    const ReceiverSummary *b = &summary->receivers[RECV_B];
+    /* Loop counter */
+    int i = 0;
+    /* Formatted durations */
+    char from[16], to[16], span[16];
+
+    fprintf(stream, "Capture summary from %.4fms to %.4fms\n\n",
+            summary->startTime * summary->clockPeriod * 1000.0, summary->endTime * summary->clockPeriod * 1000.0);
+    fprintf(stream, "%-24s  %26s  %26s\n", "", "Receiver A", "Receiver B");
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Packets", a->packets, b->packets);
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Bytes", a->bytes, b->bytes);
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Terminated by EOP", a->eop, b->eop);
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Terminated by EEP", a->eep, b->eep);
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Incomplete", a->incomplete, b->incomplete);
+    fprintf(stream, "%-24s  %8u %8.1f %8u  %8u %8.1f %8u\n", "Length min/mean/max",
+            a->minLength, (0 < a->packets) ? (double)a->bytes / a->packets : 0.0, a->maxLength,
+            b->minLength, (0 < b->packets) ? (double)b->bytes / b->packets : 0.0, b->maxLength);
+    printIntervalRow(stream, "Gap min/mean/max", summary, 0);
+    for (i = 0; i < SUMMARY_PACKET_ERRORS; i++)
+    {
+        fprintf(stream, "Packets with %-11s  %26llu  %26llu\n", summaryPacketErrorNames[i], a->packetErrors[i], b->packetErrors[i]);
+    }
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Parity error events", a->parityErrors, b->parityErrors);
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Rx credit error events", a->rxCreditErrors, b->rxCreditErrors);
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Tx credit error events", a->txCreditErrors, b->txCreditErrors);
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Time-codes", a->timecodes, b->timecodes);
+    printIntervalRow(stream, "Time-code min/mean/max", summary, 1);
+    fprintf(stream, "%-24s  %26llu  %26llu\n", "Time-code skips", a->timecodeSkips, b->timecodeSkips);
+
+    fprintf(stream, "\n%-24s  %26s  %26s\n", "Packet length", "Receiver A", "Receiver B");
+    for (i = 0; i < SUMMARY_LENGTH_BUCKETS; i++)
+    {
+        if ((0 < a->lengths[i]) || (0 < b->lengths[i]))
+        {
+            fprintf(stream, "%11llu - %-10llu  %26llu  %26llu\n", 1ull << i, (2ull << i) - 1, a->lengths[i], b->lengths[i]);
+        }
+    }
+
+    fprintf(stream, "\n%-24s  %26s  %26s\n", "Inter-packet gap", "Receiver A", "Receiver B");
+    for (i = 0; i < SUMMARY_GAP_BUCKETS; i++)
+    {
+        if ((0 < a->gaps[i]) || (0 < b->gaps[i]))
+        {
+            fprintf(stream, "%11s - %-10s  %26llu  %26llu\n", (0 < i) ? formatDuration(from, sizeof(from), getGapBound(i - 1) * 1e-9) : "0",
+                    (SUMMARY_GAP_BUCKETS - 1 > i) ? formatDuration(to, sizeof(to), getGapBound(i) * 1e-9) : "", a->gaps[i], b->gaps[i]);
+        }
+    }
+
+    fprintf(stream, "\nThroughput per %-9s  %21s/s  %21s/s\n", formatDuration(span, sizeof(span), summary->binSeconds), "Bytes A", "Bytes B");
+    for (i = 0; i < SUMMARY_TIME_BINS; i++)
+    {
+        fprintf(stream, "%22.4fms  %26.0f  %26.0f\n", (summary->startTime * summary->clockPeriod + i * summary->binSeconds) * 1000.0,
+                a->binBytes[i] / summary->binSeconds, b->binBytes[i] / summary->binSeconds);
+    }
+
+    return;
+}
@@ -0,0 +1,449 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <json-c/json.h>
+#include <spw_la_api.h>
+#include "arg_parser.h"
+#include "config_logger.h"
+#include "data_logger.h"
+#include "event_store.h"
+#include "packet_index.h"
+#include "file_writer.h"
+#include "columnar_export.h"
+
+/* Columns of the export */
+enum exportColumn {
+    COLUMN_EVENT_TICK,
+    COLUMN_A_TYPE,
+    COLUMN_A_DATA,
+    COLUMN_A_ERRORS,
+    COLUMN_B_TYPE,
+    COLUMN_B_DATA,
+    COLUMN_B_ERRORS,
+    COLUMN_PACKET_START_TICK,
+    COLUMN_PACKET_END_TICK,
+    COLUMN_PACKET_START_EVENT,
+    COLUMN_PACKET_END_EVENT,
+    COLUMN_PACKET_LENGTH,
+    COLUMN_PACKET_RECEIVER,
+    COLUMN_PACKET_TERMINATION,
+    COLUMN_PACKET_ERRORS,
+    COLUMN_PACKET_RMAP,
+    COLUMN_COUNT
+};
+
+/* Description of an exported column */
+struct columnInfo
+{
+    const char *name;           /* Name of the column and its file */
+    const char *dtype;          /* Element type as numpy dtype string */
+    U32 size;                   /* Size of an element in bytes */
+    char packets;               /* The column belongs to the packet table instead of the event table */
+    const char *description;    /* Description written to the schema */
+};
+
+static const struct columnInfo columnInfos[COLUMN_COUNT] = {
+    { "event_tick", "<i8", 8, 0, "Capture clock tick of the event relative to the trigger" },
+    { "a_type", "|u1", 1, 0, "Event type on receiver A (see event_types)" },
+    { "a_data", "|u1", 1, 0, "Event data on receiver A" },
+    { "a_errors", "|u1", 1, 0, "Error flags of the event on receiver A (see event_errors)" },
+    { "b_type", "|u1", 1, 0, "Event type on receiver B (see event_types)" },
+    { "b_data", "|u1", 1, 0, "Event data on receiver B" },
+    { "b_errors", "|u1", 1, 0, "Error flags of the event on receiver B (see event_errors)" },
+    { "packet_start_tick", "<i8", 8, 1, "Capture clock tick of the header relative to the trigger" },
+    { "packet_end_tick", "<i8", 8, 1, "Capture clock tick of the terminating or last recorded event relative to the trigger" },
+    { "packet_start_event", "<u4", 4, 1, "Row of the header in the event columns" },
+    { "packet_end_event", "<u4", 4, 1, "Row of the terminating or last recorded event in the event columns" },
+    { "packet_length", "<u4", 4, 1, "Number of bytes in the packet" },
+    { "packet_receiver", "|u1", 1, 1, "Receiver the packet was recorded on (0 = A, 1 = B)" },
+    { "packet_termination", "|u1", 1, 1, "Termination of the packet (see terminations)" },
+    { "packet_errors", "|u1", 1, 1, "Error flags of the packet (see packet_errors)" },
+    { "packet_rmap", "|u1", 1, 1, "RMAP flags of the packet (see rmap_flags, 0 = no RMAP packet)" }
+};
+
+/* Names of the packet terminations in the schema */
+static const char *const terminationNames[] = { "eop", "eep", "incomplete", "timecode" };
+
+/* Names of the packet error flags in the schema, from the lowest bit */
+static const char *const packetErrorNames[] = { "parity", "rx_credit", "tx_credit", "sequence", "escape", "disconnect", "header" };
+
+/* Names of the RMAP flags in the schema, from the lowest bit */
+static const char *const rmapFlagNames[] = { "packet", "command", "header_crc", "data_crc", "length" };
+
+/* Position reached in the event store while writing a column */
+struct columnCursor
+{
+    long long time;             /* Capture clock tick of the previous event */
+    U32 error;                  /* Next entry of the error list */
+};
+
+static void putS64(U8 *buffer, long long value)
+{
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; i < 8; i++)
+    {
+        buffer[i] = (U8)((unsigned long long)value >> (8 * i));
+    }
+
+    return;
+}
+
+static void putU32(U8 *buffer, U32 value)
+{
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        buffer[i] = (U8)(value >> (8 * i));
+    }
+
+    return;
+}
+
+static void fillEventColumn(int column, const EventStore *store, U32 first, U32 count, U8 *buffer, struct columnCursor *cursor)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* Receiver of the error flags */
+    const int receiver = (COLUMN_A_ERRORS == column) ? RECV_A : RECV_B;
+
+    if (COLUMN_EVENT_TICK == column)
+    {
+        for (i = 0; i < count; i++)
+        {
+            cursor->time = getNextEventTime(store, first + i, cursor->time);
+            putS64(buffer + 8 * (size_t)i, cursor->time);
+        }
+    }
+    else
+    {
+        /* The error flags are kept sparse in order of the events */
+        memset(buffer, 0, count);
+        for (; (cursor->error < store->errorCount) && (store->errors[cursor->error].event < first + count); cursor->error++)
+        {
+            buffer[store->errors[cursor->error].event - first] = store->errors[cursor->error].errors[receiver];
+        }
+    }
+
+    return;
+}
+
+static void fillPacketColumn(int column, const EventStore *store, const PacketIndex *index, U32 first, U32 count, U8 *buffer)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* The current entry */
+    const PacketEntry *entry = NULL;
+
+    for (i = 0; i < count; i++)
+    {
+        entry = &index->entries[first + i];
+        switch (column)
+        {
+        case COLUMN_PACKET_START_TICK:
+            putS64(buffer + 8 * (size_t)i, entry->startTime);
+            break;
+        case COLUMN_PACKET_END_TICK:
+            putS64(buffer + 8 * (size_t)i, advanceEventTime(store, entry->startEvent, entry->startTime, entry->endEvent));
+            break;
+        case COLUMN_PACKET_START_EVENT:
+            putU32(buffer + 4 * (size_t)i, entry->startEvent - index->firstEvent);
+            break;
+        case COLUMN_PACKET_END_EVENT:
+            putU32(buffer + 4 * (size_t)i, entry->endEvent - index->firstEvent);
+            break;
+        case COLUMN_PACKET_LENGTH:
+            putU32(buffer + 4 * (size_t)i, entry->length);
+            break;
+        case COLUMN_PACKET_RECEIVER:
+            buffer[i] = entry->receiver;
+            break;
+        case COLUMN_PACKET_TERMINATION:
+            buffer[i] = entry->termination;
+            break;
+        case COLUMN_PACKET_ERRORS:
+            buffer[i] = entry->errors;
+            break;
+        default:
+            buffer[i] = entry->rmap;
+            break;
+        }
+    }
+
+    return;
+}
+
+static int writeColumn(const char *directory, int column, const EventStore *store, const PacketIndex *index, U8 *buffer, int fsyncPolicy)
+{
+    /* Description of the column */
+    const struct columnInfo *info = &columnInfos[column];
+    /* Number of rows of the column */
+    const U32 rows = info->packets ? index->count : store->count - index->firstEvent;
+    /* Row of the current block */
+    U32 row = 0;
+    /* Number of rows in the current block */
+    U32 count = 0;
+    /* Position reached in the event store */
+    struct columnCursor cursor = { 0, 0 };
+    /* Path of the column file */
+    char *fileName = malloc(strlen(directory) + strlen(info->name) + sizeof(COLUMNS_FILE_EXTENSION) + 1);
+    /* The column file */
+    FILE *stream = NULL;
+    /* Start of the type or data column, written without copying */
+    const U8 *bytes = NULL;
+    /* Return value */
+    int ret = 1;
+
+    if (NULL == fileName)
+    {
+        fputs("Unable to allocate memory for the column export\n", stderr);
+        return 0;
+    }
+    sprintf(fileName, "%s/%s%s", directory, info->name, COLUMNS_FILE_EXTENSION);
+    stream = writerOpen(fileName, (unsigned long long)rows * info->size, fsyncPolicy);
+    if (NULL == stream)
+    {
+        free(fileName);
+        return 0;
+    }
+
+    switch (column)
+    {
+    case COLUMN_A_TYPE:
+    case COLUMN_B_TYPE:
+        bytes = store->types[(COLUMN_A_TYPE == column) ? RECV_A : RECV_B] + index->firstEvent;
+        break;
+    case COLUMN_A_DATA:
+    case COLUMN_B_DATA:
+        bytes = store->data[(COLUMN_A_DATA == column) ? RECV_A : RECV_B] + index->firstEvent;
+        break;
+    default:
+        break;
+    }
+
+    /* Start the error list at the first exported event */
+    for (; (cursor.error < store->errorCount) && (store->errors[cursor.error].event < index->firstEvent); cursor.error++)
+    {
+    }
+    /* The time of the first exported event follows from that of the preceding one */
+    cursor.time = (0 < index->firstEvent) ? getEventTime(store, index->firstEvent - 1) : 0;
+
+    for (row = 0; ret && (row < rows); row += count)
+    {
+        count = (rows - row < COLUMNS_BLOCK_ROWS) ? rows - row : COLUMNS_BLOCK_ROWS;
+        if (NULL != bytes)
+        {
+            ret = (count == fwrite(bytes + row, 1, count, stream));
+            continue;
+        }
+        if (info->packets)
+        {
+            fillPacketColumn(column, store, index, row, count, buffer);
+        }
+        else
+        {
+            fillEventColumn(column, store, index->firstEvent + row, count, buffer, &cursor);
+        }
+        ret = (count == fwrite(buffer, info->size, count, stream));
+    }
+
+    ret = (0 == fclose(stream)) && ret;
+    if (!ret)
+    {
+        fprintf(stderr, "Unable to write column %s\n", fileName);
+    }
+    free(fileName);
+
+    return ret;
+}
+
+static struct json_object *newFlagObject(const char *const *names, int count)
+{
+    /* Loop counter */
+    int i = 0;
+    /* Bit values of the flags by name */
+    struct json_object *flags = json_object_new_object();
+
+    for (i = 0; i < count; i++)
+    {
+        json_object_object_add(flags, names[i], json_object_new_int(1 << i));
+    }
+
+    return flags;
+}
+
+static int writeSchema(const char *directory, const EventStore *store, const PacketIndex *index, Settings settings,
+                       struct timespec *triggerTime)
+{
+    /* Loop counter */
+    int i = 0;
+    /* Trigger time as string */
+    char triggerTimeStr[30] = "";
+    /* Name of a column file or a code */
+    char name[64];
+    /* JSON objects of the schema */
+    struct json_object *schema = json_object_new_object();
+    struct json_object *tables = json_object_new_object();
+    struct json_object *table = NULL;
+    struct json_object *columns = json_object_new_array();
+    struct json_object *column = NULL;
+    struct json_object *codes = NULL;
+    /* Path of the schema file */
+    char *fileName = malloc(strlen(directory) + sizeof(COLUMNS_SCHEMA_FILE) + 1);
+    /* The schema file */
+    FILE *file = NULL;
+    /* Return value */
+    int ret = 0;
+
+    json_object_object_add(schema, "format_version", json_object_new_int(COLUMNS_FORMAT_VERSION));
+    json_object_object_add(schema, "version", json_object_new_string(settings.version));
+    if (NULL != settings.inputFile)
+    {
+        json_object_object_add(schema, "input", json_object_new_string(settings.inputFile));
+    }
+    else
+    {
+        json_object_object_add(schema, "serial_number", json_object_new_string(settings.args[0]));
+    }
+    if (timeToStr(triggerTime, triggerTimeStr))
+    {
+        json_object_object_add(schema, "trigger_time", json_object_new_string(triggerTimeStr));
+    }
+    json_object_object_add(schema, "trigger_sec", json_object_new_int64((int64_t)triggerTime->tv_sec));
+    json_object_object_add(schema, "trigger_nsec", json_object_new_int64((int64_t)triggerTime->tv_nsec));
+    json_object_object_add(schema, "clock_period_s", json_object_new_double(store->clockPeriod));
+    json_object_object_add(schema, "header_only", json_object_new_boolean(settings.headerOnly));
+    json_object_object_add(schema, "pre_trigger_ms", json_object_new_int(settings.preTrigger));
+    if (NULL != settings.filterSpec)
+    {
+        json_object_object_add(schema, "filter", json_object_new_string(settings.filterSpec));
+    }
+
+    table = json_object_new_object();
+    json_object_object_add(table, "rows", json_object_new_int64((int64_t)(store->count - index->firstEvent)));
+    json_object_object_add(table, "first_event", json_object_new_int64((int64_t)index->firstEvent));
+    json_object_object_add(tables, "events", table);
+    table = json_object_new_object();
+    json_object_object_add(table, "rows", json_object_new_int64((int64_t)index->count));
+    json_object_object_add(table, "order", json_object_new_string("completion"));
+    json_object_object_add(tables, "packets", table);
+    json_object_object_add(schema, "tables", tables);
+
+    for (i = 0; i < COLUMN_COUNT; i++)
+    {
+        column = json_object_new_object();
+        snprintf(name, sizeof(name), "%s%s", columnInfos[i].name, COLUMNS_FILE_EXTENSION);
+        json_object_object_add(column, "name", json_object_new_string(columnInfos[i].name));
+        json_object_object_add(column, "file", json_object_new_string(name));
+        json_object_object_add(column, "table", json_object_new_string(columnInfos[i].packets ? "packets" : "events"));
+        json_object_object_add(column, "dtype", json_object_new_string(columnInfos[i].dtype));
+        json_object_object_add(column, "rows", json_object_new_int64((int64_t)(columnInfos[i].packets ? index->count : store->count - index->firstEvent)));
+        json_object_object_add(column, "description", json_object_new_string(columnInfos[i].description));
+        json_object_array_add(columns, column);
+    }
+    json_object_object_add(schema, "columns", columns);
+
+    /* Codes of the event types and the error flags as named by the event log */
+    codes = json_object_new_object();
+    for (i = STAR_LA_TRAFFIC_TYPE_HEADER; i <= STAR_LA_TRAFFIC_TYPE_DISCONNECT_ERROR; i++)
+    {
+        snprintf(name, sizeof(name), "%d", i);
+        json_object_object_add(codes, name, json_object_new_string(GetEventTypeString((U8)i)));
+    }
+    json_object_object_add(schema, "event_types", codes);
+    codes = json_object_new_object();
+    for (i = 0; i < 8; i++)
+    {
+        if (0 != strcmp("None", GetErrorString((U8)(1 << i))))
+        {
+            json_object_object_add(codes, GetErrorString((U8)(1 << i)), json_object_new_int(1 << i));
+        }
+    }
+    json_object_object_add(schema, "event_errors", codes);
+    codes = json_object_new_object();
+    for (i = PACKET_TERM_EOP; i <= PACKET_TERM_TIMECODE; i++)
+    {
+        json_object_object_add(codes, terminationNames[i], json_object_new_int(i));
+    }
+    json_object_object_add(schema, "terminations", codes);
+    json_object_object_add(schema, "packet_errors", newFlagObject(packetErrorNames, sizeof(packetErrorNames) / sizeof(packetErrorNames[0])));
+    json_object_object_add(schema, "rmap_flags", newFlagObject(rmapFlagNames, sizeof(rmapFlagNames) / sizeof(rmapFlagNames[0])));
+
+    if (NULL != fileName)
+    {
+        sprintf(fileName, "%s/%s", directory, COLUMNS_SCHEMA_FILE);
+        file = fopen(fileName, "w");
+    }
+    if (NULL == file)
+    {
+        fprintf(stderr, "Unable to open column schema in %s\n", directory);
+    }
+    else
+    {
+        ret = (0 <= fprintf(file, "%s\n", json_object_to_json_string_ext(schema, JSON_C_TO_STRING_PRETTY)));
+        ret = (0 == fclose(file)) && ret;
+        if (!ret)
+        {
+            fprintf(stderr, "Unable to write column schema %s\n", fileName);
+        }
+    }
+
+    json_object_put(schema);
+    free(fileName);
+
+    return ret;
+}
+
+int LA_MK3_exportColumns(const char *directory, const EventStore *store, const PacketIndex *index, Settings settings,
+                         struct timespec *triggerTime)
+{
+    /* Loop counter */
+    int i = 0;
+    /* Block of encoded rows, large enough for the widest column */
+    U8 *buffer = NULL;
+    /* Path of the stale schema */
+    char *schemaName = NULL;
+    /* Return value */
+    int ret = 1;
+
+    fputs("\nExporting columns...\n", stderr);
+    if ((0 != mkdir(directory, 0777)) && (EEXIST != errno))
+    {
+        fprintf(stderr, "Unable to create column directory %s\n", directory);
+        return 0;
+    }
+
+    /* Remove the schema of an earlier export first, so an interrupted export is not taken as complete */
+    schemaName = malloc(strlen(directory) + sizeof(COLUMNS_SCHEMA_FILE) + 1);
+    buffer = malloc((size_t)COLUMNS_BLOCK_ROWS * 8);
+    if ((NULL == schemaName) || (NULL == buffer))
+    {
+        fputs("Unable to allocate memory for the column export\n", stderr);
+        free(schemaName);
+        free(buffer);
+        return 0;
+    }
+    sprintf(schemaName, "%s/%s", directory, COLUMNS_SCHEMA_FILE);
+    remove(schemaName);
+    free(schemaName);
+
+    for (i = 0; ret && (i < COLUMN_COUNT); i++)
+    {
+        ret = writeColumn(directory, i, store, index, buffer, settings.fsyncPolicy);
+    }
+    free(buffer);
+
+    ret = ret && writeSchema(directory, store, index, settings, triggerTime);
+    if (ret)
+    {
+        fprintf(stderr, "Exported %u events and %u packets as columns to %s\n", store->count - index->firstEvent, index->count, directory);
+    }
+
+    return ret;
+}
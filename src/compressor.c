@@ -0,0 +1,363 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <zlib.h>
+#include "compressor.h"
+#include "run_stats.h"
+
+/* States of a frame */
+enum frameState {
+    FRAME_FREE,         /* Being filled by the formatting thread */
+    FRAME_QUEUED,       /* Waiting for a worker */
+    FRAME_COMPRESSING,  /* Being compressed by a worker */
+    FRAME_DONE,         /* Compressed, waiting to be written */
+    FRAME_FAILED        /* Compressing failed */
+};
+
+/* A frame of data compressed into a single gzip member */
+struct compressFrame
+{
+    unsigned char *input;       /* Uncompressed data */
+    size_t inputLength;         /* Number of bytes of uncompressed data */
+    unsigned char *output;      /* The gzip member */
+    size_t outputLength;        /* Size of the gzip member */
+    int state;                  /* State of the frame (see enum frameState) */
+};
+
+/* A compressing stream */
+struct compressor
+{
+    FILE *sink;                         /* Stream receiving the gzip members */
+    int closeSink;                      /* Close the sink together with the stream */
+    int level;                          /* The zlib compression level */
+    struct compressFrame *frames;       /* Frames cycling between the formatting thread and the workers */
+    int frameCount;                     /* Number of frames */
+    int filling;                        /* Frame being filled */
+    int nextQueued;                     /* Oldest frame not yet taken by a worker */
+    pthread_t workers[COMPRESS_MAX_WORKERS]; /* The worker threads */
+    int workerCount;                    /* Number of started workers */
+    int stopping;                       /* The workers are asked to stop */
+    int failed;                         /* Compressing or writing failed */
+    pthread_mutex_t lock;               /* Protects the frame states */
+    pthread_cond_t queuedCond;          /* Signals a queued frame to the workers */
+    pthread_cond_t doneCond;            /* Signals a compressed frame to the formatting thread */
+};
+
+static void putLE(unsigned char *buffer, uint32_t value, int bytes)
+{
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; i < bytes; i++)
+    {
+        buffer[i] = (unsigned char)(value >> (8 * i));
+    }
+
+    return;
+}
+
+static int compressFrame(z_stream *stream, struct compressFrame *frame)
+{
+    /* Gzip member header with the size subfield */
+    static const unsigned char header[16] = { 0x1F, 0x8B, 0x08, 0x04, 0, 0, 0, 0, 0, 0x03, 12, 0, 'S', 'P', 8, 0 };
+    /* Size of the compressed data */
+    size_t deflated = 0;
+    /* Return value */
+    int ret = 0;
+
+    stream->next_in = frame->input;
+    stream->avail_in = (uInt)frame->inputLength;
+    stream->next_out = frame->output + COMPRESS_HEADER_SIZE;
+    stream->avail_out = (uInt)compressBound((uLong)frame->inputLength);
+    ret = (Z_STREAM_END == deflate(stream, Z_FINISH));
+    deflated = stream->total_out;
+    deflateReset(stream);
+
+    if (ret)
+    {
+        frame->outputLength = COMPRESS_HEADER_SIZE + deflated + COMPRESS_TRAILER_SIZE;
+        memcpy(frame->output, header, sizeof(header));
+        putLE(frame->output + 16, (uint32_t)frame->outputLength, 4);
+        putLE(frame->output + 20, (uint32_t)frame->inputLength, 4);
+        putLE(frame->output + COMPRESS_HEADER_SIZE + deflated, (uint32_t)crc32(crc32(0, Z_NULL, 0), frame->input, (uInt)frame->inputLength), 4);
+        putLE(frame->output + COMPRESS_HEADER_SIZE + deflated + 4, (uint32_t)frame->inputLength, 4);
+    }
+
+    return ret;
+}
+
+static void *compressFrames(void *arg)
+{
+    /* The compressor */
+    struct compressor *compressor = arg;
+    /* Raw deflate stream of this worker, the gzip framing is added per member */
+    z_stream stream;
+    /* The frame to compress */
+    struct compressFrame *frame = NULL;
+    /* Compressing the frame succeeded */
+    int success = 0;
+    /* Start and end of compressing a frame */
+    struct timespec start, end;
+    /* The deflate stream could be initialized */
+    int ready = 0;
+
+    memset(&stream, 0, sizeof(stream));
+    ready = (Z_OK == deflateInit2(&stream, compressor->level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY));
+
+    pthread_mutex_lock(&compressor->lock);
+    while (!compressor->stopping)
+    {
+        frame = &compressor->frames[compressor->nextQueued];
+        if (FRAME_QUEUED != frame->state)
+        {
+            pthread_cond_wait(&compressor->queuedCond, &compressor->lock);
+        }
+        else
+        {
+            /* Take the oldest queued frame */
+            frame->state = FRAME_COMPRESSING;
+            compressor->nextQueued = (compressor->nextQueued + 1) % compressor->frameCount;
+            pthread_mutex_unlock(&compressor->lock);
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            success = ready && compressFrame(&stream, frame);
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            statsAdd(STATS_COMPRESS_BUSY_US, (unsigned long long)((end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_nsec - start.tv_nsec) / 1000));
+
+            pthread_mutex_lock(&compressor->lock);
+            frame->state = success ? FRAME_DONE : FRAME_FAILED;
+            pthread_cond_broadcast(&compressor->doneCond);
+        }
+    }
+    pthread_mutex_unlock(&compressor->lock);
+
+    deflateEnd(&stream);
+
+    return NULL;
+}
+
+static void writeOldestFrame(struct compressor *compressor)
+{
+    /* The frame to be filled next, which is the oldest one in the ring */
+    struct compressFrame *frame = &compressor->frames[compressor->filling];
+
+    /* Called with the lock held */
+    while ((FRAME_QUEUED == frame->state) || (FRAME_COMPRESSING == frame->state))
+    {
+        pthread_cond_wait(&compressor->doneCond, &compressor->lock);
+    }
+    if (FRAME_DONE == frame->state)
+    {
+        /* Workers leave finished frames alone, so the lock is not needed while writing */
+        pthread_mutex_unlock(&compressor->lock);
+        if (frame->outputLength != fwrite(frame->output, 1, frame->outputLength, compressor->sink))
+        {
+            compressor->failed = 1;
+        }
+        statsAdd(STATS_COMPRESS_INPUT_BYTES, frame->inputLength);
+        statsAdd(STATS_COMPRESS_OUTPUT_BYTES, frame->outputLength);
+        pthread_mutex_lock(&compressor->lock);
+    }
+    else if (FRAME_FAILED == frame->state)
+    {
+        compressor->failed = 1;
+    }
+    frame->state = FRAME_FREE;
+    frame->inputLength = 0;
+
+    return;
+}
+
+static void queueFrame(struct compressor *compressor)
+{
+    pthread_mutex_lock(&compressor->lock);
+    compressor->frames[compressor->filling].state = FRAME_QUEUED;
+    pthread_cond_signal(&compressor->queuedCond);
+    compressor->filling = (compressor->filling + 1) % compressor->frameCount;
+    /* Write the oldest frame in order before filling it again */
+    writeOldestFrame(compressor);
+    pthread_mutex_unlock(&compressor->lock);
+
+    return;
+}
+
+static ssize_t writeStream(void *cookie, const char *data, size_t length)
+{
+    /* The compressor */
+    struct compressor *compressor = cookie;
+    /* The frame being filled */
+    struct compressFrame *frame = NULL;
+    /* Bytes copied into the current frame */
+    size_t chunk = 0;
+    /* Bytes left to copy */
+    size_t left = length;
+
+    while (!compressor->failed && (0 < left))
+    {
+        frame = &compressor->frames[compressor->filling];
+        chunk = (COMPRESS_FRAME_SIZE - frame->inputLength < left) ? COMPRESS_FRAME_SIZE - frame->inputLength : left;
+        memcpy(frame->input + frame->inputLength, data, chunk);
+        frame->inputLength += chunk;
+        data += chunk;
+        left -= chunk;
+        if (COMPRESS_FRAME_SIZE == frame->inputLength)
+        {
+            queueFrame(compressor);
+        }
+    }
+
+    /* A short count reports the error to stdio */
+    return compressor->failed ? 0 : (ssize_t)length;
+}
+
+static void freeCompressor(struct compressor *compressor)
+{
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; (NULL != compressor->frames) && (i < compressor->frameCount); i++)
+    {
+        free(compressor->frames[i].input);
+        free(compressor->frames[i].output);
+    }
+    free(compressor->frames);
+    pthread_mutex_destroy(&compressor->lock);
+    pthread_cond_destroy(&compressor->queuedCond);
+    pthread_cond_destroy(&compressor->doneCond);
+    free(compressor);
+
+    return;
+}
+
+static void stopWorkers(struct compressor *compressor)
+{
+    /* Loop counter */
+    int i = 0;
+
+    pthread_mutex_lock(&compressor->lock);
+    compressor->stopping = 1;
+    pthread_cond_broadcast(&compressor->queuedCond);
+    pthread_mutex_unlock(&compressor->lock);
+    for (i = 0; i < compressor->workerCount; i++)
+    {
+        pthread_join(compressor->workers[i], NULL);
+    }
+
+    return;
+}
+
+static int closeStream(void *cookie)
+{
+    /* The compressor */
+    struct compressor *compressor = cookie;
+    /* Loop counter */
+    int i = 0;
+    /* Return value */
+    int ret = 0;
+
+    if (0 < compressor->frames[compressor->filling].inputLength)
+    {
+        queueFrame(compressor);
+    }
+    /* Write the remaining frames in order */
+    pthread_mutex_lock(&compressor->lock);
+    for (i = 0; i < compressor->frameCount; i++)
+    {
+        writeOldestFrame(compressor);
+        compressor->filling = (compressor->filling + 1) % compressor->frameCount;
+    }
+    pthread_mutex_unlock(&compressor->lock);
+    stopWorkers(compressor);
+
+    ret = !compressor->failed;
+    if (compressor->closeSink)
+    {
+        ret = (0 == fclose(compressor->sink)) && ret;
+    }
+    else
+    {
+        ret = (0 == fflush(compressor->sink)) && ret;
+    }
+    freeCompressor(compressor);
+
+    return ret ? 0 : -1;
+}
+
+FILE *compressOpen(FILE *sink, int level, int closeSink)
+{
+    /* Loop counter */
+    int i = 0;
+    /* The compressor */
+    struct compressor *compressor = calloc(1, sizeof(struct compressor));
+    /* Functions of the stream */
+    cookie_io_functions_t functions = { NULL, writeStream, NULL, closeStream };
+    /* Number of online processors */
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    /* The compressing stream */
+    FILE *stream = NULL;
+    /* All frames have been allocated */
+    int ready = (NULL != compressor);
+
+    if (ready)
+    {
+        pthread_mutex_init(&compressor->lock, NULL);
+        pthread_cond_init(&compressor->queuedCond, NULL);
+        pthread_cond_init(&compressor->doneCond, NULL);
+        compressor->sink = sink;
+        compressor->closeSink = closeSink;
+        compressor->level = level;
+        compressor->workerCount = (1 > processors) ? 1 : ((COMPRESS_MAX_WORKERS < processors) ? COMPRESS_MAX_WORKERS : (int)processors);
+        compressor->frameCount = compressor->workerCount * COMPRESS_FRAMES_PER_WORKER + 1;
+        compressor->frames = calloc((size_t)compressor->frameCount, sizeof(struct compressFrame));
+        ready = (NULL != compressor->frames);
+    }
+    for (i = 0; ready && (i < compressor->frameCount); i++)
+    {
+        compressor->frames[i].input = malloc(COMPRESS_FRAME_SIZE);
+        compressor->frames[i].output = malloc(COMPRESS_HEADER_SIZE + compressBound(COMPRESS_FRAME_SIZE) + COMPRESS_TRAILER_SIZE);
+        ready = (NULL != compressor->frames[i].input) && (NULL != compressor->frames[i].output);
+    }
+    if (!ready)
+    {
+        fputs("Unable to allocate memory for compressing the output\n", stderr);
+        if (NULL != compressor)
+        {
+            freeCompressor(compressor);
+        }
+        return NULL;
+    }
+
+    for (i = 0; i < compressor->workerCount; i++)
+    {
+        if (0 != pthread_create(&compressor->workers[i], NULL, compressFrames, compressor))
+        {
+            /* Continue with the workers started so far */
+            compressor->workerCount = i;
+        }
+    }
+    if (0 == compressor->workerCount)
+    {
+        fputs("Unable to start the compression workers\n", stderr);
+        freeCompressor(compressor);
+        return NULL;
+    }
+
+    stream = fopencookie(compressor, "w", functions);
+    if (NULL == stream)
+    {
+        fputs("Unable to open the compressing stream\n", stderr);
+        stopWorkers(compressor);
+        freeCompressor(compressor);
+    }
+    else
+    {
+        setvbuf(stream, NULL, _IOFBF, COMPRESS_FRAME_SIZE / 16);
+    }
+
+    return stream;
+}
@@ -4,48 +4,74 @@
 #include "spw_la_api.h"
 #include "config_logger.h"
 
-void printConfig(Settings settings)
+void printConfig(FILE *stream, Settings settings)
 {
-    fputs("### Configuration\n", stdout);
+    fputs("### Configuration\n", stream);
     /* Print duration of record in seconds */
-    fprintf(stdout, "# Record duration:     %ss\n", settings.args[1]);
+    fprintf(stream, "# Record duration:     %ss\n", settings.args[1]);
     /* Print max displayed record duration before the trigger milliseconds */
-    fprintf(stdout, "# PreTrig duration:    %dms\n", settings.preTrigger);
+    fprintf(stream, "# PreTrig duration:    %dms\n", settings.preTrigger);
 
-    /* Print trigger event*/
-    fprintf(stdout, "# Trigger event:       %s\n", settings.trigFCT ? "FCT" : "Timecode");
+    /* Print trigger event or sequence */
+    if (0 < settings.trigStageCount)
+    {
+        fprintf(stream, "# Trigger sequence:    %s\n", settings.trigSpec);
+    }
+    else
+    {
+        fprintf(stream, "# Trigger event:       %s\n", settings.trigFCT ? "FCT" : "Timecode");
+    }
+    /* Print trigger delay and memory split */
+    fprintf(stream, "# Trigger delay:       %u\n", settings.trigDelay);
+    fprintf(stream, "# PostTrig memory:     %d%%\n", settings.postTrigMemory);
 
     /* Print chars enabled for recording */
-    fprintf(stdout, "# Enable NULLs:        %d\n", settings.enNull);
-    fprintf(stdout, "# Enable FCTs:         %d\n", settings.enFCT);
-    fprintf(stdout, "# Enable Timecodes:    %d\n", settings.enTimecode);
-    fprintf(stdout, "# Enable NChars:       %d\n", settings.enNChar);
+    fprintf(stream, "# Enable NULLs:        %d\n", settings.enNull);
+    fprintf(stream, "# Enable FCTs:         %d\n", settings.enFCT);
+    fprintf(stream, "# Enable Timecodes:    %d\n", settings.enTimecode);
+    fprintf(stream, "# Enable NChars:       %d\n", settings.enNChar);
+    /* Print whether only packet headers were recorded */
+    fprintf(stream, "# Header only:         %d\n", settings.headerOnly);
+    /* Print the packet filter, if only a part of the packets is logged */
+    if (NULL != settings.filterSpec)
+    {
+        fprintf(stream, "# Packet filter:       %s\n", settings.filterSpec);
+    }
+    /* Print how the event log has been reduced */
+    if (NULL != settings.logExcludeSpec)
+    {
+        fprintf(stream, "# Excluded events:     %s\n", settings.logExcludeSpec);
+    }
+    if (settings.collapseIdle)
+    {
+        fprintf(stream, "# Collapse idle rows:  %d\n", settings.collapseIdle);
+    }
 
     return;
 }
 
-void LA_printApiVersion(void)
+void LA_printApiVersion(FILE *stream)
 {
     int major, minor, edit, patch;
     /* Get the API version */
     STAR_LA_GetAPIVersion(&major, &minor, &edit, &patch);
     /* Display the API version */
-    fprintf(stdout, "# API version:         v%d.%02d", major, minor);
+    fprintf(stream, "# API version:         v%d.%02d", major, minor);
     /* Print edit and patch level, if available */
     if (edit)
     {
-        fprintf(stdout, " edit %d", edit);
+        fprintf(stream, " edit %d", edit);
     }
     if (patch)
     {
-        fprintf(stdout, " patch level %d", patch);
+        fprintf(stream, " patch level %d", patch);
     }
 
     /* New line */
-    fputs("\n", stdout);
+    fputs("\n", stream);
 }
 
-int LA_printDeviceVersion(STAR_LA_LinkAnalyser linkAnalyser)
+int LA_printDeviceVersion(FILE *stream, STAR_LA_LinkAnalyser linkAnalyser)
 {
     U8 major, minor;
     U16 edit, patch;
@@ -58,25 +84,25 @@ int LA_printDeviceVersion(STAR_LA_LinkAnalyser linkAnalyser)
     else
     {
         /* Display the device version */
-        fprintf(stdout, "# Device version:      v%d.%02d", major, minor);
+        fprintf(stream, "# Device version:      v%d.%02d", major, minor);
         /* Print edit and patch level, if available */
         if (edit)
         {
-            fprintf(stdout, " edit %d", edit);
+            fprintf(stream, " edit %d", edit);
         }
         if (patch)
         {
-            fprintf(stdout, " patch level %d", patch);
+            fprintf(stream, " patch level %d", patch);
         }
 
         /* New line */
-        fputs("\n", stdout);
+        fputs("\n", stream);
     }
 
     return 1;
 }
 
-void printFirmwareVersion(STAR_VERSION_INFO *firmwareVersion)
+void printFirmwareVersion(FILE *stream, STAR_VERSION_INFO *firmwareVersion)
 {
     /* Get module name */
     char *moduleName = firmwareVersion->name;
@@ -95,33 +121,33 @@ void printFirmwareVersion(STAR_VERSION_INFO *firmwareVersion)
     if (strlen(moduleName) > (size_t)0)
     {
         /* Print module name */
-        fprintf(stdout, "%s", moduleName);
+        fprintf(stream, "%s", moduleName);
     }
 
     /* Print version information string */
-    fprintf(stdout, "v%d.%02u", major, minor);
+    fprintf(stream, "v%d.%02u", major, minor);
     /* Print edit and patch level, if available */
     if (edit)
     {
-        fprintf(stdout, " edit %u", edit);
+        fprintf(stream, " edit %u", edit);
     }
     if (patch)
     {
-        fprintf(stdout, " patch level %u", patch);
+        fprintf(stream, " patch level %u", patch);
     }
 
     /* If module has an author */
     if (strlen(moduleAuthor) > (size_t)0)
     {
         /* Print module author */
-        fprintf(stdout, "   Author: %s\n", moduleAuthor);
+        fprintf(stream, "   Author: %s\n", moduleAuthor);
     }
 
     /* New line */
-    fputs("\n", stdout);
+    fputs("\n", stream);
 }
 
-int LA_printBuildDate(STAR_LA_LinkAnalyser linkAnalyser)
+int LA_printBuildDate(FILE *stream, STAR_LA_LinkAnalyser linkAnalyser)
 {
     /* Build date values */
     U8 year, month, day, hour, minute;
@@ -137,13 +163,13 @@ int LA_printBuildDate(STAR_LA_LinkAnalyser linkAnalyser)
     else
     {
         /* Print build date of the device */
-        charsWritten = fprintf(stdout, "# Build date:          %d-%02d-%02d %02d:%02d\n", year, month, day, hour, minute);
+        charsWritten = fprintf(stream, "# Build date:          %d-%02d-%02d %02d:%02d\n", year, month, day, hour, minute);
     }
 
     return charsWritten;
 }
 
-int LA_printInfo(STAR_LA_LinkAnalyser linkAnalyser)
+int LA_printInfo(FILE *stream, STAR_LA_LinkAnalyser linkAnalyser)
 {
     /* ID of the used Link Analyser device */
     STAR_DEVICE_ID deviceID = linkAnalyser.deviceID;
@@ -158,22 +184,22 @@ int LA_printInfo(STAR_LA_LinkAnalyser linkAnalyser)
         return 0;
     }
 
-    fputs("### Link Analyser\n", stdout);
+    fputs("### Link Analyser\n", stream);
     /* Print API version */
-    LA_printApiVersion();
+    LA_printApiVersion(stream);
     /* Print device name and serial number */
-    fprintf(stdout, "# Device name:         %s\n", STAR_getDeviceName(deviceID));
-    fprintf(stdout, "# Serial number:       %s\n", STAR_getDeviceSerialNumber(deviceID));
+    fprintf(stream, "# Device name:         %s\n", STAR_getDeviceName(deviceID));
+    fprintf(stream, "# Serial number:       %s\n", STAR_getDeviceSerialNumber(deviceID));
     /* Print device version */
-    if (!LA_printDeviceVersion(linkAnalyser))
+    if (!LA_printDeviceVersion(stream, linkAnalyser))
     {
         return 0;
     }
     /* Print firmware version  */
-    fputs("# Firmware version:    ", stdout);
-    printFirmwareVersion(firmware_version);
+    fputs("# Firmware version:    ", stream);
+    printFirmwareVersion(stream, firmware_version);
     /* Print build date */
-    if (!LA_printBuildDate(linkAnalyser))
+    if (!LA_printBuildDate(stream, linkAnalyser))
     {
         return 0;
     }
@@ -187,16 +213,18 @@ int timeToStr(struct timespec *timestamp, char *timeString)
     int ret = 0;
     /* Date and time buffer */
     char buff[20];
+    /* Broken down local time (reentrant for formatting on multiple threads) */
+    struct tm localTime;
 
     /* Format date and time and save in buffer */
-    ret = strftime(buff, sizeof buff, "%FT%T", localtime(&timestamp->tv_sec));
+    ret = (NULL != localtime_r(&timestamp->tv_sec, &localTime)) && strftime(buff, sizeof buff, "%FT%T", &localTime);
     /* Combine time string */
     ret = ret && (0 <= sprintf(timeString, "%s.%09d", buff, timestamp->tv_nsec));
 
     return ret;
 }
 
-int printConfigHeader(struct timespec *triggerTime, Settings settings, STAR_LA_LinkAnalyser linkAnalyser)
+int printConfigHeader(FILE *stream, struct timespec *triggerTime, Settings settings, STAR_LA_LinkAnalyser linkAnalyser)
 {
     /* Return value */
     int ret = 0;
@@ -206,24 +234,24 @@ int printConfigHeader(struct timespec *triggerTime, Settings settings, STAR_LA_L
     ret = timeToStr(triggerTime, triggerTimeStr);
 
     /* Print time, at which the trigger fired */
-    fprintf(stdout, "# Trigger timestamp:   %s\n", triggerTimeStr);
+    fprintf(stream, "# Trigger timestamp:   %s\n", triggerTimeStr);
 
     /* Print software version */
-    fprintf(stdout, "# Software version:    spw_data_rec %s\n", settings.version);
-    fputs("\n", stdout);
+    fprintf(stream, "# Software version:    spw_data_rec %s\n", settings.version);
+    fputs("\n", stream);
 
     /* Print configuration set by input arguments */
-    printConfig(settings);
-    fputs("\n", stdout);
+    printConfig(stream, settings);
+    fputs("\n", stream);
 
     /* Print information for the Link Analyser device and API */
-    if (!LA_printInfo(linkAnalyser))
+    if (!LA_printInfo(stream, linkAnalyser))
     {
         fputs("Error while printing Link Analyser info\n", stderr);
         ret = 0;
     }
 
-    fputs("\n", stdout);
+    fputs("\n", stream);
 
     return ret;
 }
@@ -1,9 +1,17 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include <spw_la_api.h>
 #include "config_logger.h"
 #include "data_logger.h"
+#include "event_store.h"
+#include "packet_index.h"
 #include "arg_parser.h"
+#include "run_stats.h"
+#include "metrics.h"
+#include "raw_capture.h"
+#include "output_file.h"
+#include "error_log.h"
 
 char *GetEventTypeString(U8 trafficType)
 {
@@ -87,7 +95,7 @@ char *GetEventTypeString(U8 trafficType)
     return "ERROR:Unknown";
 }
 
-static char *GetErrorString(U8 errors)
+char *GetErrorString(U8 errors)
 {
     if (STAR_LA_MK3_ParityError(errors))
     {
@@ -104,6 +112,13 @@ static char *GetErrorString(U8 errors)
     return "None";
 }
 
+int LA_MK3_printEvent(FILE *stream, const EventStore *store, U32 event, double time)
+{
+    return fprintf(stream, "%-8d%010.4fms    %-20s%02X              %-13s%-20s%02X              %s\n", event, time,
+                   GetEventTypeString(store->types[RECV_A][event]), store->data[RECV_A][event], GetErrorString(getEventErrors(store, event, RECV_A)),
+                   GetEventTypeString(store->types[RECV_B][event]), store->data[RECV_B][event], GetErrorString(getEventErrors(store, event, RECV_B)));
+}
+
 int LA_MK3_getPacketTimestamp(const double *deltaToTrigger, struct timespec *triggerTime, char *timeString)
 {
     /* Return value */
@@ -137,205 +152,591 @@ int LA_MK3_getPacketTimestamp(const double *deltaToTrigger, struct timespec *tri
     return ret;
 }
 
-unsigned int LA_MK3_printByte(struct dataPacket *packet, const double *deltaToTrigger, struct timespec *triggerTime)
+int LA_MK3_printPacket(FILE *stream, const PacketEntry *entry, const EventStore *store, U8 *buffer, struct timespec *triggerTime, const char headerOnly)
 {
-    /* Total number of bytes in the packet */
-    unsigned int packetBytes = 0;
+    /* Loop counter */
+    U32 i = 0;
+    /* Number of bytes in the packet */
+    U32 length = 0;
+    /* Time difference of the packet to the trigger in seconds */
+    double deltaToTrigger = entry->startTime * store->clockPeriod;
+    /* Time between the header and the end of packet in seconds */
+    double duration = 0.0;
     /* Timestamp of the current packet */
     char timestampStr[30];
+    /* The direction of traffic (Recv A = 'I'; Recv B = 'O') */
+    char direction = entry->receiver ? 'O' : 'I';
+    /* Number of characters printed */
+    int written = 0;
+
+    LA_MK3_getPacketTimestamp(&deltaToTrigger, triggerTime, timestampStr);
+    length = LA_MK3_getHexdumpBytes(entry, store, buffer);
 
-    /* Start new packet with preceding timestamp, if header event is detected */
-    if ((0 == packet->bytesReceived) && (STAR_LA_TRAFFIC_TYPE_HEADER == packet->event.type))
+    /* Print Timecode directly to hexdump */
+    if (PACKET_TERM_TIMECODE == entry->termination)
     {
-        LA_MK3_getPacketTimestamp(deltaToTrigger, triggerTime, timestampStr);
-        fprintf(packet->packetStream, "%c %s\n", packet->direction, timestampStr);
-        fprintf(packet->packetStream, "%06X %02X", packet->bytesReceived, packet->event.data);
-        packet->bytesReceived++;
+        written += fprintf(stream, "\n%c %s\n", direction, timestampStr);
+        written += fprintf(stream, "%06X %02X\n", 0, buffer[0]);
+        return written;
     }
-    /* Add byte to packet, if data event is detected */
-    else if ((0 < packet->bytesReceived) && (STAR_LA_TRAFFIC_TYPE_DATA == packet->event.type)) // Also print header events?
+
+    /* Start packet with preceding timestamp */
+    if (PACKET_TERM_INCOMPLETE != entry->termination)
+    {
+        written += fprintf(stream, "\n");
+    }
+    written += fprintf(stream, "%c %s\n", direction, timestampStr);
+    written += fprintf(stream, "%06X %02X", 0, buffer[0]);
+
+    for (i = 1; i < length; i++)
     {
-        if ((HEADER_BYTES <= packet->bytesReceived) && (0 == (packet->bytesReceived - HEADER_BYTES) % BYTES_PER_LINE))
+        if ((HEADER_BYTES <= i) && (0 == (i - HEADER_BYTES) % BYTES_PER_LINE))
         {
             /* Start new line with byte offset */
-            fprintf(packet->packetStream, "\n%06X", packet->bytesReceived);
+            written += fprintf(stream, "\n%06X", i);
         }
         /* Print byte */
-        fprintf(packet->packetStream, " %02X", packet->event.data);
-        packet->bytesReceived++;
+        written += fprintf(stream, " %02X", buffer[i]);
     }
-    /* End packet and return number of bytes received, if EOP or EEP event is detected */
-    else if (STAR_LA_TRAFFIC_TYPE_EOP == packet->event.type || STAR_LA_TRAFFIC_TYPE_EEP == packet->event.type)
+
+    if (PACKET_TERM_INCOMPLETE == entry->termination)
     {
-        packetBytes = (unsigned int)packet->bytesReceived;
-        packet->bytesReceived = 0;
+        written += fprintf(stream, "\n### Incomplete packet ###\n");
     }
-    /* Print Timecode directly to hexdump */
-    else if (STAR_LA_TRAFFIC_TYPE_TIMECODE == packet->event.type)
+    else
     {
-        LA_MK3_getPacketTimestamp(deltaToTrigger, triggerTime, timestampStr);
-        fprintf(stdout, "\n%c %s\n", packet->direction, timestampStr);
-        fprintf(stdout, "%06X %02X\n", 0, packet->event.data);
+        if (headerOnly)
+        {
+            /* Mark truncated packet with its duration up to the end of packet */
+            duration = (getEventTime(store, entry->endEvent) - entry->startTime) * store->clockPeriod;
+            written += fprintf(stream, "\n### Header only: %u bytes recorded, %s after %.3fus ###",
+                    length, (PACKET_TERM_EOP == entry->termination) ? "EOP" : "EEP", duration * 1000000.0);
+        }
+        written += fprintf(stream, "\n");
     }
 
-    return packetBytes;
+    return written;
 }
 
-void LA_MK3_printHexdumpData(STAR_LA_MK3_Traffic *pTraffic, const U32 *trafficCount, const double *charCaptureClockPeriod, struct timespec *triggerTime, const int preTrigger)
+/* A block of index entries formatted by a single thread */
+struct formatJob
 {
+    const EventStore *store;                /* The recorded events */
+    PacketIndex *index;                     /* The packet index of the recorded events */
+    struct timespec *triggerTime;           /* The timestamp of when the trigger occurred */
+    char headerOnly;                        /* Only the packet headers have been recorded */
+    U32 first;                              /* First entry of the block */
+    U32 last;                               /* Entry following the block */
+    U8 *buffer;                             /* Buffer for gathering the packet data */
+    char *text;                             /* The formatted block */
+    size_t textSize;                        /* Size of the formatted block */
+    size_t ends[FORMAT_BLOCK_ENTRIES];      /* Offsets behind each formatted packet in the block */
+};
+
+static void *formatPacketBlock(void *arg)
+{
+    /* The block to format */
+    struct formatJob *job = arg;
     /* Loop counter */
     U32 i = 0;
-    /* Time difference of the current traffic event to the trigger in seconds */
-    double deltaToTrigger = 0.0;
-
-    /* String of packet received on receiver A */
-    char *packetA = NULL;
-    /* Size of packet string for receiver A */
-    size_t packetSizeA = 0;
-    /* Struct collecting events received on receiver A */
-    struct dataPacket receiverA;
-    receiverA.bytesReceived = 0;
-    receiverA.direction = 'I';
-    receiverA.packetStream = open_memstream(&packetA, &packetSizeA);
-
-    /* String of packet received on receiver B */
-    char *packetB = NULL;
-    /* Size of packet string for receiver B */
-    size_t packetSizeB = 0;
-    /* Struct collecting events received on receiver B */
-    struct dataPacket receiverB;
-    receiverB.bytesReceived = 0;
-    receiverB.direction = 'O';
-    receiverB.packetStream = open_memstream(&packetB, &packetSizeB);
-
-    for (i = 0; i < *trafficCount; i++)
-    {
-        deltaToTrigger = pTraffic[i].time * *charCaptureClockPeriod;
-        /* Print packets, starting at set pre trigger duration */
-        if (-preTrigger <= (deltaToTrigger * 1000.0))
+    /* Offset behind the last formatted packet */
+    size_t end = 0;
+    /* Stream for the formatted block */
+    FILE *blockStream = open_memstream(&job->text, &job->textSize);
+
+    if (NULL != blockStream)
+    {
+        for (i = job->first; i < job->last; i++)
         {
-            receiverA.event = pTraffic[i].linkAEvent;
-            receiverB.event = pTraffic[i].linkBEvent;
+            end += LA_MK3_printPacket(blockStream, &job->index->entries[i], job->store, job->buffer,
+                                      job->triggerTime, job->headerOnly);
+            job->ends[i - job->first] = end;
+        }
+        fclose(blockStream);
+    }
 
-            /* Print packet from receiver A, if complete */
-            if (0 != LA_MK3_printByte(&receiverA, &deltaToTrigger, triggerTime))
-            {
-                fclose(receiverA.packetStream);
-                fprintf(stdout, "\n%s\n", packetA);
-                free(packetA);
-                receiverA.packetStream = open_memstream(&packetA, &packetSizeA);
-            }
+    return NULL;
+}
 
-            /* Print packet from receiver B, if complete */
-            if (0 != LA_MK3_printByte(&receiverB, &deltaToTrigger, triggerTime))
-            {
-                fclose(receiverB.packetStream);
-                fprintf(stdout, "\n%s\n", packetB);
-                free(packetB);
-                receiverB.packetStream = open_memstream(&packetB, &packetSizeB);
-            }
+static unsigned long long writeFormattedBlock(OutputFile *output, const struct formatJob *job)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* Offset of the current packet in the block */
+    size_t start = 0;
+    /* Stream to write the current packet to */
+    FILE *stream = NULL;
+    /* Number of characters written */
+    unsigned long long written = 0;
+
+    if ((NULL == job->text) || (job->first == job->last))
+    {
+        return 0;
+    }
+
+    if (!outputRotates(output))
+    {
+        /* Write the whole block at once */
+        stream = outputBoundary(output, job->index->entries[job->first].startTime);
+        written = fwrite(job->text, 1, job->textSize, stream);
+    }
+    else
+    {
+        /* Write packet by packet, so that the output can be rotated in between */
+        for (i = job->first; i < job->last; i++)
+        {
+            stream = outputBoundary(output, job->index->entries[i].startTime);
+            written += fwrite(job->text + start, 1, job->ends[i - job->first] - start, stream);
+            outputWritten(output, job->ends[i - job->first] - start);
+            start = job->ends[i - job->first];
         }
     }
 
-    /* Close files */
-    fclose(receiverA.packetStream);
-    fclose(receiverB.packetStream);
+    return written;
+}
+
+static void countWrittenPackets(const PacketIndex *index, U32 first, U32 last)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* Number of packets written per receiver */
+    unsigned long long packets[2] = { 0, 0 };
 
-    /* Print incomplete packets */
-    if (0 < packetSizeA)
+    for (i = first; i < last; i++)
     {
-        fprintf(stdout, "%s\n", packetA);
-        fputs("### Incomplete packet ###\n", stdout);
+        if (PACKET_TERM_TIMECODE != index->entries[i].termination)
+        {
+            packets[index->entries[i].receiver]++;
+        }
     }
-    if (0 < packetSizeB)
+    statsAdd(STATS_PACKETS_WRITTEN_A, packets[RECV_A]);
+    statsAdd(STATS_PACKETS_WRITTEN_B, packets[RECV_B]);
+    metricsSetGauge(METRIC_GAUGE_DECODER_BACKLOG, index->count - last);
+
+    return;
+}
+
+unsigned long long LA_MK3_printHexdumpData(OutputFile *output, const EventStore *store, PacketIndex *index, struct timespec *triggerTime, const char headerOnly, const int jobs)
+{
+    /* Loop counters */
+    U32 i = 0;
+    int t = 0;
+    /* Number of threads formatting the packets */
+    int threadCount = (1 < jobs) ? jobs : 1;
+    /* Blocks formatted by the individual threads */
+    struct formatJob *formatJobs = calloc((size_t)threadCount, sizeof(struct formatJob));
+    /* Threads formatting the blocks */
+    pthread_t *threads = calloc((size_t)threadCount, sizeof(pthread_t));
+    /* All memory needed for formatting has been allocated */
+    int allocated = (NULL != formatJobs) && (NULL != threads);
+    /* Stream to print the current packet to */
+    FILE *stream = NULL;
+    /* Number of characters printed for the current packet */
+    int length = 0;
+    /* Number of characters printed */
+    unsigned long long written = 0;
+
+    for (t = 0; allocated && (t < threadCount); t++)
     {
-        fprintf(stdout, "%s\n", packetB);
-        fputs("### Incomplete packet ###\n", stdout);
+        formatJobs[t].store = store;
+        formatJobs[t].index = index;
+        formatJobs[t].triggerTime = triggerTime;
+        formatJobs[t].headerOnly = headerOnly;
+        formatJobs[t].buffer = malloc(index->maxLength + 1);
+        allocated = (NULL != formatJobs[t].buffer);
     }
 
-    fputs("\n", stdout);
+    if (!allocated)
+    {
+        fputs("Unable to allocate memory for formatting the hexdump\n", stderr);
+    }
+    else if (1 == threadCount)
+    {
+        /* Print packets directly in order of completion */
+        for (i = 0; i < index->count; i++)
+        {
+            stream = outputBoundary(output, index->entries[i].startTime);
+            length = LA_MK3_printPacket(stream, &index->entries[i], store, formatJobs[0].buffer, triggerTime, headerOnly);
+            outputWritten(output, (unsigned long long)length);
+            written += (unsigned long long)length;
+            if ((0 == (i + 1) % FORMAT_BLOCK_ENTRIES) || (i + 1 == index->count))
+            {
+                countWrittenPackets(index, (i / FORMAT_BLOCK_ENTRIES) * FORMAT_BLOCK_ENTRIES, i + 1);
+            }
+        }
+    }
+    else
+    {
+        /* Format consecutive blocks in parallel and print them in order */
+        for (i = 0; i < index->count; i += (U32)threadCount * FORMAT_BLOCK_ENTRIES)
+        {
+            for (t = 0; t < threadCount; t++)
+            {
+                formatJobs[t].first = i + (U32)t * FORMAT_BLOCK_ENTRIES;
+                formatJobs[t].first = (formatJobs[t].first < index->count) ? formatJobs[t].first : index->count;
+                formatJobs[t].last = formatJobs[t].first + FORMAT_BLOCK_ENTRIES;
+                formatJobs[t].last = (formatJobs[t].last < index->count) ? formatJobs[t].last : index->count;
+                formatJobs[t].text = NULL;
+                formatJobs[t].textSize = 0;
+                if (0 != pthread_create(&threads[t], NULL, formatPacketBlock, &formatJobs[t]))
+                {
+                    /* Format block in this thread instead */
+                    formatPacketBlock(&formatJobs[t]);
+                    threads[t] = pthread_self();
+                }
+            }
+            for (t = 0; t < threadCount; t++)
+            {
+                if (!pthread_equal(threads[t], pthread_self()))
+                {
+                    pthread_join(threads[t], NULL);
+                }
+                written += writeFormattedBlock(output, &formatJobs[t]);
+                free(formatJobs[t].text);
+                countWrittenPackets(index, formatJobs[t].first, formatJobs[t].last);
+            }
+        }
+    }
+
+    written += fprintf(output->stream, "\n");
     fputs("Printing hexdump completed\n", stderr);
 
     /* Free memory */
-    free(packetA);
-    free(packetB);
+    for (t = 0; (NULL != formatJobs) && (t < threadCount); t++)
+    {
+        free(formatJobs[t].buffer);
+    }
+    free(formatJobs);
+    free(threads);
 
-    return;
+    return written;
 }
 
-int LA_MK3_printRecordedTraffic(STAR_LA_LinkAnalyser linkAnalyser, STAR_LA_MK3_Traffic *pTraffic, Settings settings, const U32 *trafficCount, const double *charCaptureClockPeriod, struct timespec *triggerTime)
+/* Capture logs written by printCaptureLog() */
+enum captureLog {
+    CAPTURE_LOG_HEXDUMP,        /* Packet based hexdump */
+    CAPTURE_LOG_EVENTS,         /* Event based capture log */
+    CAPTURE_LOG_ERRORS          /* Error events with their context */
+};
+
+static int printCaptureLog(const char *fileName, unsigned long long expectedSize, STAR_LA_LinkAnalyser linkAnalyser, const EventStore *store,
+                           PacketIndex *index, Settings settings, struct timespec *triggerTime, const int log)
 {
     /* Return value */
     int success = 0;
+    /* Header repeated at the start of every output file */
+    char *header = NULL;
+    /* Length of the header */
+    size_t headerLength = 0;
+    /* Stream for formatting the header */
+    FILE *headerStream = open_memstream(&header, &headerLength);
+    /* The output of the capture log */
+    OutputFile output;
 
     /* Print config header for hexdump */
-    success = printConfigHeader(triggerTime, settings, linkAnalyser);
+    success = (NULL != headerStream) && printConfigHeader(headerStream, triggerTime, settings, linkAnalyser);
+    if (success && (CAPTURE_LOG_EVENTS == log))
+    {
+        fputs(EVENT_LOG_TITLE, headerStream);
+    }
+    else if (success && (CAPTURE_LOG_ERRORS == log))
+    {
+        fputs(ERROR_LOG_TITLE, headerStream);
+    }
+    if (NULL != headerStream)
+    {
+        fclose(headerStream);
+    }
 
     if (0 == success)
     {
         fputs("\nPrinting capture log aborted\n", stderr);
     }
+    else if (0 == outputOpen(&output, fileName, settings, expectedSize, store->clockPeriod, CAPTURE_LOG_ERRORS != log, header, headerLength))
+    {
+        success = 0;
+    }
     else
     {
         fputs("\nPrinting capture log...\n", stderr);
-        if (0 == settings.verbose)
+        if (CAPTURE_LOG_HEXDUMP == log)
         {
             /* Print recorded traffic data as hexdump */
-            LA_MK3_printHexdumpData(pTraffic, trafficCount, charCaptureClockPeriod, triggerTime, settings.preTrigger);
+            statsAdd(STATS_BYTES_WRITTEN, LA_MK3_printHexdumpData(&output, store, index, triggerTime, settings.headerOnly, settings.jobs));
         }
-        else
+        else if (CAPTURE_LOG_EVENTS == log)
         {
             /* Print event based log of captured data */
-            LA_MK3_printEventCaptureLog(pTraffic, trafficCount, charCaptureClockPeriod, settings.preTrigger);
-            success = 1;
+            statsAdd(STATS_BYTES_WRITTEN, LA_MK3_printEventCaptureLog(&output, store, settings.preTrigger, settings.logExclude, settings.collapseIdle));
+        }
+        else
+        {
+            /* Print the error events with their context, the error log is never rotated */
+            statsAdd(STATS_BYTES_WRITTEN, LA_MK3_printErrorLog(&output, store, index, triggerTime, settings.errorContext, settings.errorContextTime));
         }
+        success = outputClose(&output);
     }
+    free(header);
 
     return success;
 }
 
-void LA_MK3_printEventCaptureLog(STAR_LA_MK3_Traffic *pTraffic, const U32 *trafficCount, const double *charCaptureClockPeriod, const int preTrigger)
+int LA_MK3_printRecordedTraffic(STAR_LA_LinkAnalyser linkAnalyser, const EventStore *store, PacketIndex *index, Settings settings, struct timespec *triggerTime)
+{
+    /* Return value */
+    int success = 0;
+    /* Expected sizes of the hexdump and the event log for preallocating the files */
+    unsigned long long hexdumpSize = OUTPUT_HEADER_SIZE + 3 * (index->byteCount[RECV_A] + index->byteCount[RECV_B]) +
+                                     (index->byteCount[RECV_A] + index->byteCount[RECV_B]) / BYTES_PER_LINE * 7 +
+                                     (unsigned long long)index->count * OUTPUT_PACKET_OVERHEAD;
+    unsigned long long eventLogSize = OUTPUT_HEADER_SIZE + (unsigned long long)store->count * OUTPUT_EVENT_LINE;
+
+    /* Write the hexdump or the event log to the output file, or to stdout unless the summary or search is printed there */
+    if ((NULL != settings.outputFile) || ((NULL == settings.summaryFile) && (NULL == settings.searchPatterns) && (NULL == settings.diffFile)))
+    {
+        success = printCaptureLog(settings.outputFile, settings.verbose ? eventLogSize : hexdumpSize, linkAnalyser,
+                                  store, index, settings, triggerTime, settings.verbose ? CAPTURE_LOG_EVENTS : CAPTURE_LOG_HEXDUMP);
+    }
+    else
+    {
+        success = 1;
+    }
+
+    /* Write the event log to its own file */
+    if (NULL != settings.eventLogFile)
+    {
+        success = printCaptureLog(settings.eventLogFile, eventLogSize, linkAnalyser, store, index, settings, triggerTime, CAPTURE_LOG_EVENTS) && success;
+    }
+
+    /* Write the error events with their context to their own file */
+    if (NULL != settings.errorLogFile)
+    {
+        success = printCaptureLog(settings.errorLogFile, OUTPUT_HEADER_SIZE + (unsigned long long)store->errorCount * OUTPUT_EVENT_LINE * 4,
+                                  linkAnalyser, store, index, settings, triggerTime, CAPTURE_LOG_ERRORS) && success;
+    }
+
+    /* Write all events in the binary capture format */
+    if (NULL != settings.rawFile)
+    {
+        success = LA_MK3_saveRawCapture(store, settings, triggerTime) && success;
+    }
+
+    return success;
+}
+
+int LA_MK3_saveRawCapture(const EventStore *store, Settings settings, struct timespec *triggerTime)
+{
+    /* Return value */
+    int success = 0;
+    /* Output of the raw capture */
+    OutputFile output;
+
+    fputs("\nWriting raw capture...\n", stderr);
+    if (outputOpen(&output, settings.rawFile, settings, RAW_HEADER_SIZE + (unsigned long long)store->count * RAW_RECORD_SIZE,
+                   store->clockPeriod, 0, NULL, 0))
+    {
+        success = (0 < LA_MK3_writeRawCapture(output.stream, store, triggerTime, settings.headerOnly));
+        success = outputClose(&output) && success;
+    }
+
+    return success;
+}
+
+/* A row of the event log, or a run of identical idle rows */
+struct eventRow
+{
+    U32 event;                  /* Index of the first event of the row */
+    long long tick;             /* Capture clock tick of the first event */
+    double firstTime;           /* Time of the first event in milliseconds */
+    double lastTime;            /* Time of the last event in milliseconds */
+    U32 count;                  /* Number of collapsed rows (0 = no row) */
+    char shown[2];              /* The event of each receiver is shown */
+    char inPacket[2];           /* Receivers with an open packet before the first event */
+};
+
+static unsigned int getLogEventBit(U8 type)
+{
+    switch (type)
+    {
+    case STAR_LA_TRAFFIC_TYPE_HEADER:
+        return 1u << LOG_EVENT_HEADER;
+    case STAR_LA_TRAFFIC_TYPE_DATA:
+        return 1u << LOG_EVENT_DATA;
+    case STAR_LA_TRAFFIC_TYPE_EOP:
+        return 1u << LOG_EVENT_EOP;
+    case STAR_LA_TRAFFIC_TYPE_EEP:
+        return 1u << LOG_EVENT_EEP;
+    case STAR_LA_TRAFFIC_TYPE_FCT:
+        return 1u << LOG_EVENT_FCT;
+    case STAR_LA_TRAFFIC_TYPE_TIMECODE:
+        return 1u << LOG_EVENT_TIMECODE;
+    case STAR_LA_TRAFFIC_TYPE_NULL:
+        return 1u << LOG_EVENT_NULL;
+    case STAR_LA_TRAFFIC_TYPE_NO_CHARACTER:
+        return 1u << LOG_EVENT_NCHAR;
+    case STAR_LA_TRAFFIC_TYPE_GOT_BIT:
+        return 1u << LOG_EVENT_GOT_BIT;
+    default:
+        /* Errors are never left out */
+        return 0;
+    }
+}
+
+static int isIdleEvent(const EventStore *store, U32 event, U8 receiver)
+{
+    /* Type of the event */
+    U8 type = store->types[receiver][event];
+
+    return ((STAR_LA_TRAFFIC_TYPE_NULL == type) || (STAR_LA_TRAFFIC_TYPE_FCT == type) || (STAR_LA_TRAFFIC_TYPE_NO_CHARACTER == type)) &&
+           (0 == getEventErrors(store, event, receiver));
+}
+
+static int isSameRow(const EventStore *store, const struct eventRow *row, U32 event, const char *shown)
 {
     /* Loop counter */
+    U8 r = 0;
+    /* The rows show the same events */
+    int same = (row->shown[RECV_A] == shown[RECV_A]) && (row->shown[RECV_B] == shown[RECV_B]);
+
+    /* Idle characters carry no data, so only their types are compared */
+    for (r = RECV_A; same && (r <= RECV_B); r++)
+    {
+        same = !shown[r] || (store->types[r][row->event] == store->types[r][event]);
+    }
+
+    return same;
+}
+
+static unsigned long long printEventRow(OutputFile *output, const EventStore *store, const struct eventRow *row)
+{
+    /* Stream to print the row to */
+    FILE *stream = output->stream;
+    /* Number of characters printed */
+    int length = 0;
+
+    if (0 == row->count)
+    {
+        return 0;
+    }
+    /* The output is only rotated outside of packets, as they were when the row started */
+    if (!row->inPacket[RECV_A] && !row->inPacket[RECV_B])
+    {
+        stream = outputBoundary(output, row->tick);
+    }
+
+    /* Print index and time */
+    length = fprintf(stream, "%-8d%010.4fms    ", row->event, row->firstTime);
+    /* Print link A event type, data and error flag */
+    if (!row->shown[RECV_A])
+    {
+        length += fprintf(stream, "%49s", "");
+    }
+    else if (1 < row->count)
+    {
+        /* The data of collapsed idle characters differs between the rows */
+        length += fprintf(stream, "%-20s--              %-13s", GetEventTypeString(store->types[RECV_A][row->event]),
+                          GetErrorString(getEventErrors(store, row->event, RECV_A)));
+    }
+    else
+    {
+        length += fprintf(stream, "%-20s%02X              %-13s", GetEventTypeString(store->types[RECV_A][row->event]),
+                          store->data[RECV_A][row->event], GetErrorString(getEventErrors(store, row->event, RECV_A)));
+    }
+    /* Print link B event type, data and error flag */
+    if (row->shown[RECV_B] && (1 < row->count))
+    {
+        length += fprintf(stream, "%-20s--              %s", GetEventTypeString(store->types[RECV_B][row->event]),
+                          GetErrorString(getEventErrors(store, row->event, RECV_B)));
+    }
+    else if (row->shown[RECV_B])
+    {
+        length += fprintf(stream, "%-20s%02X              %s", GetEventTypeString(store->types[RECV_B][row->event]),
+                          store->data[RECV_B][row->event], GetErrorString(getEventErrors(store, row->event, RECV_B)));
+    }
+    /* Print the span of collapsed rows */
+    if (1 < row->count)
+    {
+        length += fprintf(stream, "    x%u from %010.4fms to %010.4fms", row->count, row->firstTime, row->lastTime);
+    }
+    length += fprintf(stream, "\n");
+    outputWritten(output, (unsigned long long)length);
+
+    return (unsigned long long)length;
+}
+
+unsigned long long LA_MK3_printEventCaptureLog(OutputFile *output, const EventStore *store, const int preTrigger, const unsigned int *exclude, const char collapse)
+{
+    /* Loop counters */
     U32 i = 0;
+    U8 r = 0;
+    /* Capture clock tick of the current event */
+    long long time = 0;
+    /* Receivers with an open packet, the output is only rotated outside of packets */
+    char inPacket[2] = { 0, 0 };
+    /* The events of the receivers are shown in the current row */
+    char shown[2] = { 1, 1 };
+    /* The current row consists of idle events, which may be collapsed */
+    int idle = 0;
+    /* The row waiting to be printed, while identical idle rows are collapsed into it */
+    struct eventRow row = { 0 };
+    /* Number of characters printed */
+    unsigned long long written = 0;
 
-    fprintf(stdout, "Index   Time            Event A Type        Event A Data    Error        Event B Type        Event B Data    Error\n");
-    for (i = 0; i < *trafficCount; i++)
+    for (i = 0; i < store->count; i++)
     {
+        time = getNextEventTime(store, i, time);
         /* Print events after trigger */
-        if (-preTrigger <= (pTraffic[i].time * *charCaptureClockPeriod * 1000))
+        if (-preTrigger <= (time * store->clockPeriod * 1000))
         {
-            /* Convert event types to strings */
-            char *linkAEventType = GetEventTypeString(pTraffic[i].linkAEvent.type);
-            char *linkBEventType = GetEventTypeString(pTraffic[i].linkBEvent.type);
-            /* Get Event Data */
-            U8 linkAEventData = pTraffic[i].linkAEvent.data;
-            U8 linkBEventData = pTraffic[i].linkBEvent.data;
-            /* Convert time to milliseconds */
-            double timeInMilliSeconds = pTraffic[i].time * *charCaptureClockPeriod * 1000;
-            /* Get error detected flags */
-            char *linkAError = GetErrorString(pTraffic[i].linkAEvent.errors);
-            char *linkBError = GetErrorString(pTraffic[i].linkBEvent.errors);
-            /* Print index */
-            fprintf(stdout, "%-8d", i);
-            /* Print time */
-            fprintf(stdout, "%010.4fms    ", timeInMilliSeconds);
-            /* Print link A event type */
-            fprintf(stdout, "%-20s", linkAEventType);
-            /* Print link A event data */
-            fprintf(stdout, "%02X              ", linkAEventData);
-            /* Print link A error flag */
-            fprintf(stdout, "%-13s", linkAError);
-            /* Print link B event type */
-            fprintf(stdout, "%-20s", linkBEventType);
-            /* Print link B event data */
-            fprintf(stdout, "%02X              ", linkBEventData);
-            /* Print link B error flag */
-            fprintf(stdout, "%s\n", linkBError);
+            for (r = RECV_A; (NULL != exclude) && (r <= RECV_B); r++)
+            {
+                shown[r] = (0 == (exclude[r] & getLogEventBit(store->types[r][i])));
+            }
+            idle = collapse && (!shown[RECV_A] || isIdleEvent(store, i, RECV_A)) && (!shown[RECV_B] || isIdleEvent(store, i, RECV_B));
+
+            if (idle && (0 < row.count) && isSameRow(store, &row, i, shown))
+            {
+                /* Extend the run of identical idle rows */
+                row.count++;
+                row.lastTime = time * store->clockPeriod * 1000;
+            }
+            else if (shown[RECV_A] || shown[RECV_B])
+            {
+                /* Print the previous row and start a new one */
+                written += printEventRow(output, store, &row);
+                row.event = i;
+                row.tick = time;
+                row.firstTime = time * store->clockPeriod * 1000;
+                row.lastTime = row.firstTime;
+                row.count = 1;
+                row.shown[RECV_A] = shown[RECV_A];
+                row.shown[RECV_B] = shown[RECV_B];
+                row.inPacket[RECV_A] = inPacket[RECV_A];
+                row.inPacket[RECV_B] = inPacket[RECV_B];
+                if (!idle)
+                {
+                    /* Rows other than idle ones are printed right away */
+                    written += printEventRow(output, store, &row);
+                    row.count = 0;
+                }
+            }
+        }
+        for (r = RECV_A; r <= RECV_B; r++)
+        {
+            /* Packets open with their header and close with an EOP or EEP */
+            if ((STAR_LA_TRAFFIC_TYPE_HEADER == store->types[r][i]) || (STAR_LA_TRAFFIC_TYPE_DATA == store->types[r][i]))
+            {
+                inPacket[r] = 1;
+            }
+            else if ((STAR_LA_TRAFFIC_TYPE_EOP == store->types[r][i]) || (STAR_LA_TRAFFIC_TYPE_EEP == store->types[r][i]))
+            {
+                inPacket[r] = 0;
+            }
         }
     }
+    written += printEventRow(output, store, &row);
 
     fputs("Printing event based capture log completed\n", stderr);
 
-    return;
+    return written;
 }
@@ -0,0 +1,302 @@
+#include <stdio.h>
+#include <time.h>
+#include <spw_la_api.h>
+#include "event_store.h"
+#include "event_scan.h"
+#include "packet_index.h"
+#include "arg_parser.h"
+#include "data_logger.h"
+#include "output_file.h"
+#include "run_stats.h"
+#include "error_log.h"
+
+/* Names of the packet terminations as used in the error log */
+static const char *const terminationNames[] = { "terminated by EOP", "terminated by EEP", "incomplete", "time-code" };
+
+/* Position of the single pass over the error events */
+struct errorCursor
+{
+    U32 flagged;        /* Next entry of the list of events with error flags */
+    U32 typed[2];       /* Next event with an error type on receiver A and B */
+};
+
+static void initErrorCursor(struct errorCursor *cursor, const EventStore *store, U32 first)
+{
+    /* Bounds for the binary search in the error list */
+    U32 low = 0;
+    U32 high = store->errorCount;
+    U32 mid = 0;
+
+    /* Find the first event with error flags at or after the first event */
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (store->errors[mid].event < first)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    cursor->flagged = low;
+    cursor->typed[RECV_A] = scanErrorEvent(store->types[RECV_A], first, store->count);
+    cursor->typed[RECV_B] = scanErrorEvent(store->types[RECV_B], first, store->count);
+
+    return;
+}
+
+static U32 nextErrorEvent(struct errorCursor *cursor, const EventStore *store)
+{
+    /* The next error event of all three sources */
+    U32 event = store->count;
+    /* Receiver counter */
+    U8 r = 0;
+
+    if (cursor->flagged < store->errorCount)
+    {
+        event = store->errors[cursor->flagged].event;
+    }
+    for (r = RECV_A; r <= RECV_B; r++)
+    {
+        event = (cursor->typed[r] < event) ? cursor->typed[r] : event;
+    }
+
+    /* Advance every source that found this event */
+    if ((cursor->flagged < store->errorCount) && (store->errors[cursor->flagged].event == event))
+    {
+        cursor->flagged++;
+    }
+    for (r = RECV_A; r <= RECV_B; r++)
+    {
+        if ((cursor->typed[r] == event) && (event < store->count))
+        {
+            cursor->typed[r] = scanErrorEvent(store->types[r], event + 1, store->count);
+        }
+    }
+
+    return event;
+}
+
+static long long getPreviousEventTime(const EventStore *store, U32 event, long long time)
+{
+    if ((0 == event % STORE_CHECKPOINT_INTERVAL) || (STORE_DELTA_OVERFLOW == store->timeDeltas[event]))
+    {
+        return getEventTime(store, event - 1);
+    }
+    return time - store->timeDeltas[event];
+}
+
+static U32 getContextStart(const EventStore *store, U32 event, long long time, unsigned int contextEvents, long long contextTicks)
+{
+    /* First event of the context */
+    U32 start = event;
+    /* Capture clock tick of that event */
+    long long startTime = time;
+    /* Capture clock tick of the event before */
+    long long previousTime = 0;
+
+    if (0 == contextTicks)
+    {
+        return (event > contextEvents) ? event - contextEvents : 0;
+    }
+    while (0 < start)
+    {
+        previousTime = getPreviousEventTime(store, start, startTime);
+        if (time - previousTime > contextTicks)
+        {
+            break;
+        }
+        start--;
+        startTime = previousTime;
+    }
+
+    return start;
+}
+
+static U32 getContextEnd(const EventStore *store, U32 event, long long time, unsigned int contextEvents, long long contextTicks)
+{
+    /* Last event of the context */
+    U32 end = event;
+    /* Capture clock tick of that event */
+    long long endTime = time;
+    /* Capture clock tick of the event after */
+    long long nextTime = 0;
+
+    if (0 == contextTicks)
+    {
+        return (store->count - 1 - event > contextEvents) ? event + contextEvents : store->count - 1;
+    }
+    while (end + 1 < store->count)
+    {
+        nextTime = getNextEventTime(store, end + 1, endTime);
+        if (nextTime - time > contextTicks)
+        {
+            break;
+        }
+        end++;
+        endTime = nextTime;
+    }
+
+    return end;
+}
+
+static U32 findPacket(const PacketIndex *index, U32 event, U8 receiver)
+{
+    /* Bounds for the binary search in the packet index */
+    U32 low = 0;
+    U32 high = index->count;
+    U32 mid = 0;
+    /* The checked entry */
+    const PacketEntry *entry = NULL;
+
+    /* Entries are ordered by their last event, find the first one ending at or after the event */
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (index->entries[mid].endEvent < event)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    /* Packets of a receiver never overlap, so only its next packet can hold the event */
+    for (; low < index->count; low++)
+    {
+        entry = &index->entries[low];
+        if ((entry->receiver == receiver) && ((PACKET_TERM_TIMECODE != entry->termination) || (entry->startEvent == event)))
+        {
+            return (entry->startEvent <= event) ? low : index->count;
+        }
+    }
+
+    return index->count;
+}
+
+static int printErrorReference(FILE *stream, const EventStore *store, const PacketIndex *index, struct timespec *triggerTime,
+                               U32 event, U8 receiver, U32 *lastPacket, unsigned long long *packetsHit)
+{
+    /* Type and error flags of the event */
+    U8 type = store->types[receiver][event];
+    U8 errors = getEventErrors(store, event, receiver);
+    /* The event has an error type */
+    int typed = (event == scanErrorEvent(store->types[receiver], event, event + 1));
+    /* Entry of the packet holding the event */
+    U32 packet = index->count;
+    /* Time of the packet relative to the trigger */
+    double deltaToTrigger = 0;
+    /* Timestamp of the packet as in the hexdump */
+    char timeString[40] = "";
+    /* Number of characters printed */
+    int length = 0;
+
+    if (!typed && (0 == errors))
+    {
+        return 0;
+    }
+
+    length = fprintf(stream, "#   %c: %s", (RECV_A == receiver) ? 'A' : 'B', typed ? GetEventTypeString(type) : "");
+    if (0 != errors)
+    {
+        length += fprintf(stream, "%s%s flag", typed ? " with " : "", GetErrorString(errors));
+    }
+
+    packet = findPacket(index, event, receiver);
+    if (packet < index->count)
+    {
+        deltaToTrigger = index->entries[packet].startTime * store->clockPeriod;
+        LA_MK3_getPacketTimestamp(&deltaToTrigger, triggerTime, timeString);
+        length += fprintf(stream, " in record %u of the hexdump at %s (%u bytes, %s)\n", packet + 1, timeString,
+                          index->entries[packet].length, terminationNames[index->entries[packet].termination]);
+        if (packet != *lastPacket)
+        {
+            (*packetsHit)++;
+            *lastPacket = packet;
+        }
+    }
+    else
+    {
+        length += fprintf(stream, " outside of the indexed packets\n");
+    }
+
+    return length;
+}
+
+unsigned long long LA_MK3_printErrorLog(OutputFile *output, const EventStore *store, const PacketIndex *index, struct timespec *triggerTime,
+                                        unsigned int contextEvents, double contextTime)
+{
+    /* Stream to print to */
+    FILE *stream = output->stream;
+    /* Position of the pass over the error events */
+    struct errorCursor cursor;
+    /* The next error event */
+    U32 error = 0;
+    /* First, current and last event of the block */
+    U32 start = 0;
+    U32 i = 0;
+    U32 end = 0;
+    /* Capture clock tick of the current event and of the error */
+    long long time = 0;
+    long long errorTime = 0;
+    /* Context around each error in capture clock ticks (0 = counted in events) */
+    long long contextTicks = ((0.0 < contextTime) && (0.0 < store->clockPeriod)) ? (long long)(contextTime / store->clockPeriod) + 1 : 0;
+    /* Last packet hit on receiver A and B */
+    U32 lastPacket[2] = { index->count, index->count };
+    /* Number of error events and of packets hit */
+    unsigned long long errors = 0;
+    unsigned long long packetsHit = 0;
+    /* Number of characters printed */
+    unsigned long long written = 0;
+    /* Receiver counter */
+    U8 r = 0;
+
+    initErrorCursor(&cursor, store, index->firstEvent);
+    error = nextErrorEvent(&cursor, store);
+    while (error < store->count)
+    {
+        /* Start a new block, errors within the context of a block are printed in it */
+        errorTime = getEventTime(store, error);
+        start = getContextStart(store, error, errorTime, contextEvents, contextTicks);
+        end = getContextEnd(store, error, errorTime, contextEvents, contextTicks);
+        written += fprintf(stream, "\n### Error %llu at %010.4fms\n", errors + 1, errorTime * store->clockPeriod * 1000);
+
+        for (i = start; i <= end; i++)
+        {
+            time = (i == start) ? getEventTime(store, i) : getNextEventTime(store, i, time);
+            written += fprintf(stream, "%s", (i == error) ? "> " : "  ");
+            written += LA_MK3_printEvent(stream, store, i, time * store->clockPeriod * 1000);
+            if (i != error)
+            {
+                continue;
+            }
+
+            /* Reference the packets hit by the error and extend the block by the context of the next one */
+            for (r = RECV_A; r <= RECV_B; r++)
+            {
+                written += printErrorReference(stream, store, index, triggerTime, error, r, &lastPacket[r], &packetsHit);
+            }
+            errors++;
+            error = nextErrorEvent(&cursor, store);
+            if (error < store->count)
+            {
+                errorTime = getEventTime(store, error);
+                if (getContextStart(store, error, errorTime, contextEvents, contextTicks) <= end + 1)
+                {
+                    end = getContextEnd(store, error, errorTime, contextEvents, contextTicks);
+                }
+            }
+        }
+    }
+    written += fprintf(stream, "\n### %llu error event(s), %llu packet(s) and time-code(s) hit\n", errors, packetsHit);
+    outputWritten(output, written);
+    statsAdd(STATS_ERROR_EVENTS, errors);
+
+    fprintf(stderr, "Found %llu error event(s) hitting %llu packet(s) and time-code(s)\n", errors, packetsHit);
+
+    return written;
+}
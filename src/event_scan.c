@@ -0,0 +1,725 @@
+#include <stdio.h>
+#include <string.h>
+#include <spw_la_api.h>
+#include "event_scan.h"
+
+#if defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__))
+#include <immintrin.h>
+#define SCAN_X86 1
+#else
+#define SCAN_X86 0
+#endif
+
+/* Classes of event types used by the scalar kernels */
+#define CLASS_START     0x01    /* Header or time-code */
+#define CLASS_CONTINUE  0x02    /* Data or idle event within a packet */
+#define CLASS_BYTE      0x04    /* Header or data byte */
+#define CLASS_ERROR     0x08    /* Sequence, parity, escape or disconnect error */
+
+/* Instruction set in use (-1 = not yet detected) */
+static int scanLevel = -1;
+
+static int getSupportedLevel(void)
+{
+#if SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        return SCAN_LEVEL_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2"))
+    {
+        return SCAN_LEVEL_SSE2;
+    }
+#endif
+    return SCAN_LEVEL_SCALAR;
+}
+
+int setScanLevel(int level)
+{
+    /* Best level supported by the CPU */
+    int supported = getSupportedLevel();
+
+    scanLevel = (level < supported) ? level : supported;
+    scanLevel = (SCAN_LEVEL_SCALAR < scanLevel) ? scanLevel : SCAN_LEVEL_SCALAR;
+
+    return scanLevel;
+}
+
+int getScanLevel(void)
+{
+    if (0 > scanLevel)
+    {
+        scanLevel = getSupportedLevel();
+    }
+
+    return scanLevel;
+}
+
+static U8 getTypeClass(U8 type)
+{
+    /* Class of the event type */
+    U8 typeClass = 0;
+
+    switch (type)
+    {
+    case STAR_LA_TRAFFIC_TYPE_HEADER:
+        typeClass = CLASS_START | CLASS_BYTE;
+        break;
+    case STAR_LA_TRAFFIC_TYPE_DATA:
+        typeClass = CLASS_CONTINUE | CLASS_BYTE;
+        break;
+    case STAR_LA_TRAFFIC_TYPE_TIMECODE:
+        typeClass = CLASS_START;
+        break;
+    case STAR_LA_TRAFFIC_TYPE_NULL:
+    case STAR_LA_TRAFFIC_TYPE_FCT:
+    case STAR_LA_TRAFFIC_TYPE_NO_CHARACTER:
+        typeClass = CLASS_CONTINUE;
+        break;
+    case STAR_LA_TRAFFIC_TYPE_DATA_SEQ_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_EOP_SEQ_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_EEP_SEQ_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_TIMECODE_SEQ_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_PARITY_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_ESCAPE_ESCAPE_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_ESCAPE_EOP_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_ESCAPE_EEP_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_DISCONNECT_ERROR:
+        typeClass = CLASS_ERROR;
+        break;
+    default:
+        break;
+    }
+
+    return typeClass;
+}
+
+/*
+ * Scalar kernels, also used for the remainder of the vectorized kernels
+ */
+
+static U32 scanPacketStartScalar(const U8 *types, U32 start, U32 end)
+{
+    for (; (start < end) && !(getTypeClass(types[start]) & CLASS_START); start++)
+    {
+    }
+
+    return start;
+}
+
+static U32 scanPacketDataScalar(const U8 *types, U32 start, U32 end, U32 *bytes)
+{
+    /* Class of the current event */
+    U8 typeClass = 0;
+
+    for (; start < end; start++)
+    {
+        typeClass = getTypeClass(types[start]);
+        if (!(typeClass & CLASS_CONTINUE))
+        {
+            break;
+        }
+        *bytes += (typeClass & CLASS_BYTE) ? 1 : 0;
+    }
+
+    return start;
+}
+
+static U32 scanErrorEventScalar(const U8 *types, U32 start, U32 end)
+{
+    for (; (start < end) && !(getTypeClass(types[start]) & CLASS_ERROR); start++)
+    {
+    }
+
+    return start;
+}
+
+static U32 scanBytePairScalar(const U8 *bytes, U32 start, U32 end, U8 first, U8 last, U32 distance)
+{
+    for (; (start < end) && ((first != bytes[start]) || (last != bytes[start + distance])); start++)
+    {
+    }
+
+    return start;
+}
+
+static U32 gatherPacketDataScalar(const U8 *types, const U8 *data, U32 start, U32 end, U8 *buffer, U32 maxLength)
+{
+    /* Number of bytes written to the buffer */
+    U32 length = 0;
+
+    for (; (start < end) && (length < maxLength); start++)
+    {
+        if (getTypeClass(types[start]) & CLASS_BYTE)
+        {
+            buffer[length++] = data[start];
+        }
+    }
+
+    return length;
+}
+
+static int getHexNibble(char character)
+{
+    if (('0' <= character) && ('9' >= character))
+    {
+        return character - '0';
+    }
+    if (('A' <= (character & ~0x20)) && ('F' >= (character & ~0x20)))
+    {
+        return (character & ~0x20) - 'A' + 10;
+    }
+
+    return -1;
+}
+
+static U32 decodeHexBytesScalar(const char *text, size_t length, U8 *bytes, U32 maxBytes)
+{
+    /* Number of decoded bytes */
+    U32 count = 0;
+    /* Values of the two digits of the current group */
+    int high = 0, low = 0;
+
+    for (; (count < maxBytes) && (3 * (size_t)count + 3 <= length); count++)
+    {
+        high = getHexNibble(text[3 * count + 1]);
+        low = getHexNibble(text[3 * count + 2]);
+        if ((' ' != text[3 * count]) || (0 > high) || (0 > low))
+        {
+            break;
+        }
+        bytes[count] = (U8)((high << 4) | low);
+    }
+
+    return count;
+}
+
+#if SCAN_X86
+
+/*
+ * SSE2 kernels processing 16 events at once
+ */
+
+static U32 scanPacketStartSse2(const U8 *types, U32 start, U32 end)
+{
+    const __m128i header = _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_HEADER);
+    const __m128i timecode = _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_TIMECODE);
+    /* Vector of event types */
+    __m128i vec;
+    /* Mask of matching events */
+    unsigned int mask = 0;
+
+    for (; start + 16 <= end; start += 16)
+    {
+        vec = _mm_loadu_si128((const __m128i *)(types + start));
+        mask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(vec, header), _mm_cmpeq_epi8(vec, timecode)));
+        if (mask)
+        {
+            return start + (U32)__builtin_ctz(mask);
+        }
+    }
+
+    return scanPacketStartScalar(types, start, end);
+}
+
+static __m128i getByteMaskSse2(__m128i vec)
+{
+    return _mm_or_si128(_mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_HEADER)),
+                        _mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_DATA)));
+}
+
+static __m128i getDataMaskSse2(__m128i vec)
+{
+    return _mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_DATA));
+}
+
+static __m128i getIdleMaskSse2(__m128i vec)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_NULL)),
+                                     _mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_FCT))),
+                        _mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_NO_CHARACTER)));
+}
+
+static U32 scanPacketDataSse2(const U8 *types, U32 start, U32 end, U32 *bytes)
+{
+    /* Vector of event types */
+    __m128i vec;
+    /* Masks of data events and of events ending the run */
+    unsigned int dataMask = 0;
+    unsigned int stopMask = 0;
+
+    for (; start + 16 <= end; start += 16)
+    {
+        vec = _mm_loadu_si128((const __m128i *)(types + start));
+        dataMask = (unsigned int)_mm_movemask_epi8(getDataMaskSse2(vec));
+        stopMask = ~((unsigned int)_mm_movemask_epi8(getIdleMaskSse2(vec)) | dataMask) & 0xFFFFu;
+        if (stopMask)
+        {
+            /* Count bytes up to the first other event */
+            *bytes += (U32)__builtin_popcount(dataMask & ((1u << __builtin_ctz(stopMask)) - 1u));
+            return start + (U32)__builtin_ctz(stopMask);
+        }
+        *bytes += (U32)__builtin_popcount(dataMask);
+    }
+
+    return scanPacketDataScalar(types, start, end, bytes);
+}
+
+static __m128i getErrorMaskSse2(__m128i vec)
+{
+    /* Mask of the sequence errors */
+    __m128i mask = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_DATA_SEQ_ERROR)),
+                                             _mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_EOP_SEQ_ERROR))),
+                                _mm_or_si128(_mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_EEP_SEQ_ERROR)),
+                                             _mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_TIMECODE_SEQ_ERROR))));
+
+    /* Add the parity, escape and disconnect errors */
+    mask = _mm_or_si128(mask, _mm_or_si128(_mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_PARITY_ERROR)),
+                                           _mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_DISCONNECT_ERROR))));
+    return _mm_or_si128(mask, _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_ESCAPE_ESCAPE_ERROR)),
+                                                        _mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_ESCAPE_EOP_ERROR))),
+                                           _mm_cmpeq_epi8(vec, _mm_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_ESCAPE_EEP_ERROR))));
+}
+
+static U32 scanErrorEventSse2(const U8 *types, U32 start, U32 end)
+{
+    /* Mask of error events */
+    unsigned int mask = 0;
+
+    for (; start + 16 <= end; start += 16)
+    {
+        mask = (unsigned int)_mm_movemask_epi8(getErrorMaskSse2(_mm_loadu_si128((const __m128i *)(types + start))));
+        if (mask)
+        {
+            return start + (U32)__builtin_ctz(mask);
+        }
+    }
+
+    return scanErrorEventScalar(types, start, end);
+}
+
+static U32 scanBytePairSse2(const U8 *bytes, U32 start, U32 end, U8 first, U8 last, U32 distance)
+{
+    const __m128i firstVec = _mm_set1_epi8((char)first);
+    const __m128i lastVec = _mm_set1_epi8((char)last);
+    /* Mask of positions holding both bytes */
+    unsigned int mask = 0;
+
+    for (; start + 16 <= end; start += 16)
+    {
+        mask = (unsigned int)_mm_movemask_epi8(_mm_and_si128(
+                   _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(bytes + start)), firstVec),
+                   _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(bytes + start + distance)), lastVec)));
+        if (mask)
+        {
+            return start + (U32)__builtin_ctz(mask);
+        }
+    }
+
+    return scanBytePairScalar(bytes, start, end, first, last, distance);
+}
+
+static U32 gatherPacketDataSse2(const U8 *types, const U8 *data, U32 start, U32 end, U8 *buffer, U32 maxLength)
+{
+    /* Number of bytes written to the buffer */
+    U32 length = 0;
+    /* Mask of byte events */
+    unsigned int byteMask = 0;
+
+    for (; (start + 16 <= end) && (length < maxLength); start += 16)
+    {
+        byteMask = (unsigned int)_mm_movemask_epi8(getByteMaskSse2(_mm_loadu_si128((const __m128i *)(types + start))));
+        if ((0xFFFFu == byteMask) && (length + 16 <= maxLength))
+        {
+            /* Copy a run of data bytes at once */
+            _mm_storeu_si128((__m128i *)(buffer + length), _mm_loadu_si128((const __m128i *)(data + start)));
+            length += 16;
+        }
+        else
+        {
+            for (; byteMask && (length < maxLength); byteMask &= byteMask - 1)
+            {
+                buffer[length++] = data[start + (U32)__builtin_ctz(byteMask)];
+            }
+        }
+    }
+
+    return length + gatherPacketDataScalar(types, data, start, end, buffer + length, maxLength - length);
+}
+
+/* Converts hex digits to their values, other characters to zero */
+static __m128i getHexNibblesSse2(__m128i vec, unsigned int *digitMask)
+{
+    const __m128i digits = _mm_sub_epi8(vec, _mm_set1_epi8('0'));
+    const __m128i letters = _mm_sub_epi8(_mm_or_si128(vec, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    /* Unsigned range checks, characters below the range wrap around to large values */
+    const __m128i isDigit = _mm_cmpeq_epi8(_mm_min_epu8(digits, _mm_set1_epi8(9)), digits);
+    const __m128i isLetter = _mm_cmpeq_epi8(_mm_min_epu8(letters, _mm_set1_epi8(5)), letters);
+
+    *digitMask = (unsigned int)_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter));
+    return _mm_or_si128(_mm_and_si128(isDigit, digits), _mm_and_si128(isLetter, _mm_add_epi8(letters, _mm_set1_epi8(10))));
+}
+
+static U32 decodeHexBytesSse2(const char *text, size_t length, U8 *bytes, U32 maxBytes)
+{
+    /* Number of decoded bytes */
+    U32 count = 0;
+    /* Loop counter */
+    U32 i = 0;
+    /* Number of leading valid groups in the block */
+    U32 groups = 0;
+    /* Masks of spaces, hex digits and invalid groups in the block */
+    unsigned int spaceMask = 0, digitMask = 0, badMask = 0;
+    /* Block of characters and the digit values */
+    __m128i vec, nibbles;
+    /* Byte values, the value of a group at its first digit */
+    U8 values[16] __attribute__((aligned(16)));
+
+    /* Five groups of a space and two digits per block */
+    for (; (count + 5 <= maxBytes) && (3 * (size_t)count + 16 <= length); count += 5)
+    {
+        vec = _mm_loadu_si128((const __m128i *)(text + 3 * count));
+        nibbles = getHexNibblesSse2(vec, &digitMask);
+        spaceMask = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(vec, _mm_set1_epi8(' ')));
+        badMask = ~(spaceMask & (digitMask >> 1) & (digitMask >> 2)) & 0x1249u;
+        _mm_store_si128((__m128i *)values, _mm_or_si128(_mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi8((char)0xF0)),
+                                                        _mm_srli_si128(nibbles, 1)));
+        groups = badMask ? (U32)__builtin_ctz(badMask) / 3 : 5;
+        for (i = 0; i < groups; i++)
+        {
+            bytes[count + i] = values[3 * i + 1];
+        }
+        if (5 > groups)
+        {
+            return count + groups;
+        }
+    }
+
+    return count + decodeHexBytesScalar(text + 3 * count, length - 3 * count, bytes + count, maxBytes - count);
+}
+
+/*
+ * AVX2 kernels processing 32 events at once
+ */
+
+__attribute__((target("avx2")))
+static U32 scanPacketStartAvx2(const U8 *types, U32 start, U32 end)
+{
+    const __m256i header = _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_HEADER);
+    const __m256i timecode = _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_TIMECODE);
+    /* Vector of event types */
+    __m256i vec;
+    /* Mask of matching events */
+    unsigned int mask = 0;
+
+    for (; start + 32 <= end; start += 32)
+    {
+        vec = _mm256_loadu_si256((const __m256i *)(types + start));
+        mask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(vec, header), _mm256_cmpeq_epi8(vec, timecode)));
+        if (mask)
+        {
+            return start + (U32)__builtin_ctz(mask);
+        }
+    }
+
+    /* Clear the upper register halves before the SSE2 tail to avoid the AVX-SSE transition penalty */
+    _mm256_zeroupper();
+    return scanPacketStartSse2(types, start, end);
+}
+
+__attribute__((target("avx2")))
+static __m256i getByteMaskAvx2(__m256i vec)
+{
+    return _mm256_or_si256(_mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_HEADER)),
+                           _mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_DATA)));
+}
+
+__attribute__((target("avx2")))
+static __m256i getDataMaskAvx2(__m256i vec)
+{
+    return _mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_DATA));
+}
+
+__attribute__((target("avx2")))
+static __m256i getIdleMaskAvx2(__m256i vec)
+{
+    return _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_NULL)),
+                                           _mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_FCT))),
+                           _mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_NO_CHARACTER)));
+}
+
+__attribute__((target("avx2")))
+static U32 scanPacketDataAvx2(const U8 *types, U32 start, U32 end, U32 *bytes)
+{
+    /* Vector of event types */
+    __m256i vec;
+    /* Masks of data events and of events ending the run */
+    unsigned int dataMask = 0;
+    unsigned int stopMask = 0;
+
+    for (; start + 32 <= end; start += 32)
+    {
+        vec = _mm256_loadu_si256((const __m256i *)(types + start));
+        dataMask = (unsigned int)_mm256_movemask_epi8(getDataMaskAvx2(vec));
+        stopMask = ~((unsigned int)_mm256_movemask_epi8(getIdleMaskAvx2(vec)) | dataMask);
+        if (stopMask)
+        {
+            /* Count bytes up to the first other event */
+            *bytes += (U32)__builtin_popcount(dataMask & ((1u << __builtin_ctz(stopMask)) - 1u));
+            return start + (U32)__builtin_ctz(stopMask);
+        }
+        *bytes += (U32)__builtin_popcount(dataMask);
+    }
+
+    /* Clear the upper register halves before the SSE2 tail to avoid the AVX-SSE transition penalty */
+    _mm256_zeroupper();
+    return scanPacketDataSse2(types, start, end, bytes);
+}
+
+__attribute__((target("avx2")))
+static __m256i getErrorMaskAvx2(__m256i vec)
+{
+    /* Mask of the sequence errors */
+    __m256i mask = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_DATA_SEQ_ERROR)),
+                                                   _mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_EOP_SEQ_ERROR))),
+                                   _mm256_or_si256(_mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_EEP_SEQ_ERROR)),
+                                                   _mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_TIMECODE_SEQ_ERROR))));
+
+    /* Add the parity, escape and disconnect errors */
+    mask = _mm256_or_si256(mask, _mm256_or_si256(_mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_PARITY_ERROR)),
+                                                 _mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_DISCONNECT_ERROR))));
+    return _mm256_or_si256(mask, _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_ESCAPE_ESCAPE_ERROR)),
+                                                                 _mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_ESCAPE_EOP_ERROR))),
+                                                 _mm256_cmpeq_epi8(vec, _mm256_set1_epi8((char)STAR_LA_TRAFFIC_TYPE_ESCAPE_EEP_ERROR))));
+}
+
+__attribute__((target("avx2")))
+static U32 scanErrorEventAvx2(const U8 *types, U32 start, U32 end)
+{
+    /* Mask of error events */
+    unsigned int mask = 0;
+
+    for (; start + 32 <= end; start += 32)
+    {
+        mask = (unsigned int)_mm256_movemask_epi8(getErrorMaskAvx2(_mm256_loadu_si256((const __m256i *)(types + start))));
+        if (mask)
+        {
+            return start + (U32)__builtin_ctz(mask);
+        }
+    }
+
+    /* Clear the upper register halves before the SSE2 tail to avoid the AVX-SSE transition penalty */
+    _mm256_zeroupper();
+    return scanErrorEventSse2(types, start, end);
+}
+
+__attribute__((target("avx2")))
+static U32 scanBytePairAvx2(const U8 *bytes, U32 start, U32 end, U8 first, U8 last, U32 distance)
+{
+    const __m256i firstVec = _mm256_set1_epi8((char)first);
+    const __m256i lastVec = _mm256_set1_epi8((char)last);
+    /* Mask of positions holding both bytes */
+    unsigned int mask = 0;
+
+    for (; start + 32 <= end; start += 32)
+    {
+        mask = (unsigned int)_mm256_movemask_epi8(_mm256_and_si256(
+                   _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(bytes + start)), firstVec),
+                   _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(bytes + start + distance)), lastVec)));
+        if (mask)
+        {
+            return start + (U32)__builtin_ctz(mask);
+        }
+    }
+
+    _mm256_zeroupper();
+    return scanBytePairSse2(bytes, start, end, first, last, distance);
+}
+
+__attribute__((target("avx2")))
+static U32 gatherPacketDataAvx2(const U8 *types, const U8 *data, U32 start, U32 end, U8 *buffer, U32 maxLength)
+{
+    /* Number of bytes written to the buffer */
+    U32 length = 0;
+    /* Mask of byte events */
+    unsigned int byteMask = 0;
+
+    for (; (start + 32 <= end) && (length < maxLength); start += 32)
+    {
+        byteMask = (unsigned int)_mm256_movemask_epi8(getByteMaskAvx2(_mm256_loadu_si256((const __m256i *)(types + start))));
+        if ((0xFFFFFFFFu == byteMask) && (length + 32 <= maxLength))
+        {
+            /* Copy a run of data bytes at once */
+            _mm256_storeu_si256((__m256i *)(buffer + length), _mm256_loadu_si256((const __m256i *)(data + start)));
+            length += 32;
+        }
+        else
+        {
+            for (; byteMask && (length < maxLength); byteMask &= byteMask - 1)
+            {
+                buffer[length++] = data[start + (U32)__builtin_ctz(byteMask)];
+            }
+        }
+    }
+
+    /* Clear the upper register halves before the SSE2 tail to avoid the AVX-SSE transition penalty */
+    _mm256_zeroupper();
+    return length + gatherPacketDataSse2(types, data, start, end, buffer + length, maxLength - length);
+}
+
+__attribute__((target("avx2")))
+static __m256i getHexNibblesAvx2(__m256i vec, unsigned int *digitMask)
+{
+    const __m256i digits = _mm256_sub_epi8(vec, _mm256_set1_epi8('0'));
+    const __m256i letters = _mm256_sub_epi8(_mm256_or_si256(vec, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    const __m256i isDigit = _mm256_cmpeq_epi8(_mm256_min_epu8(digits, _mm256_set1_epi8(9)), digits);
+    const __m256i isLetter = _mm256_cmpeq_epi8(_mm256_min_epu8(letters, _mm256_set1_epi8(5)), letters);
+
+    *digitMask = (unsigned int)_mm256_movemask_epi8(_mm256_or_si256(isDigit, isLetter));
+    return _mm256_or_si256(_mm256_and_si256(isDigit, digits),
+                           _mm256_and_si256(isLetter, _mm256_add_epi8(letters, _mm256_set1_epi8(10))));
+}
+
+__attribute__((target("avx2")))
+static U32 decodeHexBytesAvx2(const char *text, size_t length, U8 *bytes, U32 maxBytes)
+{
+    /* Moves the values of the five groups of a lane to its first bytes */
+    const __m256i compact = _mm256_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    /* Number of decoded bytes */
+    U32 count = 0;
+    /* Number of leading valid groups in the block */
+    U32 groups = 0;
+    /* Masks of spaces, hex digits and invalid groups in the block */
+    unsigned int spaceMask = 0, digitMask = 0, badMask = 0;
+    /* Block of characters and the digit values */
+    __m256i vec, nibbles;
+    /* Byte values of the groups of both lanes */
+    U8 values[32] __attribute__((aligned(32)));
+
+    /* Ten groups per block, five in each lane so no group crosses the lanes */
+    for (; (count + 10 <= maxBytes) && (3 * (size_t)count + 31 <= length); count += 10)
+    {
+        vec = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *)(text + 3 * count))),
+                                      _mm_loadu_si128((const __m128i *)(text + 3 * count + 15)), 1);
+        nibbles = getHexNibblesAvx2(vec, &digitMask);
+        spaceMask = (unsigned int)_mm256_movemask_epi8(_mm256_cmpeq_epi8(vec, _mm256_set1_epi8(' ')));
+        badMask = ~(spaceMask & (digitMask >> 1) & (digitMask >> 2)) & 0x12491249u;
+        _mm256_store_si256((__m256i *)values,
+                           _mm256_shuffle_epi8(_mm256_or_si256(_mm256_and_si256(_mm256_slli_epi16(nibbles, 4), _mm256_set1_epi8((char)0xF0)),
+                                                               _mm256_srli_si256(nibbles, 1)), compact));
+        groups = !badMask ? 10 : (16 > __builtin_ctz(badMask)) ? (U32)__builtin_ctz(badMask) / 3 : 5 + (U32)(__builtin_ctz(badMask) - 16) / 3;
+        memcpy(bytes + count, values, (5 < groups) ? 5 : groups);
+        if (5 < groups)
+        {
+            memcpy(bytes + count + 5, values + 16, groups - 5);
+        }
+        if (10 > groups)
+        {
+            _mm256_zeroupper();
+            return count + groups;
+        }
+    }
+
+    _mm256_zeroupper();
+    return count + decodeHexBytesSse2(text + 3 * count, length - 3 * count, bytes + count, maxBytes - count);
+}
+
+#endif
+
+U32 scanPacketStart(const U8 *types, U32 start, U32 end)
+{
+#if SCAN_X86
+    switch (getScanLevel())
+    {
+    case SCAN_LEVEL_AVX2:
+        return scanPacketStartAvx2(types, start, end);
+    case SCAN_LEVEL_SSE2:
+        return scanPacketStartSse2(types, start, end);
+    default:
+        break;
+    }
+#endif
+    return scanPacketStartScalar(types, start, end);
+}
+
+U32 scanPacketData(const U8 *types, U32 start, U32 end, U32 *bytes)
+{
+#if SCAN_X86
+    switch (getScanLevel())
+    {
+    case SCAN_LEVEL_AVX2:
+        return scanPacketDataAvx2(types, start, end, bytes);
+    case SCAN_LEVEL_SSE2:
+        return scanPacketDataSse2(types, start, end, bytes);
+    default:
+        break;
+    }
+#endif
+    return scanPacketDataScalar(types, start, end, bytes);
+}
+
+U32 scanErrorEvent(const U8 *types, U32 start, U32 end)
+{
+#if SCAN_X86
+    switch (getScanLevel())
+    {
+    case SCAN_LEVEL_AVX2:
+        return scanErrorEventAvx2(types, start, end);
+    case SCAN_LEVEL_SSE2:
+        return scanErrorEventSse2(types, start, end);
+    default:
+        break;
+    }
+#endif
+    return scanErrorEventScalar(types, start, end);
+}
+
+U32 scanBytePair(const U8 *bytes, U32 start, U32 end, U8 first, U8 last, U32 distance)
+{
+#if SCAN_X86
+    switch (getScanLevel())
+    {
+    case SCAN_LEVEL_AVX2:
+        return scanBytePairAvx2(bytes, start, end, first, last, distance);
+    case SCAN_LEVEL_SSE2:
+        return scanBytePairSse2(bytes, start, end, first, last, distance);
+    default:
+        break;
+    }
+#endif
+    return scanBytePairScalar(bytes, start, end, first, last, distance);
+}
+
+U32 gatherPacketData(const U8 *types, const U8 *data, U32 start, U32 end, U8 *buffer, U32 maxLength)
+{
+#if SCAN_X86
+    switch (getScanLevel())
+    {
+    case SCAN_LEVEL_AVX2:
+        return gatherPacketDataAvx2(types, data, start, end, buffer, maxLength);
+    case SCAN_LEVEL_SSE2:
+        return gatherPacketDataSse2(types, data, start, end, buffer, maxLength);
+    default:
+        break;
+    }
+#endif
+    return gatherPacketDataScalar(types, data, start, end, buffer, maxLength);
+}
+
+U32 decodeHexBytes(const char *text, size_t length, U8 *bytes, U32 maxBytes)
+{
+#if SCAN_X86
+    switch (getScanLevel())
+    {
+    case SCAN_LEVEL_AVX2:
+        return decodeHexBytesAvx2(text, length, bytes, maxBytes);
+    case SCAN_LEVEL_SSE2:
+        return decodeHexBytesSse2(text, length, bytes, maxBytes);
+    default:
+        break;
+    }
+#endif
+    return decodeHexBytesScalar(text, length, bytes, maxBytes);
+}
@@ -0,0 +1,279 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <spw_la_api.h>
+#include "event_store.h"
+
+/* Number of bits per word of the error bitmap */
+#define BITMAP_WORD_BITS 64
+
+static int appendOverflow(EventStore *store, U32 *capacity, U32 event, long long time)
+{
+    /* Reallocated overflow list */
+    TimeOverflow *overflows = NULL;
+
+    if (store->overflowCount == *capacity)
+    {
+        *capacity = *capacity ? 2 * *capacity : 16;
+        overflows = realloc(store->overflows, *capacity * sizeof(TimeOverflow));
+        if (NULL == overflows)
+        {
+            return 0;
+        }
+        store->overflows = overflows;
+    }
+    store->overflows[store->overflowCount].event = event;
+    store->overflows[store->overflowCount].time = time;
+    store->overflowCount++;
+
+    return 1;
+}
+
+static int appendErrors(EventStore *store, U32 *capacity, U32 event, U8 errorsA, U8 errorsB)
+{
+    /* Reallocated error list */
+    EventErrors *errors = NULL;
+
+    if (store->errorCount == *capacity)
+    {
+        *capacity = *capacity ? 2 * *capacity : 64;
+        errors = realloc(store->errors, *capacity * sizeof(EventErrors));
+        if (NULL == errors)
+        {
+            return 0;
+        }
+        store->errors = errors;
+    }
+    store->errors[store->errorCount].event = event;
+    store->errors[store->errorCount].errors[RECV_A] = errorsA;
+    store->errors[store->errorCount].errors[RECV_B] = errorsB;
+    store->errorCount++;
+    store->errorBitmap[event / BITMAP_WORD_BITS] |= 1ull << (event % BITMAP_WORD_BITS);
+
+    return 1;
+}
+
+/* Returns the whole pages between the released part of the traffic and the given event to the system */
+static int releaseTraffic(uintptr_t *released, const STAR_LA_MK3_Traffic *end, uintptr_t pageSize)
+{
+    /* Start of the last page not yet converted */
+    uintptr_t stop = (uintptr_t)end & ~(pageSize - 1);
+
+    if (*released >= stop)
+    {
+        return 1;
+    }
+    if (0 != madvise((void *)*released, stop - *released, MADV_DONTNEED))
+    {
+        return 0;
+    }
+    *released = stop;
+
+    return 1;
+}
+
+int LA_MK3_convertTraffic(EventStore *store, STAR_LA_MK3_Traffic *pTraffic, const U32 *trafficCount, const double *charCaptureClockPeriod)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* Return value */
+    int ret = 1;
+    /* Number of events (at least one to keep the allocations valid) */
+    size_t count = *trafficCount ? *trafficCount : 1;
+    /* Ticks since the previous event */
+    long long delta = 0;
+    /* Allocated entries of the overflow and error lists */
+    U32 overflowCapacity = 0;
+    U32 errorCapacity = 0;
+    /* Size of a memory page */
+    uintptr_t pageSize = (uintptr_t)sysconf(_SC_PAGESIZE);
+    /* End of the released traffic, starting at the first whole page */
+    uintptr_t released = ((uintptr_t)pTraffic + pageSize - 1) & ~(pageSize - 1);
+    /* Whether the converted traffic is still released */
+    char release = (0 < (long)pageSize) && (0 == (pageSize & (pageSize - 1)));
+
+    store->count = *trafficCount;
+    store->clockPeriod = *charCaptureClockPeriod;
+    store->overflows = NULL;
+    store->overflowCount = 0;
+    store->errors = NULL;
+    store->errorCount = 0;
+    store->checkpoints = malloc((count / STORE_CHECKPOINT_INTERVAL + 1) * sizeof(long long));
+    store->timeDeltas = malloc(count * sizeof(U32));
+    store->types[RECV_A] = malloc(count);
+    store->types[RECV_B] = malloc(count);
+    store->data[RECV_A] = malloc(count);
+    store->data[RECV_B] = malloc(count);
+    store->errorBitmap = calloc(count / BITMAP_WORD_BITS + 1, sizeof(unsigned long long));
+
+    if ((NULL == store->checkpoints) || (NULL == store->timeDeltas) || (NULL == store->types[RECV_A]) ||
+        (NULL == store->types[RECV_B]) || (NULL == store->data[RECV_A]) || (NULL == store->data[RECV_B]) ||
+        (NULL == store->errorBitmap))
+    {
+        fputs("Unable to allocate memory for the event store\n", stderr);
+        freeEventStore(store);
+        return 0;
+    }
+
+    for (i = 0; (i < *trafficCount) && ret; i++)
+    {
+        /* Delta encode the time, keeping absolute checkpoints for random access */
+        if (0 == i % STORE_CHECKPOINT_INTERVAL)
+        {
+            store->checkpoints[i / STORE_CHECKPOINT_INTERVAL] = pTraffic[i].time;
+        }
+        delta = (0 < i) ? (long long)(pTraffic[i].time - pTraffic[i - 1].time) : 0;
+        if ((0 <= delta) && (STORE_DELTA_OVERFLOW > delta))
+        {
+            store->timeDeltas[i] = (U32)delta;
+        }
+        else
+        {
+            store->timeDeltas[i] = STORE_DELTA_OVERFLOW;
+            ret = appendOverflow(store, &overflowCapacity, i, pTraffic[i].time);
+        }
+
+        /* Pack event types and data per receiver */
+        store->types[RECV_A][i] = pTraffic[i].linkAEvent.type;
+        store->types[RECV_B][i] = pTraffic[i].linkBEvent.type;
+        store->data[RECV_A][i] = pTraffic[i].linkAEvent.data;
+        store->data[RECV_B][i] = pTraffic[i].linkBEvent.data;
+
+        /* Keep error flags only for the few events having any */
+        if (ret && (pTraffic[i].linkAEvent.errors || pTraffic[i].linkBEvent.errors))
+        {
+            ret = appendErrors(store, &errorCapacity, i, pTraffic[i].linkAEvent.errors, pTraffic[i].linkBEvent.errors);
+        }
+
+        /* Release the converted traffic in blocks, so it does not stay resident next to the store.
+           The current event is kept for the time delta of the next one. */
+        if (release && (0 == (i + 1) % STORE_RELEASE_INTERVAL))
+        {
+            release = releaseTraffic(&released, &pTraffic[i], pageSize);
+        }
+    }
+
+    if (!ret)
+    {
+        fputs("Unable to allocate memory for the event store\n", stderr);
+        freeEventStore(store);
+    }
+
+    return ret;
+}
+
+static long long getOverflowTime(const EventStore *store, U32 event)
+{
+    /* Bounds for the binary search in the overflow list */
+    U32 low = 0;
+    U32 high = store->overflowCount;
+    U32 mid = 0;
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (store->overflows[mid].event < event)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return store->overflows[low].time;
+}
+
+long long advanceEventTime(const EventStore *store, U32 fromEvent, long long fromTime, U32 toEvent)
+{
+    /* Loop counter */
+    U32 i = fromEvent;
+    /* Capture clock tick of the current event */
+    long long time = fromTime;
+
+    /* Start at the closest checkpoint, if it lies after the known event */
+    if ((toEvent / STORE_CHECKPOINT_INTERVAL) != (fromEvent / STORE_CHECKPOINT_INTERVAL))
+    {
+        i = toEvent - toEvent % STORE_CHECKPOINT_INTERVAL;
+        time = store->checkpoints[toEvent / STORE_CHECKPOINT_INTERVAL];
+    }
+
+    for (i++; i <= toEvent; i++)
+    {
+        if (STORE_DELTA_OVERFLOW == store->timeDeltas[i])
+        {
+            /* Look up absolute time of the overflowing event */
+            time = getOverflowTime(store, i);
+        }
+        else
+        {
+            time += store->timeDeltas[i];
+        }
+    }
+
+    return time;
+}
+
+long long getEventTime(const EventStore *store, U32 event)
+{
+    /* First event of the checkpoint interval */
+    U32 checkpoint = event - event % STORE_CHECKPOINT_INTERVAL;
+
+    return advanceEventTime(store, checkpoint, store->checkpoints[event / STORE_CHECKPOINT_INTERVAL], event);
+}
+
+U8 getEventErrors(const EventStore *store, U32 event, int receiver)
+{
+    /* Bounds for the binary search in the error list */
+    U32 low = 0;
+    U32 high = store->errorCount;
+    U32 mid = 0;
+
+    /* Most events have no errors */
+    if (0 == (store->errorBitmap[event / BITMAP_WORD_BITS] & (1ull << (event % BITMAP_WORD_BITS))))
+    {
+        return 0;
+    }
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (store->errors[mid].event < event)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    return store->errors[low].errors[receiver];
+}
+
+void freeEventStore(EventStore *store)
+{
+    free(store->checkpoints);
+    free(store->timeDeltas);
+    free(store->overflows);
+    free(store->types[RECV_A]);
+    free(store->types[RECV_B]);
+    free(store->data[RECV_A]);
+    free(store->data[RECV_B]);
+    free(store->errorBitmap);
+    free(store->errors);
+    store->checkpoints = NULL;
+    store->timeDeltas = NULL;
+    store->overflows = NULL;
+    store->types[RECV_A] = store->types[RECV_B] = NULL;
+    store->data[RECV_A] = store->data[RECV_B] = NULL;
+    store->errorBitmap = NULL;
+    store->errors = NULL;
+    store->count = 0;
+
+    return;
+}
@@ -0,0 +1,323 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/uio.h>
+#include "file_writer.h"
+#include "run_stats.h"
+
+/* An output file written by a writer thread */
+struct fileWriter
+{
+    int fd;                                 /* The output file */
+    int fsyncPolicy;                        /* Points at which the data is synchronized (see enum fsyncPolicy) */
+    int direct;                             /* The file is written with direct I/O */
+    char *buffers[WRITER_BUFFER_COUNT];     /* Buffers cycling between the formatting and the writer thread */
+    size_t lengths[WRITER_BUFFER_COUNT];    /* Number of bytes in each queued buffer */
+    unsigned int filling;                   /* Buffer being filled by the formatting thread */
+    size_t fill;                            /* Number of bytes in the buffer being filled */
+    unsigned long long size;                /* Number of bytes handed to the writer */
+    unsigned int next;                      /* First queued buffer */
+    unsigned int queued;                    /* Number of queued buffers */
+    off_t offset;                           /* File offset of the first queued buffer */
+    int closing;                            /* No further buffers will be queued */
+    int failed;                             /* Writing to the file failed */
+    pthread_mutex_t lock;                   /* Protects the queue and the flags */
+    pthread_cond_t queuedCond;              /* Signals a queued buffer to the writer thread */
+    pthread_cond_t freedCond;               /* Signals a written buffer to the formatting thread */
+    pthread_t thread;                       /* The writer thread */
+};
+
+static int writeBuffers(struct fileWriter *writer, struct iovec *vectors, int count)
+{
+    /* Bytes written by the last call */
+    ssize_t written = 0;
+    /* Offset of the remaining data */
+    off_t offset = writer->offset;
+
+    while (0 < count)
+    {
+        written = pwritev(writer->fd, vectors, count, offset);
+        if ((0 > written) && (EINVAL == errno) && writer->direct)
+        {
+            /* The file system refuses direct I/O for this write, continue buffered */
+            writer->direct = 0;
+            fcntl(writer->fd, F_SETFL, fcntl(writer->fd, F_GETFL) & ~O_DIRECT);
+        }
+        else if ((0 > written) && (EINTR != errno))
+        {
+            return 0;
+        }
+        else if (0 < written)
+        {
+            offset += written;
+            /* Skip the vectors written completely and continue with the rest of a partially written one */
+            while ((0 < count) && ((size_t)written >= vectors->iov_len))
+            {
+                written -= (ssize_t)vectors->iov_len;
+                vectors++;
+                count--;
+            }
+            if (0 < count)
+            {
+                vectors->iov_base = (char *)vectors->iov_base + written;
+                vectors->iov_len -= (size_t)written;
+            }
+        }
+    }
+
+    return 1;
+}
+
+static void *writeQueuedBuffers(void *arg)
+{
+    /* The writer */
+    struct fileWriter *writer = arg;
+    /* Loop counter */
+    unsigned int i = 0;
+    /* Number of buffers written at once */
+    unsigned int count = 0;
+    /* Queued buffers in file order */
+    struct iovec vectors[WRITER_BUFFER_COUNT];
+    /* Number of data bytes in the queued buffers */
+    unsigned long long bytes = 0;
+    /* Writing the buffers succeeded */
+    int success = 1;
+    /* Start and end of writing the buffers */
+    struct timespec start, end;
+    /* No buffers are left to write */
+    int done = 0;
+
+    while (!done)
+    {
+        pthread_mutex_lock(&writer->lock);
+        while ((0 == writer->queued) && !writer->closing)
+        {
+            pthread_cond_wait(&writer->queuedCond, &writer->lock);
+        }
+        count = writer->queued;
+        done = (0 == count);
+        pthread_mutex_unlock(&writer->lock);
+
+        /* Gather all queued buffers into a single write */
+        bytes = 0;
+        for (i = 0; i < count; i++)
+        {
+            vectors[i].iov_base = writer->buffers[(writer->next + i) % WRITER_BUFFER_COUNT];
+            vectors[i].iov_len = writer->lengths[(writer->next + i) % WRITER_BUFFER_COUNT];
+            bytes += vectors[i].iov_len;
+        }
+        if ((0 < count) && writer->direct && (0 != vectors[count - 1].iov_len % WRITER_ALIGNMENT))
+        {
+            /* Direct I/O needs whole blocks, the padding is truncated when closing */
+            memset((char *)vectors[count - 1].iov_base + vectors[count - 1].iov_len, 0,
+                   WRITER_ALIGNMENT - vectors[count - 1].iov_len % WRITER_ALIGNMENT);
+            vectors[count - 1].iov_len += WRITER_ALIGNMENT - vectors[count - 1].iov_len % WRITER_ALIGNMENT;
+        }
+
+        if ((0 < count) && success)
+        {
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            success = writeBuffers(writer, vectors, (int)count);
+            if (success && (FSYNC_BUFFER == writer->fsyncPolicy))
+            {
+                success = (0 == fdatasync(writer->fd));
+            }
+            clock_gettime(CLOCK_MONOTONIC, &end);
+            statsAdd(STATS_WRITER_BUSY_US, (unsigned long long)((end.tv_sec - start.tv_sec) * 1000000LL + (end.tv_nsec - start.tv_nsec) / 1000));
+            statsAdd(STATS_DISK_BYTES, success ? bytes : 0);
+        }
+
+        pthread_mutex_lock(&writer->lock);
+        writer->offset += (off_t)bytes;
+        writer->next = (writer->next + count) % WRITER_BUFFER_COUNT;
+        writer->queued -= count;
+        writer->failed = writer->failed || !success;
+        pthread_cond_signal(&writer->freedCond);
+        pthread_mutex_unlock(&writer->lock);
+    }
+
+    return NULL;
+}
+
+static int queueBuffer(struct fileWriter *writer)
+{
+    /* Writing to the file has not failed */
+    int ret = 0;
+
+    pthread_mutex_lock(&writer->lock);
+    writer->lengths[writer->filling] = writer->fill;
+    writer->queued++;
+    pthread_cond_signal(&writer->queuedCond);
+    if (WRITER_BUFFER_COUNT == writer->queued)
+    {
+        /* All buffers are queued, formatting has to wait on the disk */
+        statsAdd(STATS_WRITER_STALLS, 1);
+    }
+    while ((WRITER_BUFFER_COUNT == writer->queued) && !writer->failed)
+    {
+        pthread_cond_wait(&writer->freedCond, &writer->lock);
+    }
+    ret = !writer->failed;
+    pthread_mutex_unlock(&writer->lock);
+
+    writer->size += writer->fill;
+    writer->filling = (writer->filling + 1) % WRITER_BUFFER_COUNT;
+    writer->fill = 0;
+
+    return ret;
+}
+
+static ssize_t writeStream(void *cookie, const char *data, size_t length)
+{
+    /* The writer */
+    struct fileWriter *writer = cookie;
+    /* Bytes copied into the current buffer */
+    size_t chunk = 0;
+    /* Bytes left to copy */
+    size_t left = length;
+    /* Queueing the full buffers succeeded */
+    int success = 1;
+
+    while (success && (0 < left))
+    {
+        chunk = (WRITER_BUFFER_SIZE - writer->fill < left) ? WRITER_BUFFER_SIZE - writer->fill : left;
+        memcpy(writer->buffers[writer->filling] + writer->fill, data, chunk);
+        writer->fill += chunk;
+        data += chunk;
+        left -= chunk;
+        if (WRITER_BUFFER_SIZE == writer->fill)
+        {
+            success = queueBuffer(writer);
+        }
+    }
+
+    /* A short count reports the error to stdio */
+    return success ? (ssize_t)length : 0;
+}
+
+static void freeWriter(struct fileWriter *writer)
+{
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; i < WRITER_BUFFER_COUNT; i++)
+    {
+        free(writer->buffers[i]);
+    }
+    pthread_mutex_destroy(&writer->lock);
+    pthread_cond_destroy(&writer->queuedCond);
+    pthread_cond_destroy(&writer->freedCond);
+    free(writer);
+
+    return;
+}
+
+static int closeStream(void *cookie)
+{
+    /* The writer */
+    struct fileWriter *writer = cookie;
+    /* Return value */
+    int ret = 1;
+
+    if (0 < writer->fill)
+    {
+        queueBuffer(writer);
+    }
+    pthread_mutex_lock(&writer->lock);
+    writer->closing = 1;
+    pthread_cond_signal(&writer->queuedCond);
+    pthread_mutex_unlock(&writer->lock);
+    pthread_join(writer->thread, NULL);
+
+    /* Cut off the preallocation and the padding of direct writes */
+    ret = !writer->failed && (0 == ftruncate(writer->fd, (off_t)writer->size));
+    if (ret && (FSYNC_NONE != writer->fsyncPolicy))
+    {
+        ret = (0 == fsync(writer->fd));
+    }
+    ret = (0 == close(writer->fd)) && ret;
+    freeWriter(writer);
+
+    return ret ? 0 : -1;
+}
+
+FILE *writerOpen(const char *fileName, unsigned long long expectedSize, int fsyncPolicy)
+{
+    /* Loop counter */
+    int i = 0;
+    /* The writer */
+    struct fileWriter *writer = calloc(1, sizeof(struct fileWriter));
+    /* Functions of the stream */
+    cookie_io_functions_t functions = { NULL, writeStream, NULL, closeStream };
+    /* The stream writing to the file */
+    FILE *stream = NULL;
+    /* All buffers have been allocated */
+    int ready = (NULL != writer);
+
+    if (!ready)
+    {
+        fputs("Unable to allocate memory for the file writer\n", stderr);
+        return NULL;
+    }
+    pthread_mutex_init(&writer->lock, NULL);
+    pthread_cond_init(&writer->queuedCond, NULL);
+    pthread_cond_init(&writer->freedCond, NULL);
+    writer->fsyncPolicy = fsyncPolicy;
+    for (i = 0; ready && (i < WRITER_BUFFER_COUNT); i++)
+    {
+        ready = (0 == posix_memalign((void **)&writer->buffers[i], WRITER_ALIGNMENT, WRITER_BUFFER_SIZE));
+    }
+    if (!ready)
+    {
+        fputs("Unable to allocate memory for the file writer\n", stderr);
+        freeWriter(writer);
+        return NULL;
+    }
+
+    /* Prefer direct I/O, which file systems like tmpfs refuse */
+    writer->direct = 1;
+    writer->fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC | O_DIRECT, 0644);
+    if ((0 > writer->fd) && (EINVAL == errno))
+    {
+        writer->direct = 0;
+        writer->fd = open(fileName, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    if (0 > writer->fd)
+    {
+        fprintf(stderr, "Unable to open output file %s\n", fileName);
+        freeWriter(writer);
+        return NULL;
+    }
+    if ((0 < expectedSize) && (0 != fallocate(writer->fd, 0, 0, (off_t)expectedSize)) && (EOPNOTSUPP != errno))
+    {
+        fprintf(stderr, "Unable to preallocate %llu bytes for %s\n", expectedSize, fileName);
+    }
+
+    if (0 != pthread_create(&writer->thread, NULL, writeQueuedBuffers, writer))
+    {
+        fputs("Unable to start the file writer\n", stderr);
+        close(writer->fd);
+        freeWriter(writer);
+        return NULL;
+    }
+
+    stream = fopencookie(writer, "w", functions);
+    if (NULL == stream)
+    {
+        fprintf(stderr, "Unable to open output file %s\n", fileName);
+        /* Stop the writer thread again */
+        closeStream(writer);
+    }
+    else
+    {
+        setvbuf(stream, NULL, _IOFBF, WRITER_STREAM_BUFFER);
+    }
+
+    return stream;
+}
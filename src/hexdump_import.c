@@ -0,0 +1,947 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <spw_la_api.h>
+#include "event_store.h"
+#include "event_scan.h"
+#include "packet_index.h"
+#include "hexdump_import.h"
+#include "run_stats.h"
+
+/* A packet or time-code read from the hexdump */
+struct hexdumpRecord
+{
+    long long time;             /* Timestamp in ns, converted to the capture clock tick relative to the trigger */
+    long long endTime;          /* Timestamp of the terminator of a header only packet in ns, converted to a tick */
+    size_t offset;              /* Offset of the first byte in the byte buffer */
+    U32 length;                 /* Number of bytes */
+    U8 receiver;                /* Receiver A = RECV_A, B = RECV_B */
+    U8 termination;             /* Termination of the packet (see enum packetTermination) */
+    char truncated;             /* Only the header has been recorded, the terminator follows at endTime */
+    char single;                /* A single byte without marker, which is either a time-code or a packet of one byte */
+};
+
+/* Date and time of the last converted timestamp, which rarely change between records */
+struct timestampCache
+{
+    char minute[16];            /* Date, hour and minute as written in the timestamp */
+    time_t seconds;             /* Start of the minute in seconds since the epoch */
+    char valid;                 /* The cache holds a converted minute */
+};
+
+/* Generates the events of the records of a receiver in order */
+struct eventCursor
+{
+    const struct hexdumpRecord *records;    /* Records of the receiver sorted by time */
+    const U8 *bytes;                        /* The byte buffer */
+    U32 count;                              /* Number of records */
+    U32 record;                             /* Current record */
+    U32 position;                           /* Position of the next event in the record */
+    U32 interleaved;                        /* Number of time-codes following the record emitted within it */
+    long long tick;                         /* Tick of the current event */
+    U8 type;                                /* Type of the current event */
+    U8 data;                                /* Data of the current event */
+    char valid;                             /* There is a current event */
+    U32 moved;                              /* Number of records moved behind an overlapping record */
+};
+
+static int getDigits(const char *text, int count)
+{
+    /* The value */
+    int value = 0;
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        if (('0' > text[i]) || ('9' < text[i]))
+        {
+            return -1;
+        }
+        value = 10 * value + (text[i] - '0');
+    }
+
+    return value;
+}
+
+static int parseTimestamp(const char *text, const char *end, struct timestampCache *cache, long long *nanoSec)
+{
+    /* Broken down local time of the minute */
+    struct tm localTime;
+    /* Seconds of the timestamp */
+    int seconds = 0;
+    /* Fraction of the second in ns */
+    long fraction = 0;
+    /* Number of read decimal digits */
+    int digits = 0;
+
+    /* %FT%T with an optional fraction of any precision (older versions wrote microseconds) */
+    if ((19 > end - text) || ('-' != text[4]) || ('-' != text[7]) || ('T' != text[10]) || (':' != text[13]) ||
+        (':' != text[16]) || (0 > (seconds = getDigits(text + 17, 2))))
+    {
+        return 0;
+    }
+    if (!cache->valid || (0 != memcmp(cache->minute, text, sizeof(cache->minute))))
+    {
+        memset(&localTime, 0, sizeof(localTime));
+        localTime.tm_year = getDigits(text, 4) - 1900;
+        localTime.tm_mon = getDigits(text + 5, 2) - 1;
+        localTime.tm_mday = getDigits(text + 8, 2);
+        localTime.tm_hour = getDigits(text + 11, 2);
+        localTime.tm_min = getDigits(text + 14, 2);
+        localTime.tm_isdst = -1;
+        if ((0 > localTime.tm_year + 1900) || (0 > localTime.tm_mon) || (0 > localTime.tm_mday) ||
+            (0 > localTime.tm_hour) || (0 > localTime.tm_min))
+        {
+            return 0;
+        }
+        cache->seconds = mktime(&localTime);
+        memcpy(cache->minute, text, sizeof(cache->minute));
+        cache->valid = 1;
+    }
+
+    text += 19;
+    if ((text < end) && ('.' == *text))
+    {
+        for (text++; (text < end) && ('0' <= *text) && ('9' >= *text); text++)
+        {
+            if (9 > digits)
+            {
+                fraction = 10 * fraction + (*text - '0');
+                digits++;
+            }
+        }
+        for (; 9 > digits; digits++)
+        {
+            fraction *= 10;
+        }
+    }
+    *nanoSec = ((long long)cache->seconds + seconds) * 1000000000LL + fraction;
+
+    return 1;
+}
+
+static int parseOffset(const char *text, const char *end, U32 *offset, const char **next)
+{
+    /* Value of the current digit */
+    int digit = 0;
+    /* Number of read digits */
+    int digits = 0;
+
+    *offset = 0;
+    for (; (text < end) && (8 > digits); text++, digits++)
+    {
+        if (('0' <= *text) && ('9' >= *text))
+        {
+            digit = *text - '0';
+        }
+        else if (('A' <= (*text & ~0x20)) && ('F' >= (*text & ~0x20)))
+        {
+            digit = (*text & ~0x20) - 'A' + 10;
+        }
+        else
+        {
+            break;
+        }
+        *offset = (*offset << 4) | (U32)digit;
+    }
+    *next = text;
+
+    return (0 < digits) && (text < end) && (' ' == *text);
+}
+
+/* Copies a header or marker line, so it can be evaluated with the string functions */
+static void copyLine(char *buffer, const char *line, const char *lineEnd)
+{
+    /* Number of copied characters */
+    size_t length = (size_t)(lineEnd - line);
+
+    if (HEXDUMP_MAX_LINE <= length)
+    {
+        length = HEXDUMP_MAX_LINE - 1;
+    }
+    memcpy(buffer, line, length);
+    buffer[length] = '\0';
+
+    return;
+}
+
+static int compareRecords(const void *a, const void *b)
+{
+    const struct hexdumpRecord *first = a;
+    const struct hexdumpRecord *second = b;
+
+    /* Order by receiver and time, records starting at the same time stay in the order of the file */
+    if (first->receiver != second->receiver)
+    {
+        return (first->receiver < second->receiver) ? -1 : 1;
+    }
+    if (first->time != second->time)
+    {
+        return (first->time < second->time) ? -1 : 1;
+    }
+
+    return (first->offset < second->offset) ? -1 : (first->offset > second->offset);
+}
+
+static void advanceCursor(struct eventCursor *cursor)
+{
+    /* The current record and the time-code possibly received within it */
+    const struct hexdumpRecord *record = NULL;
+    const struct hexdumpRecord *timecode = NULL;
+    /* Tick following the previous event */
+    long long nextTick = cursor->valid ? cursor->tick + 1 : LLONG_MIN;
+    /* Tick of the next event of the current packet */
+    long long packetTick = 0;
+
+    /* Skip to the next record after its terminator or last byte, and behind the time-codes emitted within it */
+    if ((cursor->record < cursor->count) &&
+        (cursor->position > cursor->records[cursor->record].length ||
+         ((cursor->position == cursor->records[cursor->record].length) &&
+          ((PACKET_TERM_INCOMPLETE == cursor->records[cursor->record].termination) ||
+           (PACKET_TERM_TIMECODE == cursor->records[cursor->record].termination)))))
+    {
+        cursor->record += 1 + cursor->interleaved;
+        cursor->position = 0;
+        cursor->interleaved = 0;
+    }
+    if (cursor->record >= cursor->count)
+    {
+        cursor->valid = 0;
+        return;
+    }
+
+    record = &cursor->records[cursor->record];
+    if (0 < cursor->position)
+    {
+        /* A time-code received while the packet was open is emitted at its time within the packet */
+        packetTick = ((cursor->position == record->length) && record->truncated && (record->endTime > nextTick)) ? record->endTime : nextTick;
+        timecode = (cursor->record + 1 + cursor->interleaved < cursor->count) ? record + 1 + cursor->interleaved : NULL;
+        if ((NULL != timecode) && (PACKET_TERM_TIMECODE == timecode->termination) && (timecode->time <= packetTick))
+        {
+            cursor->tick = (timecode->time < nextTick) ? nextTick : timecode->time;
+            cursor->type = STAR_LA_TRAFFIC_TYPE_TIMECODE;
+            cursor->data = cursor->bytes[timecode->offset];
+            cursor->moved += (timecode->time < nextTick);
+            cursor->interleaved++;
+            cursor->valid = 1;
+            return;
+        }
+    }
+    if (0 == cursor->position)
+    {
+        /* Keep the start time unless the previous record of the receiver overlaps it */
+        if (record->time < nextTick)
+        {
+            cursor->moved++;
+        }
+        cursor->tick = (record->time < nextTick) ? nextTick : record->time;
+        cursor->type = (PACKET_TERM_TIMECODE == record->termination) ? STAR_LA_TRAFFIC_TYPE_TIMECODE : STAR_LA_TRAFFIC_TYPE_HEADER;
+        cursor->data = cursor->bytes[record->offset];
+    }
+    else if (cursor->position < record->length)
+    {
+        cursor->tick = nextTick;
+        cursor->type = STAR_LA_TRAFFIC_TYPE_DATA;
+        cursor->data = cursor->bytes[record->offset + cursor->position];
+    }
+    else
+    {
+        cursor->tick = packetTick;
+        cursor->type = (PACKET_TERM_EEP == record->termination) ? STAR_LA_TRAFFIC_TYPE_EEP : STAR_LA_TRAFFIC_TYPE_EOP;
+        cursor->data = 0;
+    }
+    cursor->position++;
+    cursor->valid = 1;
+
+    return;
+}
+
+static void setEvent(STAR_LA_MK3_Event *event, const struct eventCursor *cursor)
+{
+    event->type = cursor->type;
+    event->data = cursor->data;
+    event->errors = 0;
+
+    return;
+}
+
+static int compareTicks(const void *a, const void *b)
+{
+    const long long *first = a;
+    const long long *second = b;
+
+    return (*first > *second) - (*first < *second);
+}
+
+/* Checks whether the time-code of the second record follows the one of the first after the elapsed time-code periods */
+static int continuesTimecodes(const struct hexdumpRecord *first, const struct hexdumpRecord *second, const U8 *bytes, long long period)
+{
+    /* The time-codes */
+    U8 code = bytes[first->offset];
+    U8 nextCode = bytes[second->offset];
+    /* Increment of the time-code counter */
+    int increment = (nextCode - code) & HEXDUMP_TIMECODE_COUNTER;
+    /* Number of elapsed time-code periods */
+    long long periods = 0;
+
+    /* The control flags stay the same and the counter advances */
+    if (((code & ~HEXDUMP_TIMECODE_COUNTER) != (nextCode & ~HEXDUMP_TIMECODE_COUNTER)) || (0 == increment))
+    {
+        return 0;
+    }
+    if (0 >= period)
+    {
+        return (1 == increment);
+    }
+    /* Missing time-codes advance the counter once per period */
+    periods = llround((double)(second->time - first->time) / (double)period);
+
+    return (0 < periods) && (increment == (periods & HEXDUMP_TIMECODE_COUNTER)) &&
+           (llabs(second->time - first->time - periods * period) <= period / HEXDUMP_TIMECODE_TOLERANCE);
+}
+
+/* Checks whether a single byte record fits the time-code stream at a time-code found before or after it, possibly on the other receiver */
+static int fitsTimecodes(const struct hexdumpRecord *record, const struct hexdumpRecord *code, const U8 *bytes, long long period)
+{
+    /* The same time-code seen on both receivers */
+    if ((bytes[record->offset] == bytes[code->offset]) && (0 < period) &&
+        (llabs(record->time - code->time) <= period / HEXDUMP_TIMECODE_TOLERANCE))
+    {
+        return 1;
+    }
+
+    return (code->time < record->time) ? continuesTimecodes(code, record, bytes, period) : continuesTimecodes(record, code, bytes, period);
+}
+
+/* Checks whether a single byte record was received before the previous packet of its receiver can have ended,
+   which leaves only a time-code received within that packet */
+static int withinPacket(const struct hexdumpRecord *records, U32 record)
+{
+    /* Loop counter */
+    U32 i = record;
+    /* Earliest tick of the terminator of the previous packet */
+    long long endTick = 0;
+
+    /* Skip the other single byte records received within the same packet */
+    for (; (0 < i) && (records[i - 1].receiver == records[record].receiver) && records[i - 1].single; i--)
+    {
+    }
+    if ((0 == i) || (records[i - 1].receiver != records[record].receiver))
+    {
+        return 0;
+    }
+    /* An incomplete packet is still open at the end of the recording */
+    if (PACKET_TERM_INCOMPLETE == records[i - 1].termination)
+    {
+        return 1;
+    }
+    /* Every byte and the terminator take a tick of their own */
+    endTick = records[i - 1].time + records[i - 1].length;
+    if (records[i - 1].truncated && (records[i - 1].endTime > endTick))
+    {
+        endTick = records[i - 1].endTime;
+    }
+
+    return (records[record].time <= endTick);
+}
+
+/* Tells the single byte records apart by the time-code sequence of their receiver and the time-code stream of the other receiver,
+   counting the records that had to be guessed */
+static int classifySingleBytes(struct hexdumpRecord *records, U32 recordCount, const U8 *bytes, U32 *guessed)
+{
+    /* Loop counters */
+    U32 i = 0, j = 0, k = 0;
+    /* Single byte records of all receivers, in order of receiver and time */
+    U32 *singles = malloc((size_t)recordCount * sizeof(U32));
+    U32 singleCount = 0;
+    /* First single byte record of each receiver and the end of its records */
+    U32 receiverSingles[2] = { 0, 0 };
+    U32 receiverEnd[2] = { 0, 0 };
+    /* Periods proposed by pairs of single byte records */
+    long long *gaps = malloc((size_t)recordCount * HEXDUMP_TIMECODE_LOOKAHEAD * sizeof(long long));
+    U32 gapCount = 0;
+    /* Time-code and counter increment of a pair */
+    U8 code = 0;
+    int increment = 0;
+    /* Period of the time-codes in ticks (0 = unknown) and the number of pairs proposing it */
+    long long period = 0;
+    U32 support = 0;
+    /* Number of records found in a time-code sequence */
+    U32 found = 0;
+    /* The last record found in the time-code sequence of the receiver */
+    U32 lastCode = 0;
+    /* Whether the last time-code has been found on the current receiver */
+    char hasCode = 0;
+    /* Time since the last time-code and whether a time-code of its sequence would be due */
+    long long elapsed = 0;
+    char onTime = 0;
+    /* The single byte records found in a time-code sequence */
+    char *inSequence = malloc((size_t)recordCount);
+    /* The other receiver and the time-codes found on it before and after the record */
+    U8 other = 0;
+    U32 before = 0, after = 0;
+    char fits = 0;
+
+    if ((NULL == singles) || (NULL == gaps) || (NULL == inSequence))
+    {
+        fputs("Unable to allocate memory for importing the hexdump\n", stderr);
+        free(singles);
+        free(gaps);
+        free(inSequence);
+        return 0;
+    }
+
+    /* The single byte records per receiver, the records are sorted by receiver */
+    for (i = 0; i < recordCount; i++)
+    {
+        if ((0 == i) || (records[i].receiver != records[i - 1].receiver))
+        {
+            receiverSingles[records[i].receiver] = singleCount;
+        }
+        if (records[i].single)
+        {
+            singles[singleCount++] = i;
+        }
+        receiverEnd[records[i].receiver] = singleCount;
+    }
+
+    /* Every pair of nearby single byte records with equal control flags proposes the time per counter increment as period,
+       the period proposed most often by pairs of time-codes stands out from the scattered proposals of packets */
+    for (j = 0; j < singleCount; j++)
+    {
+        for (k = j + 1; (k < singleCount) && (k <= j + HEXDUMP_TIMECODE_LOOKAHEAD) &&
+                        (records[singles[k]].receiver == records[singles[j]].receiver); k++)
+        {
+            code = bytes[records[singles[j]].offset];
+            increment = (bytes[records[singles[k]].offset] - code) & HEXDUMP_TIMECODE_COUNTER;
+            if (((code & ~HEXDUMP_TIMECODE_COUNTER) == (bytes[records[singles[k]].offset] & ~HEXDUMP_TIMECODE_COUNTER)) &&
+                (0 < increment) && (increment <= HEXDUMP_TIMECODE_LOOKAHEAD) && (records[singles[k]].time > records[singles[j]].time))
+            {
+                gaps[gapCount++] = (records[singles[k]].time - records[singles[j]].time) / increment;
+            }
+        }
+    }
+    qsort(gaps, gapCount, sizeof(long long), compareTicks);
+    for (i = 0, k = 0; i < gapCount; i++)
+    {
+        for (; (k < gapCount) && (gaps[k] <= gaps[i] + gaps[i] / HEXDUMP_TIMECODE_TOLERANCE); k++)
+        {
+        }
+        if ((1 < k - i) && (k - i > support))
+        {
+            support = k - i;
+            period = gaps[i + support / 2];
+        }
+    }
+
+    /* A time-code continues the sequence of the last time-code, or starts a sequence continued by one of the next records.
+       Once a sequence is established, only records at the time of a time-code of that sequence may start a new one. */
+    for (j = 0; j < singleCount; j++)
+    {
+        if ((0 == j) || (records[singles[j]].receiver != records[singles[j - 1]].receiver))
+        {
+            hasCode = 0;
+        }
+        inSequence[j] = hasCode && continuesTimecodes(&records[lastCode], &records[singles[j]], bytes, period);
+        elapsed = hasCode ? records[singles[j]].time - records[lastCode].time : 0;
+        onTime = !hasCode || (0 >= period) ||
+                 (llabs(elapsed - llround((double)elapsed / (double)period) * period) <= period / HEXDUMP_TIMECODE_TOLERANCE);
+        for (k = j + 1; !inSequence[j] && onTime && (k < singleCount) && (k <= j + HEXDUMP_TIMECODE_LOOKAHEAD) &&
+                        (records[singles[k]].receiver == records[singles[j]].receiver); k++)
+        {
+            inSequence[j] = continuesTimecodes(&records[singles[j]], &records[singles[k]], bytes, period);
+        }
+        if (inSequence[j])
+        {
+            lastCode = singles[j];
+            hasCode = 1;
+            found++;
+        }
+    }
+
+    /* The others are time-codes if they fit the time-code stream of the other receiver or were received within a packet,
+       otherwise packets next to a time-code sequence. Without any sequence nothing tells them apart. */
+    for (j = 0; j < singleCount; j++)
+    {
+        if (inSequence[j])
+        {
+            records[singles[j]].termination = PACKET_TERM_TIMECODE;
+            continue;
+        }
+        other = (RECV_A == records[singles[j]].receiver) ? RECV_B : RECV_A;
+        for (before = receiverEnd[other], after = receiverSingles[other]; after < receiverEnd[other]; after++)
+        {
+            if (inSequence[after])
+            {
+                if (records[singles[after]].time > records[singles[j]].time)
+                {
+                    break;
+                }
+                before = after;
+            }
+        }
+        fits = ((before < receiverEnd[other]) && fitsTimecodes(&records[singles[j]], &records[singles[before]], bytes, period)) ||
+               ((after < receiverEnd[other]) && fitsTimecodes(&records[singles[j]], &records[singles[after]], bytes, period));
+        if (fits || withinPacket(records, singles[j]))
+        {
+            records[singles[j]].termination = PACKET_TERM_TIMECODE;
+        }
+        else if (0 < found)
+        {
+            guessed[1]++;
+        }
+        else
+        {
+            records[singles[j]].termination = PACKET_TERM_TIMECODE;
+            guessed[0]++;
+        }
+    }
+    free(singles);
+    free(gaps);
+    free(inSequence);
+
+    return 1;
+}
+
+/* Builds the traffic from the records sorted by receiver and time */
+static STAR_LA_MK3_Traffic *buildTraffic(const struct hexdumpRecord *records, U32 recordCount, const U8 *bytes,
+                                         U32 *trafficCount, U32 *moved)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* Upper bound of the number of rows */
+    unsigned long long eventCount = 0;
+    /* Cursors over the records of receiver A and B */
+    struct eventCursor cursors[2];
+    /* The built traffic */
+    STAR_LA_MK3_Traffic *pTraffic = NULL;
+    /* The current row */
+    STAR_LA_MK3_Traffic *row = NULL;
+    /* Idle event for the receiver without an event in a row */
+    STAR_LA_MK3_Event idle = { STAR_LA_TRAFFIC_TYPE_NO_CHARACTER, 0, 0 };
+
+    for (i = 0; i < recordCount; i++)
+    {
+        eventCount += records[i].length + ((PACKET_TERM_EOP == records[i].termination) || (PACKET_TERM_EEP == records[i].termination));
+    }
+    if (0xFFFFFFFFull <= eventCount)
+    {
+        fputs("Too many events in the hexdump\n", stderr);
+        return NULL;
+    }
+    pTraffic = malloc(((size_t)eventCount + 1) * sizeof(STAR_LA_MK3_Traffic));
+    if (NULL == pTraffic)
+    {
+        fputs("Unable to allocate memory for importing the hexdump\n", stderr);
+        return NULL;
+    }
+
+    memset(cursors, 0, sizeof(cursors));
+    for (i = 0; (i < recordCount) && (RECV_A == records[i].receiver); i++)
+    {
+    }
+    cursors[RECV_A].records = records;
+    cursors[RECV_A].count = i;
+    cursors[RECV_B].records = records + i;
+    cursors[RECV_B].count = recordCount - i;
+    for (i = 0; i < 2; i++)
+    {
+        cursors[i].bytes = bytes;
+        advanceCursor(&cursors[i]);
+    }
+
+    /* Merge the events of both receivers into rows, sharing a row at equal ticks */
+    row = pTraffic;
+    while (cursors[RECV_A].valid || cursors[RECV_B].valid)
+    {
+        if (!cursors[RECV_B].valid || (cursors[RECV_A].valid && (cursors[RECV_A].tick <= cursors[RECV_B].tick)))
+        {
+            row->time = cursors[RECV_A].tick;
+            setEvent(&row->linkAEvent, &cursors[RECV_A]);
+            if (cursors[RECV_B].valid && (cursors[RECV_A].tick == cursors[RECV_B].tick))
+            {
+                setEvent(&row->linkBEvent, &cursors[RECV_B]);
+                advanceCursor(&cursors[RECV_B]);
+            }
+            else
+            {
+                row->linkBEvent = idle;
+            }
+            advanceCursor(&cursors[RECV_A]);
+        }
+        else
+        {
+            row->time = cursors[RECV_B].tick;
+            row->linkAEvent = idle;
+            setEvent(&row->linkBEvent, &cursors[RECV_B]);
+            advanceCursor(&cursors[RECV_B]);
+        }
+        row++;
+    }
+
+    *trafficCount = (U32)(row - pTraffic);
+    *moved = cursors[RECV_A].moved + cursors[RECV_B].moved;
+
+    return pTraffic;
+}
+
+int LA_MK3_parseHexdump(const char *text, size_t size, const char *name, STAR_LA_MK3_Traffic **ppTraffic, U32 *trafficCount,
+                        double *charCaptureClockPeriod, struct timespec *triggerTime, char *headerOnly)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* End of the hexdump */
+    const char *end = text + size;
+    /* Current line, its end and the start of the next line */
+    const char *line = NULL, *lineEnd = NULL, *next = NULL;
+    /* Position after the byte offset of a data line */
+    const char *data = NULL;
+    /* Number of the current line */
+    unsigned long lineNumber = 0;
+    /* Copy of a header or marker line */
+    char buffer[HEXDUMP_MAX_LINE];
+    /* Terminator named in a header only marker */
+    char terminator[4];
+    /* Duration of a header only packet in us */
+    double duration = 0.0;
+    /* Number of bytes recorded of a header only packet */
+    U32 recordedBytes = 0;
+    /* Byte offset of a data line and the number of bytes decoded from it */
+    U32 offset = 0, decoded = 0;
+    /* Decoded bytes of all records, a byte takes three characters, so the text never decodes to more than a third of its size */
+    U8 *bytes = malloc(size / 3 + 1);
+    /* Number of decoded bytes */
+    size_t byteCount = 0;
+    /* The records of the hexdump */
+    struct hexdumpRecord *records = NULL;
+    /* The current record */
+    struct hexdumpRecord *record = NULL;
+    /* Number of records and allocated records */
+    U32 recordCount = 0, recordCapacity = HEXDUMP_INITIAL_RECORDS;
+    /* The current record has been marked as incomplete or header only */
+    char marked = 0;
+    /* Cache of the last converted minute */
+    struct timestampCache cache;
+    /* Trigger timestamp in ns */
+    long long triggerNanoSec = 0;
+    /* The trigger timestamp has been read from the header */
+    char triggered = 0;
+    /* The records are sorted by receiver and time */
+    char sorted = 1;
+    /* Number of records moved behind an overlapping record */
+    U32 moved = 0;
+    /* Number of single byte records guessed to be time-codes and packets */
+    U32 guessed[2] = { 0, 0 };
+    /* Whether only the packet headers have been recorded */
+    char truncated = 0;
+    /* Return value */
+    int ret = 1;
+    /* Reallocated records */
+    void *grown = NULL;
+
+    memset(&cache, 0, sizeof(cache));
+    records = malloc((size_t)recordCapacity * sizeof(struct hexdumpRecord));
+    if ((NULL == bytes) || (NULL == records))
+    {
+        fputs("Unable to allocate memory for importing the hexdump\n", stderr);
+        free(bytes);
+        free(records);
+        return 0;
+    }
+
+    for (line = text; ret && (line < end); line = next)
+    {
+        lineEnd = memchr(line, '\n', (size_t)(end - line));
+        next = (NULL == lineEnd) ? end : lineEnd + 1;
+        lineEnd = (NULL == lineEnd) ? end : lineEnd;
+        if ((lineEnd > line) && ('\r' == lineEnd[-1]))
+        {
+            lineEnd--;
+        }
+        lineNumber++;
+
+        if (lineEnd == line)
+        {
+            continue;
+        }
+
+        if ((line + 2 < lineEnd) && (('I' == line[0]) || ('O' == line[0])) && (' ' == line[1]))
+        {
+            /* A new record, a single byte is told apart from a time-code after parsing unless marked as a packet */
+            if ((NULL != record) && !marked && (1 == record->length))
+            {
+                record->single = 1;
+            }
+            if (recordCount == recordCapacity)
+            {
+                grown = realloc(records, 2 * (size_t)recordCapacity * sizeof(struct hexdumpRecord));
+                if (NULL == grown)
+                {
+                    fputs("Unable to allocate memory for importing the hexdump\n", stderr);
+                    ret = 0;
+                    break;
+                }
+                records = grown;
+                recordCapacity *= 2;
+            }
+            record = &records[recordCount++];
+            memset(record, 0, sizeof(*record));
+            record->receiver = ('I' == line[0]) ? RECV_A : RECV_B;
+            record->termination = PACKET_TERM_EOP;
+            record->offset = byteCount;
+            marked = 0;
+            if (!parseTimestamp(line + 2, lineEnd, &cache, &record->time))
+            {
+                fprintf(stderr, "Invalid timestamp in line %lu of hexdump %s\n", lineNumber, name);
+                ret = 0;
+            }
+            if (!triggered)
+            {
+                /* Without the header the first record marks the trigger */
+                fprintf(stderr, "Hexdump %s has no trigger timestamp, the first record is taken instead\n", name);
+                triggerNanoSec = record->time;
+                triggered = 1;
+            }
+            if ((1 < recordCount) && (0 < compareRecords(&records[recordCount - 2], record)))
+            {
+                sorted = 0;
+            }
+        }
+        else if (parseOffset(line, lineEnd, &offset, &data))
+        {
+            /* A data line, anything following the bytes (like the comments of older versions) is ignored */
+            decoded = decodeHexBytes(data, (size_t)(end - data), bytes + byteCount,
+                                     (0xFFFFFFFFu < (size_t)(end - data) / 3) ? 0xFFFFFFFFu : (U32)((size_t)(end - data) / 3));
+            if ((NULL == record) || marked || (0 == decoded) || (offset != record->length))
+            {
+                fprintf(stderr, "Unexpected data in line %lu of hexdump %s\n", lineNumber, name);
+                ret = 0;
+            }
+            else
+            {
+                byteCount += decoded;
+                record->length += decoded;
+            }
+        }
+        else if ('#' == line[0])
+        {
+            copyLine(buffer, line, lineEnd);
+            if ((NULL != record) && (0 == strcmp(buffer, "### Incomplete packet ###")))
+            {
+                record->termination = PACKET_TERM_INCOMPLETE;
+                marked = 1;
+            }
+            else if ((NULL != record) && (3 == sscanf(buffer, "### Header only: %u bytes recorded, %3s after %lfus ###",
+                                                      &recordedBytes, terminator, &duration)))
+            {
+                record->termination = (0 == strcmp(terminator, "EEP")) ? PACKET_TERM_EEP : PACKET_TERM_EOP;
+                record->endTime = record->time + llround(duration * 1000.0);
+                record->truncated = 1;
+                marked = 1;
+            }
+            else if ((0 == strncmp(buffer, "# Trigger timestamp:", 20)) && !triggered)
+            {
+                for (data = line + 20; (data < lineEnd) && (' ' == *data); data++)
+                {
+                }
+                triggered = parseTimestamp(data, lineEnd, &cache, &triggerNanoSec);
+                if (!triggered)
+                {
+                    fprintf(stderr, "Invalid trigger timestamp in hexdump %s\n", name);
+                    ret = 0;
+                }
+            }
+            else if (0 == strncmp(buffer, "# Header only:", 14))
+            {
+                truncated = (0 != atoi(buffer + 14));
+            }
+        }
+        else if (NULL != record)
+        {
+            fprintf(stderr, "Unexpected line %lu in hexdump %s\n", lineNumber, name);
+            ret = 0;
+        }
+    }
+    if (ret && (NULL != record) && !marked && (1 == record->length))
+    {
+        record->single = 1;
+    }
+    if (ret && (0 == recordCount))
+    {
+        fprintf(stderr, "No packets found in hexdump %s\n", name);
+        ret = 0;
+    }
+
+    if (ret)
+    {
+        /* Convert the timestamps to capture clock ticks relative to the trigger */
+        for (i = 0; i < recordCount; i++)
+        {
+            records[i].time = llround((records[i].time - triggerNanoSec) * 1e-9 / HEXDUMP_CLOCK_PERIOD);
+            if (records[i].truncated)
+            {
+                records[i].endTime = llround((records[i].endTime - triggerNanoSec) * 1e-9 / HEXDUMP_CLOCK_PERIOD);
+            }
+        }
+        /* Packets are written in order of completion, the events are rebuilt in order of their start */
+        if (!sorted)
+        {
+            qsort(records, recordCount, sizeof(struct hexdumpRecord), compareRecords);
+        }
+        ret = classifySingleBytes(records, recordCount, bytes, guessed);
+    }
+    if (ret)
+    {
+        *ppTraffic = buildTraffic(records, recordCount, bytes, trafficCount, &moved);
+        ret = (NULL != *ppTraffic);
+    }
+
+    if (ret)
+    {
+        *charCaptureClockPeriod = HEXDUMP_CLOCK_PERIOD;
+        triggerTime->tv_sec = (time_t)(triggerNanoSec / 1000000000LL);
+        triggerTime->tv_nsec = (long)(triggerNanoSec % 1000000000LL);
+        if (0 > triggerTime->tv_nsec)
+        {
+            triggerTime->tv_nsec += 1000000000L;
+            triggerTime->tv_sec -= 1;
+        }
+        *headerOnly = truncated;
+        if (0 < moved)
+        {
+            fprintf(stderr, "%u records of hexdump %s overlapped the previous record of their receiver and were moved behind it\n",
+                moved, name);
+        }
+        if (0 < guessed[0] + guessed[1])
+        {
+            fprintf(stderr, "%u single byte records of hexdump %s did not fit the time-code sequence of the receivers,"
+                    " %u were guessed to be time-codes and %u to be packets\n", guessed[0] + guessed[1], name, guessed[0], guessed[1]);
+            statsAdd(STATS_IMPORT_GUESSED, guessed[0] + guessed[1]);
+        }
+    }
+    free(records);
+    free(bytes);
+
+    return ret;
+}
+
+static char *inflateHexdump(const char *fileName, size_t *size)
+{
+    /* The compressed hexdump */
+    gzFile file = gzopen(fileName, "rb");
+    /* The inflated hexdump */
+    char *text = NULL;
+    /* Reallocated hexdump */
+    char *grown = NULL;
+    /* Number of allocated bytes */
+    size_t capacity = 1 << 20;
+    /* Number of bytes read at once */
+    int count = 0;
+
+    *size = 0;
+    if (NULL == file)
+    {
+        return NULL;
+    }
+    gzbuffer(file, 1 << 17);
+    text = malloc(capacity);
+    while (NULL != text)
+    {
+        if (*size == capacity)
+        {
+            grown = realloc(text, 2 * capacity);
+            if (NULL == grown)
+            {
+                free(text);
+                text = NULL;
+                break;
+            }
+            text = grown;
+            capacity *= 2;
+        }
+        count = gzread(file, text + *size, (unsigned int)((capacity - *size < (1u << 30)) ? capacity - *size : (1u << 30)));
+        if (0 >= count)
+        {
+            if (0 > count)
+            {
+                free(text);
+                text = NULL;
+            }
+            break;
+        }
+        *size += (size_t)count;
+    }
+    gzclose(file);
+
+    return text;
+}
+
+int LA_MK3_importHexdump(const char *fileName, STAR_LA_MK3_Traffic **ppTraffic, U32 *trafficCount,
+                         double *charCaptureClockPeriod, struct timespec *triggerTime, char *headerOnly)
+{
+    /* The hexdump file */
+    int fd = open(fileName, O_RDONLY);
+    /* Status of the file */
+    struct stat status;
+    /* The mapped or inflated hexdump */
+    char *text = NULL;
+    /* Size of the hexdump */
+    size_t size = 0;
+    /* Return value */
+    int ret = 0;
+
+    if ((0 > fd) || (0 != fstat(fd, &status)) || (0 == status.st_size))
+    {
+        fprintf(stderr, "Unable to open hexdump %s\n", fileName);
+        if (0 <= fd)
+        {
+            close(fd);
+        }
+        return 0;
+    }
+
+    size = (size_t)status.st_size;
+    text = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == text)
+    {
+        fprintf(stderr, "Unable to map hexdump %s\n", fileName);
+        return 0;
+    }
+
+    if ((2 <= size) && (0x1F == (U8)text[0]) && (0x8B == (U8)text[1]))
+    {
+        /* A compressed hexdump written with -z is inflated into memory first */
+        munmap(text, size);
+        text = inflateHexdump(fileName, &size);
+        if (NULL == text)
+        {
+            fprintf(stderr, "Unable to inflate hexdump %s\n", fileName);
+            return 0;
+        }
+        ret = LA_MK3_parseHexdump(text, size, fileName, ppTraffic, trafficCount, charCaptureClockPeriod, triggerTime, headerOnly);
+        free(text);
+    }
+    else
+    {
+        /* Read ahead, the hexdump is parsed front to back in a single pass */
+        madvise(text, size, MADV_SEQUENTIAL);
+        ret = LA_MK3_parseHexdump(text, size, fileName, ppTraffic, trafficCount, charCaptureClockPeriod, triggerTime, headerOnly);
+        munmap(text, size);
+    }
+    if (ret)
+    {
+        fprintf(stderr, "Imported %u events from hexdump %s\n", *trafficCount, fileName);
+    }
+
+    return ret;
+}
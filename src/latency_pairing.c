@@ -0,0 +1,683 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <json-c/json.h>
+#include <spw_la_api.h>
+#include "arg_parser.h"
+#include "config_logger.h"
+#include "event_store.h"
+#include "event_scan.h"
+#include "packet_index.h"
+#include "latency_pairing.h"
+
+/* Receiver names as used in the report */
+static const char *const receiverNames[] = { "a", "b" };
+
+/* A request waiting for its response */
+struct pendingRequest
+{
+    unsigned long long key;     /* Key of the request */
+    long long startTime;        /* Capture clock tick of the header */
+    long long endTime;          /* Capture clock tick of the terminating event */
+    U32 record;                 /* Record number of the request in the hexdump */
+    U32 hash;                   /* Hash of the key and rule */
+    U8  rule;                   /* Rule the request belongs to */
+    U8  used;                   /* The slot holds a request */
+};
+
+/* Hash table of the pending requests with linear probing */
+struct pairingTable
+{
+    struct pendingRequest *slots; /* PAIR_TABLE_SIZE slots */
+    U32 count;                  /* Number of pending requests */
+};
+
+static int parseSide(const char **position, PairSide *side, U32 *byteCount)
+{
+    /* Current position in the specification */
+    const char *text = *position;
+    /* End of a parsed number */
+    char *end = NULL;
+    /* Parsed field */
+    unsigned long offset = 0;
+    unsigned long length = 0;
+    unsigned long long mask = 0;
+    /* Number of key bytes of the side */
+    U32 keyBytes = 0;
+
+    /* Receiver followed by a colon */
+    if (('A' == text[0] || 'a' == text[0]) && ':' == text[1])
+    {
+        side->receiver = RECV_A;
+    }
+    else if (('B' == text[0] || 'b' == text[0]) && ':' == text[1])
+    {
+        side->receiver = RECV_B;
+    }
+    else
+    {
+        return 0;
+    }
+    text += 2;
+
+    side->fieldCount = 0;
+    do
+    {
+        offset = strtoul(text, &end, 0);
+        if (end == text)
+        {
+            return 0;
+        }
+        text = end;
+        length = 1;
+        if ('+' == *text)
+        {
+            length = strtoul(text + 1, &end, 0);
+            if ((end == text + 1) || (0 == length) || (PAIR_MAX_KEY_BYTES < length))
+            {
+                return 0;
+            }
+            text = end;
+        }
+        mask = (PAIR_MAX_KEY_BYTES == length) ? ~0ull : (1ull << (8 * length)) - 1;
+        if ('/' == *text)
+        {
+            mask &= strtoull(text + 1, &end, 0);
+            if (end == text + 1)
+            {
+                return 0;
+            }
+            text = end;
+        }
+        keyBytes += length;
+        if ((PAIR_MAX_FIELDS <= side->fieldCount) || (PAIR_MAX_KEY_BYTES < keyBytes) || (PAIR_MAX_BYTES < offset + length))
+        {
+            return 0;
+        }
+        side->fields[side->fieldCount].offset = (U8)offset;
+        side->fields[side->fieldCount].length = (U8)length;
+        side->fields[side->fieldCount].mask = mask;
+        side->fieldCount++;
+        if (offset + length > *byteCount)
+        {
+            *byteCount = offset + length;
+        }
+    } while ((',' == *text) && ++text);
+
+    *position = text;
+
+    return 1;
+}
+
+PairingRules *compilePairingRules(const char *spec)
+{
+    /* Current position in the specification */
+    const char *position = spec;
+    /* The compiled rules */
+    PairingRules *rules = calloc(1, sizeof(PairingRules));
+    /* Non-zero, while the specification is valid */
+    int valid = 1;
+
+    if (NULL == rules)
+    {
+        fputs("Unable to allocate memory for the pairing rules\n", stderr);
+        return NULL;
+    }
+
+    do
+    {
+        valid = (PAIR_MAX_RULES > rules->count) && parseSide(&position, &rules->rules[rules->count].request, &rules->byteCount);
+        valid = valid && ('>' == *position);
+        position++;
+        valid = valid && parseSide(&position, &rules->rules[rules->count].response, &rules->byteCount);
+        rules->count++;
+    } while (valid && (';' == *position++));
+
+    /* The last rule has to end the specification */
+    if (!valid || ('\0' != *(position - 1)))
+    {
+        fprintf(stderr, "\nInvalid pairing rules '%s'\n", spec);
+        free(rules);
+        rules = NULL;
+    }
+
+    return rules;
+}
+
+void freePairingRules(PairingRules *rules)
+{
+    free(rules);
+
+    return;
+}
+
+static int getKey(const PairSide *side, const U8 *bytes, U32 length, unsigned long long *key)
+{
+    /* Loop counters */
+    U8 i = 0;
+    U8 j = 0;
+    /* The field read as big-endian value */
+    unsigned long long value = 0;
+    /* The current field */
+    const PairField *field = NULL;
+
+    *key = 0;
+    for (i = 0; i < side->fieldCount; i++)
+    {
+        field = &side->fields[i];
+        if (field->offset + field->length > length)
+        {
+            /* The packet is too short to hold the key */
+            return 0;
+        }
+        value = 0;
+        for (j = 0; j < field->length; j++)
+        {
+            value = (value << 8) | bytes[field->offset + j];
+        }
+        *key = (PAIR_MAX_KEY_BYTES == field->length) ? (value & field->mask) : ((*key << (8 * field->length)) | (value & field->mask));
+    }
+
+    return 1;
+}
+
+static U32 hashKey(unsigned long long key, U8 rule)
+{
+    /* Finalizer of SplitMix64, spreading the key bits over the table */
+    unsigned long long hash = key + (rule + 1ull) * 0x9E3779B97F4A7C15ull;
+
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ull;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBull;
+
+    return (U32)(hash ^ (hash >> 31));
+}
+
+static U32 findSlot(const struct pairingTable *table, U32 hash, unsigned long long key, U8 rule)
+{
+    /* Slot to check */
+    U32 slot = hash & (PAIR_TABLE_SIZE - 1);
+    /* The checked request */
+    const struct pendingRequest *request = &table->slots[slot];
+
+    /* The table is never full, so an empty slot ends every probe sequence */
+    while (request->used && ((request->hash != hash) || (request->key != key) || (request->rule != rule)))
+    {
+        slot = (slot + 1) & (PAIR_TABLE_SIZE - 1);
+        request = &table->slots[slot];
+    }
+
+    return slot;
+}
+
+static void removeSlot(struct pairingTable *table, U32 slot)
+{
+    /* Slot following the emptied one */
+    U32 next = (slot + 1) & (PAIR_TABLE_SIZE - 1);
+    /* Home slot of the request in the next slot */
+    U32 home = 0;
+
+    /* Move later requests of the probe sequence back, so no gap breaks it */
+    while (table->slots[next].used)
+    {
+        home = table->slots[next].hash & (PAIR_TABLE_SIZE - 1);
+        if (((next - home) & (PAIR_TABLE_SIZE - 1)) >= ((next - slot) & (PAIR_TABLE_SIZE - 1)))
+        {
+            table->slots[slot] = table->slots[next];
+            slot = next;
+        }
+        next = (next + 1) & (PAIR_TABLE_SIZE - 1);
+    }
+    table->slots[slot].used = 0;
+    table->count--;
+
+    return;
+}
+
+static void listUnmatched(RuleLatency *latency, U32 record, long long time, unsigned long long key, U8 receiver, U8 reason)
+{
+    /* The listed transaction */
+    UnmatchedTransaction *transaction = NULL;
+
+    latency->unmatched[reason]++;
+    if (PAIR_MAX_LISTED > latency->listedCount)
+    {
+        transaction = &latency->listed[latency->listedCount++];
+        transaction->record = record;
+        transaction->time = time;
+        transaction->key = key;
+        transaction->receiver = receiver;
+        transaction->reason = reason;
+    }
+
+    return;
+}
+
+static void listRequest(LatencyPairing *pairing, const PairingRules *rules, const struct pendingRequest *request, U8 reason)
+{
+    listUnmatched(&pairing->rules[request->rule], request->record, request->startTime, request->key,
+                  rules->rules[request->rule].request.receiver, reason);
+
+    return;
+}
+
+static void expireRequests(LatencyPairing *pairing, const PairingRules *rules, struct pairingTable *table, long long now)
+{
+    /* Slot to check */
+    U32 slot = 0;
+
+    while (slot < PAIR_TABLE_SIZE)
+    {
+        if (table->slots[slot].used && ((now - table->slots[slot].endTime) * pairing->clockPeriod > pairing->timeout))
+        {
+            listRequest(pairing, rules, &table->slots[slot], UNMATCHED_TIMEOUT);
+            /* A later request may move into the slot, so it is checked again */
+            removeSlot(table, slot);
+        }
+        else
+        {
+            slot++;
+        }
+    }
+
+    return;
+}
+
+static void addLatency(RuleLatency *latency, double seconds)
+{
+    /* Latency in whole nanoseconds */
+    unsigned long long nanoseconds = (unsigned long long)(seconds * 1e9 + 0.5);
+    /* Bucket of the latency */
+    int bucket = 0;
+
+    if ((0 == latency->matched) || (seconds < latency->min))
+    {
+        latency->min = seconds;
+    }
+    if ((0 == latency->matched) || (seconds > latency->max))
+    {
+        latency->max = seconds;
+    }
+    latency->sum += seconds;
+    latency->sumSquares += seconds * seconds;
+    latency->matched++;
+
+    while ((bucket < PAIR_LATENCY_BUCKETS - 1) && (nanoseconds >> (bucket + 1)))
+    {
+        bucket++;
+    }
+    latency->histogram[bucket]++;
+
+    return;
+}
+
+static int compareRecords(const void *a, const void *b)
+{
+    /* Record numbers of both transactions */
+    U32 recordA = ((const UnmatchedTransaction *)a)->record;
+    U32 recordB = ((const UnmatchedTransaction *)b)->record;
+
+    return (recordA > recordB) - (recordA < recordB);
+}
+
+static int answerRequests(LatencyPairing *pairing, const PairingRules *rules, struct pairingTable *table, const PacketEntry *entry,
+                          const U8 *bytes, U32 length, U8 *candidates)
+{
+    /* Loop counter */
+    U8 r = 0;
+    /* Key of the packet */
+    unsigned long long key = 0;
+    /* Slot of the pending request */
+    U32 slot = 0;
+    /* Latency of the transaction */
+    double latency = 0.0;
+    /* Non-zero, if the packet answered a request */
+    int answered = 0;
+
+    *candidates = 0;
+    for (r = 0; r < rules->count; r++)
+    {
+        if ((rules->rules[r].response.receiver != entry->receiver) || !getKey(&rules->rules[r].response, bytes, length, &key))
+        {
+            continue;
+        }
+        *candidates |= 1u << r;
+        slot = findSlot(table, hashKey(key, r), key, r);
+        if (!table->slots[slot].used)
+        {
+            continue;
+        }
+
+        /* A response has to start after the request ended */
+        latency = (entry->startTime - table->slots[slot].endTime) * pairing->clockPeriod;
+        if (0.0 > latency)
+        {
+            continue;
+        }
+        if (latency <= pairing->timeout)
+        {
+            addLatency(&pairing->rules[r], latency);
+            answered = 1;
+        }
+        else
+        {
+            listRequest(pairing, rules, &table->slots[slot], UNMATCHED_TIMEOUT);
+        }
+        removeSlot(table, slot);
+    }
+
+    return answered;
+}
+
+static int addRequests(LatencyPairing *pairing, const PairingRules *rules, struct pairingTable *table, const EventStore *store,
+                       const PacketEntry *entry, U32 record, const U8 *bytes, U32 length)
+{
+    /* Loop counter */
+    U8 r = 0;
+    /* Key and its hash of the packet */
+    unsigned long long key = 0;
+    U32 hash = 0;
+    /* Slot of the request */
+    struct pendingRequest *request = NULL;
+    /* Non-zero, if the packet is a request */
+    int requested = 0;
+
+    for (r = 0; r < rules->count; r++)
+    {
+        if ((rules->rules[r].request.receiver != entry->receiver) || !getKey(&rules->rules[r].request, bytes, length, &key))
+        {
+            continue;
+        }
+        requested = 1;
+        pairing->rules[r].requests++;
+
+        /* Make room by removing expired requests once the table is filled */
+        if (PAIR_MAX_PENDING <= table->count)
+        {
+            expireRequests(pairing, rules, table, entry->startTime);
+        }
+        hash = hashKey(key, r);
+        request = &table->slots[findSlot(table, hash, key, r)];
+        if (request->used)
+        {
+            listRequest(pairing, rules, request, UNMATCHED_SUPERSEDED);
+        }
+        else if (PAIR_MAX_PENDING <= table->count)
+        {
+            listUnmatched(&pairing->rules[r], record, entry->startTime, key, entry->receiver, UNMATCHED_DROPPED);
+            continue;
+        }
+        else
+        {
+            table->count++;
+        }
+
+        request->key = key;
+        request->startTime = entry->startTime;
+        request->endTime = advanceEventTime(store, entry->startEvent, entry->startTime, entry->endEvent);
+        request->record = record;
+        request->hash = hash;
+        request->rule = r;
+        request->used = 1;
+        if (table->count > pairing->peakPending)
+        {
+            pairing->peakPending = table->count;
+        }
+    }
+
+    return requested;
+}
+
+int LA_MK3_pairTransactions(LatencyPairing *pairing, const EventStore *store, const PacketIndex *index, const PairingRules *rules, double timeout)
+{
+    /* Pending requests */
+    struct pairingTable table;
+    /* Leading bytes of the packet */
+    U8 bytes[PAIR_MAX_BYTES];
+    /* Number of leading bytes gathered */
+    U32 length = 0;
+    /* Rules the packet is a response for */
+    U8 candidates = 0;
+    /* Key of an unmatched response */
+    unsigned long long key = 0;
+    /* The current packet */
+    const PacketEntry *entry = NULL;
+    /* Loop counters */
+    U32 i = 0;
+    U8 r = 0;
+
+    memset(pairing, 0, sizeof(LatencyPairing));
+    pairing->clockPeriod = store->clockPeriod;
+    pairing->timeout = timeout;
+    pairing->ruleCount = rules->count;
+    for (r = 0; r < rules->count; r++)
+    {
+        pairing->rules[r].requestReceiver = rules->rules[r].request.receiver;
+        pairing->rules[r].responseReceiver = rules->rules[r].response.receiver;
+    }
+
+    table.count = 0;
+    table.slots = calloc(PAIR_TABLE_SIZE, sizeof(struct pendingRequest));
+    if (NULL == table.slots)
+    {
+        fputs("Unable to allocate memory for pairing transactions\n", stderr);
+        return 0;
+    }
+
+    /* Packets are indexed in the order they have been completed */
+    for (i = 0; i < index->count; i++)
+    {
+        entry = &index->entries[i];
+        if ((PACKET_TERM_TIMECODE == entry->termination) || (PACKET_TERM_INCOMPLETE == entry->termination))
+        {
+            continue;
+        }
+        length = gatherPacketData(store->types[entry->receiver], store->data[entry->receiver],
+                                  entry->startEvent, entry->endEvent + 1, bytes, rules->byteCount);
+
+        /* A response is never taken as request itself */
+        if (answerRequests(pairing, rules, &table, entry, bytes, length, &candidates) ||
+            addRequests(pairing, rules, &table, store, entry, i + 1, bytes, length))
+        {
+            continue;
+        }
+        for (r = 0; r < rules->count; r++)
+        {
+            if (candidates & (1u << r))
+            {
+                /* The key depends on the rule, so it is read again */
+                getKey(&rules->rules[r].response, bytes, length, &key);
+                listUnmatched(&pairing->rules[r], i + 1, entry->startTime, key, entry->receiver, UNMATCHED_RESPONSE);
+            }
+        }
+    }
+
+    /* Requests still pending have not been answered */
+    for (i = 0; i < PAIR_TABLE_SIZE; i++)
+    {
+        if (table.slots[i].used)
+        {
+            listRequest(pairing, rules, &table.slots[i], UNMATCHED_UNANSWERED);
+        }
+    }
+    free(table.slots);
+
+    for (r = 0; r < rules->count; r++)
+    {
+        qsort(pairing->rules[r].listed, pairing->rules[r].listedCount, sizeof(UnmatchedTransaction), compareRecords);
+    }
+
+    return 1;
+}
+
+static struct json_object *newRuleObject(const LatencyPairing *pairing, const RuleLatency *latency)
+{
+    /* JSON objects of the rule */
+    struct json_object *object = json_object_new_object();
+    struct json_object *unmatched = json_object_new_object();
+    struct json_object *statistic = json_object_new_object();
+    struct json_object *histogram = json_object_new_array();
+    struct json_object *listed = json_object_new_array();
+    struct json_object *item = NULL;
+    /* Mean and variance of the latencies */
+    double mean = (0 < latency->matched) ? latency->sum / latency->matched : 0.0;
+    double variance = (0 < latency->matched) ? latency->sumSquares / latency->matched - mean * mean : 0.0;
+    /* Key as hexadecimal string */
+    char key[24] = "";
+    /* Loop counter */
+    U32 i = 0;
+
+    json_object_object_add(object, "request_receiver", json_object_new_string(receiverNames[latency->requestReceiver]));
+    json_object_object_add(object, "response_receiver", json_object_new_string(receiverNames[latency->responseReceiver]));
+    json_object_object_add(object, "requests", json_object_new_int64((int64_t)latency->requests));
+    json_object_object_add(object, "matched", json_object_new_int64((int64_t)latency->matched));
+    for (i = 0; i < UNMATCHED_REASONS; i++)
+    {
+        json_object_object_add(unmatched, unmatchedReasonNames[i], json_object_new_int64((int64_t)latency->unmatched[i]));
+    }
+    json_object_object_add(object, "unmatched", unmatched);
+
+    json_object_object_add(statistic, "count", json_object_new_int64((int64_t)latency->matched));
+    if (0 < latency->matched)
+    {
+        json_object_object_add(statistic, "min_us", json_object_new_double(latency->min * 1e6));
+        json_object_object_add(statistic, "mean_us", json_object_new_double(mean * 1e6));
+        json_object_object_add(statistic, "max_us", json_object_new_double(latency->max * 1e6));
+        json_object_object_add(statistic, "stddev_us", json_object_new_double((0.0 < variance) ? sqrt(variance) * 1e6 : 0.0));
+    }
+    json_object_object_add(object, "latency", statistic);
+
+    /* Only buckets holding transactions are listed */
+    for (i = 0; i < PAIR_LATENCY_BUCKETS; i++)
+    {
+        if (0 < latency->histogram[i])
+        {
+            item = json_object_new_object();
+            json_object_object_add(item, "min_us", json_object_new_double((0 < i) ? (1ull << i) * 1e-3 : 0.0));
+            json_object_object_add(item, "max_us", json_object_new_double((2ull << i) * 1e-3));
+            json_object_object_add(item, "transactions", json_object_new_int64((int64_t)latency->histogram[i]));
+            json_object_array_add(histogram, item);
+        }
+    }
+    json_object_object_add(object, "latency_histogram", histogram);
+
+    for (i = 0; i < latency->listedCount; i++)
+    {
+        item = json_object_new_object();
+        snprintf(key, sizeof(key), "0x%llX", latency->listed[i].key);
+        json_object_object_add(item, "record", json_object_new_int64(latency->listed[i].record));
+        json_object_object_add(item, "receiver", json_object_new_string(receiverNames[latency->listed[i].receiver]));
+        json_object_object_add(item, "time_ms", json_object_new_double(latency->listed[i].time * pairing->clockPeriod * 1000.0));
+        json_object_object_add(item, "key", json_object_new_string(key));
+        json_object_object_add(item, "reason", json_object_new_string(unmatchedReasonNames[latency->listed[i].reason]));
+        json_object_array_add(listed, item);
+    }
+    json_object_object_add(object, "unmatched_transactions", listed);
+
+    return object;
+}
+
+int writeLatencyReport(const char *fileName, const LatencyPairing *pairing, Settings settings, struct timespec *triggerTime)
+{
+    /* Loop counter */
+    U8 r = 0;
+    /* Trigger time as string */
+    char triggerTimeStr[30] = "";
+    /* JSON objects of the report */
+    struct json_object *report = json_object_new_object();
+    struct json_object *rules = json_object_new_array();
+    /* The report file */
+    FILE *file = NULL;
+    /* Return value */
+    int ret = 0;
+
+    json_object_object_add(report, "version", json_object_new_string(settings.version));
+    if (NULL != settings.inputFile)
+    {
+        json_object_object_add(report, "input", json_object_new_string(settings.inputFile));
+    }
+    else
+    {
+        json_object_object_add(report, "serial_number", json_object_new_string(settings.args[0]));
+    }
+    if ((NULL != triggerTime) && timeToStr(triggerTime, triggerTimeStr))
+    {
+        json_object_object_add(report, "trigger_time", json_object_new_string(triggerTimeStr));
+    }
+    json_object_object_add(report, "rules", json_object_new_string(settings.pairSpec));
+    json_object_object_add(report, "timeout_s", json_object_new_double(pairing->timeout));
+    json_object_object_add(report, "peak_pending", json_object_new_int64(pairing->peakPending));
+    for (r = 0; r < pairing->ruleCount; r++)
+    {
+        json_object_array_add(rules, newRuleObject(pairing, &pairing->rules[r]));
+    }
+    json_object_object_add(report, "transactions", rules);
+
+    file = fopen(fileName, "w");
+    if (NULL == file)
+    {
+        fprintf(stderr, "Unable to open latency report %s\n", fileName);
+    }
+    else
+    {
+        ret = (0 <= fprintf(file, "%s\n", json_object_to_json_string_ext(report, JSON_C_TO_STRING_PRETTY)));
+        ret = (0 == fclose(file)) && ret;
+        if (!ret)
+        {
+            fprintf(stderr, "Unable to write latency report %s\n", fileName);
+        }
+    }
+
+    json_object_put(report);
+
+    return ret;
+}
+
+void printLatencyTable(FILE *stream, const LatencyPairing *pairing)
+{
+    /* Loop counters */
+    U8 r = 0;
+    int i = 0;
+    /* Transactions of the rule */
+    const RuleLatency *latency = NULL;
+    /* Mean and variance of the latencies */
+    double mean = 0.0;
+    double variance = 0.0;
+
+    fprintf(stream, "Transaction latencies (timeout %gs, at most %u requests pending)\n", pairing->timeout, pairing->peakPending);
+    for (r = 0; r < pairing->ruleCount; r++)
+    {
+        latency = &pairing->rules[r];
+        fprintf(stream, "\n### Requests on receiver %c answered on receiver %c\n",
+                (RECV_A == latency->requestReceiver) ? 'A' : 'B', (RECV_A == latency->responseReceiver) ? 'A' : 'B');
+        fprintf(stream, "%-26s  %16llu\n", "Requests", latency->requests);
+        fprintf(stream, "%-26s  %16llu\n", "Answered", latency->matched);
+        fprintf(stream, "%-26s  %16llu\n", "Unanswered", latency->unmatched[UNMATCHED_UNANSWERED]);
+        fprintf(stream, "%-26s  %16llu\n", "Timed out", latency->unmatched[UNMATCHED_TIMEOUT]);
+        fprintf(stream, "%-26s  %16llu\n", "Superseded", latency->unmatched[UNMATCHED_SUPERSEDED]);
+        fprintf(stream, "%-26s  %16llu\n", "Dropped", latency->unmatched[UNMATCHED_DROPPED]);
+        fprintf(stream, "%-26s  %16llu\n", "Responses without request", latency->unmatched[UNMATCHED_RESPONSE]);
+        if (0 == latency->matched)
+        {
+            continue;
+        }
+
+        mean = latency->sum / latency->matched;
+        variance = latency->sumSquares / latency->matched - mean * mean;
+        fprintf(stream, "%-26s  %16.3f\n", "Latency min (us)", latency->min * 1e6);
+        fprintf(stream, "%-26s  %16.3f\n", "Latency mean (us)", mean * 1e6);
+        fprintf(stream, "%-26s  %16.3f\n", "Latency max (us)", latency->max * 1e6);
+        fprintf(stream, "%-26s  %16.3f\n", "Latency stddev (us)", (0.0 < variance) ? sqrt(variance) * 1e6 : 0.0);
+        fprintf(stream, "\n%-26s  %16s\n", "Latency (us)", "Transactions");
+        for (i = 0; i < PAIR_LATENCY_BUCKETS; i++)
+        {
+            if (0 < latency->histogram[i])
+            {
+                fprintf(stream, "%11.3f - %-12.3f  %16llu\n", (0 < i) ? (1ull << i) * 1e-3 : 0.0, (2ull << i) * 1e-3, latency->histogram[i]);
+            }
+        }
+    }
+
+    return;
+}
@@ -12,12 +12,29 @@
  *
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 #include <spw_la_api.h>
 #include "arg_parser.h"
 #include "LA_interface.h"
 #include "data_logger.h"
+#include "event_store.h"
+#include "packet_index.h"
+#include "packet_filter.h"
+#include "capture_summary.h"
+#include "timecode_analysis.h"
+#include "latency_pairing.h"
+#include "packet_search.h"
+#include "capture_diff.h"
+#include "raw_capture.h"
+#include "hexdump_import.h"
+#include "pcapng_stream.h"
+#include "columnar_export.h"
+#include "error_log.h"
 #include "packet_archiver.h"
+#include "run_stats.h"
+#include "metrics.h"
+#include "file_writer.h"
 
 #define VERSION "v0.4.1"
 
@@ -37,21 +54,136 @@ static void printConfiguration(Settings config)
             VERSION);
 
     /* Print configuration */
-    fprintf(stderr, "\nCapture Configuration:\n"
-                    "LA serial number: %s\n"
-                    "Record duration: %ss\n"
-                    "Record duration before trigger: %dms\n"
+    fputs("\nCapture Configuration:\n", stderr);
+    if (NULL != config.inputFile)
+    {
+        fprintf(stderr, "Input capture: %s\n", config.inputFile);
+    }
+    else
+    {
+        fprintf(stderr, "LA serial number: %s\n"
+                        "Record duration: %ss\n",
+                        config.args[0], config.args[1]);
+    }
+    fprintf(stderr, "Record duration before trigger: %dms\n"
                     "Record NULLs: %s\n"
                     "Record FCTs: %s\n"
                     "Record Timecodes: %s\n"
                     "Record NChars: %s\n"
-                    "Trigger: %s on receiver %c\n"
-                    "Capture log format: %s\n\n",
-                    config.args[0], config.args[1], config.preTrigger,
+                    "Record only headers: %s\n"
+                    "Capture log format: %s\n"
+                    "Formatting threads: %d\n",
+                    config.preTrigger,
                     flagToString(config.enNull), flagToString(config.enFCT),
                     flagToString(config.enTimecode), flagToString(config.enNChar),
-                    config.trigFCT ? "FCT" : "Timecode", config.recv ? 'B' : 'A',
-                    config.verbose ? "Event based" : "Hexdump");
+                    flagToString(config.headerOnly),
+                    config.verbose ? "Event based" : "Hexdump", config.jobs);
+
+    /* Print trigger configuration */
+    if (0 < config.trigStageCount)
+    {
+        fprintf(stderr, "Trigger sequence: %s\n", config.trigSpec);
+    }
+    else
+    {
+        fprintf(stderr, "Trigger: %s on receiver %c\n", config.trigFCT ? "FCT" : "Timecode", config.recv ? 'B' : 'A');
+    }
+    fprintf(stderr, "Trigger delay: %u\n"
+                    "Post trigger memory: %d%%\n",
+                    config.trigDelay, config.postTrigMemory);
+    if (NULL != config.statsFile)
+    {
+        fprintf(stderr, "Statistics report: %s\n", config.statsFile);
+    }
+    if (NULL != config.summaryFile)
+    {
+        fprintf(stderr, "Capture summary: %s\n", config.summaryFile);
+    }
+    if (NULL != config.timecodeFile)
+    {
+        fprintf(stderr, "Time-code analysis: %s\n", config.timecodeFile);
+    }
+    if (NULL != config.latencyFile)
+    {
+        fprintf(stderr, "Transaction latencies: %s (rules %s, timeout %gs)\n", config.latencyFile, config.pairSpec, config.pairTimeout);
+    }
+    if (NULL != config.searchSpec)
+    {
+        fprintf(stderr, "Search patterns: %s\n", config.searchSpec);
+    }
+    if (NULL != config.diffFile)
+    {
+        fprintf(stderr, "Diff against: %s (shift tolerance %gs)\n", config.diffFile, config.diffTolerance);
+    }
+    if (NULL != config.metricsTarget)
+    {
+        fprintf(stderr, "Metrics export: %s\n", config.metricsTarget);
+    }
+    if (NULL != config.outputFile)
+    {
+        fprintf(stderr, "Output file: %s\n", config.outputFile);
+    }
+    if (NULL != config.eventLogFile)
+    {
+        fprintf(stderr, "Event log file: %s\n", config.eventLogFile);
+    }
+    if (NULL != config.rawFile)
+    {
+        fprintf(stderr, "Raw capture file: %s\n", config.rawFile);
+    }
+    if (NULL != config.columnsDir)
+    {
+        fprintf(stderr, "Column export directory: %s\n", config.columnsDir);
+    }
+    if (NULL != config.pcapngTarget)
+    {
+        fprintf(stderr, "PCAPNG stream: %s\n", config.pcapngTarget);
+    }
+    if (NULL != config.errorLogFile)
+    {
+        if (0.0 < config.errorContextTime)
+        {
+            fprintf(stderr, "Error log file: %s (context of %gus)\n", config.errorLogFile, config.errorContextTime * 1e6);
+        }
+        else
+        {
+            fprintf(stderr, "Error log file: %s (context of %u events)\n", config.errorLogFile, config.errorContext);
+        }
+    }
+    if ((NULL != config.outputFile) || (NULL != config.eventLogFile) || (NULL != config.rawFile) || (NULL != config.errorLogFile) ||
+        (NULL != config.columnsDir))
+    {
+        fprintf(stderr, "Output fsync policy: %s\n", fsyncPolicyNames[config.fsyncPolicy]);
+    }
+    if (0 < config.compressLevel)
+    {
+        fprintf(stderr, "Output compression: gzip level %d\n", config.compressLevel);
+    }
+    if (0 < config.rotateSize)
+    {
+        fprintf(stderr, "Output rotation: every %llu bytes\n", config.rotateSize);
+    }
+    if (0.0 < config.rotateTime)
+    {
+        fprintf(stderr, "Output rotation: every %g seconds of capture time\n", config.rotateTime);
+    }
+    if (NULL != config.logExcludeSpec)
+    {
+        fprintf(stderr, "Event log exclusions: %s\n", config.logExcludeSpec);
+    }
+    if (config.collapseIdle)
+    {
+        fputs("Event log idle rows: collapsed\n", stderr);
+    }
+    if (NULL != config.filterSpec)
+    {
+        fprintf(stderr, "Packet filter: %s\n", config.filterSpec);
+    }
+    if (((0 < config.rotateSize) || (0.0 < config.rotateTime)) && (NULL == config.outputFile) && (NULL == config.eventLogFile))
+    {
+        fputs("Output rotation only applies to output files, stdout is not rotated\n", stderr);
+    }
+    fputs("\n", stderr);
 
     if (NULL != config.kafka_topic)
     {
@@ -66,11 +198,58 @@ static void printConfiguration(Settings config)
                     config.kafka_topic, config.kafka_testId, config.kafka_testVersion,
                     config.kafka_interfaceIdIn, config.kafka_interfaceIdOut,
                     config.kafka_aswVersion, config.kafka_dbVersion);
+        if (0.0 < config.archiveDedup)
+        {
+            fprintf(stderr, "Repeated packets: archived as references, in full again after %gs\n\n", config.archiveDedup);
+        }
     }
 
     return;
 }
 
+static int readCapture(const char *fileName, STAR_LA_MK3_Traffic **ppTraffic, U32 *trafficCount,
+                       double *charCaptureClockPeriod, struct timespec *triggerTime, char *headerOnly)
+{
+    /* Anything but a raw capture is imported as a hexdump written by an earlier recording */
+    if (isRawCapture(fileName))
+    {
+        return LA_MK3_readRawCapture(fileName, ppTraffic, trafficCount, charCaptureClockPeriod, triggerTime, headerOnly);
+    }
+
+    return LA_MK3_importHexdump(fileName, ppTraffic, trafficCount, charCaptureClockPeriod, triggerTime, headerOnly);
+}
+
+static int loadReferenceCapture(Settings config, EventStore *store, PacketIndex *index, struct timespec *triggerTime)
+{
+    /* The traffic read from the reference capture */
+    STAR_LA_MK3_Traffic *pTraffic = NULL;
+    /* Number of events in the reference capture */
+    U32 trafficCount = 0;
+    /* Character capture clock period of the reference capture */
+    double charCaptureClockPeriod = 0.0;
+    /* Whether the reference capture holds only packet headers */
+    char headerOnly = 0;
+    /* Return value */
+    int ret = 0;
+
+    if (!readCapture(config.diffFile, &pTraffic, &trafficCount, &charCaptureClockPeriod, triggerTime, &headerOnly))
+    {
+        return 0;
+    }
+    ret = LA_MK3_convertTraffic(store, pTraffic, &trafficCount, &charCaptureClockPeriod);
+    free(pTraffic);
+
+    /* Index the reference the same way as the capture, so the packets can be compared */
+    if (ret && !LA_MK3_buildPacketIndex(index, store, config.preTrigger, config.filter))
+    {
+        freePacketIndex(index);
+        freeEventStore(store);
+        ret = 0;
+    }
+
+    return ret;
+}
+
 int main(int argc, char **argv)
 {
     /* Contains settings needed
@@ -79,14 +258,53 @@ int main(int argc, char **argv)
 
     /* Default values. */
     config.version = VERSION;
+    config.args[0] = NULL;
+    config.args[1] = NULL;
+    config.inputFile = NULL;
     config.enNull = 0;
     config.enFCT = 1;
     config.enTimecode = 1;
     config.enNChar = 1;
+    config.headerOnly = 0;
     config.trigFCT = 0;
     config.recv = 1;
     config.preTrigger = 3000;
+    config.trigSpec = NULL;
+    config.trigStageCount = 0;
+    config.trigDelay = 0;
+    config.postTrigMemory = 100;
     config.verbose = 0;
+    config.logExcludeSpec = NULL;
+    config.logExclude[0] = 0;
+    config.logExclude[1] = 0;
+    config.collapseIdle = 0;
+    config.jobs = 1;
+    config.statsFile = NULL;
+    config.summaryFile = NULL;
+    config.timecodeFile = NULL;
+    config.latencyFile = NULL;
+    config.pairSpec = NULL;
+    config.pairRules = NULL;
+    config.pairTimeout = PAIR_DEFAULT_TIMEOUT;
+    config.searchSpec = NULL;
+    config.searchPatterns = NULL;
+    config.diffFile = NULL;
+    config.diffTolerance = DIFF_DEFAULT_TOLERANCE;
+    config.metricsTarget = NULL;
+    config.outputFile = NULL;
+    config.eventLogFile = NULL;
+    config.rawFile = NULL;
+    config.columnsDir = NULL;
+    config.pcapngTarget = NULL;
+    config.errorLogFile = NULL;
+    config.errorContext = ERROR_DEFAULT_CONTEXT;
+    config.errorContextTime = 0.0;
+    config.fsyncPolicy = FSYNC_CLOSE;
+    config.compressLevel = 0;
+    config.rotateSize = 0;
+    config.rotateTime = 0.0;
+    config.filterSpec = NULL;
+    config.filter = NULL;
     config.kafka_topic = NULL;
     config.kafka_testId = NULL;
     config.kafka_testVersion = NULL;
@@ -94,6 +312,7 @@ int main(int argc, char **argv)
     config.kafka_interfaceIdOut = NULL;
     config.kafka_dbVersion = NULL;
     config.kafka_aswVersion = NULL;
+    config.archiveDedup = 0.0;
 
     /* The Link Analyser in use */
     STAR_LA_LinkAnalyser linkAnalyser;
@@ -111,40 +330,248 @@ int main(int argc, char **argv)
     /* The recorded traffic */
     STAR_LA_MK3_Traffic *pTraffic;
 
+    /* The recorded traffic in the compact event store */
+    EventStore eventStore;
+
+    /* Non-zero, if the traffic has been converted into the event store */
+    int converted = 0;
+
+    /* Packets of the recorded traffic */
+    PacketIndex packetIndex;
+
+    /* Statistics of the recorded traffic */
+    CaptureSummary summary;
+
+    /* Time-codes of the recorded traffic */
+    TimecodeAnalysis timecodes;
+
+    /* Latencies of the transactions in the recorded traffic */
+    LatencyPairing latency;
+
+    /* Packets of the recorded traffic containing the search patterns */
+    PacketSearch search;
+
+    /* Reference capture the recorded traffic is compared against */
+    EventStore referenceStore;
+    PacketIndex referenceIndex;
+    struct timespec referenceTriggerTime;
+
+    /* Changes of the recorded traffic compared to the reference */
+    CaptureDiff diff;
+
     /* Timestamp for when the Link Analyser device was triggered */
     struct timespec triggerTime;
 
+    /* Non-zero, if the Link Analyser has been detected */
+    int detected = 0;
+
+    /* Non-zero, if the traffic has been recorded */
+    int recorded = 0;
+
+    /* Loop counter */
+    U32 i = 0;
+
+    statsStartPhase(STATS_PHASE_TOTAL);
+
     /* Parse command line arguments */
     if(0 != argp_parse(&argp, argc, argv, 0, 0, &config))
     {
         fputs("Unable to parse arguments. Aborting program.\n\n", stderr);
         return 1;
     }
-    sscanf(config.args[1], "%lf", &captureDuration);
+    if (NULL != config.args[1])
+    {
+        sscanf(config.args[1], "%lf", &captureDuration);
+    }
 
     /* Print config info to stderr */
     printConfiguration(config);
 
-    /* Detect device  matching serial number */
-    if (0 != LA_MK3_detectDevice(&linkAnalyser, config.args[0]))
+    /* Export live metrics while running */
+    if (NULL != config.metricsTarget)
+    {
+        metricsStartExporter(config.metricsTarget);
+    }
+
+    /* Open the PCAPNG stream early, so Wireshark can attach to it while recording */
+    if ((NULL != config.pcapngTarget) && !pcapngStartStream(config.pcapngTarget, config.version))
+    {
+        config.pcapngTarget = NULL;
+    }
+
+    if (NULL != config.inputFile)
+    {
+        /* No device is needed for reading a saved capture */
+        detected = 1;
+    }
+    else
+    {
+        /* Detect device  matching serial number */
+        statsStartPhase(STATS_PHASE_DETECT);
+        detected = LA_MK3_detectDevice(&linkAnalyser, config.args[0]);
+        statsStopPhase(STATS_PHASE_DETECT);
+    }
+    if (0 != detected)
     {
-        /* Configure Link Analyser for recording */
-        LA_configRecording(linkAnalyser, config);
-        /* Record SpaceWire traffic */
-        if (0 != LA_MK3_recordTraffic(linkAnalyser, &pTraffic, &trafficCount, &charCaptureClockPeriod, &captureDuration, &triggerTime))
+        if (NULL != config.inputFile)
         {
-            /* Print captured traffic data */
-            LA_MK3_printRecordedTraffic(linkAnalyser, pTraffic, config, &trafficCount, &charCaptureClockPeriod, &triggerTime);
-            if (NULL != config.kafka_topic)
+            /* Read the saved capture as if it had just been recorded */
+            statsStartPhase(STATS_PHASE_DOWNLOAD);
+            recorded = readCapture(config.inputFile, &pTraffic, &trafficCount, &charCaptureClockPeriod, &triggerTime, &config.headerOnly);
+            statsStopPhase(STATS_PHASE_DOWNLOAD);
+        }
+        else
+        {
+            /* Configure Link Analyser for recording */
+            statsStartPhase(STATS_PHASE_CONFIGURE);
+            LA_configRecording(linkAnalyser, config);
+            statsStopPhase(STATS_PHASE_CONFIGURE);
+            /* Record SpaceWire traffic */
+            recorded = LA_MK3_recordTraffic(linkAnalyser, &pTraffic, &trafficCount, &charCaptureClockPeriod, &captureDuration, &triggerTime);
+        }
+        if (0 != recorded)
+        {
+            /* Convert the traffic into the compact event store */
+            statsStartPhase(STATS_PHASE_CONVERT);
+            converted = LA_MK3_convertTraffic(&eventStore, pTraffic, &trafficCount, &charCaptureClockPeriod);
+            /* Free the traffic right away, its pages have already been released during the conversion */
+            if (NULL != config.inputFile)
             {
-                /* Archive traffic via kafka messaging system */
-                LA_MK3_archiveCapturedPackets(config, pTraffic, &trafficCount, &charCaptureClockPeriod, &triggerTime, config.preTrigger);
+                free(pTraffic);
+            }
+            else
+            {
+                STAR_LA_MK3_FreeRecordedTrafficMemory(pTraffic);
+            }
+            statsStopPhase(STATS_PHASE_CONVERT);
+
+            if (0 != converted)
+            {
+                statsAdd(STATS_EVENTS, eventStore.count);
+                /* Index the packets once for all consumers */
+                statsStartPhase(STATS_PHASE_INDEX);
+                if (0 != LA_MK3_buildPacketIndex(&packetIndex, &eventStore, config.preTrigger, config.filter))
+                {
+                    statsStopPhase(STATS_PHASE_INDEX);
+                    statsAdd(STATS_PACKETS_A, packetIndex.packetCount[RECV_A]);
+                    statsAdd(STATS_PACKETS_B, packetIndex.packetCount[RECV_B]);
+                    statsAdd(STATS_TIMECODES_A, packetIndex.timecodeCount[RECV_A]);
+                    statsAdd(STATS_TIMECODES_B, packetIndex.timecodeCount[RECV_B]);
+                    statsAdd(STATS_BYTES_A, packetIndex.byteCount[RECV_A]);
+                    statsAdd(STATS_BYTES_B, packetIndex.byteCount[RECV_B]);
+                    statsAdd(STATS_PACKETS_FILTERED, packetIndex.filteredCount);
+                    statsAdd(STATS_RMAP_COMMANDS, packetIndex.rmapCommandCount);
+                    statsAdd(STATS_RMAP_REPLIES, packetIndex.rmapReplyCount);
+                    statsAdd(STATS_RMAP_CRC_ERRORS, packetIndex.rmapCrcErrorCount);
+                    /* Incomplete packets are indexed last */
+                    for (i = packetIndex.count; (0 < i) && (PACKET_TERM_INCOMPLETE == packetIndex.entries[i - 1].termination); i--)
+                    {
+                        statsAdd(STATS_INCOMPLETE_PACKETS, 1);
+                    }
+
+                    /* Hand the packets to Wireshark before anything else is done with them */
+                    if (NULL != config.pcapngTarget)
+                    {
+                        pcapngStreamPackets(&eventStore, &packetIndex, &triggerTime, config.headerOnly);
+                    }
+
+                    /* Summarize the capture instead of printing it to stdout */
+                    if (NULL != config.summaryFile)
+                    {
+                        LA_MK3_summarizeCapture(&summary, &eventStore, &packetIndex);
+                        writeSummaryReport(config.summaryFile, &summary, config, &triggerTime);
+                        printSummaryTable(stdout, &summary);
+                    }
+
+                    /* Analyse the time-codes, the table goes to stderr to leave stdout to the capture log */
+                    if (NULL != config.timecodeFile)
+                    {
+                        LA_MK3_analyseTimecodes(&timecodes, &eventStore, &packetIndex);
+                        writeTimecodeReport(config.timecodeFile, &timecodes, config, &triggerTime);
+                        printTimecodeTable(stderr, &timecodes);
+                    }
+
+                    /* Pair requests with their responses, the table goes to stderr as well */
+                    if ((NULL != config.latencyFile) &&
+                        LA_MK3_pairTransactions(&latency, &eventStore, &packetIndex, config.pairRules, config.pairTimeout))
+                    {
+                        writeLatencyReport(config.latencyFile, &latency, config, &triggerTime);
+                        printLatencyTable(stderr, &latency);
+                    }
+
+                    /* Print the packets containing the search patterns instead of the capture log */
+                    if ((NULL != config.searchPatterns) &&
+                        LA_MK3_searchPackets(&search, &eventStore, &packetIndex, config.searchPatterns, config.jobs))
+                    {
+                        printSearchMatches(stdout, &search, &eventStore, &packetIndex, &triggerTime);
+                        freePacketSearch(&search);
+                    }
+
+                    /* Print the changes compared to the reference capture instead of the capture log, the table goes to stderr */
+                    if ((NULL != config.diffFile) && loadReferenceCapture(config, &referenceStore, &referenceIndex, &referenceTriggerTime))
+                    {
+                        if (LA_MK3_diffCaptures(&diff, &referenceStore, &referenceIndex, &eventStore, &packetIndex, config.diffTolerance, config.jobs))
+                        {
+                            printCaptureDiff(stdout, &diff, &referenceStore, &referenceIndex, &referenceTriggerTime,
+                                             &eventStore, &packetIndex, &triggerTime);
+                            printDiffTable(stderr, &diff);
+                            freeCaptureDiff(&diff);
+                        }
+                        freePacketIndex(&referenceIndex);
+                        freeEventStore(&referenceStore);
+                    }
+
+                    /* There is no device to describe in the logs of a saved capture, it can only be converted to a raw capture */
+                    statsStartPhase(STATS_PHASE_PRINT);
+                    if (NULL == config.inputFile)
+                    {
+                        /* Print captured traffic data */
+                        LA_MK3_printRecordedTraffic(linkAnalyser, &eventStore, &packetIndex, config, &triggerTime);
+                    }
+                    else if (NULL != config.rawFile)
+                    {
+                        LA_MK3_saveRawCapture(&eventStore, config, &triggerTime);
+                    }
+                    /* Export the events and packets for numeric analysis */
+                    if (NULL != config.columnsDir)
+                    {
+                        LA_MK3_exportColumns(config.columnsDir, &eventStore, &packetIndex, config, &triggerTime);
+                    }
+                    statsStopPhase(STATS_PHASE_PRINT);
+                    if (NULL != config.kafka_topic)
+                    {
+                        /* Archive traffic via kafka messaging system */
+                        LA_MK3_archiveCapturedPackets(config, &eventStore, &packetIndex, &triggerTime);
+                    }
+                }
+                /* Free the packet index */
+                freePacketIndex(&packetIndex);
+                /* Free the event store */
+                freeEventStore(&eventStore);
             }
-            /* Free the traffic */
-            STAR_LA_MK3_FreeRecordedTrafficMemory(pTraffic);
         }
     }
 
+    /* Wait for the stream to be written, before the drops are reported */
+    if (NULL != config.pcapngTarget)
+    {
+        pcapngStopStream();
+    }
+    statsStopPhase(STATS_PHASE_TOTAL);
+    if (NULL != config.metricsTarget)
+    {
+        metricsStopExporter();
+    }
+    if (NULL != config.statsFile)
+    {
+        statsWriteReport(config.statsFile, config, recorded ? &triggerTime : NULL);
+    }
+    free(config.trigSpec);
+    free(config.logExcludeSpec);
+    freePacketFilter(config.filter);
+    freePairingRules(config.pairRules);
+    freeSearchPatterns(config.searchPatterns);
+
     fputs("\n", stderr);
 
     return 0;
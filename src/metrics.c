@@ -0,0 +1,280 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include "metrics.h"
+#include "run_stats.h"
+
+/* Names of the gauges */
+static const char *const gaugeNames[] = { "phase", "trigger_state", "decoder_backlog", "kafka_queue_depth", "stream_queue_depth" };
+
+/* Descriptions of the gauges */
+static const char *const gaugeHelp[] = {
+    "Current phase of the run",
+    "Trigger state last read from the Link Analyser",
+    "Indexed packets not yet written or archived",
+    "Messages waiting in the Kafka producer queue",
+    "Buffers waiting to be written to the PCAPNG stream"
+};
+
+/* Descriptions of the run statistics counters (see enum statsCounter) */
+static const char *const counterHelp[] = {
+    "Recorded events",
+    "Packets indexed on receiver A",
+    "Packets indexed on receiver B",
+    "Time-codes indexed on receiver A",
+    "Time-codes indexed on receiver B",
+    "Packet bytes indexed on receiver A",
+    "Packet bytes indexed on receiver B",
+    "Packets not terminated before the end of recording",
+    "Packets and time-codes rejected by the packet filter",
+    "RMAP commands indexed",
+    "RMAP replies indexed",
+    "Indexed RMAP packets with a header or data CRC mismatch",
+    "Error events found by the error log",
+    "Packets of receiver A written to the hexdump",
+    "Packets of receiver B written to the hexdump",
+    "Bytes written to the hexdump or event log",
+    "Bytes written to output files",
+    "Microseconds spent writing and synchronizing output files",
+    "Times formatting waited on the disk for a free output buffer",
+    "Bytes compressed into gzip members",
+    "Bytes of gzip members written",
+    "Microseconds spent compressing output frames",
+    "Output files closed by rotation",
+    "Archive messages handed to the Kafka producer",
+    "Attempts to produce repeated after a full Kafka queue",
+    "Archive messages that could not be produced",
+    "Archive messages reported as failed by the Kafka delivery callback",
+    "Archive messages left in the Kafka queue after flushing",
+    "Repeated packets archived as references to an earlier message",
+    "Packets written to the PCAPNG stream",
+    "Packets dropped from the PCAPNG stream"
+};
+
+/* Values of the gauges */
+static _Atomic long long gauges[METRIC_GAUGE_COUNT];
+
+/* The exporter thread has been asked to stop */
+static atomic_int stopExporter;
+
+/* The exporter thread is running */
+static int exporterRunning = 0;
+
+/* The exporter thread */
+static pthread_t exporterThread;
+
+/* Listening socket of the HTTP exporter (-1 = textfile exporter) */
+static int listenSocket = -1;
+
+/* Path of the metrics textfile */
+static const char *textfilePath = NULL;
+
+void metricsSetGauge(int gauge, long long value)
+{
+    atomic_store_explicit(&gauges[gauge], value, memory_order_relaxed);
+
+    return;
+}
+
+int metricsWrite(FILE *stream)
+{
+    /* Loop counter */
+    int i = 0;
+    /* Current phase of the run */
+    long long phase = atomic_load_explicit(&gauges[METRIC_GAUGE_PHASE], memory_order_relaxed);
+    /* Return value */
+    int ret = 1;
+
+    for (i = 0; i < STATS_COUNTER_COUNT; i++)
+    {
+        ret = ret && (0 <= fprintf(stream, "# TYPE " METRICS_PREFIX "%s counter\n"
+                                           "# HELP " METRICS_PREFIX "%s %s.\n"
+                                           METRICS_PREFIX "%s_total %llu\n",
+                                           statsCounterNames[i], statsCounterNames[i], counterHelp[i],
+                                           statsCounterNames[i], statsGet(i)));
+    }
+    for (i = METRIC_GAUGE_TRIGGER_STATE; i < METRIC_GAUGE_COUNT; i++)
+    {
+        ret = ret && (0 <= fprintf(stream, "# TYPE " METRICS_PREFIX "%s gauge\n"
+                                           "# HELP " METRICS_PREFIX "%s %s.\n"
+                                           METRICS_PREFIX "%s %lld\n",
+                                           gaugeNames[i], gaugeNames[i], gaugeHelp[i], gaugeNames[i],
+                                           atomic_load_explicit(&gauges[i], memory_order_relaxed)));
+    }
+
+    /* The phase is a state set, each phase is either active or not */
+    ret = ret && (0 <= fprintf(stream, "# TYPE " METRICS_PREFIX "%s stateset\n# HELP " METRICS_PREFIX "%s %s.\n",
+                               gaugeNames[METRIC_GAUGE_PHASE], gaugeNames[METRIC_GAUGE_PHASE], gaugeHelp[METRIC_GAUGE_PHASE]));
+    for (i = 0; i < STATS_PHASE_TOTAL; i++)
+    {
+        ret = ret && (0 <= fprintf(stream, METRICS_PREFIX "%s{%s=\"%s\"} %d\n", gaugeNames[METRIC_GAUGE_PHASE],
+                                   METRICS_PREFIX "phase", statsPhaseNames[i], (phase == i) ? 1 : 0));
+    }
+    ret = ret && (0 <= fputs("# EOF\n", stream));
+
+    return ret;
+}
+
+static int writeTextfile(void)
+{
+    /* Temporary file replacing the textfile once completely written */
+    char *tempPath = malloc(strlen(textfilePath) + 5);
+    /* The temporary file */
+    FILE *file = NULL;
+    /* Return value */
+    int ret = 0;
+
+    if (NULL != tempPath)
+    {
+        sprintf(tempPath, "%s.tmp", textfilePath);
+        file = fopen(tempPath, "w");
+    }
+    if (NULL != file)
+    {
+        ret = metricsWrite(file);
+        ret = (0 == fclose(file)) && ret;
+        /* Replace atomically, so scrapers never read a partial file */
+        ret = ret && (0 == rename(tempPath, textfilePath));
+    }
+    free(tempPath);
+
+    return ret;
+}
+
+static void serveScrape(int client)
+{
+    /* Request of the scraper, which is not evaluated */
+    char request[1024];
+    /* Formatted metrics */
+    char *body = NULL;
+    size_t bodySize = 0;
+    /* Stream for formatting the metrics */
+    FILE *bodyStream = open_memstream(&body, &bodySize);
+    /* HTTP response header */
+    char header[160];
+    /* Length of the response header */
+    int headerLength = 0;
+
+    if (0 > recv(client, request, sizeof(request), 0))
+    {
+        fputs("Unable to receive metrics request\n", stderr);
+    }
+    if (NULL != bodyStream)
+    {
+        metricsWrite(bodyStream);
+        fclose(bodyStream);
+        headerLength = snprintf(header, sizeof(header), "HTTP/1.1 200 OK\r\n"
+                                "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+                                "Content-Length: %zu\r\nConnection: close\r\n\r\n", bodySize);
+        if ((0 > send(client, header, (size_t)headerLength, MSG_NOSIGNAL)) ||
+            (0 > send(client, body, bodySize, MSG_NOSIGNAL)))
+        {
+            fputs("Unable to send metrics\n", stderr);
+        }
+    }
+    free(body);
+
+    return;
+}
+
+static void *exportMetrics(void *arg)
+{
+    /* Scrape request on the listening socket */
+    struct pollfd pending = { listenSocket, POLLIN, 0 };
+    /* Connection of the scraper */
+    int client = -1;
+
+    while (!atomic_load(&stopExporter))
+    {
+        if (0 > listenSocket)
+        {
+            writeTextfile();
+            usleep(METRICS_FILE_INTERVAL_MS * 1000);
+        }
+        else if (0 < poll(&pending, 1, METRICS_POLL_TIMEOUT_MS))
+        {
+            client = accept(listenSocket, NULL, NULL);
+            if (0 <= client)
+            {
+                serveScrape(client);
+                close(client);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int metricsStartExporter(const char *target)
+{
+    /* Parsed port number */
+    char *end = NULL;
+    long port = strtol(target, &end, 10);
+    /* Local address to serve the metrics on */
+    struct sockaddr_in address;
+    /* Allow restarting on the same port right away */
+    int reuse = 1;
+
+    if (('\0' == *end) && (0 < port) && (65536 > port))
+    {
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons((uint16_t)port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        if ((0 > listenSocket) ||
+            (0 != setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse))) ||
+            (0 != bind(listenSocket, (struct sockaddr *)&address, sizeof(address))) ||
+            (0 != listen(listenSocket, 4)))
+        {
+            fprintf(stderr, "Unable to serve metrics on port %ld\n", port);
+            if (0 <= listenSocket)
+            {
+                close(listenSocket);
+                listenSocket = -1;
+            }
+            return 0;
+        }
+    }
+    else
+    {
+        textfilePath = target;
+    }
+
+    atomic_store(&stopExporter, 0);
+    exporterRunning = (0 == pthread_create(&exporterThread, NULL, exportMetrics, NULL));
+    if (!exporterRunning)
+    {
+        fputs("Unable to start the metrics exporter\n", stderr);
+    }
+
+    return exporterRunning;
+}
+
+void metricsStopExporter(void)
+{
+    if (exporterRunning)
+    {
+        atomic_store(&stopExporter, 1);
+        pthread_join(exporterThread, NULL);
+        exporterRunning = 0;
+    }
+    if (0 <= listenSocket)
+    {
+        close(listenSocket);
+        listenSocket = -1;
+    }
+    else if ((NULL != textfilePath) && !writeTextfile())
+    {
+        fprintf(stderr, "Unable to write metrics to %s\n", textfilePath);
+    }
+
+    return;
+}
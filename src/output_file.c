@@ -0,0 +1,349 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "output_file.h"
+#include "arg_parser.h"
+#include "file_writer.h"
+#include "compressor.h"
+#include "run_stats.h"
+
+static FILE *openStream(const char *fileName, unsigned long long expectedSize, int compressLevel, int fsyncPolicy)
+{
+    /* Stream writing to the file or stdout */
+    FILE *stream = stdout;
+    /* Stream compressing the output */
+    FILE *compressed = NULL;
+
+    if (NULL != fileName)
+    {
+        stream = writerOpen(fileName, (0 < compressLevel) ? expectedSize / COMPRESS_EXPECTED_RATIO : expectedSize, fsyncPolicy);
+    }
+    if ((NULL != stream) && (0 < compressLevel))
+    {
+        /* The compressor closes the file, but leaves stdout open */
+        compressed = compressOpen(stream, compressLevel, NULL != fileName);
+        if ((NULL == compressed) && (NULL != fileName))
+        {
+            fclose(stream);
+        }
+        stream = compressed;
+    }
+
+    return stream;
+}
+
+static int closeStream(FILE *stream, const char *fileName)
+{
+    /* Return value */
+    int success = (stdout == stream) || (0 == fclose(stream));
+
+    if (!success)
+    {
+        fprintf(stderr, "Unable to write output file %s\n", (NULL != fileName) ? fileName : "stdout");
+    }
+
+    return success;
+}
+
+static char *getPartName(const char *fileName, unsigned int sequence)
+{
+    /* Start of the file name behind the directories */
+    const char *baseName = strrchr(fileName, '/');
+    /* Start of the file extension (a leading dot of hidden files is part of the name) */
+    const char *extension = NULL;
+    /* Name of the rotated file while written */
+    char *partName = NULL;
+
+    baseName = (NULL != baseName) ? baseName + 1 : fileName;
+    extension = strchr(('.' == *baseName) ? baseName + 1 : baseName, '.');
+    if (NULL == extension)
+    {
+        extension = baseName + strlen(baseName);
+    }
+    if (0 > asprintf(&partName, "%.*s.%04u%s%s", (int)(extension - fileName), fileName, sequence, extension, OUTPUT_PART_SUFFIX))
+    {
+        partName = NULL;
+    }
+
+    return partName;
+}
+
+static int finishFile(FILE *stream, char *partName)
+{
+    /* Name of the file after closing */
+    char *fileName = strndup(partName, strlen(partName) - strlen(OUTPUT_PART_SUFFIX));
+    /* Return value */
+    int success = closeStream(stream, partName);
+
+    if (success && ((NULL == fileName) || (0 != rename(partName, fileName))))
+    {
+        fprintf(stderr, "Unable to rename output file %s\n", partName);
+        success = 0;
+    }
+    free(fileName);
+    free(partName);
+
+    return success;
+}
+
+static void setFailed(OutputFile *output)
+{
+    /* The closer thread sets the flag as well */
+    pthread_mutex_lock(&output->lock);
+    output->failed = 1;
+    pthread_mutex_unlock(&output->lock);
+
+    return;
+}
+
+static void *closeRotatedFiles(void *arg)
+{
+    /* The output */
+    OutputFile *output = arg;
+    /* The file to close */
+    struct pendingClose file;
+    /* Closing the file succeeded */
+    int success = 1;
+    /* No files are left to close */
+    int done = 0;
+
+    while (!done)
+    {
+        pthread_mutex_lock(&output->lock);
+        while ((0 == output->pendingCount) && !output->closing)
+        {
+            pthread_cond_wait(&output->pendingCond, &output->lock);
+        }
+        done = (0 == output->pendingCount);
+        file = output->pending[output->nextPending];
+        pthread_mutex_unlock(&output->lock);
+
+        if (!done)
+        {
+            success = finishFile(file.stream, file.partName);
+
+            pthread_mutex_lock(&output->lock);
+            output->nextPending = (output->nextPending + 1) % OUTPUT_PENDING_CLOSES;
+            output->pendingCount--;
+            if (!success)
+            {
+                output->failed = 1;
+            }
+            pthread_cond_signal(&output->closedCond);
+            pthread_mutex_unlock(&output->lock);
+        }
+    }
+
+    return NULL;
+}
+
+static void handOverFile(OutputFile *output, FILE *stream, char *partName)
+{
+    if (!output->closerRunning)
+    {
+        output->closerRunning = (0 == pthread_create(&output->closer, NULL, closeRotatedFiles, output));
+    }
+
+    if (!output->closerRunning)
+    {
+        /* Close the file in this thread instead */
+        if (!finishFile(stream, partName))
+        {
+            setFailed(output);
+        }
+    }
+    else
+    {
+        pthread_mutex_lock(&output->lock);
+        while (OUTPUT_PENDING_CLOSES == output->pendingCount)
+        {
+            pthread_cond_wait(&output->closedCond, &output->lock);
+        }
+        output->pending[(output->nextPending + output->pendingCount) % OUTPUT_PENDING_CLOSES].stream = stream;
+        output->pending[(output->nextPending + output->pendingCount) % OUTPUT_PENDING_CLOSES].partName = partName;
+        output->pendingCount++;
+        pthread_cond_signal(&output->pendingCond);
+        pthread_mutex_unlock(&output->lock);
+    }
+
+    return;
+}
+
+static int openNextFile(OutputFile *output)
+{
+    /* Name of the next file while written */
+    char *partName = getPartName(output->fileName, output->sequence);
+    /* Stream of the next file */
+    FILE *stream = NULL;
+
+    if (NULL == partName)
+    {
+        fputs("Unable to allocate memory for the name of the output file\n", stderr);
+        return 0;
+    }
+    stream = openStream(partName, output->expectedSize, output->compressLevel, output->fsyncPolicy);
+    if (NULL == stream)
+    {
+        free(partName);
+        return 0;
+    }
+    if (0 < output->headerLength)
+    {
+        fwrite(output->header, 1, output->headerLength, stream);
+    }
+
+    output->stream = stream;
+    output->partName = partName;
+    output->bytes = 0;
+    output->empty = 1;
+
+    return 1;
+}
+
+int outputOpen(OutputFile *output, const char *fileName, Settings settings, unsigned long long expectedSize,
+               double clockPeriod, const char rotate, const char *header, size_t headerLength)
+{
+    /* Return value */
+    int success = 0;
+
+    memset(output, 0, sizeof(OutputFile));
+    output->fileName = fileName;
+    output->compressLevel = settings.compressLevel;
+    output->fsyncPolicy = settings.fsyncPolicy;
+    output->header = header;
+    output->headerLength = headerLength;
+    output->empty = 1;
+    if (rotate && (NULL != fileName))
+    {
+        output->maxBytes = settings.rotateSize;
+        output->maxTicks = ((0.0 < settings.rotateTime) && (0.0 < clockPeriod)) ? (long long)(settings.rotateTime / clockPeriod) : 0;
+    }
+    /* Preallocate a full file of the size limit, but nothing for files limited by time only */
+    output->expectedSize = expectedSize;
+    if ((0 < output->maxBytes) && (output->maxBytes < expectedSize))
+    {
+        output->expectedSize = headerLength + output->maxBytes;
+    }
+    else if (0 < output->maxTicks)
+    {
+        output->expectedSize = 0;
+    }
+
+    if (outputRotates(output))
+    {
+        success = openNextFile(output);
+    }
+    else
+    {
+        output->stream = openStream(fileName, output->expectedSize, output->compressLevel, output->fsyncPolicy);
+        success = (NULL != output->stream);
+        if (success && (0 < headerLength))
+        {
+            fwrite(header, 1, headerLength, output->stream);
+        }
+    }
+
+    if (success)
+    {
+        pthread_mutex_init(&output->lock, NULL);
+        pthread_cond_init(&output->pendingCond, NULL);
+        pthread_cond_init(&output->closedCond, NULL);
+    }
+
+    return success;
+}
+
+void outputAttach(OutputFile *output, FILE *stream)
+{
+    memset(output, 0, sizeof(OutputFile));
+    output->stream = stream;
+    output->attached = 1;
+    output->empty = 1;
+    pthread_mutex_init(&output->lock, NULL);
+    pthread_cond_init(&output->pendingCond, NULL);
+    pthread_cond_init(&output->closedCond, NULL);
+
+    return;
+}
+
+FILE *outputBoundary(OutputFile *output, long long tick)
+{
+    /* Stream of the file reaching its limit */
+    FILE *stream = output->stream;
+    /* Name of that file while written */
+    char *partName = output->partName;
+
+    if (!output->empty &&
+        (((0 < output->maxBytes) && (output->bytes >= output->maxBytes)) ||
+         ((0 < output->maxTicks) && (tick - output->firstTick >= output->maxTicks))))
+    {
+        output->sequence++;
+        if (openNextFile(output))
+        {
+            handOverFile(output, stream, partName);
+            statsAdd(STATS_FILES_ROTATED, 1);
+        }
+        else
+        {
+            /* Keep writing to the current file instead of failing on every packet */
+            fprintf(stderr, "Unable to rotate output file %s, continuing in %s\n", output->fileName, partName);
+            output->maxBytes = 0;
+            output->maxTicks = 0;
+            setFailed(output);
+        }
+    }
+    if (output->empty)
+    {
+        output->firstTick = tick;
+        output->empty = 0;
+    }
+
+    return output->stream;
+}
+
+void outputWritten(OutputFile *output, unsigned long long bytes)
+{
+    output->bytes += bytes;
+
+    return;
+}
+
+int outputRotates(const OutputFile *output)
+{
+    return (0 < output->maxBytes) || (0 < output->maxTicks);
+}
+
+int outputClose(OutputFile *output)
+{
+    /* Return value */
+    int success = 1;
+
+    if (NULL != output->partName)
+    {
+        /* The last rotated file is closed right away */
+        success = finishFile(output->stream, output->partName);
+    }
+    else if (!output->attached)
+    {
+        success = closeStream(output->stream, output->fileName);
+    }
+
+    if (output->closerRunning)
+    {
+        pthread_mutex_lock(&output->lock);
+        output->closing = 1;
+        pthread_cond_signal(&output->pendingCond);
+        pthread_mutex_unlock(&output->lock);
+        pthread_join(output->closer, NULL);
+    }
+    pthread_mutex_lock(&output->lock);
+    success = success && !output->failed;
+    pthread_mutex_unlock(&output->lock);
+    pthread_mutex_destroy(&output->lock);
+    pthread_cond_destroy(&output->pendingCond);
+    pthread_cond_destroy(&output->closedCond);
+
+    return success;
+}
@@ -1,9 +1,38 @@
+#include <stdlib.h>
 #include <uuid/uuid.h>
 #include <json-c/json.h>
 #include "packet_archiver.h"
 #include "arg_parser.h"
 #include "data_logger.h"
-
+#include "event_store.h"
+#include "packet_index.h"
+#include "rmap.h"
+#include "run_stats.h"
+#include "metrics.h"
+
+/* Parameters of the 64 bit FNV-1a hash */
+#define HASH_FNV_OFFSET 0xCBF29CE484222325ULL
+#define HASH_FNV_PRIME 0x100000001B3ULL
+
+/* States of a slot of the deduplication cache */
+enum dedupState {
+    DEDUP_SLOT_EMPTY,       /* The slot holds no packet */
+    DEDUP_SLOT_PENDING,     /* The message of the packet has been sent, its delivery is not known yet */
+    DEDUP_SLOT_DELIVERED    /* The message of the packet has been delivered and can be referred to */
+};
+
+/* A packet archived in full, which later packets can refer to */
+struct dedupSlot
+{
+    unsigned long long hash;    /* Hash of the interface and the packet bytes */
+    long long sentTime;         /* Capture clock tick of the packet archived in full */
+    U8  *bytes;                 /* Copy of the packet bytes */
+    U32 capacity;               /* Number of bytes allocated for the copy */
+    U32 length;                 /* Number of bytes in the packet */
+    U8  receiver;               /* Receiver the packet was recorded on */
+    U8  state;                  /* State of the slot (see enum dedupState) */
+    char uuid[37];              /* UUID of the message holding the packet */
+};
 
 /* Optional per-message delivery callback (triggered by poll() or flush())
  * when a message has been successfully delivered or permanently
@@ -13,38 +42,99 @@ static void dr_msg_cb (rd_kafka_t *kafka_handle, const rd_kafka_message_t *rkmes
 {
     if (rkmessage->err) {
         fprintf(stderr, "Message delivery failed: %s", rd_kafka_err2str(rkmessage->err));
+        statsAdd(STATS_DELIVERY_FAILURES, 1);
     }
+    /* The opaque of the producer is the transport, the one of the message its cache slot */
+    LA_MK3_reportDelivery(opaque, rkmessage->_private, !rkmessage->err);
 }
 
-static int32_t sendKafkaMessage(rd_kafka_t *producer, const char *topic, uint8_t *buffer, size_t length, uint32_t *counter)
+void LA_MK3_reportDelivery(ArchiveTransport *transport, void *opaque, int delivered)
 {
+    /* Cache slot of the reported message */
+    DedupSlot *slot = opaque;
+
+    /* A pending slot is not replaced, so the report belongs to the packet it holds */
+    if ((NULL != transport) && (NULL != transport->cache) && (NULL != slot) && (DEDUP_SLOT_PENDING == slot->state))
+    {
+        slot->state = delivered ? DEDUP_SLOT_DELIVERED : DEDUP_SLOT_EMPTY;
+    }
+
+    return;
+}
+
+static int32_t sendKafkaMessage(void *context, const char *topic, uint8_t *buffer, size_t length, void *opaque)
+{
+    /* Producer instance handle */
+    rd_kafka_t *producer = context;
     /* kafka error code */
-    rd_kafka_resp_err_t err;
+    rd_kafka_resp_err_t err = RD_KAFKA_RESP_ERR_NO_ERROR;
+    /* Attempt to produce the message */
+    int attempt = 0;
 
-    err = rd_kafka_producev(producer,
-                            RD_KAFKA_V_TOPIC(topic),
-                            RD_KAFKA_V_MSGFLAGS(RD_KAFKA_MSG_F_COPY),
-                            RD_KAFKA_V_VALUE(buffer, length),
-                            RD_KAFKA_V_OPAQUE(NULL),
-                            RD_KAFKA_V_END);
+    for (attempt = 1; attempt <= KAFKA_PRODUCE_ATTEMPTS; attempt++)
+    {
+        err = rd_kafka_producev(producer,
+                                RD_KAFKA_V_TOPIC(topic),
+                                RD_KAFKA_V_MSGFLAGS(RD_KAFKA_MSG_F_COPY),
+                                RD_KAFKA_V_VALUE(buffer, length),
+                                RD_KAFKA_V_OPAQUE(opaque),
+                                RD_KAFKA_V_END);
+        if (err != RD_KAFKA_RESP_ERR__QUEUE_FULL)
+        {
+            break;
+        }
+        /* Serve delivery reports to make room in the queue before trying again */
+        rd_kafka_poll(producer, 1000);
+        if (attempt < KAFKA_PRODUCE_ATTEMPTS)
+        {
+            statsAdd(STATS_MESSAGES_RETRIED, 1);
+        }
+    }
 
     if (err) {
         fprintf(stderr, "Failed to produce to topic %s: %s", topic, rd_kafka_err2str(err));
-        if(err == RD_KAFKA_RESP_ERR__QUEUE_FULL)
-        {
-            rd_kafka_poll(producer, 1000);
-        }
+        statsAdd(STATS_MESSAGES_DROPPED, 1);
     } else {
         //fprintf(stderr, "Produced event to topic %s: value = %12s\n", topic, buffer);
-        (*counter)++;
+        statsAdd(STATS_MESSAGES_PRODUCED, 1);
     }
 
     rd_kafka_poll(producer, 0);
+    metricsSetGauge(METRIC_GAUGE_KAFKA_QUEUE, rd_kafka_outq_len(producer));
 
-    return 1;
+    return !err;
+}
+
+static struct json_object *createRmapObject(const RmapHeader *header)
+{
+    /* The decoded header */
+    struct json_object *obj = json_object_new_object();
+    /* The packet is a command */
+    int command = (0 != (header->flags & RMAP_FLAG_COMMAND));
+
+    json_object_object_add(obj, "type", json_object_new_string(command ? "command" : "reply"));
+    json_object_object_add(obj, "instruction", json_object_new_int(header->instruction));
+    json_object_object_add(obj, "target_address", json_object_new_int(header->targetAddress));
+    json_object_object_add(obj, "initiator_address", json_object_new_int(header->initiatorAddress));
+    json_object_object_add(obj, command ? "key" : "status", json_object_new_int(header->keyStatus));
+    json_object_object_add(obj, "transaction_id", json_object_new_int(header->transactionId));
+    if (command)
+    {
+        json_object_object_add(obj, "extended_address", json_object_new_int(header->extendedAddress));
+        json_object_object_add(obj, "address", json_object_new_int64(header->address));
+    }
+    if (header->hasData)
+    {
+        json_object_object_add(obj, "data_length", json_object_new_int64(header->dataLength));
+        json_object_object_add(obj, "data_crc_error", json_object_new_boolean(0 != (header->flags & RMAP_FLAG_DATA_CRC)));
+    }
+    json_object_object_add(obj, "header_crc_error", json_object_new_boolean(0 != (header->flags & RMAP_FLAG_HEADER_CRC)));
+    json_object_object_add(obj, "length_error", json_object_new_boolean(0 != (header->flags & RMAP_FLAG_LENGTH)));
+
+    return obj;
 }
 
-static uint32_t createCapturePacket(Settings settings, PacketInfo packetInfo, uint8_t* msg, uint32_t* msg_len)
+static uint32_t createCapturePacket(Settings settings, PacketInfo packetInfo, uint8_t* msg, uint32_t* msg_len, char *uuid_)
 {
 	uint32_t ret = 0;
 	uuid_t binuuid;
@@ -58,6 +148,15 @@ static uint32_t createCapturePacket(Settings settings, PacketInfo packetInfo, ui
 
     uint32_t dynamicMessageLength = interfaceIdLength + testIdLength + testVerLength + aswVerLength + dbVerLength + packetInfo.rawDataLength;
 
+    if (settings.headerOnly)
+    {
+        dynamicMessageLength += HEADER_ONLY_MESSAGE_LENGTH;
+    }
+    if (NULL != packetInfo.rmap)
+    {
+        dynamicMessageLength += RMAP_MESSAGE_LENGTH;
+    }
+
 	if(BUF_SIZE < STATIC_MESSAGE_LENGTH + dynamicMessageLength)
 	{
 		fputs("\nMessage length exceeding buffer size.\n", stderr);
@@ -73,12 +172,6 @@ static uint32_t createCapturePacket(Settings settings, PacketInfo packetInfo, ui
 		 */
 		uuid_generate_random(binuuid);
 
-		/*
-		 * uuid_unparse() doesn't allocate memory for itself, so do that with
-		 * malloc(). 37 is the length of a UUID (36 characters), plus '\0'.
-		 */
-		char uuid_[37];
-
 		/*
 		 * Produces a UUID string at uuid consisting of letters
 		 * whose case depends on the system's locale.
@@ -95,6 +188,16 @@ static uint32_t createCapturePacket(Settings settings, PacketInfo packetInfo, ui
 		json_object_object_add(obj, "asw_version", json_object_new_string_len(settings.kafka_aswVersion, aswVerLength));
 		json_object_object_add(obj, "db_version", json_object_new_string_len(settings.kafka_dbVersion, dbVerLength));
 		json_object_object_add(obj, "raw_data", json_object_new_string_len(packetInfo.rawData, packetInfo.rawDataLength));
+		if (settings.headerOnly)
+		{
+			/* Raw data only holds the header, so add the duration up to the end of packet */
+			json_object_object_add(obj, "header_only", json_object_new_boolean(1));
+			json_object_object_add(obj, "duration_ns", json_object_new_int64((int64_t)(packetInfo.duration * 1000000000.0)));
+		}
+		if (NULL != packetInfo.rmap)
+		{
+			json_object_object_add(obj, "rmap", createRmapObject(packetInfo.rmap));
+		}
 
 		*msg_len = sprintf((char*)msg, "%s", json_object_to_json_string(obj));
 
@@ -106,80 +209,231 @@ static uint32_t createCapturePacket(Settings settings, PacketInfo packetInfo, ui
 	return ret;
 }
 
-static int32_t LA_MK3_assembleDataPacket(FILE *dataStream, PacketInfo *packet, STAR_LA_MK3_Event event, const double *deltaToTrigger, struct timespec *triggerTime)
+static void createReferencePacket(Settings settings, PacketInfo packetInfo, const char *refUuid, uint8_t* msg, int32_t* msg_len)
+{
+    /* The message */
+    struct json_object *obj = json_object_new_object();
+
+    /* The interface and all other fields are those of the referenced message */
+    json_object_object_add(obj, "ref_uuid", json_object_new_string(refUuid));
+    json_object_object_add(obj, "capture_time", json_object_new_string(packetInfo.captureTime));
+    if (settings.headerOnly)
+    {
+        json_object_object_add(obj, "duration_ns", json_object_new_int64((int64_t)(packetInfo.duration * 1000000000.0)));
+    }
+
+    *msg_len = sprintf((char*)msg, "%s", json_object_to_json_string(obj));
+
+    json_object_put(obj);
+
+    return;
+}
+
+static unsigned long long hashPacket(U8 receiver, const U8 *bytes, U32 length)
 {
-    /* Total number of bytes in the packet */
-    int32_t packetBytes = 0;
+    /* Loop counter */
+    U32 i = 0;
+    /* Hash of the interface and the packet bytes */
+    unsigned long long hash = (HASH_FNV_OFFSET ^ receiver) * HASH_FNV_PRIME;
+
+    for (i = 0; i < length; i++)
+    {
+        hash = (hash ^ bytes[i]) * HASH_FNV_PRIME;
+    }
+
+    return hash;
+}
+
+static void bytesToHex(const U8 *bytes, U32 length, char *hexString)
+{
+    /* Hexadecimal digits */
+    static const char digits[] = "0123456789abcdef";
+    /* Loop counter */
+    U32 i = 0;
+
+    for (i = 0; i < length; i++)
+    {
+        hexString[2 * i] = digits[bytes[i] >> 4];
+        hexString[2 * i + 1] = digits[bytes[i] & 0x0F];
+    }
+    hexString[2 * length] = '\0';
 
-    /* Size of the content in the data stream file */
-    int32_t fileSize = ftell(dataStream);
+    return;
+}
 
-    /* Start new packet, if header event is detected */
-    if ((0 == fileSize) && (STAR_LA_TRAFFIC_TYPE_HEADER == event.type))
+int32_t LA_MK3_serializeCapturedPackets(Settings settings, const EventStore *store, PacketIndex *index, struct timespec *triggerTime, ArchiveTransport *transport, uint32_t *messageCounter)
+{
+    /* Buffer for kafka messages */
+    uint8_t buffer[BUF_SIZE];
+    /* Length of kafka message */
+    int32_t msg_length = BUF_SIZE;
+    /* Loop counter */
+    U32 i = 0;
+
+    /* Time difference of the current packet to the trigger in seconds */
+    double deltaToTrigger = 0.0;
+    /* The current packet in the index */
+    PacketEntry *entry = NULL;
+    /* Number of bytes in the current packet */
+    U32 length = 0;
+
+    /* Struct holding the data of the current packet */
+    PacketInfo packet;
+    /* Buffer for gathering the bytes of the current packet */
+    U8 *packetBytes = NULL;
+    /* RMAP header of the current packet */
+    RmapHeader rmapHeader;
+    /* UUID of the message of the current packet */
+    char uuid[37];
+
+    /* Packets archived in full, which later packets can refer to (NULL = no deduplication) */
+    DedupSlot *cache = NULL;
+    /* Cache slot of the current packet */
+    DedupSlot *slot = NULL;
+    /* The current packet is cached until the delivery of its message is reported */
+    int cached = 0;
+    /* Copy of the packet bytes with enough capacity */
+    U8 *bytes = NULL;
+    /* Hash of the current packet */
+    unsigned long long hash = 0;
+    /* Capture clock ticks after which a repeated packet is archived in full again */
+    long long resyncTicks = (long long)(settings.archiveDedup / store->clockPeriod);
+    /* Number of packets archived as references */
+    U32 references = 0;
+
+    packet.duration = 0.0;
+    packet.rmap = NULL;
+    packet.rawDataLength = 0;
+    packet.rawData = malloc(2 * (size_t)index->maxLength + 1);
+    packetBytes = malloc(index->maxLength + 1);
+    if (0.0 < settings.archiveDedup)
     {
-        LA_MK3_getPacketTimestamp(deltaToTrigger, triggerTime, packet->captureTime);
-        fprintf(dataStream, "%02x", event.data);
-        packet->rawDataLength++;
+        cache = calloc(DEDUP_CACHE_SLOTS, sizeof(DedupSlot));
     }
-    /* Add byte to packet, if data event is detected */
-    else if ((0 < fileSize) && (STAR_LA_TRAFFIC_TYPE_DATA == event.type || STAR_LA_TRAFFIC_TYPE_HEADER == event.type))
+    if ((NULL == packet.rawData) || (NULL == packetBytes) || ((0.0 < settings.archiveDedup) && (NULL == cache)))
     {
-        /* Print byte */
-        fprintf(dataStream, "%02x", event.data);
+        fputs("Unable to allocate memory for archiving packets\n", stderr);
+        free(packet.rawData);
+        free(packetBytes);
+        free(cache);
+        return 0;
     }
-    /* End packet and return number of bytes in data stream file, if EOP or EEP event is detected */
-    else if (STAR_LA_TRAFFIC_TYPE_EOP == event.type || STAR_LA_TRAFFIC_TYPE_EEP == event.type)
+    transport->cache = cache;
+
+    for (i = 0; i < index->count; i++)
     {
-        packetBytes = fileSize;
+        if (0 == i % FORMAT_BLOCK_ENTRIES)
+        {
+            metricsSetGauge(METRIC_GAUGE_DECODER_BACKLOG, index->count - i);
+        }
+        entry = &index->entries[i];
+        /* Archive terminated packets only */
+        if ((PACKET_TERM_EOP == entry->termination) || (PACKET_TERM_EEP == entry->termination))
+        {
+            deltaToTrigger = entry->startTime * store->clockPeriod;
+            LA_MK3_getPacketTimestamp(&deltaToTrigger, triggerTime, packet.captureTime);
+            packet.interfaceId = entry->receiver ? settings.kafka_interfaceIdOut : settings.kafka_interfaceIdIn;
+            packet.duration = (getEventTime(store, entry->endEvent) - entry->startTime) * store->clockPeriod;
+
+            length = LA_MK3_getPacketBytes(entry, store, packetBytes);
+
+            /* Refer to the message of the same packet, as long as it is not due to be archived in full again */
+            if (NULL != cache)
+            {
+                hash = hashPacket(entry->receiver, packetBytes, length);
+                slot = &cache[hash & (DEDUP_CACHE_SLOTS - 1)];
+                if ((DEDUP_SLOT_DELIVERED == slot->state) && (slot->hash == hash) && (slot->length == length) &&
+                    (slot->receiver == entry->receiver) && (entry->startTime - slot->sentTime < resyncTicks) &&
+                    (0 == memcmp(slot->bytes, packetBytes, length)))
+                {
+                    createReferencePacket(settings, packet, slot->uuid, buffer, &msg_length);
+                    if (transport->send(transport->context, settings.kafka_topic, buffer, msg_length, NULL))
+                    {
+                        (*messageCounter)++;
+                        references++;
+                    }
+                    continue;
+                }
+            }
+
+            /* Create kafka packet from the packet data */
+            bytesToHex(packetBytes, length, packet.rawData);
+            packet.rawDataLength = 2 * (size_t)length;
+            /* The index already validated the CRCs, so only the header fields are decoded again */
+            packet.rmap = ((0 != entry->rmap) && decodeRmapHeader(packetBytes, length, &rmapHeader)) ? &rmapHeader : NULL;
+            rmapHeader.flags = entry->rmap;
+            createCapturePacket(settings, packet, buffer, &msg_length, uuid);
+
+            /* Cache the packet before sending, as the delivery may be reported during the send */
+            cached = (NULL != cache) && (DEDUP_SLOT_PENDING != slot->state) && (DEDUP_MAX_LENGTH >= length);
+            if (cached && (slot->capacity < length))
+            {
+                bytes = realloc(slot->bytes, length);
+                cached = (NULL != bytes);
+                if (cached)
+                {
+                    slot->bytes = bytes;
+                    slot->capacity = length;
+                }
+            }
+            if (cached)
+            {
+                slot->hash = hash;
+                slot->sentTime = entry->startTime;
+                slot->length = length;
+                slot->receiver = entry->receiver;
+                slot->state = DEDUP_SLOT_PENDING;
+                memcpy(slot->bytes, packetBytes, length);
+                memcpy(slot->uuid, uuid, sizeof(slot->uuid));
+            }
+
+            if (transport->send(transport->context, settings.kafka_topic, buffer, msg_length, cached ? slot : NULL))
+            {
+                (*messageCounter)++;
+            }
+            else if (cached)
+            {
+                /* No delivery is reported for a message which has not been sent */
+                slot->state = DEDUP_SLOT_EMPTY;
+            }
+        }
     }
-    /* Print Timecode directly to hexdump */
-    else if (STAR_LA_TRAFFIC_TYPE_TIMECODE == event.type)
+
+    metricsSetGauge(METRIC_GAUGE_DECODER_BACKLOG, 0);
+    if (NULL != cache)
     {
-        /* Ignore Timecodes
-        char timestampStr[30];
-        LA_MK3_getPacketTimestamp(deltaToTrigger, triggerTime, timestampStr);
-        fprintf(stdout, "\n%s %s\n", packet->interfaceId, timestampStr);
-        fprintf(stdout, "%02x\n", 0, event.data);
-        */
+        statsAdd(STATS_MESSAGES_REFERENCED, references);
+        fprintf(stderr, "Archived %u repeated packets as references\n", references);
     }
-    else
+
+    /* Ignore delivery reports of messages still in flight */
+    transport->cache = NULL;
+    for (i = 0; (NULL != cache) && (i < DEDUP_CACHE_SLOTS); i++)
     {
-        //fprintf(stderr, "\nUnexpected Event Type: %s\n", GetEventTypeString(event.type));
+        free(cache[i].bytes);
     }
 
-    return packetBytes;
+    /* Free memory */
+    free(packet.rawData);
+    free(packetBytes);
+    free(cache);
+
+    return 1;
 }
 
-int32_t LA_MK3_archiveCapturedPackets(Settings settings, STAR_LA_MK3_Traffic *pTraffic, const U32 *trafficCount, const double *charCaptureClockPeriod, struct timespec *triggerTime, const int preTrigger)
+int32_t LA_MK3_archiveCapturedPackets(Settings settings, const EventStore *store, PacketIndex *index, struct timespec *triggerTime)
 {
 	rd_kafka_t* producer; /* Producer instance handle */
 	rd_kafka_conf_t* conf; /* Temporary configuration object */
 	char errstr[512]; /* librdkafka API error reporting buffer */
 	const char* brokers = "RMC-070402DL"; /* Argument: broker list */
 
-    /* Buffer for kafka messages */
-    uint8_t buffer[BUF_SIZE];
-    /* Length of kafka message */
-    int32_t msg_length = BUF_SIZE;
-    /* Loop counter */
-    U32 i = 0;
     /* kafka message counter */
     uint32_t messageCounter = 0;
     /* Return value */
     int32_t ret = 1;
-
-    /* Time difference of the current traffic event to the trigger in seconds */
-    double deltaToTrigger = 0.0;
-
-    /* Struct collecting packet data received on receiver A */
-    PacketInfo receiverA;
-    receiverA.interfaceId = settings.kafka_interfaceIdIn;
-    FILE *packetA = open_memstream(&receiverA.rawData, &receiverA.rawDataLength);
-
-    /* Struct collecting packet data received on receiver B */
-    PacketInfo receiverB;
-    receiverB.interfaceId = settings.kafka_interfaceIdOut;
-    FILE *packetB = open_memstream(&receiverB.rawData, &receiverB.rawDataLength);
+    /* Transport delivering the messages to the kafka producer */
+    ArchiveTransport transport;
 
     fputs("\nArchiving packets via kafka messaging system...\n", stderr);
 
@@ -203,6 +457,8 @@ int32_t LA_MK3_archiveCapturedPackets(Settings settings, STAR_LA_MK3_Traffic *pT
 	 * The callback is only triggered from rd_kafka_poll() and
 	 * rd_kafka_flush(). */
     rd_kafka_conf_set_dr_msg_cb(conf, dr_msg_cb);
+    /* The delivery reports are passed on to the transport for the deduplication */
+    rd_kafka_conf_set_opaque(conf, &transport);
 
     /*
 	 * Create producer instance.
@@ -220,52 +476,31 @@ int32_t LA_MK3_archiveCapturedPackets(Settings settings, STAR_LA_MK3_Traffic *pT
     /* Configuration object is now owned, and freed, by the rd_kafka_t instance. */
     conf = NULL;
 
-    for (i = 0; i < *trafficCount; i++)
+    transport.send = sendKafkaMessage;
+    transport.context = producer;
+    transport.cache = NULL;
+    statsStartPhase(STATS_PHASE_ARCHIVE);
+    if (!LA_MK3_serializeCapturedPackets(settings, store, index, triggerTime, &transport, &messageCounter))
     {
-        deltaToTrigger = pTraffic[i].time * *charCaptureClockPeriod;
-        /* Print packets, starting at set pre trigger duration */
-        if (-preTrigger <= (deltaToTrigger * 1000.0))
-        {
-            /* Create kafka packet for receiver A, if complete */
-            if (0 != LA_MK3_assembleDataPacket(packetA, &receiverA, pTraffic[i].linkAEvent, &deltaToTrigger, triggerTime))
-            {
-                fclose(packetA);
-                createCapturePacket(settings, receiverA, buffer, &msg_length);
-                sendKafkaMessage(producer, settings.kafka_topic, buffer, msg_length, &messageCounter);
-                free(receiverA.rawData);
-                packetA = open_memstream(&receiverA.rawData, &receiverA.rawDataLength);
-            }
-
-            /* Create kafka packet for receiver B, if complete */
-            if (0 != LA_MK3_assembleDataPacket(packetB, &receiverB, pTraffic[i].linkBEvent, &deltaToTrigger, triggerTime))
-            {
-                fclose(packetB);
-                createCapturePacket(settings, receiverB, buffer, &msg_length);
-                sendKafkaMessage(producer, settings.kafka_topic, buffer, msg_length, &messageCounter);
-                free(receiverB.rawData);
-                packetB = open_memstream(&receiverB.rawData, &receiverB.rawDataLength);
-            }
-        }
+        rd_kafka_destroy(producer);
+        return 0;
     }
-
-    /* Close files */
-    fclose(packetA);
-    fclose(packetB);
-
-    /* Free memory */
-    free(receiverA.rawData);
-    free(receiverB.rawData);
+    statsStopPhase(STATS_PHASE_ARCHIVE);
 
     /* Wait for final messages to be delivered or fail.
 	 * rd_kafka_flush() is an abstraction over rd_kafka_poll() which
 	 * waits for all messages to be delivered. */
 	fprintf(stderr, "Delivered %u messages\nFlushing final messages...\n", messageCounter);
+	statsStartPhase(STATS_PHASE_FLUSH);
 	rd_kafka_flush(producer, 10 * 1000 /* wait for max 10 seconds */);
+	statsStopPhase(STATS_PHASE_FLUSH);
+	metricsSetGauge(METRIC_GAUGE_KAFKA_QUEUE, rd_kafka_outq_len(producer));
 
 	/* If the output queue is still not empty there is an issue
 	 * with producing messages to the clusters. */
 	if(rd_kafka_outq_len(producer) > 0) {
 		fprintf(stderr, "%% %d message(s) were not delivered\n", rd_kafka_outq_len(producer));
+        statsAdd(STATS_MESSAGES_UNDELIVERED, (unsigned long long)rd_kafka_outq_len(producer));
         ret = 0;
     } else {
         ret = 1;
@@ -275,4 +510,4 @@ int32_t LA_MK3_archiveCapturedPackets(Settings settings, STAR_LA_MK3_Traffic *pT
 	rd_kafka_destroy(producer);
 
     return ret;
-}
\ No newline at end of file
+}
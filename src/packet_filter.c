@@ -0,0 +1,506 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <spw_la_api.h>
+#include "event_store.h"
+#include "event_scan.h"
+#include "packet_index.h"
+#include "packet_filter.h"
+#include "rmap.h"
+
+/* Maximum length of a single token of the expression */
+#define FILTER_MAX_TOKEN 128
+
+/* State of compiling an expression */
+struct filterParser
+{
+    const char *position;           /* Position behind the current token */
+    char token[FILTER_MAX_TOKEN];   /* The current token ("" at the end of the expression) */
+    PacketFilter *filter;           /* The filter being compiled */
+    U32 depth;                      /* Depth of the evaluation stack after the instructions emitted so far */
+    int failed;                     /* The expression is invalid */
+};
+
+static void nextToken(struct filterParser *parser)
+{
+    /* Length of the token */
+    size_t length = 0;
+    /* The expression at the current position */
+    const char *text = parser->position;
+
+    while (isspace((unsigned char)*text))
+    {
+        text++;
+    }
+    if (('(' == *text) || (')' == *text) || ('!' == *text))
+    {
+        length = 1;
+    }
+    else if ((0 == strncmp(text, "&&", 2)) || (0 == strncmp(text, "||", 2)))
+    {
+        length = 2;
+    }
+    else
+    {
+        while (('\0' != text[length]) && !isspace((unsigned char)text[length]) && (NULL == strchr("()!&|", text[length])))
+        {
+            length++;
+        }
+    }
+
+    if (FILTER_MAX_TOKEN <= length)
+    {
+        fprintf(stderr, "\nFilter term too long at '%.20s...'\n", text);
+        parser->failed = 1;
+        length = 0;
+    }
+    memcpy(parser->token, text, length);
+    parser->token[length] = '\0';
+    parser->position = text + length;
+
+    return;
+}
+
+static int isToken(const struct filterParser *parser, const char *word, const char *symbol)
+{
+    return (0 == strcmp(parser->token, word)) || ((NULL != symbol) && (0 == strcmp(parser->token, symbol)));
+}
+
+static void emitInstruction(struct filterParser *parser, U8 op, U8 value, U8 mask, U16 offset, U32 min, U32 max)
+{
+    /* The emitted instruction */
+    struct filterInstruction *instruction = NULL;
+
+    if (parser->failed)
+    {
+        return;
+    }
+    if (FILTER_MAX_INSTRUCTIONS == parser->filter->length)
+    {
+        fprintf(stderr, "\nFilter has more than %d terms and operators\n", FILTER_MAX_INSTRUCTIONS);
+        parser->failed = 1;
+        return;
+    }
+
+    /* Terms push a value, binary operators pop one */
+    if ((FILTER_OP_AND == op) || (FILTER_OP_OR == op))
+    {
+        parser->depth--;
+    }
+    else if (FILTER_OP_NOT != op)
+    {
+        parser->depth++;
+    }
+    if (FILTER_MAX_DEPTH < parser->depth)
+    {
+        fputs("\nFilter is nested too deeply\n", stderr);
+        parser->failed = 1;
+        return;
+    }
+
+    instruction = &parser->filter->program[parser->filter->length++];
+    instruction->op = op;
+    instruction->value = value;
+    instruction->mask = mask;
+    instruction->offset = offset;
+    instruction->min = min;
+    instruction->max = max;
+
+    return;
+}
+
+static int parseNumber(const char *text, const char *end, unsigned long maximum, unsigned long *value)
+{
+    /* First character not parsed */
+    char *parsed = NULL;
+
+    if ((text == end) || isspace((unsigned char)*text) || ('-' == *text))
+    {
+        return 0;
+    }
+    *value = strtoul(text, &parsed, 0);
+
+    return (parsed == end) && (*value <= maximum);
+}
+
+static int parseInspectedBytes(struct filterParser *parser, unsigned long offset, unsigned long count)
+{
+    if (FILTER_MAX_BYTES < offset + count)
+    {
+        fprintf(stderr, "\nFilter can only inspect the first %d bytes of a packet\n", FILTER_MAX_BYTES);
+        parser->failed = 1;
+        return 0;
+    }
+    if (parser->filter->byteCount < offset + count)
+    {
+        parser->filter->byteCount = (U32)(offset + count);
+    }
+
+    return 1;
+}
+
+static int parseLength(struct filterParser *parser, const char *arg)
+{
+    /* Separator of the range */
+    const char *dash = strchr(arg, '-');
+    /* Bounds of the range */
+    unsigned long min = 0;
+    unsigned long max = 0xFFFFFFFFUL;
+
+    if (NULL == dash)
+    {
+        if (!parseNumber(arg, arg + strlen(arg), 0xFFFFFFFFUL, &min))
+        {
+            return 0;
+        }
+        max = min;
+    }
+    else if (((dash != arg) && !parseNumber(arg, dash, 0xFFFFFFFFUL, &min)) ||
+             (('\0' != dash[1]) && !parseNumber(dash + 1, dash + 1 + strlen(dash + 1), 0xFFFFFFFFUL, &max)) ||
+             ((dash == arg) && ('\0' == dash[1])))
+    {
+        return 0;
+    }
+    emitInstruction(parser, FILTER_OP_LENGTH, 0, 0, 0, (U32)min, (U32)max);
+
+    return 1;
+}
+
+static int parseByte(struct filterParser *parser, const char *arg)
+{
+    /* Separators of offset, value and mask */
+    const char *equals = strchr(arg, '=');
+    const char *slash = strchr(arg, '/');
+    /* The parsed numbers */
+    unsigned long offset = 0;
+    unsigned long value = 0;
+    unsigned long mask = 0xFF;
+
+    if ((NULL == equals) || !parseNumber(arg, equals, FILTER_MAX_BYTES - 1, &offset) ||
+        !parseNumber(equals + 1, (NULL != slash) ? slash : equals + 1 + strlen(equals + 1), 0xFF, &value) ||
+        ((NULL != slash) && !parseNumber(slash + 1, slash + 1 + strlen(slash + 1), 0xFF, &mask)) ||
+        !parseInspectedBytes(parser, offset, 1))
+    {
+        return 0;
+    }
+    emitInstruction(parser, FILTER_OP_BYTE, (U8)(value & mask), (U8)mask, (U16)offset, 0, 0);
+
+    return 1;
+}
+
+static int parsePattern(struct filterParser *parser, const char *arg)
+{
+    /* Loop counter */
+    size_t i = 0;
+    /* Separator of offset and pattern */
+    const char *equals = strchr(arg, '=');
+    /* Hex digits of the pattern */
+    const char *hex = (NULL != equals) ? equals + 1 : "";
+    /* Number of pattern bytes */
+    size_t count = strlen(hex) / 2;
+    /* The parsed offset */
+    unsigned long offset = 0;
+    /* A single hex digit pair */
+    char pair[3] = { 0 };
+    /* The pattern bytes */
+    U8 *pattern = parser->filter->patterns + parser->filter->patternLength;
+
+    if ((NULL == equals) || (0 == count) || (0 != strlen(hex) % 2) ||
+        !parseNumber(arg, equals, FILTER_MAX_BYTES - 1, &offset) || !parseInspectedBytes(parser, offset, count))
+    {
+        return 0;
+    }
+    if (FILTER_MAX_BYTES < parser->filter->patternLength + count)
+    {
+        fprintf(stderr, "\nFilter patterns exceed %d bytes\n", FILTER_MAX_BYTES);
+        parser->failed = 1;
+        return 0;
+    }
+    for (i = 0; i < count; i++)
+    {
+        if (!isxdigit((unsigned char)hex[2 * i]) || !isxdigit((unsigned char)hex[2 * i + 1]))
+        {
+            return 0;
+        }
+        pair[0] = hex[2 * i];
+        pair[1] = hex[2 * i + 1];
+        pattern[i] = (U8)strtoul(pair, NULL, 16);
+    }
+    emitInstruction(parser, FILTER_OP_PATTERN, 0, 0, (U16)offset, parser->filter->patternLength, (U32)count);
+    parser->filter->patternLength += (U32)count;
+
+    return 1;
+}
+
+static void parseTerm(struct filterParser *parser)
+{
+    /* Keyword of the term */
+    char keyword[FILTER_MAX_TOKEN];
+    /* Argument of the term */
+    const char *arg = parser->token;
+    /* The parsed value */
+    unsigned long value = 0;
+    /* The argument is valid */
+    int valid = 1;
+
+    strcpy(keyword, parser->token);
+    if (isToken(parser, "eop", NULL) || isToken(parser, "eep", NULL) || isToken(parser, "incomplete", NULL) || isToken(parser, "timecode", NULL))
+    {
+        value = isToken(parser, "eop", NULL) ? PACKET_TERM_EOP : isToken(parser, "eep", NULL) ? PACKET_TERM_EEP :
+                isToken(parser, "incomplete", NULL) ? PACKET_TERM_INCOMPLETE : PACKET_TERM_TIMECODE;
+        emitInstruction(parser, FILTER_OP_TERM, (U8)(1u << value), 0, 0, 0, 0);
+    }
+    else if (isToken(parser, "error", NULL))
+    {
+        emitInstruction(parser, FILTER_OP_ERROR, 0, 0, 0, 0, 0);
+    }
+    else if (isToken(parser, "rmap", NULL))
+    {
+        emitInstruction(parser, FILTER_OP_RMAP, RMAP_FLAG_PACKET, RMAP_FLAG_PACKET, 0, 0, 0);
+    }
+    else if (isToken(parser, "command", NULL) || isToken(parser, "reply", NULL))
+    {
+        value = RMAP_FLAG_PACKET | (isToken(parser, "command", NULL) ? RMAP_FLAG_COMMAND : 0);
+        emitInstruction(parser, FILTER_OP_RMAP, (U8)value, RMAP_FLAG_PACKET | RMAP_FLAG_COMMAND, 0, 0, 0);
+    }
+    else if (isToken(parser, "crcerror", NULL))
+    {
+        /* The flags are only set for RMAP packets */
+        emitInstruction(parser, FILTER_OP_RMAP, RMAP_FLAG_HEADER_CRC, RMAP_FLAG_HEADER_CRC, 0, 0, 0);
+        emitInstruction(parser, FILTER_OP_RMAP, RMAP_FLAG_DATA_CRC, RMAP_FLAG_DATA_CRC, 0, 0, 0);
+        emitInstruction(parser, FILTER_OP_OR, 0, 0, 0, 0, 0);
+    }
+    else if (isToken(parser, "recv", NULL) || isToken(parser, "len", NULL) || isToken(parser, "addr", NULL) ||
+             isToken(parser, "proto", NULL) || isToken(parser, "byte", NULL) || isToken(parser, "at", NULL) ||
+             isToken(parser, "tid", NULL))
+    {
+        nextToken(parser);
+        if (0 == strcmp(keyword, "recv"))
+        {
+            valid = (0 == strcasecmp(arg, "a")) || (0 == strcasecmp(arg, "b"));
+            emitInstruction(parser, FILTER_OP_RECV, (U8)((0 == strcasecmp(arg, "a")) ? RECV_A : RECV_B), 0, 0, 0, 0);
+        }
+        else if (0 == strcmp(keyword, "len"))
+        {
+            valid = parseLength(parser, arg);
+        }
+        else if ((0 == strcmp(keyword, "addr")) || (0 == strcmp(keyword, "proto")))
+        {
+            valid = parseNumber(arg, arg + strlen(arg), 0xFF, &value) && parseInspectedBytes(parser, ('a' == keyword[0]) ? 0 : 1, 1);
+            emitInstruction(parser, FILTER_OP_BYTE, (U8)value, 0xFF, ('a' == keyword[0]) ? 0 : 1, 0, 0);
+        }
+        else if (0 == strcmp(keyword, "byte"))
+        {
+            valid = parseByte(parser, arg);
+        }
+        else if (0 == strcmp(keyword, "tid"))
+        {
+            /* The transaction ID is decoded from the gathered header */
+            valid = parseNumber(arg, arg + strlen(arg), 0xFFFF, &value) && parseInspectedBytes(parser, 0, RMAP_MAX_HEADER);
+            emitInstruction(parser, FILTER_OP_TID, 0, 0, 0, (U32)value, 0);
+        }
+        else
+        {
+            valid = parsePattern(parser, arg);
+        }
+        if (!valid && !parser->failed)
+        {
+            fprintf(stderr, "\nInvalid argument '%s' of filter term '%s'\n", arg, keyword);
+            parser->failed = 1;
+        }
+    }
+    else if (!parser->failed && ('\0' == keyword[0]))
+    {
+        fputs("\nFilter ends unexpectedly\n", stderr);
+        parser->failed = 1;
+    }
+    else if (!parser->failed)
+    {
+        fprintf(stderr, "\nUnknown filter term '%s'\n", keyword);
+        parser->failed = 1;
+    }
+    nextToken(parser);
+
+    return;
+}
+
+static void parseOr(struct filterParser *parser);
+
+static void parseUnary(struct filterParser *parser)
+{
+    if (parser->failed)
+    {
+        return;
+    }
+    if (isToken(parser, "not", "!"))
+    {
+        nextToken(parser);
+        parseUnary(parser);
+        emitInstruction(parser, FILTER_OP_NOT, 0, 0, 0, 0, 0);
+    }
+    else if (isToken(parser, "(", NULL))
+    {
+        nextToken(parser);
+        parseOr(parser);
+        if (!parser->failed && !isToken(parser, ")", NULL))
+        {
+            fputs("\nMissing ')' in filter\n", stderr);
+            parser->failed = 1;
+        }
+        nextToken(parser);
+    }
+    else
+    {
+        parseTerm(parser);
+    }
+
+    return;
+}
+
+static void parseAnd(struct filterParser *parser)
+{
+    parseUnary(parser);
+    while (!parser->failed && isToken(parser, "and", "&&"))
+    {
+        nextToken(parser);
+        parseUnary(parser);
+        emitInstruction(parser, FILTER_OP_AND, 0, 0, 0, 0, 0);
+    }
+
+    return;
+}
+
+static void parseOr(struct filterParser *parser)
+{
+    parseAnd(parser);
+    while (!parser->failed && isToken(parser, "or", "||"))
+    {
+        nextToken(parser);
+        parseAnd(parser);
+        emitInstruction(parser, FILTER_OP_OR, 0, 0, 0, 0, 0);
+    }
+
+    return;
+}
+
+PacketFilter *compilePacketFilter(const char *expression)
+{
+    /* State of compiling the expression */
+    struct filterParser parser;
+
+    parser.position = expression;
+    parser.depth = 0;
+    parser.failed = 0;
+    parser.filter = calloc(1, sizeof(PacketFilter));
+    if (NULL == parser.filter)
+    {
+        fputs("Unable to allocate memory for the packet filter\n", stderr);
+        return NULL;
+    }
+
+    nextToken(&parser);
+    parseOr(&parser);
+    if (!parser.failed && ('\0' != parser.token[0]))
+    {
+        fprintf(stderr, "\nUnexpected '%s' in filter\n", parser.token);
+        parser.failed = 1;
+    }
+    if (parser.failed)
+    {
+        free(parser.filter);
+        parser.filter = NULL;
+    }
+
+    return parser.filter;
+}
+
+int matchPacketFilter(const PacketFilter *filter, const PacketEntry *entry, const EventStore *store)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* The current instruction */
+    const struct filterInstruction *instruction = NULL;
+    /* Leading bytes of the packet */
+    U8 bytes[FILTER_MAX_BYTES];
+    /* Number of leading bytes gathered */
+    U32 length = 0;
+    /* RMAP header of the packet */
+    RmapHeader rmapHeader;
+    /* Evaluation stack */
+    U8 stack[FILTER_MAX_DEPTH];
+    /* Number of values on the stack */
+    U32 top = 0;
+
+    /* Gather only the bytes the program inspects */
+    if (0 < filter->byteCount)
+    {
+        if (PACKET_TERM_TIMECODE == entry->termination)
+        {
+            bytes[0] = store->data[entry->receiver][entry->startEvent];
+            length = 1;
+        }
+        else
+        {
+            length = gatherPacketData(store->types[entry->receiver], store->data[entry->receiver],
+                                      entry->startEvent, entry->endEvent + 1, bytes, filter->byteCount);
+        }
+    }
+
+    for (i = 0; i < filter->length; i++)
+    {
+        instruction = &filter->program[i];
+        switch (instruction->op)
+        {
+        case FILTER_OP_RECV:
+            stack[top++] = (entry->receiver == instruction->value);
+            break;
+        case FILTER_OP_TERM:
+            stack[top++] = (0 != ((1u << entry->termination) & instruction->value));
+            break;
+        case FILTER_OP_ERROR:
+            stack[top++] = (0 != entry->errors);
+            break;
+        case FILTER_OP_LENGTH:
+            stack[top++] = (instruction->min <= entry->length) && (entry->length <= instruction->max);
+            break;
+        case FILTER_OP_BYTE:
+            stack[top++] = (instruction->offset < length) && (instruction->value == (bytes[instruction->offset] & instruction->mask));
+            break;
+        case FILTER_OP_PATTERN:
+            stack[top++] = (instruction->offset + instruction->max <= length) &&
+                           (0 == memcmp(bytes + instruction->offset, filter->patterns + instruction->min, instruction->max));
+            break;
+        case FILTER_OP_RMAP:
+            stack[top++] = (instruction->value == (entry->rmap & instruction->mask));
+            break;
+        case FILTER_OP_TID:
+            stack[top++] = (0 != entry->rmap) && decodeRmapHeader(bytes, length, &rmapHeader) &&
+                           (instruction->min == rmapHeader.transactionId);
+            break;
+        case FILTER_OP_NOT:
+            stack[top - 1] = !stack[top - 1];
+            break;
+        case FILTER_OP_AND:
+            top--;
+            stack[top - 1] = stack[top - 1] && stack[top];
+            break;
+        case FILTER_OP_OR:
+            top--;
+            stack[top - 1] = stack[top - 1] || stack[top];
+            break;
+        default:
+            break;
+        }
+    }
+
+    return stack[0];
+}
+
+void freePacketFilter(PacketFilter *filter)
+{
+    free(filter);
+
+    return;
+}
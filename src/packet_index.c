@@ -0,0 +1,470 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <spw_la_api.h>
+#include "event_store.h"
+#include "event_scan.h"
+#include "packet_index.h"
+#include "packet_filter.h"
+#include "rmap.h"
+
+/* State of the packet currently assembled on a single receiver */
+struct openPacket
+{
+    U32 length;             /* Number of bytes received so far (0 = no open packet) */
+    U32 startEvent;         /* Index of the header event */
+    long long startTime;    /* Capture clock tick of the header event */
+    U8  errors;             /* Error flags collected so far */
+};
+
+static U8 getPacketErrors(U8 type, U8 eventErrors)
+{
+    /* Error flags of the event */
+    U8 errors = 0;
+
+    if (STAR_LA_MK3_ParityError(eventErrors))
+    {
+        errors |= PACKET_ERROR_PARITY;
+    }
+    if (STAR_LA_MK3_ReceiverCreditError(eventErrors))
+    {
+        errors |= PACKET_ERROR_RX_CREDIT;
+    }
+    if (STAR_LA_MK3_TransmitterCreditError(eventErrors))
+    {
+        errors |= PACKET_ERROR_TX_CREDIT;
+    }
+
+    switch (type)
+    {
+    case STAR_LA_TRAFFIC_TYPE_DATA_SEQ_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_EOP_SEQ_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_EEP_SEQ_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_TIMECODE_SEQ_ERROR:
+        errors |= PACKET_ERROR_SEQUENCE;
+        break;
+    case STAR_LA_TRAFFIC_TYPE_PARITY_ERROR:
+        errors |= PACKET_ERROR_PARITY;
+        break;
+    case STAR_LA_TRAFFIC_TYPE_ESCAPE_ESCAPE_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_ESCAPE_EOP_ERROR:
+    case STAR_LA_TRAFFIC_TYPE_ESCAPE_EEP_ERROR:
+        errors |= PACKET_ERROR_ESCAPE;
+        break;
+    case STAR_LA_TRAFFIC_TYPE_DISCONNECT_ERROR:
+        errors |= PACKET_ERROR_DISCONNECT;
+        break;
+    default:
+        break;
+    }
+
+    return errors;
+}
+
+static int appendEntry(PacketIndex *index, const struct openPacket *packet, U32 endEvent, U8 receiver, U8 termination,
+                       const EventStore *store, const PacketFilter *filter)
+{
+    /* Reallocated entries */
+    PacketEntry *entries = NULL;
+    /* The appended entry */
+    PacketEntry *entry = NULL;
+    /* The entry to append */
+    PacketEntry candidate;
+    /* RMAP header of the entry */
+    RmapHeader rmapHeader;
+
+    candidate.startTime = packet->startTime;
+    candidate.startEvent = packet->startEvent;
+    candidate.endEvent = endEvent;
+    candidate.length = packet->length;
+    candidate.receiver = receiver;
+    candidate.termination = termination;
+    candidate.errors = packet->errors;
+    candidate.rmap = LA_MK3_decodeRmapPacket(&candidate, store, &rmapHeader);
+
+    /* Drop filtered out packets before anything else is done with them */
+    if ((NULL != filter) && !matchPacketFilter(filter, &candidate, store))
+    {
+        index->filteredCount++;
+        return 1;
+    }
+
+    if (index->count == index->capacity)
+    {
+        entries = realloc(index->entries, 2 * index->capacity * sizeof(PacketEntry));
+        if (NULL == entries)
+        {
+            fputs("Unable to allocate memory for the packet index\n", stderr);
+            return 0;
+        }
+        index->entries = entries;
+        index->capacity *= 2;
+    }
+
+    entry = &index->entries[index->count++];
+    *entry = candidate;
+
+    if (PACKET_TERM_TIMECODE == termination)
+    {
+        index->timecodeCount[receiver]++;
+    }
+    else
+    {
+        index->packetCount[receiver]++;
+        index->byteCount[receiver] += packet->length;
+        if (index->maxLength < packet->length)
+        {
+            index->maxLength = packet->length;
+        }
+        if (candidate.rmap & RMAP_FLAG_COMMAND)
+        {
+            index->rmapCommandCount++;
+        }
+        else if (candidate.rmap & RMAP_FLAG_PACKET)
+        {
+            index->rmapReplyCount++;
+        }
+        if (candidate.rmap & (RMAP_FLAG_HEADER_CRC | RMAP_FLAG_DATA_CRC))
+        {
+            index->rmapCrcErrorCount++;
+        }
+    }
+
+    return 1;
+}
+
+static int initIndex(PacketIndex *index)
+{
+    index->count = 0;
+    index->capacity = INDEX_INITIAL_ENTRIES;
+    index->maxLength = 0;
+    index->packetCount[RECV_A] = index->packetCount[RECV_B] = 0;
+    index->timecodeCount[RECV_A] = index->timecodeCount[RECV_B] = 0;
+    index->byteCount[RECV_A] = index->byteCount[RECV_B] = 0;
+    index->filteredCount = 0;
+    index->rmapCommandCount = index->rmapReplyCount = index->rmapCrcErrorCount = 0;
+    index->entries = malloc(index->capacity * sizeof(PacketEntry));
+    if (NULL == index->entries)
+    {
+        fputs("Unable to allocate memory for the packet index\n", stderr);
+        return 0;
+    }
+
+    return 1;
+}
+
+static U8 getRangeErrors(const EventStore *store, U32 start, U32 end, U8 receiver)
+{
+    /* Error flags of the events within the range */
+    U8 errors = 0;
+    /* Bounds for the binary search in the error list */
+    U32 low = 0;
+    U32 high = store->errorCount;
+    U32 mid = 0;
+
+    /* Find first event with error flags within the range */
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (store->errors[mid].event < start)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    /* Time-codes within the packet keep their errors for themselves */
+    for (; (low < store->errorCount) && (store->errors[low].event <= end); low++)
+    {
+        if (STAR_LA_TRAFFIC_TYPE_TIMECODE != store->types[receiver][store->errors[low].event])
+        {
+            errors |= getPacketErrors(STAR_LA_TRAFFIC_TYPE_NULL, store->errors[low].errors[receiver]);
+        }
+    }
+
+    return errors;
+}
+
+static U32 getFirstEventInWindow(const EventStore *store, const int preTrigger)
+{
+    /* Bounds for the binary search in the time checkpoints */
+    U32 low = 0;
+    U32 high = (store->count + STORE_CHECKPOINT_INTERVAL - 1) / STORE_CHECKPOINT_INTERVAL;
+    U32 mid = 0;
+    /* Loop counter */
+    U32 i = 0;
+    /* Capture clock tick of the current event */
+    long long time = 0;
+
+    /* Find the last checkpoint before the window */
+    while (low + 1 < high)
+    {
+        mid = low + (high - low) / 2;
+        if (-preTrigger <= (store->checkpoints[mid] * store->clockPeriod * 1000.0))
+        {
+            high = mid;
+        }
+        else
+        {
+            low = mid;
+        }
+    }
+
+    /* Find the first event within the window */
+    for (i = low * STORE_CHECKPOINT_INTERVAL; i < store->count; i++)
+    {
+        time = getNextEventTime(store, i, time);
+        if (-preTrigger <= (time * store->clockPeriod * 1000.0))
+        {
+            break;
+        }
+    }
+
+    return i;
+}
+
+static int indexReceiver(PacketIndex *index, struct openPacket *packet, const EventStore *store, U32 first, U8 receiver,
+                         const PacketFilter *filter)
+{
+    /* Return value */
+    int ret = 1;
+    /* Loop counter */
+    U32 i = first;
+    /* Event with known capture clock tick */
+    U32 timeEvent = first;
+    /* Capture clock tick of that event */
+    long long time = (first < store->count) ? getEventTime(store, first) : 0;
+    /* Event types on the receiver */
+    const U8 *types = store->types[receiver];
+    /* Time-code record */
+    struct openPacket timecode;
+
+    packet->length = 0;
+    packet->errors = 0;
+
+    while (ret && (i < store->count))
+    {
+        if (0 == packet->length)
+        {
+            /* Skip to the next header or time-code */
+            i = scanPacketStart(types, i, store->count);
+        }
+        else
+        {
+            /* Skip the data and idle events of the open packet */
+            i = scanPacketData(types, i, store->count, &packet->length);
+        }
+        if (i >= store->count)
+        {
+            break;
+        }
+
+        if (STAR_LA_TRAFFIC_TYPE_TIMECODE == types[i])
+        {
+            /* Index time-codes as single byte records */
+            time = advanceEventTime(store, timeEvent, time, i);
+            timeEvent = i;
+            timecode.length = 1;
+            timecode.startEvent = i;
+            timecode.startTime = time;
+            timecode.errors = getPacketErrors(types[i], getEventErrors(store, i, receiver));
+            ret = appendEntry(index, &timecode, i, receiver, PACKET_TERM_TIMECODE, store, filter);
+        }
+        else if (0 == packet->length)
+        {
+            /* Start new packet at the header */
+            time = advanceEventTime(store, timeEvent, time, i);
+            timeEvent = i;
+            packet->length = 1;
+            packet->startEvent = i;
+            packet->startTime = time;
+            packet->errors = 0;
+        }
+        else if ((STAR_LA_TRAFFIC_TYPE_EOP == types[i]) || (STAR_LA_TRAFFIC_TYPE_EEP == types[i]))
+        {
+            /* End packet and collect the errors of all its events */
+            packet->errors |= getRangeErrors(store, packet->startEvent, i, receiver);
+            ret = appendEntry(index, packet, i, receiver,
+                              (STAR_LA_TRAFFIC_TYPE_EOP == types[i]) ? PACKET_TERM_EOP : PACKET_TERM_EEP, store, filter);
+            packet->length = 0;
+        }
+        else if (STAR_LA_TRAFFIC_TYPE_HEADER == types[i])
+        {
+            /* A header within the packet is kept as a byte of it */
+            packet->length++;
+            packet->errors |= PACKET_ERROR_HEADER;
+        }
+        else
+        {
+            /* Collect error events occurring within a packet */
+            packet->errors |= getPacketErrors(types[i], 0);
+        }
+        i++;
+    }
+
+    if (0 < packet->length)
+    {
+        packet->errors |= getRangeErrors(store, packet->startEvent, store->count - 1, receiver);
+    }
+
+    return ret;
+}
+
+static int mergeEntries(PacketIndex *index, PacketIndex *receiverIndex)
+{
+    /* Positions in the indices of receiver A and B */
+    U32 a = 0;
+    U32 b = 0;
+
+    index->entries = malloc(((size_t)receiverIndex[RECV_A].count + receiverIndex[RECV_B].count + 2) * sizeof(PacketEntry));
+    if (NULL == index->entries)
+    {
+        fputs("Unable to allocate memory for the packet index\n", stderr);
+        return 0;
+    }
+    index->capacity = receiverIndex[RECV_A].count + receiverIndex[RECV_B].count + 2;
+
+    /* Merge in order of completion, receiver A first for the same event */
+    while ((a < receiverIndex[RECV_A].count) || (b < receiverIndex[RECV_B].count))
+    {
+        if ((b >= receiverIndex[RECV_B].count) ||
+            ((a < receiverIndex[RECV_A].count) && (receiverIndex[RECV_A].entries[a].endEvent <= receiverIndex[RECV_B].entries[b].endEvent)))
+        {
+            index->entries[index->count++] = receiverIndex[RECV_A].entries[a++];
+        }
+        else
+        {
+            index->entries[index->count++] = receiverIndex[RECV_B].entries[b++];
+        }
+    }
+
+    return 1;
+}
+
+int LA_MK3_buildPacketIndex(PacketIndex *index, const EventStore *store, const int preTrigger, const PacketFilter *filter)
+{
+    /* Return value */
+    int ret = 1;
+    /* Loop counter */
+    U8 receiver = 0;
+    /* First event within the pre trigger duration */
+    U32 first = getFirstEventInWindow(store, preTrigger);
+    /* Packets indexed separately per receiver */
+    PacketIndex receiverIndex[2];
+    /* Packets left open on receiver A and B */
+    struct openPacket packets[2] = { { 0 }, { 0 } };
+
+    index->count = 0;
+    index->capacity = 0;
+    index->entries = NULL;
+    index->firstEvent = first;
+    ret = initIndex(&receiverIndex[RECV_A]);
+    ret = initIndex(&receiverIndex[RECV_B]) && ret;
+
+    /* Index each receiver in a single pass over its event types */
+    for (receiver = RECV_A; ret && (receiver <= RECV_B); receiver++)
+    {
+        ret = indexReceiver(&receiverIndex[receiver], &packets[receiver], store, first, receiver, filter);
+    }
+
+    ret = ret && mergeEntries(index, receiverIndex);
+    index->filteredCount = receiverIndex[RECV_A].filteredCount + receiverIndex[RECV_B].filteredCount;
+    index->rmapCommandCount = receiverIndex[RECV_A].rmapCommandCount + receiverIndex[RECV_B].rmapCommandCount;
+    index->rmapReplyCount = receiverIndex[RECV_A].rmapReplyCount + receiverIndex[RECV_B].rmapReplyCount;
+    index->rmapCrcErrorCount = receiverIndex[RECV_A].rmapCrcErrorCount + receiverIndex[RECV_B].rmapCrcErrorCount;
+    index->maxLength = (receiverIndex[RECV_A].maxLength > receiverIndex[RECV_B].maxLength) ? receiverIndex[RECV_A].maxLength : receiverIndex[RECV_B].maxLength;
+    for (receiver = RECV_A; receiver <= RECV_B; receiver++)
+    {
+        index->packetCount[receiver] = receiverIndex[receiver].packetCount[receiver];
+        index->timecodeCount[receiver] = receiverIndex[receiver].timecodeCount[receiver];
+        index->byteCount[receiver] = receiverIndex[receiver].byteCount[receiver];
+        free(receiverIndex[receiver].entries);
+    }
+
+    /* Index incomplete packets */
+    if (ret && (0 < packets[RECV_A].length))
+    {
+        ret = appendEntry(index, &packets[RECV_A], store->count - 1, RECV_A, PACKET_TERM_INCOMPLETE, store, filter);
+    }
+    if (ret && (0 < packets[RECV_B].length))
+    {
+        ret = appendEntry(index, &packets[RECV_B], store->count - 1, RECV_B, PACKET_TERM_INCOMPLETE, store, filter);
+    }
+
+    if (ret)
+    {
+        fprintf(stderr, "Indexed %u packet(s) on receiver A and %u packet(s) on receiver B\n",
+                index->packetCount[RECV_A], index->packetCount[RECV_B]);
+        if (0 < index->rmapCommandCount + index->rmapReplyCount)
+        {
+            fprintf(stderr, "Decoded %u RMAP command(s) and %u RMAP reply(ies), %u with CRC errors\n",
+                    index->rmapCommandCount, index->rmapReplyCount, index->rmapCrcErrorCount);
+        }
+        if (NULL != filter)
+        {
+            fprintf(stderr, "Filtered out %u packet(s) and time-code(s)\n", index->filteredCount);
+        }
+    }
+
+    return ret;
+}
+
+U32 LA_MK3_getPacketBytes(const PacketEntry *entry, const EventStore *store, U8 *buffer)
+{
+    /* Event types and data on the receiver of the packet */
+    const U8 *types = store->types[entry->receiver];
+    const U8 *data = store->data[entry->receiver];
+
+    /* Time-codes consist of the data of a single event */
+    if (PACKET_TERM_TIMECODE == entry->termination)
+    {
+        buffer[0] = data[entry->startEvent];
+        return 1;
+    }
+
+    return gatherPacketData(types, data, entry->startEvent, entry->endEvent + 1, buffer, entry->length);
+}
+
+U32 LA_MK3_getHexdumpBytes(const PacketEntry *entry, const EventStore *store, U8 *buffer)
+{
+    /* Event types on the receiver of the packet */
+    const U8 *types = store->types[entry->receiver];
+    /* Loop counter */
+    U32 i = 0;
+    /* Number of gathered bytes */
+    U32 length = LA_MK3_getPacketBytes(entry, store, buffer);
+    /* Read and write positions in the buffer, behind the first header */
+    U32 position = 1;
+    U32 kept = 1;
+
+    if (!(entry->errors & PACKET_ERROR_HEADER) || (PACKET_TERM_TIMECODE == entry->termination))
+    {
+        return length;
+    }
+    /* Move the data bytes over the headers following the first one */
+    for (i = entry->startEvent + 1; (i <= entry->endEvent) && (position < length); i++)
+    {
+        if (STAR_LA_TRAFFIC_TYPE_DATA == types[i])
+        {
+            buffer[kept++] = buffer[position++];
+        }
+        else if (STAR_LA_TRAFFIC_TYPE_HEADER == types[i])
+        {
+            position++;
+        }
+    }
+
+    return kept;
+}
+
+void freePacketIndex(PacketIndex *index)
+{
+    free(index->entries);
+    index->entries = NULL;
+    index->count = 0;
+    index->capacity = 0;
+
+    return;
+}
@@ -0,0 +1,403 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <time.h>
+#include <pthread.h>
+#include <spw_la_api.h>
+#include "arg_parser.h"
+#include "event_store.h"
+#include "event_scan.h"
+#include "packet_index.h"
+#include "data_logger.h"
+#include "packet_search.h"
+
+/* Names of the packet terminations as printed with the matches */
+static const char *const terminationNames[] = { "EOP", "EEP", "incomplete", "timecode" };
+
+/* Packets searched by a single thread */
+struct searchJob
+{
+    const EventStore *store;        /* The recorded events */
+    const PacketIndex *index;       /* The packet index */
+    const SearchPatterns *patterns; /* The compiled patterns */
+    U32 first;                      /* Index of the first packet to search */
+    U32 last;                       /* Index following the last packet to search */
+    U8  *buffer;                    /* Buffer for gathering the bytes of a packet */
+    SearchMatch *matches;           /* Matches found by the thread */
+    U32 count;                      /* Number of matches */
+    U32 capacity;                   /* Number of allocated matches */
+    unsigned long long searched;    /* Number of packet bytes searched */
+    int failed;                     /* Memory for the matches could not be allocated */
+};
+
+static int parseHex(const char **position, U8 *bytes, U8 *count)
+{
+    /* Current position in the specification */
+    const char *text = *position;
+    /* A single hex digit pair */
+    char pair[3] = { 0 };
+
+    for (*count = 0; isxdigit((unsigned char)text[0]) && isxdigit((unsigned char)text[1]); text += 2)
+    {
+        if (SEARCH_MAX_BYTES == *count)
+        {
+            return 0;
+        }
+        pair[0] = text[0];
+        pair[1] = text[1];
+        bytes[(*count)++] = (U8)strtoul(pair, NULL, 16);
+    }
+    *position = text;
+
+    /* An odd number of digits is not accepted */
+    return (0 < *count) && !isxdigit((unsigned char)text[0]);
+}
+
+static int parsePattern(const char **position, SearchPattern *pattern)
+{
+    /* Current position in the specification */
+    const char *text = *position;
+    /* End of a parsed number */
+    char *end = NULL;
+    /* Parsed offset */
+    unsigned long offset = strtoul(text, &end, 0);
+    /* Number of mask bytes */
+    U8 maskCount = 0;
+    /* Loop counter */
+    U8 i = 0;
+
+    /* Anchored patterns start with their offset */
+    pattern->offset = SEARCH_ANYWHERE;
+    if ((end != text) && ('=' == *end))
+    {
+        if (SEARCH_ANYWHERE <= offset)
+        {
+            return 0;
+        }
+        pattern->offset = (U32)offset;
+        text = end + 1;
+    }
+
+    if (!parseHex(&text, pattern->bytes, &pattern->length))
+    {
+        return 0;
+    }
+    memset(pattern->mask, 0xFF, sizeof(pattern->mask));
+    if ('/' == *text)
+    {
+        text++;
+        if (!parseHex(&text, pattern->mask, &maskCount) || (maskCount != pattern->length))
+        {
+            return 0;
+        }
+    }
+
+    /* Candidates are located by the first and last byte compared completely */
+    pattern->exact = 0;
+    for (i = 0; i < pattern->length; i++)
+    {
+        pattern->bytes[i] &= pattern->mask[i];
+        if (0xFF == pattern->mask[i])
+        {
+            pattern->first = pattern->exact ? pattern->first : i;
+            pattern->last = i;
+            pattern->exact = 1;
+        }
+    }
+    *position = text;
+
+    return 1;
+}
+
+SearchPatterns *compileSearchPatterns(const char *spec)
+{
+    /* Current position in the specification */
+    const char *position = spec;
+    /* The compiled patterns */
+    SearchPatterns *patterns = calloc(1, sizeof(SearchPatterns));
+    /* Non-zero, while the specification is valid */
+    int valid = 1;
+
+    if (NULL == patterns)
+    {
+        fputs("Unable to allocate memory for the search patterns\n", stderr);
+        return NULL;
+    }
+
+    do
+    {
+        valid = (SEARCH_MAX_PATTERNS > patterns->count) && parsePattern(&position, &patterns->patterns[patterns->count]);
+        patterns->count++;
+    } while (valid && (';' == *position++));
+
+    /* The last pattern has to end the specification */
+    if (!valid || ('\0' != *(position - 1)))
+    {
+        fprintf(stderr, "\nInvalid search patterns '%s'\n", spec);
+        free(patterns);
+        patterns = NULL;
+    }
+
+    return patterns;
+}
+
+void freeSearchPatterns(SearchPatterns *patterns)
+{
+    free(patterns);
+
+    return;
+}
+
+static int matchPattern(const SearchPattern *pattern, const U8 *bytes)
+{
+    /* Loop counter */
+    U8 i = 0;
+
+    for (i = 0; (i < pattern->length) && (pattern->bytes[i] == (bytes[i] & pattern->mask[i])); i++)
+    {
+    }
+
+    return i == pattern->length;
+}
+
+static int findPattern(const SearchPattern *pattern, const U8 *bytes, U32 length, U32 *offset)
+{
+    /* Number of positions the pattern can start at */
+    U32 positions = (pattern->length <= length) ? length - pattern->length + 1 : 0;
+    /* Current candidate position of the first fully compared byte */
+    U32 candidate = 0;
+
+    if (SEARCH_ANYWHERE != pattern->offset)
+    {
+        *offset = pattern->offset;
+        return (pattern->offset < positions) && matchPattern(pattern, bytes + pattern->offset);
+    }
+
+    if (!pattern->exact)
+    {
+        /* Without a fully compared byte every position is a candidate */
+        for (*offset = 0; *offset < positions; (*offset)++)
+        {
+            if (matchPattern(pattern, bytes + *offset))
+            {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    for (candidate = scanBytePair(bytes, pattern->first, positions + pattern->first, pattern->bytes[pattern->first],
+                                  pattern->bytes[pattern->last], pattern->last - pattern->first);
+         candidate < positions + pattern->first;
+         candidate = scanBytePair(bytes, candidate + 1, positions + pattern->first, pattern->bytes[pattern->first],
+                                  pattern->bytes[pattern->last], pattern->last - pattern->first))
+    {
+        if (matchPattern(pattern, bytes + candidate - pattern->first))
+        {
+            *offset = candidate - pattern->first;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static void appendMatch(struct searchJob *job, U32 entry, U32 offset, U8 pattern)
+{
+    /* Reallocated matches */
+    SearchMatch *matches = NULL;
+
+    if (job->count == job->capacity)
+    {
+        matches = realloc(job->matches, 2 * (size_t)job->capacity * sizeof(SearchMatch));
+        if (NULL == matches)
+        {
+            job->failed = 1;
+            return;
+        }
+        job->matches = matches;
+        job->capacity *= 2;
+    }
+
+    job->matches[job->count].entry = entry;
+    job->matches[job->count].offset = offset;
+    job->matches[job->count].pattern = pattern;
+    job->count++;
+
+    return;
+}
+
+static void *searchPacketBlock(void *arg)
+{
+    /* The packets to search */
+    struct searchJob *job = arg;
+    /* Loop counters */
+    U32 i = 0;
+    U8 p = 0;
+    /* Number of bytes of the current packet */
+    U32 length = 0;
+    /* Position of a found pattern */
+    U32 offset = 0;
+
+    for (i = job->first; (i < job->last) && !job->failed; i++)
+    {
+        if (PACKET_TERM_TIMECODE == job->index->entries[i].termination)
+        {
+            continue;
+        }
+        length = LA_MK3_getPacketBytes(&job->index->entries[i], job->store, job->buffer);
+        job->searched += length;
+        for (p = 0; p < job->patterns->count; p++)
+        {
+            if (findPattern(&job->patterns->patterns[p], job->buffer, length, &offset))
+            {
+                appendMatch(job, i, offset, p);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+int LA_MK3_searchPackets(PacketSearch *search, const EventStore *store, const PacketIndex *index, const SearchPatterns *patterns, int jobs)
+{
+    /* Loop counters */
+    int t = 0;
+    U32 i = 0;
+    /* Number of threads searching the packets */
+    int threadCount = (1 < jobs) ? jobs : 1;
+    /* Packets searched by the individual threads */
+    struct searchJob *searchJobs = calloc((size_t)threadCount, sizeof(struct searchJob));
+    /* Threads searching the packets */
+    pthread_t *threads = calloc((size_t)threadCount, sizeof(pthread_t));
+    /* Number of packets per thread */
+    U32 blockSize = index->count / (U32)threadCount + 1;
+    /* All memory needed for searching has been allocated */
+    int allocated = (NULL != searchJobs) && (NULL != threads);
+    /* Total number of matches */
+    U32 total = 0;
+
+    search->matches = NULL;
+    search->count = 0;
+    search->packets = 0;
+    search->searched = 0;
+
+    for (t = 0; allocated && (t < threadCount); t++)
+    {
+        searchJobs[t].store = store;
+        searchJobs[t].index = index;
+        searchJobs[t].patterns = patterns;
+        searchJobs[t].first = ((U32)t * blockSize < index->count) ? (U32)t * blockSize : index->count;
+        searchJobs[t].last = (searchJobs[t].first + blockSize < index->count) ? searchJobs[t].first + blockSize : index->count;
+        searchJobs[t].capacity = SEARCH_INITIAL_MATCHES;
+        searchJobs[t].matches = malloc(SEARCH_INITIAL_MATCHES * sizeof(SearchMatch));
+        searchJobs[t].buffer = malloc(index->maxLength + 1);
+        allocated = (NULL != searchJobs[t].matches) && (NULL != searchJobs[t].buffer);
+    }
+
+    if (allocated)
+    {
+        /* Search consecutive blocks of packets in parallel */
+        for (t = 0; t < threadCount; t++)
+        {
+            if (0 != pthread_create(&threads[t], NULL, searchPacketBlock, &searchJobs[t]))
+            {
+                /* Search block in this thread instead */
+                searchPacketBlock(&searchJobs[t]);
+                threads[t] = pthread_self();
+            }
+        }
+        for (t = 0; t < threadCount; t++)
+        {
+            if (!pthread_equal(threads[t], pthread_self()))
+            {
+                pthread_join(threads[t], NULL);
+            }
+            allocated = allocated && !searchJobs[t].failed;
+            total += searchJobs[t].count;
+        }
+    }
+    if (allocated)
+    {
+        search->matches = malloc(((size_t)total + 1) * sizeof(SearchMatch));
+        allocated = (NULL != search->matches);
+    }
+
+    /* Join the matches of all threads in order of the packet index */
+    for (t = 0; allocated && (t < threadCount); t++)
+    {
+        memcpy(search->matches + search->count, searchJobs[t].matches, searchJobs[t].count * sizeof(SearchMatch));
+        search->count += searchJobs[t].count;
+        search->searched += searchJobs[t].searched;
+    }
+    for (i = 0; i < search->count; i++)
+    {
+        if ((0 == i) || (search->matches[i].entry != search->matches[i - 1].entry))
+        {
+            search->packets++;
+        }
+    }
+
+    if (!allocated)
+    {
+        fputs("Unable to allocate memory for searching the packets\n", stderr);
+    }
+    else
+    {
+        fprintf(stderr, "Found %u pattern(s) in %u packet(s), searching %llu bytes\n", search->count, search->packets, search->searched);
+    }
+
+    /* Free memory */
+    for (t = 0; (NULL != searchJobs) && (t < threadCount); t++)
+    {
+        free(searchJobs[t].matches);
+        free(searchJobs[t].buffer);
+    }
+    free(searchJobs);
+    free(threads);
+
+    return allocated;
+}
+
+unsigned long long printSearchMatches(FILE *stream, const PacketSearch *search, const EventStore *store, const PacketIndex *index,
+                                      struct timespec *triggerTime)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* The packet of the current match */
+    const PacketEntry *entry = NULL;
+    /* Time difference of the packet to the trigger in seconds */
+    double deltaToTrigger = 0.0;
+    /* Timestamp of the packet */
+    char timestampStr[30];
+    /* Number of characters printed */
+    unsigned long long written = 0;
+
+    written += fprintf(stream, "# Record Dir Timestamp                     Length Termination Patterns (NUMBER@OFFSET)\n");
+    for (i = 0; i < search->count; i++)
+    {
+        entry = &index->entries[search->matches[i].entry];
+        if ((0 == i) || (search->matches[i].entry != search->matches[i - 1].entry))
+        {
+            /* Start the line of a packet, the record number counts the records of the hexdump */
+            deltaToTrigger = entry->startTime * store->clockPeriod;
+            LA_MK3_getPacketTimestamp(&deltaToTrigger, triggerTime, timestampStr);
+            written += fprintf(stream, "%s%8u %c   %s %6u %-11s", (0 == i) ? "" : "\n", search->matches[i].entry + 1,
+                               entry->receiver ? 'O' : 'I', timestampStr, entry->length, terminationNames[entry->termination]);
+        }
+        written += fprintf(stream, " %u@%u", search->matches[i].pattern + 1, search->matches[i].offset);
+    }
+    written += fprintf(stream, "%s", (0 < search->count) ? "\n" : "");
+
+    return written;
+}
+
+void freePacketSearch(PacketSearch *search)
+{
+    free(search->matches);
+    search->matches = NULL;
+    search->count = 0;
+
+    return;
+}
@@ -0,0 +1,814 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <spw_la_api.h>
+#include "event_store.h"
+#include "packet_index.h"
+#include "rmap.h"
+#include "pcapng_stream.h"
+#include "run_stats.h"
+#include "metrics.h"
+
+/* Block types of the PCAPNG format */
+#define BLOCK_SECTION_HEADER    0x0A0D0D0A
+#define BLOCK_INTERFACE         0x00000001
+#define BLOCK_INTERFACE_STATS   0x00000005
+#define BLOCK_ENHANCED_PACKET   0x00000006
+
+/* Options of the PCAPNG blocks */
+#define OPTION_END              0
+#define OPTION_COMMENT          1
+#define OPTION_USER_APPLICATION 4   /* shb_userappl */
+#define OPTION_INTERFACE_NAME   2   /* if_name */
+#define OPTION_TIME_RESOLUTION  9   /* if_tsresol */
+#define OPTION_PACKET_FLAGS     2   /* epb_flags */
+#define OPTION_RECEIVED         4   /* isb_ifrecv */
+#define OPTION_DROPPED          5   /* isb_ifdrop */
+
+/* Direction of a packet in the packet flags (receiver A inbound, B outbound as in the hexdump) */
+#define FLAGS_INBOUND  0x1
+#define FLAGS_OUTBOUND 0x2
+
+/* Link type of the interface carrying the dummy Ethernet headers */
+#define LINKTYPE_ETHERNET 1
+
+/* Size of the fixed part of an enhanced packet block and of its packet flags option in bytes */
+#define PACKET_BLOCK_FIXED (7 * 4)
+#define PACKET_FLAGS_OPTION (4 + 4)
+
+/* Longest packet comment in bytes */
+#define COMMENT_SIZE 128
+
+/* The PCAPNG stream written by a writer thread */
+struct pcapngStream
+{
+    const char *target;                             /* The named pipe or file written to */
+    int fd;                                         /* The open target, -1 until a reader opened the named pipe */
+    int live;                                       /* The target is a named pipe, which drops packets on a full queue after a timeout */
+    char *buffers[PCAPNG_BUFFER_COUNT];             /* Buffers cycling between the producer and the writer thread */
+    size_t lengths[PCAPNG_BUFFER_COUNT];            /* Number of bytes in each queued buffer */
+    unsigned long long packets[PCAPNG_BUFFER_COUNT];/* Number of packets in each buffer */
+    unsigned int filling;                           /* Buffer being filled by the producer */
+    size_t fill;                                    /* Number of bytes in the buffer being filled */
+    unsigned int next;                              /* First queued buffer */
+    unsigned int queued;                            /* Number of queued buffers */
+    unsigned long long offered;                     /* Packets offered to the stream */
+    unsigned long long dropped;                     /* Packets dropped on a full queue */
+    unsigned long long streamed;                    /* Packets written to the target */
+    unsigned long long lost;                        /* Queued packets not written */
+    U32 sequence[2];                                /* Sequence numbers of the dummy TCP headers per receiver */
+    int connected;                                  /* The target has been opened */
+    int closing;                                    /* No further buffers will be queued */
+    int failed;                                     /* Writing to the target failed */
+    int stalled;                                    /* Waiting for a free buffer timed out and the reader has not caught up since */
+    int aborted;                                    /* Stopping gave up on the reader, the queued buffers are not written */
+    pthread_mutex_t lock;                           /* Protects the queue, the counters and the flags */
+    pthread_cond_t queuedCond;                      /* Signals a queued buffer to the writer thread */
+    pthread_cond_t freedCond;                       /* Signals a written buffer to the producer */
+    pthread_t thread;                               /* The writer thread */
+    int running;                                    /* The writer thread has been started */
+};
+
+/* The running stream, NULL if not streaming */
+static struct pcapngStream *stream = NULL;
+
+static void putU16(U8 *buffer, uint16_t value)
+{
+    buffer[0] = (U8)value;
+    buffer[1] = (U8)(value >> 8);
+
+    return;
+}
+
+static void putU32(U8 *buffer, uint32_t value)
+{
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        buffer[i] = (U8)(value >> (8 * i));
+    }
+
+    return;
+}
+
+static void putU64(U8 *buffer, uint64_t value)
+{
+    putU32(buffer, (uint32_t)value);
+    putU32(buffer + 4, (uint32_t)(value >> 32));
+
+    return;
+}
+
+static void putNetU16(U8 *buffer, uint16_t value)
+{
+    buffer[0] = (U8)(value >> 8);
+    buffer[1] = (U8)value;
+
+    return;
+}
+
+static void putNetU32(U8 *buffer, uint32_t value)
+{
+    putNetU16(buffer, (uint16_t)(value >> 16));
+    putNetU16(buffer + 2, (uint16_t)value);
+
+    return;
+}
+
+static size_t padded(size_t length)
+{
+    return (length + 3) & ~(size_t)3;
+}
+
+static size_t putOption(U8 *buffer, uint16_t code, const void *value, size_t length)
+{
+    putU16(buffer, code);
+    putU16(buffer + 2, (uint16_t)length);
+    memcpy(buffer + 4, value, length);
+    memset(buffer + 4 + length, 0, padded(length) - length);
+
+    return 4 + padded(length);
+}
+
+static uint32_t addChecksum(uint32_t sum, const U8 *bytes, size_t length)
+{
+    /* Loop counter */
+    size_t i = 0;
+
+    for (i = 0; i + 1 < length; i += 2)
+    {
+        sum += ((uint32_t)bytes[i] << 8) | bytes[i + 1];
+    }
+    if (length & 1)
+    {
+        sum += (uint32_t)bytes[length - 1] << 8;
+    }
+
+    return sum;
+}
+
+static uint16_t foldChecksum(uint32_t sum)
+{
+    while (sum >> 16)
+    {
+        sum = (sum & 0xFFFF) + (sum >> 16);
+    }
+
+    return (uint16_t)~sum;
+}
+
+static void putDummyHeaders(U8 *frame, const U8 *payload, U32 length, U32 sequence)
+{
+    /* Dummy Ethernet addresses and IPv4 addresses 10.1.1.1 and 10.2.2.2 as used by text2pcap */
+    static const U8 ethernet[14] = { 0x0A, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0A, 0x01, 0x01, 0x01, 0x01, 0x01, 0x08, 0x00 };
+    static const U8 addresses[8] = { 10, 1, 1, 1, 10, 2, 2, 2 };
+    /* IPv4 and TCP header */
+    U8 *ip = frame + 14;
+    U8 *tcp = ip + 20;
+    /* Checksum of the TCP pseudo header, header and payload */
+    uint32_t sum = 0;
+
+    memcpy(frame, ethernet, sizeof(ethernet));
+
+    memset(ip, 0, 20);
+    ip[0] = 0x45;
+    putNetU16(ip + 2, (uint16_t)(20 + 20 + length));
+    ip[8] = 0xFF;
+    ip[9] = 6;
+    memcpy(ip + 12, addresses, sizeof(addresses));
+    putNetU16(ip + 10, foldChecksum(addChecksum(0, ip, 20)));
+
+    memset(tcp, 0, 20);
+    putNetU16(tcp, PCAPNG_SOURCE_PORT);
+    putNetU16(tcp + 2, PCAPNG_DESTINATION_PORT);
+    putNetU32(tcp + 4, sequence);
+    tcp[12] = 0x50;
+    tcp[13] = 0x18;
+    putNetU16(tcp + 14, 0x2000);
+    sum = addChecksum(0, addresses, sizeof(addresses)) + 6 + 20 + length;
+    sum = addChecksum(sum, tcp, 20);
+    sum = addChecksum(sum, payload, length);
+    putNetU16(tcp + 16, foldChecksum(sum));
+
+    return;
+}
+
+static void *writeStreamBuffers(void *arg)
+{
+    /* Loop counter */
+    unsigned int i = 0;
+    /* Number of buffers written at once */
+    unsigned int count = 0;
+    /* Queued buffers in stream order */
+    struct iovec vectors[PCAPNG_BUFFER_COUNT];
+    /* Remaining queued buffers */
+    struct iovec *remaining = vectors;
+    int left = 0;
+    /* Bytes written by the last call */
+    ssize_t written = 0;
+    /* Number of buffers finished by the last call */
+    unsigned int freed = 0;
+    /* Packets in the finished buffers */
+    unsigned long long packets = 0;
+    /* Writing the buffers succeeded */
+    int success = 1;
+    /* No buffers are left to write */
+    int done = 0;
+    /* Signals to block in this thread */
+    sigset_t signals;
+    /* Error opening the named pipe */
+    int error = 0;
+    /* The named pipe to wait for until it takes more data */
+    struct pollfd writable;
+
+    (void)arg;
+    /* A reader closing the named pipe is reported by the failing write instead */
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+    /* Wait for Wireshark to open the named pipe for reading */
+    while (0 > stream->fd)
+    {
+        stream->fd = open(stream->target, O_WRONLY | O_NONBLOCK);
+        error = errno;
+        pthread_mutex_lock(&stream->lock);
+        if (0 <= stream->fd)
+        {
+            /* The pipe stays non-blocking, so stopping can give up on a reader not taking any data */
+            stream->connected = 1;
+        }
+        else if ((ENXIO != error) || stream->closing)
+        {
+            success = 0;
+            stream->failed = 1;
+            pthread_mutex_unlock(&stream->lock);
+            break;
+        }
+        pthread_mutex_unlock(&stream->lock);
+        if (0 > stream->fd)
+        {
+            usleep(PCAPNG_POLL_INTERVAL_MS * 1000);
+        }
+    }
+
+    while (!done)
+    {
+        pthread_mutex_lock(&stream->lock);
+        while ((0 == stream->queued) && !stream->closing)
+        {
+            pthread_cond_wait(&stream->queuedCond, &stream->lock);
+        }
+        count = stream->queued;
+        done = (0 == count);
+        pthread_mutex_unlock(&stream->lock);
+
+        /* Gather all queued buffers into a single write */
+        for (i = 0; i < count; i++)
+        {
+            vectors[i].iov_base = stream->buffers[(stream->next + i) % PCAPNG_BUFFER_COUNT];
+            vectors[i].iov_len = stream->lengths[(stream->next + i) % PCAPNG_BUFFER_COUNT];
+        }
+        remaining = vectors;
+        left = (int)count;
+        while (0 < left)
+        {
+            written = success ? writev(stream->fd, remaining, left) : 0;
+            if ((0 > written) && (EAGAIN == errno))
+            {
+                /* The named pipe is full, wait for the reader unless stopping has given up on it */
+                writable.fd = stream->fd;
+                writable.events = POLLOUT;
+                poll(&writable, 1, PCAPNG_POLL_INTERVAL_MS);
+                pthread_mutex_lock(&stream->lock);
+                success = !stream->aborted;
+                pthread_mutex_unlock(&stream->lock);
+            }
+            else if ((0 > written) && (EINTR != errno))
+            {
+                success = 0;
+            }
+
+            /* Finish the buffers written completely, or all of them once writing failed */
+            freed = 0;
+            packets = 0;
+            while ((0 < left) && (!success || ((0 < written) && ((size_t)written >= remaining->iov_len))))
+            {
+                written -= success ? (ssize_t)remaining->iov_len : 0;
+                packets += stream->packets[(stream->next + freed) % PCAPNG_BUFFER_COUNT];
+                freed++;
+                remaining++;
+                left--;
+            }
+            if (success && (0 < written))
+            {
+                remaining->iov_base = (char *)remaining->iov_base + written;
+                remaining->iov_len -= (size_t)written;
+            }
+
+            /* Hand the finished buffers back to the producer right away */
+            if (0 < freed)
+            {
+                pthread_mutex_lock(&stream->lock);
+                if (success)
+                {
+                    stream->streamed += packets;
+                }
+                else
+                {
+                    stream->lost += packets;
+                }
+                stream->next = (stream->next + freed) % PCAPNG_BUFFER_COUNT;
+                stream->queued -= freed;
+                stream->failed = stream->failed || !success;
+                stream->stalled = 0;
+                metricsSetGauge(METRIC_GAUGE_STREAM_QUEUE, stream->queued);
+                pthread_cond_signal(&stream->freedCond);
+                pthread_mutex_unlock(&stream->lock);
+            }
+        }
+    }
+
+    return NULL;
+}
+
+static void getDeadline(struct timespec *deadline, long milliseconds)
+{
+    clock_gettime(CLOCK_MONOTONIC, deadline);
+    deadline->tv_sec += milliseconds / 1000;
+    deadline->tv_nsec += (milliseconds % 1000) * 1000000;
+    if (1000000000 <= deadline->tv_nsec)
+    {
+        deadline->tv_sec++;
+        deadline->tv_nsec -= 1000000000;
+    }
+
+    return;
+}
+
+static int queueBuffer(const struct timespec *deadline)
+{
+    /* A free buffer is left to continue with */
+    int ret = 0;
+    /* Result of the last wait */
+    int waited = 0;
+
+    pthread_mutex_lock(&stream->lock);
+    /* Once waiting for the reader timed out, buffers are dropped right away until it catches up */
+    waited = ((NULL != deadline) && stream->stalled) ? ETIMEDOUT : 0;
+    while ((ETIMEDOUT != waited) && (PCAPNG_BUFFER_COUNT == stream->queued + 1))
+    {
+        waited = (NULL == deadline) ? pthread_cond_wait(&stream->freedCond, &stream->lock) :
+                                      pthread_cond_timedwait(&stream->freedCond, &stream->lock, deadline);
+    }
+    ret = (PCAPNG_BUFFER_COUNT > stream->queued + 1);
+    stream->stalled = stream->stalled || (!ret && (ETIMEDOUT == waited));
+    if (ret)
+    {
+        stream->lengths[stream->filling] = stream->fill;
+        stream->queued++;
+        metricsSetGauge(METRIC_GAUGE_STREAM_QUEUE, stream->queued);
+        pthread_cond_signal(&stream->queuedCond);
+    }
+    pthread_mutex_unlock(&stream->lock);
+
+    if (ret)
+    {
+        stream->filling = (stream->filling + 1) % PCAPNG_BUFFER_COUNT;
+        stream->fill = 0;
+        stream->packets[stream->filling] = 0;
+    }
+
+    return ret;
+}
+
+static U8 *reserveBlock(size_t length, int limited)
+{
+    /* Time to give up waiting for a free buffer */
+    struct timespec deadline;
+
+    if (limited && (PCAPNG_BUFFER_SIZE - stream->fill < length))
+    {
+        getDeadline(&deadline, PCAPNG_STALL_TIMEOUT_MS);
+    }
+    if ((PCAPNG_BUFFER_SIZE - stream->fill < length) && !queueBuffer(limited ? &deadline : NULL))
+    {
+        /* The queue is full */
+        return NULL;
+    }
+
+    return (U8 *)stream->buffers[stream->filling] + stream->fill;
+}
+
+static void putHeaderBlocks(const char *version)
+{
+    /* Name of the application and interface */
+    char application[64];
+    static const char interfaceName[] = "spw";
+    /* Time stamps in nanoseconds */
+    static const U8 resolution = 9;
+    /* Length of the blocks */
+    size_t length = 0;
+    /* The block */
+    U8 *block = NULL;
+
+    snprintf(application, sizeof(application), "spw_data_rec %s", version);
+    length = 24 + 4 + padded(strlen(application)) + 4 + 4;
+    block = reserveBlock(length, 0);
+    putU32(block, BLOCK_SECTION_HEADER);
+    putU32(block + 4, (uint32_t)length);
+    putU32(block + 8, 0x1A2B3C4D);
+    putU16(block + 12, 1);
+    putU16(block + 14, 0);
+    /* The length of the section is unknown */
+    putU64(block + 16, UINT64_MAX);
+    putOption(block + 24, OPTION_USER_APPLICATION, application, strlen(application));
+    putU32(block + length - 8, OPTION_END);
+    putU32(block + length - 4, (uint32_t)length);
+    stream->fill += length;
+
+    length = 16 + 4 + padded(strlen(interfaceName)) + 4 + 4 + 4 + 4;
+    block = reserveBlock(length, 0);
+    putU32(block, BLOCK_INTERFACE);
+    putU32(block + 4, (uint32_t)length);
+    putU16(block + 8, LINKTYPE_ETHERNET);
+    putU16(block + 10, 0);
+    putU32(block + 12, 0);
+    putOption(block + 16 + putOption(block + 16, OPTION_INTERFACE_NAME, interfaceName, strlen(interfaceName)),
+              OPTION_TIME_RESOLUTION, &resolution, 1);
+    putU32(block + length - 8, OPTION_END);
+    putU32(block + length - 4, (uint32_t)length);
+    stream->fill += length;
+
+    return;
+}
+
+int pcapngStartStream(const char *target, const char *version)
+{
+    /* Loop counter */
+    int i = 0;
+    /* Type of the target */
+    struct stat status;
+    /* All buffers have been allocated */
+    int ready = 0;
+    /* Attributes of the condition waited on with a timeout */
+    pthread_condattr_t attributes;
+
+    stream = calloc(1, sizeof(struct pcapngStream));
+    ready = (NULL != stream);
+    if (ready)
+    {
+        stream->fd = -1;
+    }
+    for (i = 0; ready && (i < PCAPNG_BUFFER_COUNT); i++)
+    {
+        stream->buffers[i] = malloc(PCAPNG_BUFFER_SIZE);
+        ready = (NULL != stream->buffers[i]);
+    }
+    if (!ready)
+    {
+        fputs("Unable to allocate memory for the PCAPNG stream\n", stderr);
+        if (NULL != stream)
+        {
+            pcapngStopStream();
+        }
+        return 0;
+    }
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_cond_init(&stream->queuedCond, NULL);
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&stream->freedCond, &attributes);
+    pthread_condattr_destroy(&attributes);
+    stream->target = target;
+
+    /* A named pipe is opened by the writer thread once Wireshark reads it */
+    stream->live = (0 == stat(target, &status)) && S_ISFIFO(status.st_mode);
+    stream->fd = stream->live ? -1 : open(target, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    stream->connected = !stream->live;
+    if (!stream->live && (0 > stream->fd))
+    {
+        fprintf(stderr, "Unable to open PCAPNG stream %s\n", target);
+        pcapngStopStream();
+        return 0;
+    }
+
+    putHeaderBlocks(version);
+    queueBuffer(NULL);
+    stream->running = (0 == pthread_create(&stream->thread, NULL, writeStreamBuffers, NULL));
+    if (!stream->running)
+    {
+        fputs("Unable to start the PCAPNG stream writer\n", stderr);
+        pcapngStopStream();
+        return 0;
+    }
+    if (stream->live)
+    {
+        fprintf(stderr, "Streaming to %s as soon as Wireshark reads it\n", target);
+    }
+
+    return 1;
+}
+
+static size_t formatComment(const PacketEntry *entry, const EventStore *store, U32 length, const char headerOnly, char *comment)
+{
+    /* Loop counter */
+    unsigned int i = 0;
+    /* Length of the comment */
+    int used = 0;
+    /* Time between the header and the end of packet in seconds */
+    double duration = 0.0;
+
+    comment[0] = '\0';
+    if (PACKET_TERM_TIMECODE == entry->termination)
+    {
+        used = snprintf(comment, COMMENT_SIZE, "Time-code");
+    }
+    else if (PACKET_TERM_INCOMPLETE == entry->termination)
+    {
+        used = snprintf(comment, COMMENT_SIZE, "Incomplete packet");
+    }
+    else if (headerOnly)
+    {
+        duration = (getEventTime(store, entry->endEvent) - entry->startTime) * store->clockPeriod;
+        used = snprintf(comment, COMMENT_SIZE, "Header only: %u bytes recorded, %s after %.3fus", length,
+                        (PACKET_TERM_EOP == entry->termination) ? "EOP" : "EEP", duration * 1000000.0);
+    }
+    else if (PACKET_TERM_EEP == entry->termination)
+    {
+        used = snprintf(comment, COMMENT_SIZE, "EEP");
+    }
+    if (PCAPNG_MAX_PAYLOAD < length)
+    {
+        used += snprintf(comment + used, (size_t)(COMMENT_SIZE - used), "%sTruncated from %u bytes", (0 < used) ? ", " : "", length);
+    }
+    for (i = 0; i < sizeof(pcapngErrorNames) / sizeof(pcapngErrorNames[0]); i++)
+    {
+        if ((entry->errors & (1u << i)) && (COMMENT_SIZE > used))
+        {
+            used += snprintf(comment + used, (size_t)(COMMENT_SIZE - used), "%s%s", (0 < used) ? ", " : "", pcapngErrorNames[i]);
+        }
+    }
+    for (i = 0; i < sizeof(pcapngRmapErrorNames) / sizeof(pcapngRmapErrorNames[0]); i++)
+    {
+        if ((entry->rmap & (RMAP_FLAG_HEADER_CRC << i)) && (COMMENT_SIZE > used))
+        {
+            used += snprintf(comment + used, (size_t)(COMMENT_SIZE - used), "%s%s", (0 < used) ? ", " : "", pcapngRmapErrorNames[i]);
+        }
+    }
+
+    return (COMMENT_SIZE > used) ? (size_t)used : COMMENT_SIZE - 1;
+}
+
+unsigned long long pcapngStreamPackets(const EventStore *store, const PacketIndex *index, struct timespec *triggerTime, const char headerOnly)
+{
+    /* Loop counter */
+    U32 i = 0;
+    /* The current packet */
+    const PacketEntry *entry = NULL;
+    /* Buffer for gathering the packet data */
+    U8 *bytes = NULL;
+    /* Number of bytes in the packet and in the stream */
+    U32 length = 0;
+    U32 payload = 0;
+    /* Comment of the packet and its length */
+    char comment[COMMENT_SIZE];
+    size_t commentLength = 0;
+    /* Length of the block */
+    size_t blockLength = 0;
+    /* The block */
+    U8 *block = NULL;
+    /* Time stamp of the trigger and of the packet in nanoseconds */
+    long long triggerNanoSec = (long long)triggerTime->tv_sec * 1000000000LL + triggerTime->tv_nsec;
+    long long timestamp = 0;
+    /* Packet flags of the block */
+    U8 flags[4] = { 0, 0, 0, 0 };
+    /* Number of packets queued and dropped */
+    unsigned long long queued = 0;
+    unsigned long long dropped = 0;
+    /* Time to give up waiting for a free buffer */
+    struct timespec deadline;
+
+    if (NULL == stream)
+    {
+        return 0;
+    }
+    bytes = malloc(index->maxLength + 1);
+    if (NULL == bytes)
+    {
+        fputs("Unable to allocate memory for streaming the packets\n", stderr);
+        return 0;
+    }
+
+    for (i = 0; i < index->count; i++)
+    {
+        entry = &index->entries[i];
+        length = LA_MK3_getPacketBytes(entry, store, bytes);
+        payload = (PCAPNG_MAX_PAYLOAD < length) ? PCAPNG_MAX_PAYLOAD : length;
+        commentLength = formatComment(entry, store, length, headerOnly, comment);
+        blockLength = PACKET_BLOCK_FIXED + padded(PCAPNG_DUMMY_HEADERS + payload) + PACKET_FLAGS_OPTION +
+                      ((0 < commentLength) ? 4 + padded(commentLength) : 0) + 4 + 4;
+
+        /* A regular file waits for a free buffer, a named pipe only up to the stall timeout */
+        block = reserveBlock(blockLength, stream->live);
+        if (NULL == block)
+        {
+            dropped++;
+            continue;
+        }
+
+        timestamp = triggerNanoSec + llround(entry->startTime * store->clockPeriod * 1e9);
+        putU32(block, BLOCK_ENHANCED_PACKET);
+        putU32(block + 4, (uint32_t)blockLength);
+        putU32(block + 8, 0);
+        putU32(block + 12, (uint32_t)((uint64_t)timestamp >> 32));
+        putU32(block + 16, (uint32_t)timestamp);
+        putU32(block + 20, PCAPNG_DUMMY_HEADERS + payload);
+        putU32(block + 24, PCAPNG_DUMMY_HEADERS + length);
+        putDummyHeaders(block + PACKET_BLOCK_FIXED, bytes, payload, stream->sequence[entry->receiver]);
+        memcpy(block + PACKET_BLOCK_FIXED + PCAPNG_DUMMY_HEADERS, bytes, payload);
+        memset(block + PACKET_BLOCK_FIXED + PCAPNG_DUMMY_HEADERS + payload, 0,
+               padded(PCAPNG_DUMMY_HEADERS + payload) - (PCAPNG_DUMMY_HEADERS + payload));
+        stream->sequence[entry->receiver] += payload;
+
+        putU32(flags, entry->receiver ? FLAGS_OUTBOUND : FLAGS_INBOUND);
+        block += PACKET_BLOCK_FIXED + padded(PCAPNG_DUMMY_HEADERS + payload);
+        block += putOption(block, OPTION_PACKET_FLAGS, flags, sizeof(flags));
+        if (0 < commentLength)
+        {
+            block += putOption(block, OPTION_COMMENT, comment, commentLength);
+        }
+        putU32(block, OPTION_END);
+        putU32(block + 4, (uint32_t)blockLength);
+
+        stream->fill += blockLength;
+        stream->packets[stream->filling]++;
+        queued++;
+    }
+
+    /* Hand the packets over right away, a buffer left over is written when stopping */
+    if (0 < stream->fill)
+    {
+        if (stream->live)
+        {
+            getDeadline(&deadline, PCAPNG_STALL_TIMEOUT_MS);
+        }
+        queueBuffer(stream->live ? &deadline : NULL);
+    }
+    free(bytes);
+
+    stream->offered += queued + dropped;
+    stream->dropped += dropped;
+    statsAdd(STATS_PACKETS_STREAM_DROPPED, dropped);
+    if (0 < dropped)
+    {
+        fprintf(stderr, "PCAPNG stream reader stalled, dropped %llu of %llu packets\n", dropped, queued + dropped);
+    }
+
+    return queued;
+}
+
+static void putStatisticsBlock(const struct timespec *deadline)
+{
+    /* Length of the block */
+    const size_t length = 20 + 12 + 12 + 4 + 4;
+    /* The block */
+    U8 *block = ((PCAPNG_BUFFER_SIZE - stream->fill >= length) || queueBuffer(deadline)) ?
+                (U8 *)stream->buffers[stream->filling] + stream->fill : NULL;
+    /* Time the statistics have been taken */
+    struct timespec now;
+    unsigned long long timestamp = 0;
+    /* Option values */
+    U8 value[8];
+
+    if (NULL == block)
+    {
+        /* The reader does not take the stream anymore */
+        return;
+    }
+    clock_gettime(CLOCK_REALTIME, &now);
+    timestamp = (unsigned long long)now.tv_sec * 1000000000ULL + (unsigned long long)now.tv_nsec;
+    putU32(block, BLOCK_INTERFACE_STATS);
+    putU32(block + 4, (uint32_t)length);
+    putU32(block + 8, 0);
+    putU32(block + 12, (uint32_t)(timestamp >> 32));
+    putU32(block + 16, (uint32_t)timestamp);
+    putU64(value, stream->offered);
+    putOption(block + 20, OPTION_RECEIVED, value, sizeof(value));
+    putU64(value, stream->dropped);
+    putOption(block + 32, OPTION_DROPPED, value, sizeof(value));
+    putU32(block + 44, OPTION_END);
+    putU32(block + 48, (uint32_t)length);
+    stream->fill += length;
+
+    return;
+}
+
+int pcapngStopStream(void)
+{
+    /* Loop counter */
+    int i = 0;
+    /* Return value */
+    int ret = 1;
+    /* A reader has opened the target */
+    int connected = 0;
+    /* Time to give up on the reader of a named pipe */
+    struct timespec deadline;
+    /* Result of the last wait */
+    int waited = 0;
+
+    if (NULL == stream)
+    {
+        return 0;
+    }
+
+    if (stream->running)
+    {
+        pthread_mutex_lock(&stream->lock);
+        connected = stream->connected;
+        if (!connected)
+        {
+            /* Nobody is reading the named pipe, give up waiting */
+            stream->closing = 1;
+            pthread_cond_signal(&stream->queuedCond);
+        }
+        pthread_mutex_unlock(&stream->lock);
+        if (connected)
+        {
+            /* Give a reader, which stalled before, until the stop timeout to take the rest of the stream */
+            getDeadline(&deadline, PCAPNG_STOP_TIMEOUT_MS);
+            pthread_mutex_lock(&stream->lock);
+            stream->stalled = 0;
+            pthread_mutex_unlock(&stream->lock);
+            /* Report the dropped packets in the stream itself */
+            putStatisticsBlock(stream->live ? &deadline : NULL);
+            if ((0 < stream->fill) && !queueBuffer(stream->live ? &deadline : NULL))
+            {
+                stream->lost += stream->packets[stream->filling];
+            }
+            pthread_mutex_lock(&stream->lock);
+            stream->closing = 1;
+            pthread_cond_signal(&stream->queuedCond);
+            while (stream->live && (0 < stream->queued) && (ETIMEDOUT != waited))
+            {
+                waited = pthread_cond_timedwait(&stream->freedCond, &stream->lock, &deadline);
+            }
+            /* Give up on a reader not taking the stream, instead of hanging at exit */
+            stream->aborted = stream->live && (0 < stream->queued);
+            pthread_mutex_unlock(&stream->lock);
+            if (stream->aborted)
+            {
+                fprintf(stderr, "PCAPNG stream reader stalled, gave up after %d s\n", PCAPNG_STOP_TIMEOUT_MS / 1000);
+            }
+        }
+        pthread_join(stream->thread, NULL);
+
+        /* The packets of the buffer not queued for a named pipe nobody has read */
+        stream->lost += connected ? 0 : stream->packets[stream->filling];
+        ret = !stream->failed;
+        statsAdd(STATS_PACKETS_STREAMED, stream->streamed);
+        statsAdd(STATS_PACKETS_STREAM_DROPPED, stream->lost);
+        fprintf(stderr, "Streamed %llu packets to %s, %llu dropped\n", stream->streamed, stream->target, stream->dropped + stream->lost);
+        if (!connected)
+        {
+            fprintf(stderr, "No reader opened the PCAPNG stream %s\n", stream->target);
+        }
+        else if (!ret && !stream->aborted)
+        {
+            fprintf(stderr, "Unable to write the PCAPNG stream %s\n", stream->target);
+        }
+    }
+    if (NULL != stream->target)
+    {
+        pthread_mutex_destroy(&stream->lock);
+        pthread_cond_destroy(&stream->queuedCond);
+        pthread_cond_destroy(&stream->freedCond);
+    }
+    if (0 <= stream->fd)
+    {
+        ret = (0 == close(stream->fd)) && ret;
+    }
+
+    for (i = 0; i < PCAPNG_BUFFER_COUNT; i++)
+    {
+        free(stream->buffers[i]);
+    }
+    free(stream);
+    stream = NULL;
+
+    return ret;
+}
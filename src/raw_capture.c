@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <spw_la_api.h>
+#include "event_store.h"
+#include "raw_capture.h"
+
+static void putU32(U8 *buffer, uint32_t value)
+{
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; i < 4; i++)
+    {
+        buffer[i] = (U8)(value >> (8 * i));
+    }
+
+    return;
+}
+
+static void putU64(U8 *buffer, uint64_t value)
+{
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 0; i < 8; i++)
+    {
+        buffer[i] = (U8)(value >> (8 * i));
+    }
+
+    return;
+}
+
+static uint32_t getU32(const U8 *buffer)
+{
+    /* The value */
+    uint32_t value = 0;
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 3; i >= 0; i--)
+    {
+        value = (value << 8) | buffer[i];
+    }
+
+    return value;
+}
+
+static uint64_t getU64(const U8 *buffer)
+{
+    /* The value */
+    uint64_t value = 0;
+    /* Loop counter */
+    int i = 0;
+
+    for (i = 7; i >= 0; i--)
+    {
+        value = (value << 8) | buffer[i];
+    }
+
+    return value;
+}
+
+unsigned long long LA_MK3_writeRawCapture(FILE *stream, const EventStore *store, struct timespec *triggerTime, const char headerOnly)
+{
+    /* Loop counters */
+    U32 i = 0, j = 0;
+    /* The capture header */
+    U8 header[RAW_HEADER_SIZE];
+    /* Bit pattern of the clock period */
+    uint64_t clockPeriodBits = 0;
+    /* Encoded records of a block of events */
+    U8 *records = malloc((size_t)RAW_BLOCK_EVENTS * RAW_RECORD_SIZE);
+    /* The current record */
+    U8 *record = NULL;
+    /* Capture clock tick of the current event */
+    long long time = 0;
+    /* Number of bytes written */
+    unsigned long long written = 0;
+
+    if (NULL == records)
+    {
+        fputs("Unable to allocate memory for writing the raw capture\n", stderr);
+        return 0;
+    }
+
+    memset(header, 0, sizeof(header));
+    memcpy(header, RAW_MAGIC, 8);
+    putU32(&header[8], RAW_FORMAT_VERSION);
+    putU32(&header[12], RAW_HEADER_SIZE);
+    putU64(&header[16], store->count);
+    memcpy(&clockPeriodBits, &store->clockPeriod, sizeof(clockPeriodBits));
+    putU64(&header[24], clockPeriodBits);
+    putU64(&header[32], (uint64_t)triggerTime->tv_sec);
+    putU64(&header[40], (uint64_t)triggerTime->tv_nsec);
+    putU32(&header[48], headerOnly ? RAW_FLAG_HEADER_ONLY : 0);
+    putU32(&header[52], RAW_RECORD_SIZE);
+    written += fwrite(header, 1, sizeof(header), stream);
+
+    for (i = 0; i < store->count; i += RAW_BLOCK_EVENTS)
+    {
+        record = records;
+        for (j = i; (j < store->count) && (j < i + RAW_BLOCK_EVENTS); j++)
+        {
+            time = getNextEventTime(store, j, time);
+            putU64(record, (uint64_t)time);
+            record[8] = store->types[RECV_A][j];
+            record[9] = store->data[RECV_A][j];
+            record[10] = getEventErrors(store, j, RECV_A);
+            record[11] = store->types[RECV_B][j];
+            record[12] = store->data[RECV_B][j];
+            record[13] = getEventErrors(store, j, RECV_B);
+            record[14] = record[15] = 0;
+            record += RAW_RECORD_SIZE;
+        }
+        written += fwrite(records, 1, (size_t)(record - records), stream);
+    }
+
+    free(records);
+
+    return written;
+}
+
+int isRawCapture(const char *fileName)
+{
+    /* The file to check */
+    FILE *stream = fopen(fileName, "rb");
+    /* The start of the file */
+    char magic[8];
+    /* Return value */
+    int ret = 0;
+
+    if (NULL != stream)
+    {
+        ret = (sizeof(magic) == fread(magic, 1, sizeof(magic), stream)) && (0 == memcmp(magic, RAW_MAGIC, sizeof(magic)));
+        fclose(stream);
+    }
+
+    return ret;
+}
+
+int LA_MK3_readRawCapture(const char *fileName, STAR_LA_MK3_Traffic **ppTraffic, U32 *trafficCount,
+                          double *charCaptureClockPeriod, struct timespec *triggerTime, char *headerOnly)
+{
+    /* Loop counters */
+    U32 i = 0, j = 0;
+    /* The capture file */
+    FILE *stream = fopen(fileName, "rb");
+    /* The capture header */
+    U8 header[RAW_HEADER_SIZE];
+    /* Sizes of the header and the records as stored in the capture */
+    uint32_t headerSize = 0;
+    uint32_t recordSize = 0;
+    /* Number of events in the capture */
+    uint64_t eventCount = 0;
+    /* Bit pattern of the clock period */
+    uint64_t clockPeriodBits = 0;
+    /* Encoded records of a block of events */
+    U8 *records = NULL;
+    /* The current record */
+    const U8 *record = NULL;
+    /* Number of records in the current block */
+    size_t blockCount = 0;
+    /* The read traffic */
+    STAR_LA_MK3_Traffic *pTraffic = NULL;
+    /* Return value */
+    int ret = 0;
+
+    if (NULL == stream)
+    {
+        fprintf(stderr, "Unable to open raw capture %s\n", fileName);
+        return 0;
+    }
+
+    if ((RAW_HEADER_SIZE != fread(header, 1, RAW_HEADER_SIZE, stream)) || (0 != memcmp(header, RAW_MAGIC, 8)) ||
+        (RAW_FORMAT_VERSION != getU32(&header[8])))
+    {
+        fprintf(stderr, "%s is no raw capture of format version %d\n", fileName, RAW_FORMAT_VERSION);
+        fclose(stream);
+        return 0;
+    }
+    headerSize = getU32(&header[12]);
+    eventCount = getU64(&header[16]);
+    recordSize = getU32(&header[52]);
+    if ((RAW_HEADER_SIZE > headerSize) || (RAW_RECORD_SIZE > recordSize) || (0xFFFFFFFFu < eventCount) ||
+        (0 != fseek(stream, headerSize, SEEK_SET)))
+    {
+        fprintf(stderr, "Invalid header of raw capture %s\n", fileName);
+        fclose(stream);
+        return 0;
+    }
+
+    records = malloc((size_t)RAW_BLOCK_EVENTS * recordSize);
+    pTraffic = malloc(((size_t)eventCount + 1) * sizeof(STAR_LA_MK3_Traffic));
+    if ((NULL == records) || (NULL == pTraffic))
+    {
+        fputs("Unable to allocate memory for reading the raw capture\n", stderr);
+        free(records);
+        free(pTraffic);
+        fclose(stream);
+        return 0;
+    }
+
+    ret = 1;
+    for (i = 0; ret && (i < eventCount); i += (U32)blockCount)
+    {
+        blockCount = (eventCount - i < RAW_BLOCK_EVENTS) ? (size_t)(eventCount - i) : RAW_BLOCK_EVENTS;
+        if (blockCount != fread(records, recordSize, blockCount, stream))
+        {
+            fprintf(stderr, "Raw capture %s is truncated after %u events\n", fileName, i);
+            ret = 0;
+        }
+        record = records;
+        for (j = 0; ret && (j < blockCount); j++)
+        {
+            pTraffic[i + j].time = (long long)getU64(record);
+            pTraffic[i + j].linkAEvent.type = record[8];
+            pTraffic[i + j].linkAEvent.data = record[9];
+            pTraffic[i + j].linkAEvent.errors = record[10];
+            pTraffic[i + j].linkBEvent.type = record[11];
+            pTraffic[i + j].linkBEvent.data = record[12];
+            pTraffic[i + j].linkBEvent.errors = record[13];
+            record += recordSize;
+        }
+    }
+
+    if (ret)
+    {
+        clockPeriodBits = getU64(&header[24]);
+        memcpy(charCaptureClockPeriod, &clockPeriodBits, sizeof(clockPeriodBits));
+        triggerTime->tv_sec = (time_t)getU64(&header[32]);
+        triggerTime->tv_nsec = (long)getU64(&header[40]);
+        *headerOnly = (0 != (getU32(&header[48]) & RAW_FLAG_HEADER_ONLY));
+        *trafficCount = (U32)eventCount;
+        *ppTraffic = pTraffic;
+        fprintf(stderr, "Read %u events from raw capture %s\n", *trafficCount, fileName);
+    }
+    else
+    {
+        free(pTraffic);
+    }
+    free(records);
+    fclose(stream);
+
+    return ret;
+}
@@ -0,0 +1,133 @@
+#include <stdio.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <json-c/json.h>
+#include <spw_la_api.h>
+#include "arg_parser.h"
+#include "config_logger.h"
+#include "run_stats.h"
+#include "metrics.h"
+
+/* Start of the running measurement of each phase */
+static struct timespec phaseStart[STATS_PHASE_COUNT];
+
+/* Accumulated duration of each phase in seconds */
+static double phaseSeconds[STATS_PHASE_COUNT];
+
+/* Number of times each phase has been run */
+static unsigned int phaseRuns[STATS_PHASE_COUNT];
+
+/* Values of the counters */
+static _Atomic unsigned long long counters[STATS_COUNTER_COUNT];
+
+void statsStartPhase(int phase)
+{
+    clock_gettime(CLOCK_MONOTONIC, &phaseStart[phase]);
+    if (STATS_PHASE_TOTAL != phase)
+    {
+        metricsSetGauge(METRIC_GAUGE_PHASE, phase);
+    }
+
+    return;
+}
+
+void statsStopPhase(int phase)
+{
+    /* Current time */
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    phaseSeconds[phase] += (double)(now.tv_sec - phaseStart[phase].tv_sec) + (now.tv_nsec - phaseStart[phase].tv_nsec) * 1e-9;
+    phaseRuns[phase]++;
+
+    return;
+}
+
+void statsAdd(int counter, unsigned long long value)
+{
+    atomic_fetch_add_explicit(&counters[counter], value, memory_order_relaxed);
+
+    return;
+}
+
+unsigned long long statsGet(int counter)
+{
+    return atomic_load_explicit(&counters[counter], memory_order_relaxed);
+}
+
+int statsWriteReport(const char *fileName, Settings settings, struct timespec *triggerTime)
+{
+    /* Loop counter */
+    int i = 0;
+    /* Trigger time as string */
+    char triggerTimeStr[30] = "";
+    /* JSON objects of the report */
+    struct json_object *report = json_object_new_object();
+    struct json_object *phases = json_object_new_object();
+    struct json_object *values = json_object_new_object();
+    struct json_object *phase = NULL;
+    /* The report file */
+    FILE *file = NULL;
+    /* Return value */
+    int ret = 0;
+
+    json_object_object_add(report, "version", json_object_new_string(settings.version));
+    if (NULL != settings.inputFile)
+    {
+        json_object_object_add(report, "input", json_object_new_string(settings.inputFile));
+    }
+    else
+    {
+        json_object_object_add(report, "serial_number", json_object_new_string(settings.args[0]));
+    }
+    if ((NULL != triggerTime) && timeToStr(triggerTime, triggerTimeStr))
+    {
+        json_object_object_add(report, "trigger_time", json_object_new_string(triggerTimeStr));
+    }
+    for (i = 0; i < STATS_PHASE_COUNT; i++)
+    {
+        phase = json_object_new_object();
+        json_object_object_add(phase, "seconds", json_object_new_double(phaseSeconds[i]));
+        json_object_object_add(phase, "runs", json_object_new_int(phaseRuns[i]));
+        json_object_object_add(phases, statsPhaseNames[i], phase);
+    }
+    json_object_object_add(report, "phases", phases);
+    for (i = 0; i < STATS_COUNTER_COUNT; i++)
+    {
+        json_object_object_add(values, statsCounterNames[i], json_object_new_int64((int64_t)statsGet(i)));
+    }
+    json_object_object_add(report, "counters", values);
+    if (0 < statsGet(STATS_WRITER_BUSY_US))
+    {
+        /* Throughput of the file writers while writing */
+        json_object_object_add(report, "writer_mib_per_second",
+                               json_object_new_double(statsGet(STATS_DISK_BYTES) / (1024.0 * 1024.0) / (statsGet(STATS_WRITER_BUSY_US) * 1e-6)));
+    }
+    if (0 < statsGet(STATS_COMPRESS_OUTPUT_BYTES))
+    {
+        /* Compression ratio and throughput summed over all workers */
+        json_object_object_add(report, "compress_ratio",
+                               json_object_new_double((double)statsGet(STATS_COMPRESS_INPUT_BYTES) / statsGet(STATS_COMPRESS_OUTPUT_BYTES)));
+        json_object_object_add(report, "compress_mib_per_second",
+                               json_object_new_double(statsGet(STATS_COMPRESS_INPUT_BYTES) / (1024.0 * 1024.0) / (statsGet(STATS_COMPRESS_BUSY_US) * 1e-6 + 1e-9)));
+    }
+
+    file = fopen(fileName, "w");
+    if (NULL == file)
+    {
+        fprintf(stderr, "Unable to open statistics report %s\n", fileName);
+    }
+    else
+    {
+        ret = (0 <= fprintf(file, "%s\n", json_object_to_json_string_ext(report, JSON_C_TO_STRING_PRETTY)));
+        ret = (0 == fclose(file)) && ret;
+        if (!ret)
+        {
+            fprintf(stderr, "Unable to write statistics report %s\n", fileName);
+        }
+    }
+
+    json_object_put(report);
+
+    return ret;
+}
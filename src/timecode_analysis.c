@@ -0,0 +1,396 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <json-c/json.h>
+#include <spw_la_api.h>
+#include "arg_parser.h"
+#include "config_logger.h"
+#include "event_store.h"
+#include "event_scan.h"
+#include "packet_index.h"
+#include "timecode_analysis.h"
+
+/* Receiver names as used in the report */
+static const char *const receiverNames[] = { "a", "b" };
+
+static void addStatistic(TimecodeStatistic *statistic, double seconds)
+{
+    /* Difference to the mean before the update */
+    double delta = seconds - statistic->mean;
+
+    if ((0 == statistic->count) || (seconds < statistic->min))
+    {
+        statistic->min = seconds;
+    }
+    if ((0 == statistic->count) || (seconds > statistic->max))
+    {
+        statistic->max = seconds;
+    }
+    statistic->count++;
+    statistic->mean += delta / statistic->count;
+    statistic->m2 += delta * (seconds - statistic->mean);
+
+    return;
+}
+
+static double getDeviation(const TimecodeStatistic *statistic)
+{
+    return (0 < statistic->count) ? sqrt(statistic->m2 / statistic->count) : 0.0;
+}
+
+static double getFittedPeriod(const ReceiverTimecodes *receiver)
+{
+    return (0.0 < receiver->positionM2) ? receiver->comoment / receiver->positionM2 : 0.0;
+}
+
+static double getTimeError(const ReceiverTimecodes *receiver)
+{
+    /* Sum of the squared differences of the times to the fitted line */
+    double residual = (0.0 < receiver->positionM2) ? receiver->timeM2 - receiver->comoment * receiver->comoment / receiver->positionM2 : 0.0;
+
+    return ((0 < receiver->count) && (0.0 < residual)) ? sqrt(residual / receiver->count) : 0.0;
+}
+
+static void addPosition(ReceiverTimecodes *receiver, double seconds)
+{
+    /* Differences to the means before the update */
+    double positionDelta = receiver->position - receiver->meanPosition;
+    double timeDelta = seconds - receiver->meanTime;
+
+    /* The position and time of each time-code are fitted to a line, whose slope is the period */
+    receiver->meanPosition += positionDelta / receiver->count;
+    receiver->meanTime += timeDelta / receiver->count;
+    receiver->positionM2 += positionDelta * (receiver->position - receiver->meanPosition);
+    receiver->timeM2 += timeDelta * (seconds - receiver->meanTime);
+    receiver->comoment += positionDelta * (seconds - receiver->meanTime);
+
+    return;
+}
+
+static void pairTimecode(TimecodeAnalysis *analysis, U8 r, long long time, U8 value)
+{
+    /* The other receiver */
+    U8 other = (RECV_A == r) ? RECV_B : RECV_A;
+    /* Largest distance of two paired time-codes, half a period once it is known */
+    double window = analysis->receivers[r].period.mean / 2;
+
+    if (analysis->pending[other] && (analysis->pendingValue[other] == value) &&
+        ((0 == analysis->receivers[r].period.count) || ((time - analysis->pendingTime[other]) * analysis->clockPeriod <= window)))
+    {
+        addStatistic(&analysis->delay, ((RECV_B == r) ? time - analysis->pendingTime[other] : analysis->pendingTime[other] - time) * analysis->clockPeriod);
+        analysis->pending[other] = 0;
+        return;
+    }
+
+    /* A time-code still waiting is replaced by the next one of its receiver */
+    if (analysis->pending[r])
+    {
+        analysis->unpaired[r]++;
+    }
+    analysis->pending[r] = 1;
+    analysis->pendingTime[r] = time;
+    analysis->pendingValue[r] = value;
+
+    return;
+}
+
+static void addTimecode(TimecodeAnalysis *analysis, U8 r, long long time, U8 data)
+{
+    /* Time-codes of the receiver */
+    ReceiverTimecodes *receiver = &analysis->receivers[r];
+    /* Step of the value from the previous time-code */
+    U8 step = (data - receiver->lastValue) & (TIMECODE_VALUES - 1);
+    /* Time since the previous time-code */
+    double interval = (time - receiver->lastTime) * analysis->clockPeriod;
+    /* Periods since the previous time-code, estimated from the time for codes out of sequence */
+    double periods = 0.0;
+
+    if (0 == receiver->count)
+    {
+        receiver->firstTime = time;
+    }
+    else if (1 == step)
+    {
+        addStatistic(&receiver->period, interval);
+        periods = 1.0;
+    }
+    else if ((0 != step) && (TIMECODE_MAX_STEP >= step))
+    {
+        receiver->missing += step - 1;
+        receiver->gaps++;
+        periods = step;
+    }
+    else
+    {
+        if (0 == step)
+        {
+            receiver->repeated++;
+        }
+        else
+        {
+            receiver->outOfSequence++;
+        }
+        periods = (0.0 < receiver->period.mean) ? round(interval / receiver->period.mean) : 1.0;
+    }
+    if ((0 < receiver->count) && ((data ^ receiver->lastValue) & ~(TIMECODE_VALUES - 1)))
+    {
+        receiver->flagChanges++;
+    }
+
+    receiver->count++;
+    receiver->position += periods;
+    addPosition(receiver, (time - receiver->firstTime) * analysis->clockPeriod);
+    receiver->lastTime = time;
+    receiver->lastValue = data;
+
+    pairTimecode(analysis, r, time, data & (TIMECODE_VALUES - 1));
+
+    return;
+}
+
+static U32 findTimecode(const EventStore *store, U8 receiver, U32 event)
+{
+    /* Headers and time-codes are the only events starting a record, skip the headers */
+    event = scanPacketStart(store->types[receiver], event, store->count);
+    while ((event < store->count) && (STAR_LA_TRAFFIC_TYPE_TIMECODE != store->types[receiver][event]))
+    {
+        event = scanPacketStart(store->types[receiver], event + 1, store->count);
+    }
+
+    return event;
+}
+
+void LA_MK3_analyseTimecodes(TimecodeAnalysis *analysis, const EventStore *store, const PacketIndex *index)
+{
+    /* Next time-code on receiver A and B */
+    U32 next[2] = { store->count, store->count };
+    /* The current event and its capture clock tick */
+    U32 event = index->firstEvent;
+    long long time = 0;
+    /* Receiver of the next time-code */
+    U8 r = 0;
+
+    memset(analysis, 0, sizeof(TimecodeAnalysis));
+    analysis->clockPeriod = store->clockPeriod;
+    if (index->firstEvent >= store->count)
+    {
+        return;
+    }
+
+    time = getEventTime(store, event);
+    next[RECV_A] = findTimecode(store, RECV_A, event);
+    next[RECV_B] = findTimecode(store, RECV_B, event);
+    while ((next[RECV_A] < store->count) || (next[RECV_B] < store->count))
+    {
+        /* Time-codes are analysed in the order they have been recorded, A before B on the same event */
+        r = (next[RECV_A] <= next[RECV_B]) ? RECV_A : RECV_B;
+        time = advanceEventTime(store, event, time, next[r]);
+        event = next[r];
+        addTimecode(analysis, r, time, store->data[r][event]);
+        next[r] = findTimecode(store, r, event + 1);
+    }
+
+    /* Time-codes still waiting have no partner */
+    for (r = RECV_A; r <= RECV_B; r++)
+    {
+        analysis->unpaired[r] += analysis->pending[r];
+    }
+
+    return;
+}
+
+static struct json_object *newStatisticObject(const TimecodeStatistic *statistic)
+{
+    /* JSON object of the statistic in microseconds */
+    struct json_object *object = json_object_new_object();
+
+    json_object_object_add(object, "count", json_object_new_int64((int64_t)statistic->count));
+    if (0 < statistic->count)
+    {
+        json_object_object_add(object, "min_us", json_object_new_double(statistic->min * 1e6));
+        json_object_object_add(object, "mean_us", json_object_new_double(statistic->mean * 1e6));
+        json_object_object_add(object, "max_us", json_object_new_double(statistic->max * 1e6));
+        json_object_object_add(object, "stddev_us", json_object_new_double(getDeviation(statistic) * 1e6));
+    }
+
+    return object;
+}
+
+static struct json_object *newReceiverObject(const TimecodeAnalysis *analysis, U8 r)
+{
+    /* Time-codes of the receiver */
+    const ReceiverTimecodes *receiver = &analysis->receivers[r];
+    /* JSON objects of the receiver */
+    struct json_object *object = json_object_new_object();
+    struct json_object *jitter = json_object_new_object();
+
+    json_object_object_add(object, "count", json_object_new_int64((int64_t)receiver->count));
+    if (0 < receiver->count)
+    {
+        json_object_object_add(object, "first_ms", json_object_new_double(receiver->firstTime * analysis->clockPeriod * 1000.0));
+        json_object_object_add(object, "last_ms", json_object_new_double(receiver->lastTime * analysis->clockPeriod * 1000.0));
+    }
+    json_object_object_add(object, "period", newStatisticObject(&receiver->period));
+    if (0 < receiver->period.count)
+    {
+        json_object_object_add(jitter, "peak_to_peak_us", json_object_new_double((receiver->period.max - receiver->period.min) * 1e6));
+        json_object_object_add(jitter, "max_deviation_us", json_object_new_double(
+            fmax(receiver->period.max - receiver->period.mean, receiver->period.mean - receiver->period.min) * 1e6));
+        json_object_object_add(jitter, "stddev_us", json_object_new_double(getDeviation(&receiver->period) * 1e6));
+        json_object_object_add(jitter, "fitted_period_us", json_object_new_double(getFittedPeriod(receiver) * 1e6));
+        json_object_object_add(jitter, "rms_time_error_us", json_object_new_double(getTimeError(receiver) * 1e6));
+    }
+    json_object_object_add(object, "jitter", jitter);
+    json_object_object_add(object, "missing", json_object_new_int64((int64_t)receiver->missing));
+    json_object_object_add(object, "gaps", json_object_new_int64((int64_t)receiver->gaps));
+    json_object_object_add(object, "repeated", json_object_new_int64((int64_t)receiver->repeated));
+    json_object_object_add(object, "out_of_sequence", json_object_new_int64((int64_t)receiver->outOfSequence));
+    json_object_object_add(object, "flag_changes", json_object_new_int64((int64_t)receiver->flagChanges));
+    json_object_object_add(object, "unpaired", json_object_new_int64((int64_t)analysis->unpaired[r]));
+
+    return object;
+}
+
+int writeTimecodeReport(const char *fileName, const TimecodeAnalysis *analysis, Settings settings, struct timespec *triggerTime)
+{
+    /* Receiver counter */
+    U8 r = 0;
+    /* Trigger time as string */
+    char triggerTimeStr[30] = "";
+    /* JSON objects of the report */
+    struct json_object *report = json_object_new_object();
+    struct json_object *receivers = json_object_new_object();
+    /* The report file */
+    FILE *file = NULL;
+    /* Return value */
+    int ret = 0;
+
+    json_object_object_add(report, "version", json_object_new_string(settings.version));
+    if (NULL != settings.inputFile)
+    {
+        json_object_object_add(report, "input", json_object_new_string(settings.inputFile));
+    }
+    else
+    {
+        json_object_object_add(report, "serial_number", json_object_new_string(settings.args[0]));
+    }
+    if ((NULL != triggerTime) && timeToStr(triggerTime, triggerTimeStr))
+    {
+        json_object_object_add(report, "trigger_time", json_object_new_string(triggerTimeStr));
+    }
+    for (r = RECV_A; r <= RECV_B; r++)
+    {
+        json_object_object_add(receivers, receiverNames[r], newReceiverObject(analysis, r));
+    }
+    json_object_object_add(report, "receivers", receivers);
+    json_object_object_add(report, "delay_b_behind_a", newStatisticObject(&analysis->delay));
+
+    file = fopen(fileName, "w");
+    if (NULL == file)
+    {
+        fprintf(stderr, "Unable to open time-code report %s\n", fileName);
+    }
+    else
+    {
+        ret = (0 <= fprintf(file, "%s\n", json_object_to_json_string_ext(report, JSON_C_TO_STRING_PRETTY)));
+        ret = (0 == fclose(file)) && ret;
+        if (!ret)
+        {
+            fprintf(stderr, "Unable to write time-code report %s\n", fileName);
+        }
+    }
+
+    json_object_put(report);
+
+    return ret;
+}
+
+static void printPeriodRow(FILE *stream, const char *name, const TimecodeAnalysis *analysis, int row)
+{
+    /* Receiver counter */
+    U8 r = 0;
+    /* Time-codes of the receiver */
+    const ReceiverTimecodes *receiver = NULL;
+    /* Value of the row in microseconds */
+    double value = 0.0;
+
+    fprintf(stream, "%-26s", name);
+    for (r = RECV_A; r <= RECV_B; r++)
+    {
+        receiver = &analysis->receivers[r];
+        switch (row)
+        {
+        case 0:
+            value = receiver->period.min;
+            break;
+        case 1:
+            value = receiver->period.mean;
+            break;
+        case 2:
+            value = receiver->period.max;
+            break;
+        case 3:
+            value = receiver->period.max - receiver->period.min;
+            break;
+        case 4:
+            value = getDeviation(&receiver->period);
+            break;
+        case 5:
+            value = getFittedPeriod(receiver);
+            break;
+        default:
+            value = getTimeError(receiver);
+            break;
+        }
+        if (0 < receiver->period.count)
+        {
+            fprintf(stream, "  %16.3f", value * 1e6);
+        }
+        else
+        {
+            fprintf(stream, "  %16s", "-");
+        }
+    }
+    fputs("\n", stream);
+
+    return;
+}
+
+void printTimecodeTable(FILE *stream, const TimecodeAnalysis *analysis)
+{
+    /* Time-codes of receiver A and B */
+    const ReceiverTimecodes *a = &analysis->receivers[RECV_A];
+    const ReceiverTimecodes *b = &analysis->receivers[RECV_B];
+    /* Delay of receiver B behind receiver A */
+    const TimecodeStatistic *delay = &analysis->delay;
+
+    fprintf(stream, "Time-code analysis\n\n");
+    fprintf(stream, "%-26s  %16s  %16s\n", "", "Receiver A", "Receiver B");
+    fprintf(stream, "%-26s  %16llu  %16llu\n", "Time-codes", a->count, b->count);
+    printPeriodRow(stream, "Period min (us)", analysis, 0);
+    printPeriodRow(stream, "Period mean (us)", analysis, 1);
+    printPeriodRow(stream, "Period max (us)", analysis, 2);
+    printPeriodRow(stream, "Jitter peak to peak (us)", analysis, 3);
+    printPeriodRow(stream, "Jitter stddev (us)", analysis, 4);
+    printPeriodRow(stream, "Fitted period (us)", analysis, 5);
+    printPeriodRow(stream, "RMS time error (us)", analysis, 6);
+    fprintf(stream, "%-26s  %16llu  %16llu\n", "Missing codes", a->missing, b->missing);
+    fprintf(stream, "%-26s  %16llu  %16llu\n", "Gaps", a->gaps, b->gaps);
+    fprintf(stream, "%-26s  %16llu  %16llu\n", "Repeated codes", a->repeated, b->repeated);
+    fprintf(stream, "%-26s  %16llu  %16llu\n", "Out of sequence", a->outOfSequence, b->outOfSequence);
+    fprintf(stream, "%-26s  %16llu  %16llu\n", "Control flag changes", a->flagChanges, b->flagChanges);
+    fprintf(stream, "%-26s  %16llu  %16llu\n", "Unpaired", analysis->unpaired[RECV_A], analysis->unpaired[RECV_B]);
+
+    if (0 < delay->count)
+    {
+        fprintf(stream, "\nDelay of B behind A over %llu pair(s) (us): min %.3f, mean %.3f, max %.3f, stddev %.3f\n",
+                delay->count, delay->min * 1e6, delay->mean * 1e6, delay->max * 1e6, getDeviation(delay) * 1e6);
+    }
+    else
+    {
+        fputs("\nNo time-codes paired between receiver A and B\n", stream);
+    }
+
+    return;
+}